@@ -6,8 +6,9 @@
 #pragma once
 #include "zxsp_globals.h"
 
-extern Frequency samples_per_second; // DSP-Konstante & Zeitbasis des Systems: samples/second
-extern Time		 system_time;		 // Realzeit [seconds]
+extern Frequency samples_per_second;	  // DSP-Konstante & Zeitbasis des Systems: samples/second
+extern int32	 dsp_samples_per_buffer;  // current audio buffer size
+extern Time		 system_time;			  // Realzeit [seconds]
 
 
 namespace os
@@ -18,5 +19,7 @@ extern void stopCoreAudio();
 extern void enableAudioInputDevice(bool f);
 extern void enableAudioOutputDevice(bool f);
 extern void setOutputVolume(Sample volume);
+extern void setAudioBufferSize(int32 samples); // restarts audio if changed
+extern void enableRateControl(bool f);		   // macOS only: no-op on Linux
 
 } // namespace os
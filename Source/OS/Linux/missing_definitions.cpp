@@ -5,8 +5,9 @@
 #include "Dsp.h"
 #include "kio/kio.h"
 
-Time	  system_time		 = 0.0;
-Frequency samples_per_second = 44100;
+Time	  system_time			 = 0.0;
+Frequency samples_per_second	 = 44100;
+int32	  dsp_samples_per_buffer = DSP_SAMPLES_PER_BUFFER_DFLT;
 
 namespace os
 {
@@ -19,4 +20,16 @@ void startCoreAudio(bool input_enabled)
 }
 
 void stopCoreAudio() { debugstr("stopCoreAudio\n"); }
+
+void setAudioBufferSize(int32 samples)
+{
+	dsp_samples_per_buffer = minmax(DSP_SAMPLES_PER_BUFFER_MIN, samples, DSP_SAMPLES_PER_BUFFER_MAX);
+}
+
+void enableRateControl(bool)
+{
+	// there is no audio driver on Linux yet, so there is no device clock to follow.
+	// the setting is disabled in Preferences.
+}
+
 } // namespace os
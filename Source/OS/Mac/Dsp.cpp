@@ -6,14 +6,17 @@
 #include "Application.h"
 #include "MachineList.h"
 #include "Qt/Settings.h"
+#include "RateControl.h"
+#include "SampleKernels.h"
 #include "StereoSample.h"
 #include "cpp/cppthreads.h"
 #include "cstrings/tempmem.h"
 #include "kio/TestTimer.h"
 #include <CoreAudio/CoreAudio.h>
 
-Time	  system_time		 = 0.0;
-Frequency samples_per_second = 44100;
+Time	  system_time			 = 0.0;
+Frequency samples_per_second	 = 44100;
+int32	  dsp_samples_per_buffer = DSP_SAMPLES_PER_BUFFER_DFLT;
 
 
 namespace os
@@ -32,8 +35,11 @@ static Sample audio_output_volume		  = 0.3f;
 static StereoSample audio_out_center = 0.0f; // for audio out High-pass filter
 static StereoSample audio_in_center	 = 0.0f; // for audio in High-pass filter
 
-static StereoSample audio_out_buffer[DSP_SAMPLES_PER_BUFFER + DSP_SAMPLES_STITCHING];
-static StereoSample audio_in_buffer[DSP_SAMPLES_PER_BUFFER + DSP_SAMPLES_STITCHING];
+static StereoSample audio_out_buffer[DSP_SAMPLES_PER_BUFFER_MAX + DSP_SAMPLES_STITCHING];
+static StereoSample audio_in_buffer[DSP_SAMPLES_PER_BUFFER_MAX + DSP_SAMPLES_STITCHING];
+
+static RateControl rate_control;				// keep samples_per_second in lockstep with the host clock
+static bool		   rate_control_enabled = yes; //
 
 static AudioDeviceID	   input_device_id	  = 0; // actually used audio devices
 static AudioDeviceID	   output_device_id	  = 0;
@@ -43,44 +49,26 @@ static AudioDeviceIOProcID audio_in_ioProcID  = nullptr; // kio 2012-08-08
 // ###################################################################################
 // High-pass filter: (remove signal bias)
 
-inline void HighPassFilter(StereoSample* p, int count, StereoSample& center, float damping)
-{
-	for (StereoSample* e = p + count; p < e; p++) { center += (*p -= center) * damping; }
-}
-
 inline void HighpassInputBuffer()
 {
-	HighPassFilter(audio_in_buffer + DSP_SAMPLES_STITCHING, DSP_SAMPLES_PER_BUFFER, audio_in_center, 0.001f);
+	highpassSamples(audio_in_buffer + DSP_SAMPLES_STITCHING, uint(dsp_samples_per_buffer), audio_in_center, 0.001f);
 }
 
 inline void HighpassOutputBuffer()
 {
-	HighPassFilter(audio_out_buffer, DSP_SAMPLES_PER_BUFFER, audio_out_center, 0.001f);
+	highpassSamples(audio_out_buffer, uint(dsp_samples_per_buffer), audio_out_center, 0.001f);
 }
 
-inline void shiftBuffer(StereoSample* bu)
-{
-	for (int i = 0; i < DSP_SAMPLES_STITCHING; i++) bu[i] = bu[DSP_SAMPLES_PER_BUFFER + i];
-}
+inline void shiftBuffer(StereoSample* bu) { copySamples(bu, bu + dsp_samples_per_buffer, DSP_SAMPLES_STITCHING); }
 
 inline void ShiftInputStitching() { shiftBuffer(audio_in_buffer); }
 
 inline void ShiftOutputStitching() { shiftBuffer(audio_out_buffer); }
 
-__unused inline void clearBuffer(StereoSample* bu) // preserves stitching at buffer start
-{
-	for (int i = DSP_SAMPLES_STITCHING; i < DSP_SAMPLES_PER_BUFFER + DSP_SAMPLES_STITCHING; i++) bu[i] = 0.0f;
-}
-
 // ###################################################################################
 // audio input handling:
 
-inline void ClearInputBuffer()
-{
-	StereoSample* z = audio_in_buffer + DSP_SAMPLES_STITCHING;
-	StereoSample* e = z + DSP_SAMPLES_PER_BUFFER;
-	while (z < e) { *z++ = 0.0; }
-}
+inline void ClearInputBuffer() { clearSamples(audio_in_buffer + DSP_SAMPLES_STITCHING, uint(dsp_samples_per_buffer)); }
 
 inline void ReadInputData(const AudioBufferList* inInputData)
 {
@@ -100,12 +88,12 @@ inline void ReadInputData(const AudioBufferList* inInputData)
 		for (uint i = 1; i < buffers; i++)
 		{
 			assert(inInputData->mBuffers[i].mNumberChannels == channels);
-			assert(inInputData->mBuffers[i].mDataByteSize == (DSP_SAMPLES_PER_BUFFER * channels * sizeof(Sample)));
+			assert(inInputData->mBuffers[i].mDataByteSize == (dsp_samples_per_buffer * channels * sizeof(Sample)));
 			assert(buffers == 1 || channels == 1);
 		}
 
 	StereoSample* z = audio_in_buffer + DSP_SAMPLES_STITCHING;
-	StereoSample* e = z + DSP_SAMPLES_PER_BUFFER;
+	StereoSample* e = z + dsp_samples_per_buffer;
 
 	switch (buffers)
 	{
@@ -177,13 +165,13 @@ inline void CopyInputToOutputBuffer()
 		assert(d == 0.0);
 	}
 
-	memset(audio_out_buffer + DSP_SAMPLES_STITCHING, 0, DSP_SAMPLES_PER_BUFFER * sizeof(*audio_out_buffer));
+	clearSamples(audio_out_buffer + DSP_SAMPLES_STITCHING, uint(dsp_samples_per_buffer));
 
 	//	if( play_through_damping==0.0 )
-	//		for( uint i=DSP_SAMPLES_STITCHING; i < DSP_SAMPLES_PER_BUFFER+DSP_SAMPLES_STITCHING; i++)
+	//		for( uint i=DSP_SAMPLES_STITCHING; i < dsp_samples_per_buffer+DSP_SAMPLES_STITCHING; i++)
 	//		{ audio_out_buffer[i] = 0.0; }
 	//	else
-	//		for( uint i=DSP_SAMPLES_STITCHING; i < DSP_SAMPLES_PER_BUFFER+DSP_SAMPLES_STITCHING; i++ )
+	//		for( uint i=DSP_SAMPLES_STITCHING; i < dsp_samples_per_buffer+DSP_SAMPLES_STITCHING; i++ )
 	//		{ audio_out_buffer[i] = audio_in_buffer[i] * play_through_damping; }
 }
 
@@ -203,12 +191,12 @@ inline void WriteOutputData(AudioBufferList* outOutputData)
 		for (uint i = 1; i < buffers; i++)
 		{
 			assert(outOutputData->mBuffers[i].mNumberChannels == channels);
-			assert(outOutputData->mBuffers[i].mDataByteSize == (DSP_SAMPLES_PER_BUFFER * channels * sizeof(Sample)));
+			assert(outOutputData->mBuffers[i].mDataByteSize == (dsp_samples_per_buffer * channels * sizeof(Sample)));
 			assert(buffers == 1 || channels == 1);
 		}
 
 	const StereoSample* q	   = audio_out_buffer;
-	const StereoSample* e	   = q + DSP_SAMPLES_PER_BUFFER;
+	const StereoSample* e	   = q + dsp_samples_per_buffer;
 	Sample				volume = audio_output_volume;
 
 	switch (buffers)
@@ -220,12 +208,7 @@ inline void WriteOutputData(AudioBufferList* outOutputData)
 		// copy audio_out_buffer to audio-out buffers (mono -> stereo):
 		Sample* z0 = (Sample*)outOutputData->mBuffers[0].mData;
 		Sample* z1 = (Sample*)outOutputData->mBuffers[1].mData;
-		while (q < e)
-		{
-			*z0++ = q->left * volume;
-			*z1++ = q->right * volume;
-			q++;
-		}
+		writeSamples(z0, z1, q, uint(dsp_samples_per_buffer), volume);
 
 		// clear other channels (if any):
 		for (uint i = 2; i < buffers; i++)
@@ -247,17 +230,11 @@ inline void WriteOutputData(AudioBufferList* outOutputData)
 		switch (channels)
 		{
 		case 1: // mono
-			while (q < e) { *z++ = Sample(*q++) * volume; }
+			writeMonoSamples(z, q, uint(dsp_samples_per_buffer), volume);
 			break;
 
 		case 2: // interleaved stereo ((99% of cases))
-			while (q < e)
-			{
-				z[0] = q->left * volume;
-				z[1] = q->right * volume;
-				q++;
-				z += 2;
-			}
+			writeSamples(z, q, uint(dsp_samples_per_buffer), volume);
 			break;
 
 		default: // e.g. 6 channels: dolby 5.1?  l/r channel seem to be buffer[0/1]
@@ -296,7 +273,7 @@ static OSStatus audioDeviceIOProc(
 		if ((inInputData && inInputData->mNumberBuffers != 0) || !audio_input_device_present)
 		{
 			static float64 lasttime = 0;
-			if (inInputTime->mSampleTime - lasttime != DSP_SAMPLES_PER_BUFFER && lasttime != 0.0)
+			if (inInputTime->mSampleTime - lasttime != dsp_samples_per_buffer && lasttime != 0.0)
 				xlogline(
 					"WARNING audio-in at sample %lu: Δ samples = %lu", (ulong)inInputTime->mSampleTime,
 					(ulong)(inInputTime->mSampleTime - lasttime));
@@ -306,7 +283,7 @@ static OSStatus audioDeviceIOProc(
 			if (audio_input_device_enabled /*implies audio_input_device_present*/)
 			{
 				ReadInputData(inInputData);
-				if (0) HighpassInputBuffer();
+				HighpassInputBuffer();
 			}
 			else ClearInputBuffer();
 		}
@@ -323,7 +300,7 @@ static OSStatus audioDeviceIOProc(
 		if (outOutputData && outOutputData->mNumberBuffers != 0)
 		{
 			static float64 lasttime = 0;
-			if (inOutputTime->mSampleTime - lasttime != DSP_SAMPLES_PER_BUFFER && lasttime != 0.0)
+			if (inOutputTime->mSampleTime - lasttime != dsp_samples_per_buffer && lasttime != 0.0)
 				xlogline(
 					"WARNING audio-out at sample %lu: Δ samples = %lu", (ulong)inOutputTime->mSampleTime,
 					(ulong)(inOutputTime->mSampleTime - lasttime));
@@ -334,11 +311,20 @@ static OSStatus audioDeviceIOProc(
 			nvptr(&gui::machine_list)->runMachinesForSound(audio_in_buffer, audio_out_buffer); // DOIT!
 			if (audio_output_device_enabled && audio_output_volume > 0.0f)
 			{
-				if (0) HighpassOutputBuffer();
+				HighpassOutputBuffer();
 				WriteOutputData(outOutputData);
 			}
 
-			system_time += DSP_SAMPLES_PER_BUFFER / samples_per_second;
+			system_time += dsp_samples_per_buffer / samples_per_second;
+
+			// dynamic rate control:
+			// nudge samples_per_second to the actual rate of the audio device measured with the host clock:
+			if (rate_control_enabled && (inOutputTime->mFlags & kAudioTimeStampSampleHostTimeValid) ==
+											kAudioTimeStampSampleHostTimeValid)
+			{
+				Time host_time	   = AudioConvertHostTimeToNanos(inOutputTime->mHostTime) * 1e-9;
+				samples_per_second = rate_control.update(host_time, inOutputTime->mSampleTime);
+			}
 
 #if XLOG
 			{
@@ -423,6 +409,12 @@ void stopCoreAudio()
 	// wait for any current sound callback to finish:
 	PLocker<PLock> lock(audio_callback_lock);
 	//    waitDelay(0.01);
+
+	// destroy callbacks: startCoreAudio() may be called again, e.g. by setAudioBufferSize()
+	if (audio_in_ioProcID) (void)AudioDeviceDestroyIOProcID(input_device_id, audio_in_ioProcID);
+	if (audio_out_ioProcID) (void)AudioDeviceDestroyIOProcID(output_device_id, audio_out_ioProcID);
+	audio_in_ioProcID  = nullptr;
+	audio_out_ioProcID = nullptr;
 }
 
 
@@ -434,7 +426,7 @@ void stopCoreAudio()
 void startCoreAudio(bool input_enabled) //, int playthrough_mode)
 {
 	xlogIn("Dsp:StartCoreAudio");
-	xlogline("DSP_SAMPLES_PER_BUFFER = %u", uint(DSP_SAMPLES_PER_BUFFER));
+	xlogline("dsp_samples_per_buffer = %u", uint(dsp_samples_per_buffer));
 
 
 	OSStatus				   status = 0 /*ok*/;
@@ -454,8 +446,8 @@ void startCoreAudio(bool input_enabled) //, int playthrough_mode)
 	// clear stitching samples: (required?)
 	for (int i = 0; i < DSP_SAMPLES_STITCHING; i++)
 	{
-		audio_out_buffer[DSP_SAMPLES_PER_BUFFER + i] = 0.0;
-		audio_in_buffer[DSP_SAMPLES_PER_BUFFER + i]	 = 0.0;
+		audio_out_buffer[dsp_samples_per_buffer + i] = 0.0;
+		audio_in_buffer[dsp_samples_per_buffer + i]	 = 0.0;
 	}
 
 
@@ -507,6 +499,7 @@ void startCoreAudio(bool input_enabled) //, int playthrough_mode)
 			logline("%4u mBitsPerChannel", uint(outputStreamBasicDescription.mBitsPerChannel));
 		}
 		samples_per_second = (Frequency)outputStreamBasicDescription.mSampleRate;
+		rate_control.reset(samples_per_second);
 
 		UInt32 ofmt = outputStreamBasicDescription.mFormatID;
 		UInt32 ocpf = outputStreamBasicDescription.mChannelsPerFrame;
@@ -519,7 +512,7 @@ void startCoreAudio(bool input_enabled) //, int playthrough_mode)
 
 		UInt32 bufferByteCount;
 		propertySize	  = sizeof(bufferByteCount);
-		bufferByteCount	  = DSP_SAMPLES_PER_BUFFER * obpf /*output bytes per frame*/;
+		bufferByteCount	  = dsp_samples_per_buffer * obpf /*output bytes per frame*/;
 		address.mSelector = kAudioDevicePropertyBufferSize;	 // kio 2012-04-29
 		address.mScope	  = kAudioDevicePropertyScopeOutput; // kio 2012-04-29
 		address.mElement  = 0 /*Channel*/;					 // kio 2012-04-29 TODO: Channel
@@ -533,6 +526,20 @@ void startCoreAudio(bool input_enabled) //, int playthrough_mode)
 
 		if (status) throw AnyError("SetOutputBufferSize");
 
+		// the device may have adjusted the buffer size:
+
+		UInt32 bufferFrameCount;
+		propertySize	  = sizeof(bufferFrameCount);
+		address.mSelector = kAudioDevicePropertyBufferFrameSize;
+		status = AudioObjectGetPropertyData(output_device_id, &address, 0, nullptr, &propertySize, &bufferFrameCount);
+
+		if (status) throw AnyError("GetOutputBufferFrameSize");
+		if (bufferFrameCount < DSP_SAMPLES_PER_BUFFER_MIN || bufferFrameCount > DSP_SAMPLES_PER_BUFFER_MAX)
+			throw AnyError("Audio buffer size %u not supported", uint(bufferFrameCount));
+		if (int32(bufferFrameCount) != dsp_samples_per_buffer)
+			logline("Dsp: audio buffer size adjusted to %u samples", uint(bufferFrameCount));
+		dsp_samples_per_buffer = int32(bufferFrameCount);
+
 		// Start audio output interrupt
 
 		status = AudioDeviceCreateIOProcID(
@@ -618,7 +625,7 @@ void startCoreAudio(bool input_enabled) //, int playthrough_mode)
 		{
 			UInt32 bufferByteCount;
 			propertySize	  = sizeof(bufferByteCount);
-			bufferByteCount	  = DSP_SAMPLES_PER_BUFFER * ibpf /*input bytes per frame*/;
+			bufferByteCount	  = dsp_samples_per_buffer * ibpf /*input bytes per frame*/;
 			address.mSelector = kAudioDevicePropertyBufferSize; // kio 2012-04-29
 			address.mScope	  = kAudioDevicePropertyScopeInput; // kio 2012-04-29
 			address.mElement  = 0 /*Channel*/;					// kio 2012-04-29	TODO Channel
@@ -675,6 +682,30 @@ void enableAudioInputDevice(bool f)
 
 void enableAudioOutputDevice(bool f) { audio_output_device_enabled = f; }
 
+void setAudioBufferSize(int32 samples)
+{
+	// set the audio buffer size, e.g. small for low latency or large for power saving
+	// the audio devices are restarted if running: the machines continue seamlessly
+	// except for the stitching samples which are lost.
+
+	samples = minmax(DSP_SAMPLES_PER_BUFFER_MIN, samples, DSP_SAMPLES_PER_BUFFER_MAX);
+	if (samples == dsp_samples_per_buffer) return;
+
+	bool running = audio_out_ioProcID != nullptr;
+	if (running) stopCoreAudio();
+	dsp_samples_per_buffer = samples;
+	if (running) startCoreAudio(audio_input_device_enabled);
+}
+
+void enableRateControl(bool f)
+{
+	PLocker<PLock> lock(audio_callback_lock);
+
+	rate_control_enabled = f;
+	rate_control.reset(rate_control.getNominalRate());
+	samples_per_second = rate_control.getRate();
+}
+
 void setOutputVolume(Sample volume)
 {
 	if (volume <= 0.0f) { audio_output_device_enabled = off; }
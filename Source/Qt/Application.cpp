@@ -156,6 +156,8 @@ Application::Application(int argc, char* argv[]) : QApplication(argc, argv)
 	//	}
 
 	// start core audio == start running the machine:
+	os::setAudioBufferSize(settings.get_int(key_audio_buffer_size, DSP_SAMPLES_PER_BUFFER_DFLT));
+	os::enableRateControl(settings.get_bool(key_audio_rate_control, yes));
 	os::startCoreAudio(settings.get_bool(key_warn_if_audio_in_fails, yes));
 
 	// open tool windows if set so in preferences:
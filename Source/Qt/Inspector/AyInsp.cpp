@@ -6,9 +6,11 @@
 #include "Ay/Ay.h"
 #include "Qt/qt_util.h"
 #include "Templates/NVPtr.h"
+#include <QAction>
 #include <QGridLayout>
 #include <QLabel>
 #include <QLineEdit>
+#include <QMenu>
 #include <QtGui>
 
 namespace gui
@@ -181,6 +183,23 @@ void AyInsp::updateWidgets()
 	}
 }
 
+void AyInsp::fillContextMenu(QMenu* menu)
+{
+	// Called by Inspector for right-click in inspector window
+
+	assert(validReference(ay));
+	Inspector::fillContextMenu(menu);
+
+	QAction* action = new QAction("Integer-tick synthesis", menu);
+	action->setCheckable(true);
+	action->setChecked(ay->usesTickCore());
+	connect(action, &QAction::toggled, this, [this](bool f) {
+		assert(validReference(this->ay));
+		nvptr(this->ay)->setTickCore(f);
+	});
+	menu->addAction(action);
+}
+
 QLineEdit* AyInsp::new_led(cstr s)
 {
 	QLineEdit* led = new QLineEdit(s);
@@ -31,6 +31,7 @@ public:
 
 protected:
 	void updateWidgets() override;
+	void fillContextMenu(QMenu*) override;
 
 private:
 	QLineEdit* new_led(cstr);
@@ -102,15 +102,10 @@ void KempstonMouseInsp::updateWidgets()
 
 	if (QApplication::keyboardModifiers() & Qt::CTRL) { mouse.ungrab(); }
 
-	uint8 newx, newy;
-	uint  newbuttons;
-
-	{
-		auto mouse = nvptr(mif);
-		newx	   = mouse->getXPos();
-		newy	   = mouse->getYPos();
-		newbuttons = mouse->getButtons();
-	}
+	// plain values: read them without locking the machine
+	uint8 newx		 = mif->getXPos();
+	uint8 newy		 = mif->getYPos();
+	uint  newbuttons = mif->getButtons();
 
 	if (old_x != newx)
 	{
@@ -6,6 +6,7 @@
 #include "MemoryAccessInspector.h"
 #include "Machine.h"
 #include "MachineController.h"
+#include "MemoryAccessCounter.h"
 #include "MemoryInspector.h"
 #include "Qt/MyLineEdit.h"
 #include "Qt/Settings.h"
@@ -104,16 +105,14 @@ void GWidgetRGB::paintEvent(QPaintEvent*)
 
 MemoryAccessInspector::MemoryAccessInspector(QWidget* parent, MachineController* mc, volatile IsaObject* item) :
 	MemoryInspector(parent, mc, item, MemAccess),
-	rom_pixels(NV(machine->rom).count()),
-	ram_pixels(NV(machine->ram).count()),
+	rom_counter(new MemoryAccessCounter(NV(machine->rom))),
+	ram_counter(new MemoryAccessCounter(NV(machine->ram))),
+	painted_canvas(nullptr),
 	decay_mode(settings.get_int(key_memoryview_access_decaymode, modeDecayFast)),
 	pixel_size(settings.get_int(key_memoryview_access_pixelsize, MIN_PIXEL_SIZE))
 {
 	xlogIn("new MemoryAccessInspector");
 
-	assert(cpu_r_access == 1 << 16);
-	assert(cpu_w_access == cpu_r_access << 1);
-	assert(cpu_x_access == cpu_r_access << 2);
 	assert(machine);
 	assert(item);
 
@@ -123,14 +122,7 @@ MemoryAccessInspector::MemoryAccessInspector(QWidget* parent, MachineController*
 	validate_rows();
 	validate_scrollposition();
 
-	{
-		NVPtr<Machine> machine(this->machine);
-		CoreByte*	   data;
-		data = machine->ram.getData();
-		for (int32 i = machine->ram.count(); i;) data[--i] |= cpu_access;
-		data = machine->rom.getData();
-		for (int32 i = machine->rom.count(); i;) data[--i] |= cpu_access;
-	}
+	// the access flags are only set in the armed pages, see updateWidgets():
 	machine->cpu_options |= cpu_access;
 
 
@@ -194,7 +186,12 @@ MemoryAccessInspector::MemoryAccessInspector(QWidget* parent, MachineController*
 }
 
 
-MemoryAccessInspector::~MemoryAccessInspector() { save_settings(); }
+MemoryAccessInspector::~MemoryAccessInspector()
+{
+	save_settings();
+	delete rom_counter; // clears the access flags in memory
+	delete ram_counter;
+}
 
 void MemoryAccessInspector::saveSettings()
 {
@@ -251,88 +248,52 @@ void MemoryAccessInspector::validate_scrollposition()
 	scroll_offset = max(scroll_offset, 0);
 }
 
-void MemoryAccessInspector::copy_access_bits_to_pixels(MemoryPtr mem, Array<QRgb>& dest)
+inline QRgb weighted_color(QRgb pixel)
 {
-	// copy cpu_access bits from memory to buffer
-	// and clear access bits in memory
-
-	assert(mem.count() == dest.count());
-
-	// color definition for read, write, execute and alpha:
-	const QRgb	r = 0x000000ff, w = 0x0000ff00, x = 0x00ff0000, a = 0xff000000;
-	static QRgb rgb[] = {0, a + r, a + w, a + r + w, a + x, a + x + r, a + x + w, a + x + r + w}; // bit 2,1,0 = x,w,r
-
-	QRgb*	  pixels = dest.getData();
-	CoreByte* memptr = mem.getData();
+	// adjust brightness of color components for display:
+	// green and red are much brighter than blue and are therefore dimmed
+	// for a balanced brightness experience
 
-	for (int bits, i = mem.count(); --i >= 0;)
-	{
-		if ((bits = ~memptr[i] & cpu_access)) // wurde eines der Bits seit letztem Mal gelöscht?
-		{
-			pixels[i] |= rgb[bits / cpu_r_access]; // entsprechend gefärbtes Pixel im Puffer setzen
-			memptr[i] |= cpu_access;			   // und Bits wieder setzen
-		}
-	}
+	if (pixel & 0x00ff0000) pixel -= (pixel & 0x00fc0000) / 4;							   // red		 -1/4
+	if (pixel & 0x0000ff00) pixel -= (pixel & 0x0000fc00) / 4 + (pixel & 0x0000f000) / 16; // green  ~  -1/3
+	return pixel;
 }
 
-void MemoryAccessInspector::prepare_for_fast_decay(Array<QRgb>& mem)
+inline QRgb pixel_for_counter(const MemoryAccessCounter::Counter& c)
 {
-	// prepare buffer for display in fast decay mode:
-	// fast decaying subtracts 5 and must hit 0 for end condition
-
-	QRgb pixel, *a = mem.getData(), *e = a + mem.count();
+	// color for read, write and execute: blue, green and red
+	// alpha = 0 for not accessed bytes
 
-	while (a < e)
-	{
-		if ((pixel = *--e))
-		{
-			QRgb r = ((pixel & 0xff0000) >> 16) / 5 * 5;
-			QRgb g = ((pixel & 0x00ff00) >> 8) / 5 * 5;
-			QRgb b = ((pixel & 0x0000ff)) / 5 * 5;
-			*e	   = 0xff000000 + (r << 16) + (g << 8) + b;
-		}
-	}
+	QRgb pixel = (c.x << 16) + (c.w << 8) + c.r;
+	return pixel ? weighted_color(0xff000000 + pixel) : 0;
 }
 
-void MemoryAccessInspector::decay_pixel(Array<QRgb>& mem, int decay)
+void MemoryAccessInspector::paint_row(int row, const RowSource& src)
 {
-	// decay pixels in buffer:
-	// color components must be a multiple of 'decay'
-	// or overfow to other color component will occur
+	// paint one row of cells into the canvas
+	// cells are pixel_size-1 pixels wide and high, plus 1 pixel black spacing
 
-	QRgb pixel, *a = mem.getData(), *e = a + mem.count();
+	const int d = pixel_size;
+	assert(graphics_view->canvas->width() >= d * bytes_per_row + 1);
+	assert(graphics_view->canvas->height() >= d * rows + 1);
 
-	QRgb r = decay << 16;
-	QRgb g = decay << 8;
-	QRgb b = decay;
+	const MemoryAccessCounter::Counter* q = nullptr;
 
-	while (a < e)
+	for (int i = 0; i < bytes_per_row; i++)
 	{
-		if ((pixel = *--e))
+		uint32 offset = src.offset + uint32(i);
+		if (src.counter && (i == 0 || (offset & (MemoryAccessCounter::page_size - 1)) == 0))
 		{
-			if (pixel & 0x0000ff) pixel -= b;
-			if (pixel & 0x00ff00) pixel -= g;
-			if (pixel & 0xff0000) pixel -= r;
-			*e = pixel;
+			q = offset < src.counter->count() ? src.counter->counters(offset) : nullptr;
 		}
-	}
-}
-
-inline void MemoryAccessInspector::clear_pixel(Array<QRgb>& mem)
-{
-	// set pixels in Array to 0x00000000 (~ full transparent black)
-	memset(mem.getData(), 0, mem.count() * sizeof(QRgb));
-}
 
-inline QRgb weighted_color(QRgb pixel)
-{
-	// adjust brightness of color components for display:
-	// green and red are much brighter than blue and are therefore dimmed
-	// for a balanced brightness experience
-
-	if (pixel & 0x00ff0000) pixel -= (pixel & 0x00fc0000) / 4;							   // red		 -1/4
-	if (pixel & 0x0000ff00) pixel -= (pixel & 0x0000fc00) / 4 + (pixel & 0x0000f000) / 16; // green  ~  -1/3
-	return pixel;
+		QRgb pixel = q ? pixel_for_counter(*q++) : 0;
+		for (int y = 1; y < d; y++)
+		{
+			QRgb* z = graphics_view->scanLine(row * d + y) + 1 + i * d;
+			for (int x = 0; x < d - 1; x++) z[x] = pixel;
+		}
+	}
 }
 
 
@@ -386,8 +347,8 @@ void MemoryAccessInspector::slotMemoryConfigChanged(Memory* m, uint how)
 	assert(isMainThread());
 	assert(controller->getMachine() == machine);
 
-	rom_pixels.resize(NV(machine->rom).count());
-	ram_pixels.resize(NV(machine->ram).count());
+	rom_counter->setMemory(NV(machine->rom));
+	ram_counter->setMemory(NV(machine->ram));
 	MemoryInspector::slotMemoryConfigChanged(m, how);
 }
 
@@ -396,15 +357,7 @@ void MemoryAccessInspector::slotSetDecayMode(int m)
 	//	slot for combobox_decaymode
 	//	argument is index in combobox
 
-	if (m != decay_mode)
-	{
-		if (m == modeDecayFast)
-		{
-			prepare_for_fast_decay(rom_pixels);
-			prepare_for_fast_decay(ram_pixels);
-		}
-		decay_mode = m;
-	}
+	decay_mode = m;
 }
 
 void MemoryAccessInspector::slotSetPixelSize(int i)
@@ -442,8 +395,8 @@ void MemoryAccessInspector::updateWidgets()
 
 	assert(isMainThread());
 	assert(controller->getMachine() == machine);
-	assert(rom_pixels.count() == NV(machine->rom).count());
-	assert(ram_pixels.count() == NV(machine->ram).count());
+	assert(rom_counter->count() == NV(machine->rom).count());
+	assert(ram_counter->count() == NV(machine->ram).count());
 
 	// these might happen in a race condition after slotSetXxx:
 	if (graphics_view->canvas->width() != bytes_per_row * pixel_size + 1)
@@ -470,34 +423,9 @@ void MemoryAccessInspector::updateWidgets()
 	// update parent:
 	MemoryInspector::updateWidgets();
 
-	// fade old pixels according to 'mode' setting:
-	switch (decay_mode)
-	{
-	case modeFlash:				 // show only what was accessed since last update
-		clear_pixel(ram_pixels); // pixel=0 => black, no decaying color here,
-		clear_pixel(rom_pixels); // needs not (and must not: alpha=0!) be drawn
-		break;
-	case modeDecayFast: // decay previous access
-		decay_pixel(rom_pixels, 5);
-		decay_pixel(ram_pixels, 5);
-		break;
-	case modeDecaySlow: // decay previous access
-		decay_pixel(rom_pixels, 1);
-		decay_pixel(ram_pixels, 1);
-		break;
-	case modeAccumulate: // don't decay/clear old access
-		break;
-	}
-
-	// update with new access bits:
-	{
-		// no need to lock because we are on the main thread which is the only allowed to add/remove items
-		copy_access_bits_to_pixels(NV(machine->rom), rom_pixels);
-		copy_access_bits_to_pixels(NV(machine->ram), ram_pixels);
-	}
-
-	// create map for row -> pixels[]
-	Array<QRgb*> pixelrows(rows);
+	// create map for row -> counters:
+	Array<RowSource> rowsources(rows);
+	for (int r = 0; r < rows; r++) rowsources[r] = RowSource {nullptr, 0};
 	switch (data_source)
 	{
 	case AsSeenByCpu:
@@ -512,112 +440,74 @@ void MemoryAccessInspector::updateWidgets()
 		for (int r = min(rows, (0x10000 - scroll_offset) / bytes_per_row); r--;)
 		{
 			CoreByte* p = cpu->rdPtr(scroll_offset + r * bytes_per_row);
-			if (p >= romptr && p < romptr + romsize) pixelrows[r] = rom_pixels.getData() + (p - romptr);
+			if (p >= romptr && p < romptr + romsize) rowsources[r] = RowSource {rom_counter, uint32(p - romptr)};
 			else if (p >= ramptr && p < ramptr + ramsize)
-				pixelrows[r] = ram_pixels.getData() + (p - ramptr); // else unmapped cpu address -> nullptr
+				rowsources[r] = RowSource {ram_counter, uint32(p - ramptr)}; // else unmapped cpu address
 		}
 		break;
 	}
 	case AllRam:
 	case RamPages:
 	{
-		QRgb* p = &ram_pixels[data.baseoffset + scroll_offset];
-		int	  r = min(rows, (data.size - scroll_offset) / bytes_per_row);
-		while (r--) { pixelrows[r] = p + r * bytes_per_row; }
+		uint32 offset = uint32(data.baseoffset + scroll_offset);
+		int	   r	  = min(rows, (data.size - scroll_offset) / bytes_per_row);
+		while (r--) { rowsources[r] = RowSource {ram_counter, offset + uint32(r * bytes_per_row)}; }
 		break;
 	}
 	case AllRom:
 	case RomPages:
 	{
-		QRgb* p = &rom_pixels[data.baseoffset + scroll_offset];
-		int	  r = min(rows, (data.size - scroll_offset) / bytes_per_row);
-		while (r--) { pixelrows[r] = p + r * bytes_per_row; }
+		uint32 offset = uint32(data.baseoffset + scroll_offset);
+		int	   r	  = min(rows, (data.size - scroll_offset) / bytes_per_row);
+		while (r--) { rowsources[r] = RowSource {rom_counter, offset + uint32(r * bytes_per_row)}; }
 		break;
 	}
 	}
 
-	// paint pixels into canvas:
-	graphics_view->canvas->fill(Qt::black);
-	switch (pixel_size)
-	{
-	case 3: // 2*2 pixel
+	// arm the visible pages for tracking:
+	for (int r = 0; r < rows; r++)
 	{
-		QRgb	  pixel;
-		const int d = 3;
-		assert(graphics_view->canvas->width() >= d * bytes_per_row);
-		assert(graphics_view->canvas->height() >= d * rows);
-
-		for (int r = 0; r < rows; r++)
-		{
-			QRgb* q = pixelrows[r];
-			if (q == nullptr) continue;
-			QRgb* z0 = graphics_view->scanLine(r * d + 1) + 1;
-			QRgb* z1 = graphics_view->scanLine(r * d + 2) + 1;
-
-			for (int zi = 0; zi < d * bytes_per_row; zi += d)
-			{
-				if ((pixel = *q++)) { z0[zi] = z1[zi] = z0[zi + 1] = z1[zi + 1] = weighted_color(pixel); }
-			}
-		}
-		break;
+		if (rowsources[r].counter) rowsources[r].counter->arm(rowsources[r].offset, uint32(bytes_per_row));
 	}
-
-	case 4: // 3*3 pixel
+	rom_counter->disarmUnused();
+	ram_counter->disarmUnused();
+
+	// update counters with new access flags:
+	// the increment and decay per update are chosen according to 'mode' setting:
+	// frequently accessed bytes saturate, rarely accessed bytes stay dim
+	static const uint increment[] = {255, 85, 32, 8}; // flash, decay fast, decay slow, accumulate
+	static const uint decay[]	  = {255, 5, 1, 0};
+	rom_counter->update(increment[decay_mode], decay[decay_mode]);
+	ram_counter->update(increment[decay_mode], decay[decay_mode]);
+
+	// paint rows into canvas which show a changed page or a different source than before:
+	if (painted_canvas != graphics_view->canvas || painted_rows.count() != uint(rows)) updateAll();
+	if (update_all)
 	{
-		QRgb	  pixel;
-		const int d = 4;
-		assert(graphics_view->canvas->width() >= d * bytes_per_row);
-		assert(graphics_view->canvas->height() >= d * rows);
-
-		for (int r = 0; r < rows; r++)
-		{
-			QRgb* q = pixelrows[r];
-			if (q == nullptr) continue;
-			QRgb* z0 = graphics_view->scanLine(r * d + 1) + 1;
-			QRgb* z1 = graphics_view->scanLine(r * d + 2) + 1;
-			QRgb* z2 = graphics_view->scanLine(r * d + 3) + 1;
-
-			for (int zi = 0; zi < d * bytes_per_row; zi += d)
-			{
-				if ((pixel = *q++))
-				{
-					z0[zi] = z1[zi] = z2[zi] = z0[zi + 1] = z1[zi + 1] = z2[zi + 1] = z0[zi + 2] = z1[zi + 2] =
-						z2[zi + 2] = weighted_color(pixel);
-				}
-			}
-		}
-		break;
+		graphics_view->canvas->fill(Qt::black);
+		painted_canvas = graphics_view->canvas;
+		painted_rows.resize(uint(rows));
 	}
 
-	case 5: // 4*4 pixel
+	for (int r = 0; r < rows; r++)
 	{
-		QRgb	  pixel;
-		const int d = 5;
-		assert(graphics_view->canvas->width() >= d * bytes_per_row);
-		assert(graphics_view->canvas->height() >= d * rows);
-
-		for (int r = 0; r < rows; r++)
+		const RowSource& src = rowsources[r];
+		bool			 f	 = update_all || src != painted_rows[r];
+		if (!f && src.counter)
 		{
-			QRgb* q = pixelrows[r];
-			if (q == nullptr) continue;
-			QRgb* z0 = graphics_view->scanLine(r * d + 1) + 1;
-			QRgb* z1 = graphics_view->scanLine(r * d + 2) + 1;
-			QRgb* z2 = graphics_view->scanLine(r * d + 3) + 1;
-			QRgb* z3 = graphics_view->scanLine(r * d + 4) + 1;
-
-			for (int zi = 0; zi < d * bytes_per_row; zi += d)
-			{
-				if ((pixel = *q++))
-				{
-					z0[zi] = z1[zi] = z2[zi] = z3[zi] = z0[zi + 1] = z1[zi + 1] = z2[zi + 1] = z3[zi + 1] = z0[zi + 2] =
-						z1[zi + 2] = z2[zi + 2] = z3[zi + 2] = z0[zi + 3] = z1[zi + 3] = z2[zi + 3] = z3[zi + 3] =
-							weighted_color(pixel);
-				}
-			}
+			uint32 a = src.offset & ~(MemoryAccessCounter::page_size - 1);
+			uint32 e = min(src.offset + uint32(bytes_per_row), src.counter->count());
+			for (; !f && a < e; a += MemoryAccessCounter::page_size) f = src.counter->isDirty(a);
 		}
-		break;
-	}
+		if (!f) continue;
+
+		paint_row(r, src);
+		painted_rows[r] = src;
 	}
+	update_all = false;
+
+	rom_counter->clearDirty();
+	ram_counter->clearDirty();
 
 	// update tooltip:
 	update_tooltip();
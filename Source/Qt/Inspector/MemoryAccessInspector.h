@@ -7,6 +7,8 @@
 #include "MemoryInspector.h"
 #include "Templates/Array.h"
 class QComboBox;
+class QImage;
+class MemoryAccessCounter;
 
 
 namespace gui
@@ -21,8 +23,17 @@ class MemoryAccessInspector : public MemoryInspector
 	QComboBox*	combobox_decaymode;
 	enum { modeFlash, modeDecayFast, modeDecaySlow, modeAccumulate };
 
-	Array<QRgb> rom_pixels;
-	Array<QRgb> ram_pixels;
+	MemoryAccessCounter* rom_counter;
+	MemoryAccessCounter* ram_counter;
+
+	struct RowSource
+	{
+		MemoryAccessCounter* counter; // nullptr = unmapped
+		uint32				 offset;
+		bool operator!=(const RowSource& q) const { return counter != q.counter || offset != q.offset; }
+	};
+	Array<RowSource> painted_rows;	 // source of the rows currently painted in the canvas
+	QImage*			 painted_canvas; // canvas of graphics_view when painted_rows[] was set
 
 	int decay_mode; // combobox_mode
 	int pixel_size; // combobox_zoom: 3 .. 5 incl. space between pixels
@@ -59,10 +70,7 @@ private:
 	int	 height_for_rows(int n);
 	int	 rows_for_height(int h);
 	int	 bytes_for_width(int w);
-	void decay_pixel(Array<QRgb>&, int);
-	void copy_access_bits_to_pixels(MemoryPtr, Array<QRgb>&);
-	void prepare_for_fast_decay(Array<QRgb>&);
-	void clear_pixel(Array<QRgb>&);
+	void paint_row(int row, const RowSource&);
 	void save_settings();
 	void validate_rows();
 	void validate_bytes_per_row();
@@ -13,6 +13,7 @@
 #include "zasm/Source/Z80Assembler.h"
 #include <QBoxLayout>
 #include <QComboBox>
+#include <QInputDialog>
 #include <QMouseEvent>
 #include <QPushButton>
 #include <QTimer>
@@ -76,6 +77,180 @@ public:
 };
 
 
+/*	Index of the opcode start addresses in the displayed data:
+
+	Opcodes are counted from the start of the data. This is the reference for stepping back,
+	which is ambiguous otherwise.
+	There is one bitmap per page of 1 kB. Pages are filled when they are used for the first time.
+	Each page depends on the last opcode of the previous page, which may cross the page boundary.
+
+	Each page keeps a copy of its bytes: after the machine ran, see touch(), a page is compared
+	with the memory when it is used again and filled again if it was modified.
+	Only the used pages are compared, which are the displayed pages, not all pages before them:
+	a modification in a page which is not used only shifts the opcode boundaries up to the next used page.
+	Modifications by the inspector itself must be reported with invalidate().
+	If the disassembler is replaced the index must be purged.
+*/
+class OpcodeIndex
+{
+	static constexpr uint page_bits = 10;
+	static constexpr uint page_size = 1 << page_bits;
+
+	struct Bitmap
+	{
+		uint32 serial; // serial when filled or last verified; 0 = not filled
+		uint8  entry;  // offset of the first opcode in this page
+		uint8  exit;   // offset of the first opcode in the next page
+		uint8  bytes[page_size];
+		uint32 bits[page_size / 32];
+	};
+
+	CoreByteDisassembler*& disass;
+	const Page&			   data;
+
+	int32	baseaddress; // of the indexed data
+	int32	size;		 // of the indexed data
+	uint	num_pages;
+	Bitmap* pages;
+	uint32	serial; // incremented by touch()
+
+	void	fill(uint i, uint entry);
+	bool	verify(uint i, uint entry);
+	Bitmap& page(uint i);
+
+public:
+	OpcodeIndex(CoreByteDisassembler*& disass, const Page& data) :
+		disass(disass),
+		data(data),
+		baseaddress(0),
+		size(0),
+		num_pages(0),
+		pages(nullptr),
+		serial(1)
+	{}
+	~OpcodeIndex() { delete[] pages; }
+	NO_COPY_MOVE(OpcodeIndex);
+
+	void  purge();
+	void  invalidate(int32 address, int n = 1); // the inspector modified the data
+	void  touch() { serial++; }					 // the machine may have modified the data
+	bool  isStart(int32 address);
+	int32 startOf(int32 address); // start of the opcode which contains address
+	int32 prev(int32 address)	  // start of the opcode before address
+	{
+		return address > data.baseaddress ? startOf(min(address, data.baseaddress + data.size) - 1) : address;
+	}
+};
+
+
+void OpcodeIndex::purge()
+{
+	// discard the whole index
+	// resize it if the data range has changed
+
+	baseaddress = data.baseaddress;
+	size		= data.size;
+
+	uint n = uint(size + page_size - 1) >> page_bits;
+	if (n != num_pages)
+	{
+		delete[] pages;
+		pages	  = new Bitmap[n];
+		num_pages = n;
+	}
+	for (uint i = 0; i < n; i++) pages[i].serial = 0;
+}
+
+void OpcodeIndex::fill(uint i, uint entry)
+{
+	// disassemble page i, starting with an opcode at offset 'entry'
+
+	Bitmap& pg = pages[i];
+	int32	a0 = baseaddress + int32(i << page_bits);
+	uint32	n  = min(uint32(size) - (i << page_bits), page_size);
+
+	for (uint32 j = 0; j < n; j++) pg.bytes[j] = disass->peek(a0 + j);
+	memset(pg.bits, 0, sizeof(pg.bits));
+
+	uint32 j = entry;
+	for (; j < n; j += disass->opcodeLength(a0 + j)) pg.bits[j >> 5] |= 1u << (j & 31);
+
+	pg.serial = serial;
+	pg.entry  = uint8(entry);
+	pg.exit	  = uint8(j - n);
+}
+
+bool OpcodeIndex::verify(uint i, uint entry)
+{
+	// test whether page i is still valid
+	// it must be filled with the same entry and the memory must not have changed
+
+	Bitmap& pg = pages[i];
+	if (pg.serial == 0 || pg.entry != entry) return false;
+	if (pg.serial == serial) return true;
+
+	int32  a0 = baseaddress + int32(i << page_bits);
+	uint32 n  = min(uint32(size) - (i << page_bits), page_size);
+	for (uint32 j = 0; j < n; j++)
+	{
+		if (pg.bytes[j] != disass->peek(a0 + j)) return false;
+	}
+
+	pg.serial = serial;
+	return true;
+}
+
+OpcodeIndex::Bitmap& OpcodeIndex::page(uint i)
+{
+	// get bitmap for page i
+	// fill all pages before page i which were never filled, then verify or fill page i
+	// pages before page i which were filled are not verified: this would be O(memory) after each touch()
+
+	uint a = i;
+	while (a > 0 && pages[a - 1].serial == 0) a--;
+
+	for (; a <= i; a++)
+	{
+		uint entry = a ? pages[a - 1].exit : 0;
+		if (!verify(a, entry)) fill(a, entry);
+	}
+	return pages[i];
+}
+
+void OpcodeIndex::invalidate(int32 address, int n)
+{
+	// bytes in range [address .. address+n[ were modified
+
+	for (int32 a = address; a < address + n; a++)
+	{
+		uint i = uint(a - baseaddress) >> page_bits;
+		if (i < num_pages) pages[i].serial = 0;
+	}
+}
+
+bool OpcodeIndex::isStart(int32 address)
+{
+	if (baseaddress != data.baseaddress || size != data.size) purge();
+
+	uint32 offset = uint32(address - baseaddress);
+	assert(offset < uint32(size));
+
+	Bitmap& pg = page(offset >> page_bits);
+	offset &= page_size - 1;
+	return (pg.bits[offset >> 5] >> (offset & 31)) & 1;
+}
+
+int32 OpcodeIndex::startOf(int32 address)
+{
+	// find the start of the opcode which contains address
+	// an opcode is at most 4 bytes long: at most 3 steps back
+
+	address = minmax(data.baseaddress, address, data.baseaddress + data.size - 1);
+	while (address > data.baseaddress && !isStart(address)) address--;
+	return address;
+}
+
+
 // ==================================================================================
 // ==================   Memory Disassemble Inspector Widget  ========================
 // ==================================================================================
@@ -96,6 +271,7 @@ MemoryDisassInspector::MemoryDisassInspector(QWidget* parent, MachineController*
 	button_breakpoint_w(nullptr),
 	button_breakpoint_x(nullptr),
 	button_edit_mode(nullptr),
+	opcode_index(new OpcodeIndex(disass, data)),
 	displayed_data(MAX_ROWS * 4 + 1),
 	cw(0),
 	rh(0),
@@ -190,13 +366,22 @@ MemoryDisassInspector::MemoryDisassInspector(QWidget* parent, MachineController*
 	button_breakpoint_x->setFixedSize(W, H);
 	button_breakpoint_x->setCheckable(1);
 	button_breakpoint_x->setStyleSheet("color: rgb(200,0,0)"); // red
+
+	for (QPushButton* b : {button_breakpoint_r, button_breakpoint_w, button_breakpoint_x})
+	{
+		b->setToolTip("Click to set or clear breakpoints.\nShift-click in the disassembly to edit the condition.");
+	}
 	toolbar->addWidget(widget_edit_mode);
 
 	toolbar->addWidget(newComboboxRegister());
 }
 
 
-MemoryDisassInspector::~MemoryDisassInspector() { delete disass; }
+MemoryDisassInspector::~MemoryDisassInspector()
+{
+	delete opcode_index;
+	delete disass;
+}
 
 
 // ==============================================================================
@@ -236,16 +421,13 @@ void MemoryDisassInspector::validate_scrollposition()
 	if (scroll_offset <= data.size - 4 * rows) return;
 
 	// else count remaining opcodes to see if disassembly will fill all rows:
-	int r = 0;
-	for (int32 a = scroll_offset; r < rows && a < data.size; a += disass->opcodeLength(a)) r++;
+	int32 a_end = data.baseaddress + data.size;
+	int	  r		= 0;
+	for (int32 a = data.baseaddress + scroll_offset; r < rows && a < a_end; a += disass->opcodeLength(a)) r++;
 	if (r == rows) return;
 
-	// else step back and find latest possible scroll_offset:
-	int32 a0 = scroll_offset - (rows - r) * 4 - 16;
-	r		 = 0;
-	for (int32 a = a0; a < data.size; a += disass->opcodeLength(a)) r++;
-	while (r-- > rows) a0 += disass->opcodeLength(a0);
-	scroll_offset = a0;
+	// else step back from the end and find latest possible scroll_offset:
+	scroll_offset = prev_opcode(a_end, rows - 1, yes) - data.baseaddress;
 }
 
 inline bool MemoryDisassInspector::editing_in_hex() { return hex_view->hasFocus(); }
@@ -312,15 +494,9 @@ int MemoryDisassInspector::displayed_data_row_for_address(int32 address)
 
 int32 MemoryDisassInspector::start_of_opcode(int32 address)
 {
-	// Note: Stepping back is ambiguous!
-	// Note: Unprecise if running machine modifies code!
+	// Note: Stepping back is ambiguous: opcodes are counted from data.baseaddress, see OpcodeIndex.
 
-	for (int32 a = max(address - 16, data.baseaddress);;)
-	{
-		int n = disass->opcodeLength(a);
-		if (a + n > address) return a;
-		a += n;
-	}
+	return opcode_index->startOf(address);
 }
 
 int32 MemoryDisassInspector::prev_opcode(int32 address)
@@ -329,25 +505,14 @@ int32 MemoryDisassInspector::prev_opcode(int32 address)
 	// assumes that displayed_data[] is valid
 	// assumes that address points to the start of an opcode
 	// if address points inside an opcode, the start of that opcode is returned
-	// note: stepping back is ambiguous!
+	// note: stepping back is ambiguous: outside the displayed rows opcodes are counted from data.baseaddress
 
 	if (address > displayed_data[0].address && address <= displayed_data[rows - 1].address)
 	{
 		uint row = displayed_data_row_for_address(address);
 		return displayed_data[address > displayed_data[row].address ? row : row - 1].address;
 	}
-	else
-	{
-		address		= min(address, data.baseaddress + data.size);
-		int32 addr0 = data.baseaddress;
-		int32 addr1 = max(address - 16, data.baseaddress);
-		while (addr1 < address)
-		{
-			addr0 = addr1;
-			addr1 += disass->opcodeLength(addr1);
-		}
-		return addr0;
-	}
+	else return opcode_index->prev(address);
 }
 
 int32 MemoryDisassInspector::prev_opcode(int32 address, int n, bool count_partial_opcode)
@@ -357,27 +522,17 @@ int32 MemoryDisassInspector::prev_opcode(int32 address, int n, bool count_partia
 	// 	count_partial_opcode==0: wird der angebrochene Opcode nicht mitgezählt.
 	// 	count_partial_opcode==1: wird der angebrochene Opcode mitgezählt.
 	// • Stops at address 0.
-	// • Note: Stepping back is ambiguous!
+	// • Note: Stepping back is ambiguous: opcodes are counted from data.baseaddress, see OpcodeIndex.
 
 	assert(n >= 0);
 
 	if (data.baseaddress + n >= address) return data.baseaddress;
 	if (address > data.baseaddress + data.size) address = data.baseaddress + data.size;
+	else if (!count_partial_opcode && opcode_index->startOf(address) != address) n += 1;
 
-	int	  sz	= n * 4 + 12;
-	int32 addr1 = max(address - sz, data.baseaddress);
-	int32 addr[sz];
-	int	  i = 0;
-
-	while (addr1 < address)
-	{
-		addr[i++] = addr1;
-		addr1 += disass->opcodeLength(addr1);
-	}
-
-	if (addr1 > address && !count_partial_opcode) n += 1;
-
-	return i > n ? addr[i - 1 - n] : data.baseaddress;
+	address = opcode_index->prev(address);
+	while (n-- && address > data.baseaddress) address = opcode_index->prev(address);
+	return address;
 }
 
 void MemoryDisassInspector::print_byte_at_address(int32 addr)
@@ -486,6 +641,8 @@ void MemoryDisassInspector::assemble_and_store_opcode()
 	{
 		((FourBytes*)disass->pointer(disass_edit_address + i))->data = NOP;
 	}
+
+	opcode_index->invalidate(disass_edit_address, max(opcode_size, old_opcode_size));
 }
 
 int MemoryDisassInspector::print_row(int row, int32 address)
@@ -762,6 +919,7 @@ void MemoryDisassInspector::slotSetDataSource(int newdatasource)
 		disass = new CoreDisass(NV(machine->ram).getData() + data.baseoffset, data.size, data.baseaddress);
 		break;
 	}
+	opcode_index->purge();
 
 	hex_view->clearFocus();
 	disass_view->clearFocus();
@@ -790,6 +948,7 @@ void MemoryDisassInspector::slotSetMemoryPage(int newpage)
 
 	//TODO: stores an unprotected pointer!!
 	disass = new CoreDisass(&(mem[data.baseoffset]), data.size, data.baseaddress);
+	opcode_index->purge();
 
 	hex_view->clearFocus();
 	disass_view->clearFocus();
@@ -819,6 +978,19 @@ void MemoryDisassInspector::slotSetAddressFromRegister(int reg)
 	follow_pc		   = pageOffsetForCpuAddress(address) != -1;
 }
 
+void MemoryDisassInspector::slotMemoryConfigChanged(Memory* m, uint how)
+{
+	// memory was added, removed or modified:
+	// the memory contents may have changed => discard the opcode index
+
+	xlogIn("MemoryDisassInspector.slotMemoryConfigChanged");
+
+	MemoryInspector::slotMemoryConfigChanged(m, how);
+	opcode_index->purge();
+	validate_scrollposition();
+	updateScrollbar();
+}
+
 void MemoryDisassInspector::slotSetEditMode(bool f)
 {
 	xlogIn("MemoryDisassInspector.slotSetEditMode");
@@ -890,7 +1062,9 @@ void MemoryDisassInspector::slotSetScrollPosition(int32 new_scrollposition)
 
 	if (fabs(delta_rows) > rows + 0.5) // beyond paging
 	{
-		scroll_offset = start_of_opcode(scroll_offset + (delta_rows + 0.5) * bytes_per_row);
+		scroll_offset =
+			start_of_opcode(data.baseaddress + scroll_offset + int32((delta_rows + 0.5) * bytes_per_row)) -
+			data.baseaddress;
 	}
 	else if (delta_rows < 0) // small movement or paging down
 	{
@@ -898,7 +1072,8 @@ void MemoryDisassInspector::slotSetScrollPosition(int32 new_scrollposition)
 	}
 	else // small movement or paging up
 	{
-		for (int r = 0; r < ceil(delta_rows); r++) scroll_offset += disass->opcodeLength(scroll_offset);
+		for (int r = 0; r < ceil(delta_rows); r++)
+			scroll_offset += disass->opcodeLength(data.baseaddress + scroll_offset);
 	}
 
 	xlogline("--> display_base_address = %i", int(scroll_offset));
@@ -916,7 +1091,7 @@ void MemoryDisassInspector::updateScrollbar()
 	assert(controller->getMachine() == machine);
 
 	int visible_bytes = 0;
-	for (int r = 0; r < rows; r++) visible_bytes += disass->opcodeLength(scroll_offset + visible_bytes);
+	for (int r = 0; r < rows; r++) visible_bytes += disass->opcodeLength(data.baseaddress + scroll_offset + visible_bytes);
 	double bytes_per_row = double(visible_bytes) / rows;
 
 	scrollbar->blockSignals(true);
@@ -952,6 +1127,9 @@ void MemoryDisassInspector::updateWidgets()
 		}
 	}
 
+	// the machine may have modified the code:
+	opcode_index->touch();
+
 	// update parent:
 	MemoryInspector::updateWidgets();
 
@@ -1057,10 +1235,18 @@ void MemoryDisassInspector::mousePressEvent(QMouseEvent* e)
 			{
 				NVPtr<Machine> z(machine); //TODO this doesn't help. disass->pointer() may be invalid
 				CoreByte*	   cb = (CoreByte*)(disass->pointer(address + col / 2));
-				if ((*cb & breakpoint_mask) == breakpoint_mask) { *cb &= ~breakpoint_mask; }
+				if ((*cb & breakpoint_mask) == breakpoint_mask)
+				{
+					*cb &= ~breakpoint_mask;
+					z->cpu->getBreakpoints().remove(cb, breakpoint_mask);
+				}
 				else { *cb |= breakpoint_mask; }
 			}
 		}
+		else if (e->modifiers() & Qt::ShiftModifier) // in disass: edit condition
+		{
+			edit_breakpoint_condition(address, opcodelen);
+		}
 		else // in disass
 		{
 			CoreByte sum = disass->peek_cb(address);
@@ -1068,13 +1254,59 @@ void MemoryDisassInspector::mousePressEvent(QMouseEvent* e)
 
 			NVPtr<Machine> z(machine); //TODO this doesn't help. disass->pointer() may be invalid
 			if ((sum & breakpoint_mask) == breakpoint_mask)
-				for (int i = 0; i < opcodelen; i++) { *(CoreByte*)disass->pointer(address + i) &= ~breakpoint_mask; }
+				for (int i = 0; i < opcodelen; i++)
+				{
+					CoreByte* cb = (CoreByte*)disass->pointer(address + i);
+					*cb &= ~breakpoint_mask;
+					z->cpu->getBreakpoints().remove(cb, breakpoint_mask);
+				}
 			else
 				for (int i = 0; i < opcodelen; i++) { *(CoreByte*)disass->pointer(address + i) |= breakpoint_mask; }
 		}
 	}
 }
 
+void MemoryDisassInspector::edit_breakpoint_condition(int32 address, int opcodelen)
+{
+	// ask for a condition for the selected breakpoint types
+	// and set these breakpoints with this condition on all bytes of the opcode
+	// the bytes share one condition, so COUNT counts the hits on the whole instruction
+	// an empty condition sets unconditional breakpoints
+
+	assert(breakpoint_mask);
+
+	QString condition;
+	{
+		NVPtr<Machine> z(machine);
+		CoreByte	   kind = breakpoint_mask & -breakpoint_mask; // lowest selected type
+		cstr		   s	= z->cpu->getBreakpoints().conditionAt((CoreByte*)disass->pointer(address), kind);
+		if (s) condition = s;
+	}
+
+	bool ok;
+	condition = QInputDialog::getText(
+		this, "Breakpoint condition",
+		"Stop only if the condition is true, e.g.:  A==$3F && (HL)>=$80  or  COUNT==100\n"
+		"Prefix 'log' for a tracepoint which only logs the registers.\n"
+		"Empty: always stop.",
+		QLineEdit::Normal, condition, &ok);
+	if (!ok) return;
+
+	try
+	{
+		NVPtr<Machine> z(machine);
+		CoreByte*	   cbs[4]; // max. opcode length
+		assert(opcodelen <= 4);
+		for (int i = 0; i < opcodelen; i++) cbs[i] = (CoreByte*)disass->pointer(address + i);
+		z->cpu->getBreakpoints().set(cbs, uint(opcodelen), breakpoint_mask, condition.toUtf8().data());
+		for (int i = 0; i < opcodelen; i++) *cbs[i] |= breakpoint_mask;
+	}
+	catch (DataError& e)
+	{
+		showAlert("%s", e.what());
+	}
+}
+
 void MemoryDisassInspector::keyPressEvent(QKeyEvent* e)
 {
 	assert(isMainThread());
@@ -1124,6 +1356,7 @@ void MemoryDisassInspector::keyPressEvent(QKeyEvent* e)
 				uint8& byte = dataReadPtrForOffset(hex_edit_address)->data;
 				if (hex_edit_col) byte = (byte & 0xF0) + (hex_digit_value(e->key()));
 				else byte = (byte & 0x0F) + (hex_digit_value(e->key()) << 4);
+				opcode_index->invalidate(hex_edit_address);
 				step_right_in_hex();
 				goto X;
 			}
@@ -14,6 +14,7 @@ namespace gui
 {
 class SimpleTerminal;
 class CoreByteDisassembler;
+class OpcodeIndex;
 
 struct DisassData
 {
@@ -35,6 +36,7 @@ class MemoryDisassInspector : public MemoryInspector
 	QPushButton* button_edit_mode;
 
 	CoreByteDisassembler* disass;
+	OpcodeIndex*		  opcode_index; // opcode start addresses: reference for stepping back
 	Array<DisassData>	  displayed_data;
 
 	int cw; // Character width
@@ -89,6 +91,7 @@ protected:
 	void slotSetDataSource(int) override;
 	void slotSetScrollPosition(int32) override;	   // scrollbar
 	void slotSetAddressFromRegister(int) override; // combobox_register, follow_pc in MemoryDisassInspector
+	void slotMemoryConfigChanged(Memory*, uint how) override;
 
 	void slotSetEditMode(bool);
 	void slotSetBreakpointR(bool f) { setBreakpoint(cpu_break_r, f); }
@@ -112,6 +115,7 @@ private:
 	int32 start_of_opcode(int32 address);
 	void  scroll_to_show_address(int32 address);
 	void  assemble_and_store_opcode();
+	void  edit_breakpoint_condition(int32 address, int opcodelen);
 	void  setBreakpoint(CoreByte mask, bool f);
 	void  validate_rows();
 	void  validate_scrollposition();
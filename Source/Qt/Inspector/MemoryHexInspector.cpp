@@ -1009,8 +1009,11 @@ void MemoryHexInspector::mousePressEvent(QMouseEvent* e)
 	{
 		if ((*byte1 & breakpoint_mask) == breakpoint_mask)
 		{
+			NVPtr<Machine> z(machine);
 			*byte1 &= ~breakpoint_mask;
 			*byte2 &= ~breakpoint_mask;
+			z->cpu->getBreakpoints().remove(byte1, breakpoint_mask);
+			z->cpu->getBreakpoints().remove(byte2, breakpoint_mask);
 		}
 		else
 		{
@@ -4,14 +4,82 @@
 
 
 #include "SmartSDCardInspector.h"
+#include "Machine.h"
+#include "Qt/qt_util.h"
+#include <QMenu>
 
 namespace gui
 {
 
 SmartSDCardInspector::SmartSDCardInspector(QWidget* p, MachineController* m, volatile SmartSDCard* o) :
-	Inspector(p, m, o)
+	Inspector(p, m, o),
+	smart_card(o)
 {}
 
 SmartSDCardInspector::~SmartSDCardInspector() {}
 
+void SmartSDCardInspector::fillContextMenu(QMenu* menu)
+{
+	Inspector::fillContextMenu(menu); // NOP
+	assert(validReference(smart_card));
+
+	QAction* action_card_wprot = new QAction("Write protected", menu);
+	action_card_wprot->setCheckable(true);
+	action_card_wprot->setChecked(!NV(smart_card)->isCardWritable());
+	action_card_wprot->setEnabled(smart_card->isCardInserted());
+	connect(action_card_wprot, &QAction::toggled, this, &SmartSDCardInspector::toggle_card_wprot);
+
+	QAction* action_zero_latency = new QAction("No card latency", menu);
+	action_zero_latency->setCheckable(true);
+	action_zero_latency->setChecked(smart_card->isCardZeroLatency());
+	connect(action_zero_latency, &QAction::toggled, this, &SmartSDCardInspector::toggle_zero_latency);
+
+	menu->addAction("Insert SD card …", this, &SmartSDCardInspector::insert_card);
+	menu->addAction("Eject SD card", this, &SmartSDCardInspector::eject_card);
+	menu->addAction(action_card_wprot);
+	menu->addAction(action_zero_latency);
+}
+
+void SmartSDCardInspector::insert_card()
+{
+	xlogline("SmartSDCardInspector: insert_card");
+	assert(validReference(smart_card));
+
+	cstr filter	  = "SD card images (*.img *.bin);;All Files (*)";
+	cstr filepath = selectLoadFile(this, "Insert SD card image", filter);
+	if (!filepath) return;
+
+	bool f = nvptr(machine)->suspend();
+	NV(smart_card)->insertCard(filepath);
+	if (f) machine->resume();
+}
+
+void SmartSDCardInspector::eject_card()
+{
+	xlogline("SmartSDCardInspector: eject_card");
+	assert(validReference(smart_card));
+
+	bool f = nvptr(machine)->suspend();
+	NV(smart_card)->ejectCard();
+	if (f) machine->resume();
+}
+
+void SmartSDCardInspector::toggle_card_wprot()
+{
+	assert(validReference(smart_card));
+
+	bool f = nvptr(machine)->suspend();
+	NV(smart_card)->toggleCardWritable();
+	if (f) machine->resume();
+}
+
+void SmartSDCardInspector::toggle_zero_latency()
+{
+	assert(validReference(smart_card));
+
+	bool f = nvptr(machine)->suspend();
+	NV(smart_card)->setCardZeroLatency(!smart_card->isCardZeroLatency());
+	if (f) machine->resume();
+}
+
 } // namespace gui
@@ -11,9 +11,20 @@ namespace gui
 
 class SmartSDCardInspector : public Inspector
 {
+	volatile SmartSDCard* smart_card;
+
 public:
 	SmartSDCardInspector(QWidget* p, MachineController* m, volatile SmartSDCard* o);
 	~SmartSDCardInspector() override;
+
+protected:
+	void fillContextMenu(QMenu*) override;
+
+private:
+	void insert_card();
+	void eject_card();
+	void toggle_card_wprot();
+	void toggle_zero_latency();
 };
 
 } // namespace gui
@@ -183,8 +183,8 @@ TapeRecorderInsp::TapeRecorderInsp(
 	btn_prev(nullptr),
 	btn_eject(nullptr),
 	btn_pause(nullptr),
-	major_block_info(""),
-	minor_block_info(""),
+	major_block_info {""},
+	minor_block_info {""},
 	tape_position(0),
 	major_block_info_label(new QLabel(this)),
 	minor_block_info_label(new QLabel(this)),
@@ -495,28 +495,28 @@ void TapeRecorderInsp::updateAnimation()
 	if (!is_visible) return;
 	assert(validReference(tr));
 
+	// the state published by the machine: don't lock the machine here!
+	MachineState state;
+	machine->getPublishedState(state);
+	const auto& tape = state.tape;
+
 	// update text fields:
 	{
-		cstr major, minor;
-		int	 p;
-		{
-			NVPtr<TapeRecorder> tr(this->tr);
-			major = tr->getMajorBlockInfo();
-			minor = tr->getMinorBlockInfo();
-			p	  = int(tr->getCurrentPosition());
-		}
+		cstr major = tape.major_info;
+		cstr minor = tape.recording ? durationstr(tape.block_position) : tape.minor_info;
+		int	 p	   = int(tape.position);
 
-		if (major_block_info != major)
+		if (!eq(major_block_info, major))
 		{
-			major_block_info = major;
-			major_block_info_label->setText(major ? major : " ");
+			strcpy(major_block_info, major);
+			major_block_info_label->setText(*major ? major : " ");
 			major_block_info_label->adjustSize();
 		}
 
-		if (minor_block_info != minor)
+		if (!eq(minor_block_info, minor))
 		{
-			minor_block_info = minor;
-			minor_block_info_label->setText(minor ? minor : " ");
+			strcpy(minor_block_info, minor);
+			minor_block_info_label->setText(*minor ? minor : " ");
 			minor_block_info_label->adjustSize();
 		}
 
@@ -539,14 +539,14 @@ void TapeRecorderInsp::updateAnimation()
 	Time now = system_time; // seconds-based time
 
 	// pause state change results in animation change only if tape loaded and playing:
-	if (anim_tr_state != TapeRecorder::playing || !anim_tr_loaded) { anim_tr_pause = tr->isPauseDown(); }
+	if (anim_tr_state != TapeRecorder::playing || !anim_tr_loaded) { anim_tr_pause = tape.pause_down; }
 
 	// animation change?
-	if (anim_tr_loaded != tr->isLoaded() || anim_tr_pause != tr->isPauseDown() || anim_tr_state != tr->state)
+	if (anim_tr_loaded != tape.loaded || anim_tr_pause != tape.pause_down || anim_tr_state != tape.state)
 	{
-		anim_tr_loaded = tr->isLoaded();
-		anim_tr_pause  = tr->isPauseDown();
-		anim_tr_state  = tr->state;
+		anim_tr_loaded = tape.loaded;
+		anim_tr_pause  = tape.pause_down;
+		anim_tr_state  = tape.state;
 		next_time_l = next_time_r = now + 0.05;
 		update();
 		return;
@@ -559,15 +559,13 @@ void TapeRecorderInsp::updateAnimation()
 
 		if (cass.head_pos == head_down)
 		{
-			NVPtr<TapeRecorder> tr(this->tr);
-			current_dia_r = reel_diameter_for_seconds(tr->getCurrentPosition());
-			current_dia_l = reel_diameter_for_seconds(tr->getTotalPlaytime() - tr->getCurrentPosition());
+			current_dia_r = reel_diameter_for_seconds(tape.position);
+			current_dia_l = reel_diameter_for_seconds(tape.playtime - tape.position);
 		}
 		else
 		{
-			NVPtr<TapeRecorder> tr(this->tr);
-			current_dia_l = reel_diameter_for_seconds(tr->getCurrentPosition());
-			current_dia_r = reel_diameter_for_seconds(tr->getTotalPlaytime() - tr->getCurrentPosition());
+			current_dia_l = reel_diameter_for_seconds(tape.position);
+			current_dia_r = reel_diameter_for_seconds(tape.playtime - tape.position);
 		}
 
 		int d = 1;
@@ -75,8 +75,8 @@ protected:
 	MySimpleToggleButton* btn_pause;
 
 	// labels:
-	cstr	   major_block_info; // displayed value
-	cstr	   minor_block_info; // displayed value
+	char	   major_block_info[64]; // displayed value
+	char	   minor_block_info[64]; // displayed value
 	int		   tape_position;	 // displayed value
 	QLabel*	   major_block_info_label;
 	QLabel*	   minor_block_info_label;
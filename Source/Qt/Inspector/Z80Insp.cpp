@@ -136,6 +136,7 @@ void Z80Insp::updateWidgets()
 {
 	// update displayed values
 	// called by QTimer started in this.c'tor
+	// reads the state published by the machine: don't lock the machine here!
 
 	xxlogIn("Z80Insp::update");
 	assert(validReference(cpu));
@@ -160,7 +161,10 @@ void Z80Insp::updateWidgets()
   }                                                 \
   while (0)
 
-	const volatile Z80Regs& regs = cpu->getRegisters();
+	MachineState state;
+	machine->getPublishedState(state);
+
+	const Z80Regs& regs = state.regs;
 	SetRR(pc);
 	SetRR(sp);
 	SetRR(bc);
@@ -193,21 +197,21 @@ void Z80Insp::updateWidgets()
 		im->setText(tostr(value.im));
 	}
 
-	if (cpu->cpuCycle() != value.cc)
+	if (state.cc != value.cc)
 	{
-		value.cc = cpu->cpuCycle();
+		value.cc = state.cc;
 		cc->setText(tostr(value.cc));
 	}
 
-	if (machine->cpu_clock != value.clock)
+	if (state.cpu_clock != value.clock)
 	{
-		value.clock = machine->cpu_clock;
+		value.clock = state.cpu_clock;
 		clock->setText(MHzStr(value.clock));
 	}
 
 	ie->setChecked(regs.iff1);
-	nmi->setChecked(cpu->nmiPending());
-	irpt->setChecked(cpu->interruptPending());
+	nmi->setChecked(state.nmi_pending);
+	irpt->setChecked(state.int_pending);
 }
 
 
@@ -142,8 +142,17 @@ void MachineController::updateSomeMenuItems()
 		{
 			if (machine->rzxIsLoaded())
 			{
-				if (!rzx_overlay) rzx_overlay = new RzxOverlay;
+				if (!rzx_overlay)
+				{
+					rzx_overlay		  = new RzxOverlay;
+					rzx_overlay->seek = [=](uint32 frame) { machine->rzxSeekFrame(frame); };
+				}
 				rzx_overlay->setRecording(is_recording);
+				if (is_playing)
+				{
+					NVPtr<Machine> m(machine.get());
+					rzx_overlay->setPosition(m->rzxCurrentFrame(), m->rzxFrameCount());
+				}
 				screen->setRzxOverlay(rzx_overlay);
 			}
 			else { screen->setRzxOverlay(nullptr); }
@@ -225,9 +234,23 @@ void MachineController::pollInputDevices()
 	volatile Machine* m = machine.get();
 	if (!m) return;
 
+	// compare with the state last sent, not with the state applied by the machine:
+	// else a change would be sent again and again until the machine applied it
+	if (sent_to != m)
+	{
+		sent_to = m;
+		for (uint i = 0; i < MAX_USB_JOYSTICKS; i++) sent_joystick_buttons[i] = m->peekJoystickButtons(JoystickID(2 + i));
+		sent_mouse_buttons = m->getMouseButtons();
+	}
+
 	for (uint i = 0; i < num_usb_joysticks; i++) //
 	{
-		m->joystick_buttons[2 + i] = NV(&usb_joysticks[i])->getState();
+		uint8 state = NV(&usb_joysticks[i])->getState();
+		if (state != sent_joystick_buttons[i])
+		{
+			sent_joystick_buttons[i] = state;
+			m->updateJoystickButtons(JoystickID(2 + i), state);
+		}
 	}
 
 	if (m->kbd_joystick_active) m->kbd_joystick_active -= 1;
@@ -245,8 +268,15 @@ void MachineController::pollInputDevices()
 		}
 
 		uint mb = QApplication::mouseButtons();
-		m->updateMouseButtons(MouseButtons(mb));
+		if (mb != sent_mouse_buttons)
+		{
+			sent_mouse_buttons = mb;
+			m->updateMouseButtons(MouseButtons(mb));
+		}
 	}
+
+	// events are applied by runForSound(): apply them if the machine does not run:
+	if (m->isSuspended() || m->isPowerOff()) NVPtr<Machine>(m)->applyPendingInputEvents();
 }
 
 
@@ -284,6 +314,7 @@ RCPtr<Machine> MachineController::newMachineForModel(Model model)
 	m->taperecorder->setAutoStartStopTape(auto_start);
 	m->taperecorder->setInstantLoadTape(fast_load);
 	m->installRomPatches();
+	m->setRunAheadFrames(uint(settings.get_int(key_run_ahead_frames, 0)));
 
 	return m;
 }
@@ -364,6 +395,7 @@ void MachineController::loadSnapshot(cstr filename)
 		action_RzxRecord->setChecked(false);
 		machine->rzxDispose();
 	}
+	machine->detachSnapshots(); // loading modifies the memory
 	RzxFile* rzx = nullptr;
 
 	try
@@ -848,6 +880,7 @@ void MachineController::createActions()
 	 });
 	action_enable_breakpoints =
 		newAction(NOICON, "Enable breakpoints", Qt::Key_B | SHIFT, [=](bool f) { enableBreakpoints(f); });
+	action_traceCpu = newAction(NOICON, "Record cpu trace", NOKEY, [=](bool f) { traceCpu(f); });
 
 	action_minimize		= newAction(NOICON, "Minimize", NOKEY, [=]() { showMinimized(); });
 	action_zoom[0]		= newAction(NOICON, "Size x 1", Qt::Key_1, [=]() { setWindowZoom(1); });
@@ -926,6 +959,7 @@ void MachineController::createActions()
 		NOICON, "SPECTRA video interface", NOKEY, [=](bool f) { addSpectraVideo(f); }, isa_SpectraVideo);
 
 	action_gifAnimateBorder = settings.action_gifAnimateBorder;
+	action_movieRawVideo	= settings.action_movieRawVideo;
 
 	action_setKbdBasic =
 		newAction("mini_zxsp.gif", "Keyboard BASIC mode", Qt::Key_B, [=] { setKeyboardMode(kbdbasic); });
@@ -1027,11 +1061,12 @@ void MachineController::createMenus()
 		QList<QAction*>() // <-- void QCocoaMenu::insertNative … Menu item is already in a menu …
 		<< action_newMachine << separator << action_openFile << action_recentFiles << action_reloadFile << separator2
 		<< action_closeWindow << action_saveAs << separator3 << action_screenshot << action_recordMovie
-		<< action_gifAnimateBorder << action_showAbout << action_showPreferences);
+		<< action_gifAnimateBorder << action_movieRawVideo << action_showAbout << action_showPreferences);
 
 	control_menu->addActions(
 		QList<QAction*>() << action_pwrOnReset << action_reset << action_nmi << separator << action_enable_breakpoints
-						  << action_suspend << action_stepIn << action_stepOver << action_stepOut);
+						  << action_suspend << action_stepIn << action_stepOver << action_stepOut << separator2
+						  << action_traceCpu);
 
 	options_menu->addAction(action_audioin_enabled);
 	options_menu->addMenu(speed_menu);
@@ -1197,7 +1232,10 @@ MachineController::MachineController(QString filepath) :
 	mem {nullptr, nullptr, nullptr, nullptr},
 	lenslok(nullptr),
 	keyjoy_keys {0, 0, 0, 0, 0},
-	keyjoy_fnmatch_pattern(nullptr)
+	keyjoy_fnmatch_pattern(nullptr),
+	sent_to(nullptr),
+	sent_joystick_buttons {0, 0, 0, 0},
+	sent_mouse_buttons(0)
 {
 	// setup window
 	// setup menubar
@@ -1278,12 +1316,14 @@ void MachineController::killMachine()
 	nvptr(&machine_list)->remove(machine);
 	in_machine_dtor = yes;
 	NV(machine)->_power_off();
+	sent_to = nullptr; // the next machine may get the same address
 
 	// unchecked menu items:
 	action_showLenslok->setChecked(off);
 	action_recordMovie->setChecked(off);
 	action_suspend->setChecked(off);
 	action_enable_breakpoints->setChecked(off);
+	action_traceCpu->setChecked(off);
 	// keep action_zoom
 	// keep action_fullscreen
 	// action_showMachineImage will be reset in init()
@@ -1726,7 +1766,7 @@ static KeyboardModifiers zxmodifiers(uint32 qtm) // helper
 
 void MachineController::allKeysUp()
 {
-	if (machine) nvptr(machine)->allKeysAndButtonsUp();
+	if (machine) machine->allKeysAndButtonsUp();
 }
 
 inline bool cmdkey_involved(QKeyEvent* e)
@@ -1803,11 +1843,11 @@ void MachineController::keyPressEvent(QKeyEvent* e)
 			for (uint i = 0; i < NELEM(keyjoy_keys); i++)
 				if (keyjoy_keys[i] == keycode)
 				{
-					machine->joystick_buttons[kbd_joystick] |= 1 << i;
+					machine->joystickButtonsDown(kbd_joystick, uint8(1 << i));
 					if (machine->kbd_joystick_active) return;
 				}
 
-		NV(machine)->keyDown(charcode, keycode, zxmodifiers(modifiers));
+		machine->keyDown(charcode, keycode, zxmodifiers(modifiers));
 	}
 
 	emit signal_keymapModified();
@@ -1828,11 +1868,11 @@ void MachineController::keyReleaseEvent(QKeyEvent* e)
 			for (uint i = 0; i < NELEM(keyjoy_keys); i++)
 				if (keyjoy_keys[i] == keycode)
 				{
-					machine->joystick_buttons[kbd_joystick] &= ~(1 << i);
+					machine->joystickButtonsUp(kbd_joystick, uint8(1 << i));
 					//if (machine->kbd_joystick_active) return;
 				}
 
-		NV(machine)->keyUp(charcode, keycode, zxmodifiers(modifiers));
+		machine->keyUp(charcode, keycode, zxmodifiers(modifiers));
 	}
 
 	emit signal_keymapModified();
@@ -1892,7 +1932,8 @@ void MachineController::recordMovie(bool f) // controlMenu
 			cstr dir  = fullpath("~/Desktop/", yes);
 			cstr name = filepath ? basename_from_path(filepath) : model_info->name;
 			str	 time = datetimestr(time_t(now())); // time[10]='-'; time[13]='.'; time[16]='.';
-			cstr path = catstr(dir, name, " [", time, "]", ".gif");
+			cstr ext  = action_movieRawVideo->isChecked() ? ".y4m" : ".gif"; // .y4m: plus .wav
+			cstr path = catstr(dir, name, " [", time, "]", ext);
 
 			try
 			{
@@ -1904,6 +1945,11 @@ void MachineController::recordMovie(bool f) // controlMenu
 				showAlert("File error: \n%s", e.what());
 				action_recordMovie->setChecked(off);
 			}
+			catch (AnyError& e)
+			{
+				showAlert("%s", e.what());
+				action_recordMovie->setChecked(off);
+			}
 		}
 	}
 	else { screen->stopRecording(); }
@@ -1970,6 +2016,36 @@ void MachineController::enableBreakpoints(bool f)
 	else m->cpu_options &= ~cpu_break_rwx;
 }
 
+void MachineController::traceCpu(bool f)
+{
+	xlogIn("MachineController:traceCpu(%i)", int(f));
+
+	if (f)
+	{
+		cstr dir  = fullpath("~/Desktop/", yes);
+		cstr name = filepath ? basename_from_path(filepath) : model_info->name;
+		str	 time = datetimestr(time_t(now()));
+		cstr path = catstr(dir, name, " [", time, "].z80trace");
+
+		try
+		{
+			uint32 mb = uint32(minmax(2, settings.get_int(key_trace_buffer_size, 24), 1536));
+			nvptr(machine)->startTrace(path, mb << 20);
+		}
+		catch (FileError& e)
+		{
+			showAlert("File error: \n%s", e.what());
+			action_traceCpu->setChecked(off);
+		}
+		catch (AnyError& e)
+		{
+			showAlert("%s", e.what());
+			action_traceCpu->setChecked(off);
+		}
+	}
+	else { nvptr(machine)->stopTrace(); }
+}
+
 void MachineController::haltMachine(bool f)
 {
 	xlogIn("MachineController:haltMachine(%i)", int(f));
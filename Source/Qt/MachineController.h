@@ -50,6 +50,11 @@ class MachineController : public QMainWindow, public IMachineController
 	uint8 keyjoy_keys[5];		  // (RLDUF) Qt keycode to use for keyboard joystick up-down-left-right-fire
 	cstr  keyjoy_fnmatch_pattern; // the filename pattern, for which the keys were set
 
+	// input state last sent to the machine: see pollInputDevices()
+	const volatile Machine* sent_to;
+	uint8					sent_joystick_buttons[MAX_USB_JOYSTICKS];
+	uint					sent_mouse_buttons;
+
 	static void guiTimerCallback();
 	void		pollInputDevices();
 	void		updateSomeMenuItems();
@@ -70,7 +75,7 @@ public:
 		*action_setSpeed200, *action_setSpeed400, *action_setSpeed800, *action_RzxRecord, *action_RzxRecordAutostart,
 		*action_RzxRecordAppendSna, *action_newInspector, *action_showMachineImage, *action_showMemHex,
 		*action_showMemDisass, *action_showMemAccess, *action_showMemGraphical, *action_showLenslok,
-		*action_gifAnimateBorder,
+		*action_gifAnimateBorder, *action_movieRawVideo, *action_traceCpu,
 
 		// add external items:
 		*action_addDivIDE, *action_addSpectraVideo, *action_addCurrahMicroSpeech, *action_addFdcBeta128,
@@ -110,6 +115,7 @@ private:
 	void	 resetMachine();
 	void	 haltMachine(bool);
 	void	 enableBreakpoints(bool);
+	void	 traceCpu(bool);
 	void	 showLenslok(bool);
 	void	 addExternalItem(isa_id, bool);
 	void	 addExternalRam(isa_id, bool, uint options = 0);
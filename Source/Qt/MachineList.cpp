@@ -23,10 +23,17 @@ void MachineList::runMachinesForSound(const StereoBuffer audio_in_buffer, Stereo
 				{
 					if (machine->isRunning()) // not suspended
 					{
-						machine->runForSound(audio_in_buffer, audio_out_buffer, 0);
+						// run into the machine's own buffer and mix it with the machine's gain:
+						// the stitching samples at the end stay with the machine.
+						StereoSample* bu = machine->own_audio_out_buffer;
+						machine->shiftBuffer(bu);
+						machine->clearBuffer(bu);
+						machine->runForSound(audio_in_buffer, bu, 0);
+						mixSamples(audio_out_buffer, bu, uint(dsp_samples_per_buffer), machine->audio_gain);
 						if (machine->cpu_clock > 100000) continue;
 					}
 
+					machine->publishState(); // also while suspended: show changes made by the debugger
 					machine->drawVideoBeamIndicator();
 				}
 			}
@@ -32,14 +32,46 @@ RzxOverlay::RzxOverlay() :
 {
 	xlogIn("new RzxOverlay");
 
-	w = background.width() / 4;
-	h = background.height() / 4;
+	w = icon_w = background.width() / 4;
+	h		   = background.height() / 4;
 	xlogline("size = %u x %u", w, h);
 }
 
 void RzxOverlay::draw(QPainter& p, int)
 {
-	p.drawPixmap(x, y, w, h, background); //TODO: blink recording lamp
+	p.drawPixmap(x + w - icon_w, y, icon_w, h, background); //TODO: blink recording lamp
+
+	if (frames == 0) return;
+
+	// scrubber:
+	QColor background_color {0, 0, 0, 0x40}; // rgba
+	QColor line_color(222, 222, 222, 0xA0);
+
+	int yc = y + h / 2;
+	int xk = x + 2 + int((scrubber_w - 4) * double(frame) / frames); // knob
+
+	p.setPen(Qt::NoPen);
+	p.setBrush(background_color);
+	p.drawRoundedRect(x, yc - 4, scrubber_w, 8, 3, 3);
+	p.setBrush(line_color);
+	p.drawRect(x + 2, yc - 1, xk - x - 2, 2);
+	p.drawEllipse(QPoint(xk, yc), 3, 3);
+}
+
+void RzxOverlay::setPosition(uint32 frame, uint32 frames)
+{
+	this->frame	 = frame;
+	this->frames = frames;
+	w			 = frames ? scrubber_w + 4 + icon_w : icon_w;
+}
+
+bool RzxOverlay::mousePressed(int x, int y)
+{
+	if (frames == 0 || x < 0 || x >= scrubber_w || y < 0 || y >= h) return false;
+
+	double f = minmax(0.0, double(x - 2) / (scrubber_w - 4), 1.0);
+	if (seek) seek(min(uint32(f * frames), frames - 1));
+	return true;
 }
 
 void RzxOverlay::setRecording(bool f)
@@ -47,6 +79,7 @@ void RzxOverlay::setRecording(bool f)
 	if (recording == f) return;
 	background = QPixmap(usingstr("%sOverlays/%s.png", appl_rsrc_path, f ? "record" : "play"));
 	recording  = f;
+	if (f) setPosition(0, 0);
 }
 
 
@@ -9,6 +9,7 @@
 #include <QPen>
 #include <QPixmap>
 #include <QPolygon>
+#include <functional>
 class IScreen;
 
 namespace gui
@@ -49,13 +50,22 @@ public:
 class RzxOverlay : public Overlay
 {
 public:
+	static constexpr int scrubber_w = 100; // nominal width of the scrubber left of the icon
+
 	QPixmap background;
+	int		icon_w;
 	bool	recording = false;
+	uint32	frame	  = 0; // playing: current frame
+	uint32	frames	  = 0; // playing: total frames; 0 = no scrubber
+
+	std::function<void(uint32)> seek; // called when the scrubber is clicked or dragged
 
 public:
 	RzxOverlay();
 	void draw(QPainter&, int scale) override;
 	void setRecording(bool);
+	void setPosition(uint32 frame, uint32 frames);
+	bool mousePressed(int x, int y); // nominal, relative to the overlay; false if not in the scrubber
 };
 
 
@@ -3,6 +3,7 @@
 // https://opensource.org/licenses/BSD-2-Clause
 
 #include "Preferences.h"
+#include "OS/Dsp.h"
 #include "Qt/Settings.h"
 #include "ZxInfo.h"
 #include "cpp/cppthreads.h"
@@ -22,6 +23,9 @@ namespace gui
 
 static int modelList[num_models];
 
+static const int audio_buffer_sizes[] = {64, 128, 200, 256, 512, 1024, 2048};
+static const int trace_buffer_sizes[] = {6, 24, 96, 384, 1536}; // MB
+
 // helper
 inline Qt::CheckState is_checked(bool f) { return f ? Qt::Checked : Qt::Unchecked; }
 
@@ -149,6 +153,48 @@ Preferences::Preferences(QWidget* parent) : QWidget(parent)
 		settings.setValue(key_new_snapshot_keyboard_mode, index);
 	});
 
+	QComboBox* audio_buffer_size = new QComboBox();
+	audio_buffer_size->setFocusPolicy(Qt::NoFocus);
+	for (uint i = 0; i < NELEM(audio_buffer_sizes); i++)
+	{
+		int n = audio_buffer_sizes[i];
+		audio_buffer_size->addItem(usingstr("%i samples (%.1f ms)", n, n * 1000 / samples_per_second));
+		if (settings.get_int(key_audio_buffer_size, DSP_SAMPLES_PER_BUFFER_DFLT) == n)
+			audio_buffer_size->setCurrentIndex(int(i));
+	}
+	audio_buffer_size->setFixedWidth(180);
+	connect(audio_buffer_size, FP(&QComboBox::currentIndexChanged), [](int index) {
+		settings.setValue(key_audio_buffer_size, audio_buffer_sizes[index]);
+		os::setAudioBufferSize(audio_buffer_sizes[index]);
+	});
+
+	QCheckBox* audio_rate_control = new QCheckBox("Lock emulation speed to the real time clock");
+	audio_rate_control->setCheckState(is_checked(settings.get_bool(key_audio_rate_control, yes)));
+	connect(audio_rate_control, &QCheckBox::toggled, [](bool f) {
+		settings.setValue(key_audio_rate_control, f);
+		os::enableRateControl(f);
+	});
+#ifndef _MACOSX
+	audio_rate_control->setEnabled(false); // needs the audio driver's timestamps
+	audio_rate_control->setText("Lock emulation speed to the real time clock (macOS only)");
+#endif
+
+	QComboBox* new_machine_run_ahead = new QComboBox();
+	new_machine_run_ahead->addItems(
+		QStringList() << "Off"
+					  << "1 frame"
+					  << "2 frames");
+	new_machine_run_ahead->setFocusPolicy(Qt::NoFocus);
+	new_machine_run_ahead->setCurrentIndex(settings.get_int(key_run_ahead_frames, 0));
+	new_machine_run_ahead->setFixedWidth(180);
+	connect(new_machine_run_ahead, FP(&QComboBox::currentIndexChanged), [](int index) {
+		settings.setValue(key_run_ahead_frames, index);
+	});
+	QLabel* run_ahead_note = new QLabel(
+		"Run-ahead is paused on ZX80, ZX81 and Jupiter Ace models, with disk interfaces, printers and most "
+		"other peripherals attached, while the tape is running and while an rzx file is played.");
+	run_ahead_note->setWordWrap(true);
+
 	QComboBox* new_machine_model = new QComboBox();
 	new_machine_model->setFocusPolicy(Qt::NoFocus);
 	for (int i = 0, m = 0; m < num_models; m++)
@@ -178,6 +224,19 @@ Preferences::Preferences(QWidget* parent) : QWidget(parent)
 		settings.setValue(key_startup_screen_size, index);
 	});
 
+	QComboBox* trace_buffer_size = new QComboBox();
+	trace_buffer_size->setFocusPolicy(Qt::NoFocus);
+	for (uint i = 0; i < NELEM(trace_buffer_sizes); i++)
+	{
+		int n = trace_buffer_sizes[i];
+		trace_buffer_size->addItem(usingstr("%i MB", n));
+		if (settings.get_int(key_trace_buffer_size, 24) == n) trace_buffer_size->setCurrentIndex(int(i));
+	}
+	trace_buffer_size->setFixedWidth(180);
+	connect(trace_buffer_size, FP(&QComboBox::currentIndexChanged), [](int index) {
+		settings.setValue(key_trace_buffer_size, trace_buffer_sizes[index]);
+	});
+
 	// Layout:
 	// das Layout ist 2 Spalten breit
 	// Normalerweise erstrecken sich Einträge über beide Spalten
@@ -195,6 +254,11 @@ Preferences::Preferences(QWidget* parent) : QWidget(parent)
 	gridlayout->addWidget(show_joystick_overlays, i++, 0, 1, 2); // permanent
 	gridlayout->addWidget(start_audioin_enabled, i++, 0, 1, 2);
 
+	gridlayout->addWidget(new MyGroupLabel("Audio:"), i++, 0);
+	gridlayout->addWidget(audio_buffer_size, i, 0);
+	gridlayout->addWidget(new QLabel("Audio buffer size"), i++, 1);
+	gridlayout->addWidget(audio_rate_control, i++, 0, 1, 2);
+
 	gridlayout->addWidget(new MyGroupLabel("Options for new machines:"), i++, 0);
 	gridlayout->addWidget(new_machine_model, i, 0);
 	gridlayout->addWidget(new QLabel("Default model"), i++, 1);
@@ -202,6 +266,9 @@ Preferences::Preferences(QWidget* parent) : QWidget(parent)
 	gridlayout->addWidget(new QLabel("Default keyboard mode"), i++, 1);
 	gridlayout->addWidget(auto_start_stop_tape, i++, 0, 1, 2);
 	gridlayout->addWidget(fast_load_tape, i++, 0, 1, 2);
+	gridlayout->addWidget(new_machine_run_ahead, i, 0);
+	gridlayout->addWidget(new QLabel("Run ahead to hide input lag"), i++, 1);
+	gridlayout->addWidget(run_ahead_note, i++, 0, 1, 2);
 
 	gridlayout->addWidget(new MyGroupLabel("Options for new snapshots:"), i++, 0);
 	gridlayout->addWidget(new_snapshot_kbdmode, i, 0);
@@ -212,6 +279,10 @@ Preferences::Preferences(QWidget* parent) : QWidget(parent)
 	gridlayout->addWidget(new_machine_divide, i++, 0, 1, 2);
 	//	gridlayout->addWidget(use_individual_settings, i++, 0, 1, 2);
 
+	gridlayout->addWidget(new MyGroupLabel("Instruction trace:"), i++, 0);
+	gridlayout->addWidget(trace_buffer_size, i, 0);
+	gridlayout->addWidget(new QLabel("Buffer size: records are dropped if it is full"), i++, 1);
+
 	setLayout(gridlayout);
 }
 
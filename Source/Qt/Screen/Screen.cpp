@@ -16,6 +16,7 @@
 #include <QApplication>
 #include <QGLFormat>
 #include <QGLWidget>
+#include <QMouseEvent>
 #include <QMutex>
 #include <QSemaphore>
 #include <QThread>
@@ -73,12 +74,11 @@ Screen::Screen(QWidget* owner, isa_id id) :
 	render_thread(new RenderThread(this)),
 	id(id),
 	_what(IDLE),
-	_gifmovie_filepath(nullptr),
 	_screenshot_filepath(nullptr),
 	frames_hit_percent(100.0f),
 	zoom(calc_zoom()),
 	screen_renderer(newRenderer()),
-	gif_writer(nullptr)
+	movie_recorder(nullptr)
 {
 	xlogIn("new Screen");
 
@@ -108,8 +108,7 @@ Screen::~Screen()
 
 	render_thread->wait();
 
-	delete gif_writer;
-	delete[] _gifmovie_filepath;
+	delete movie_recorder;
 	delete[] _screenshot_filepath;
 }
 
@@ -216,17 +215,39 @@ void Screen::saveScreenshot(cstr path)
 
 void Screen::startRecording(cstr path, bool with_border)
 {
-	if (_gifmovie_filepath) return;
-	_gifmovie_with_bordereffects = with_border;
-	_gifmovie_filepath			 = newcopy(path);
+	// start recording a gif movie or, if path ends with ".y4m", a raw video and a .wav file
+	// frames are copied in ffb_or_vbi() and encoded on the MovieRecorder's own thread
+	// the emulation thread waits in ffb_or_vbi() if the MovieRecorder falls behind
+	// throws FileError
+
+	if (movie_recorder) return;
+	bool		   raw_video = eq(lowerstr(extension_from_path(path)), ".y4m");
+	MovieRecorder* recorder	 = new MovieRecorder(newGifWriter(with_border, 50), path, raw_video);
+
+	_recorder_mutex.lock();
+	movie_recorder = recorder;
+	_recorder_mutex.unlock();
 }
 
 void Screen::stopRecording()
 {
-	_mutex.lock();
-	_what |= STOPMOVIE;
-	_mutex.unlock();
-	_sema.release();
+	_recorder_mutex.lock(); // waits while the emulation thread waits for a free slot
+	MovieRecorder* recorder = movie_recorder;
+	movie_recorder			= nullptr;
+	_recorder_mutex.unlock();
+
+	delete recorder; // encodes all pending frames and closes the file
+}
+
+void Screen::audioBufferEnd(const StereoSample* samples, uint count)
+{
+	// called by the machine at the end of each dsp buffer
+
+	if (!movie_recorder) return;
+
+	_recorder_mutex.lock();
+	if (movie_recorder) movie_recorder->writeSound(samples, count);
+	_recorder_mutex.unlock();
 }
 
 void Screen::do_render_thread()
@@ -253,24 +274,6 @@ void Screen::do_render_thread()
 				continue;
 			}
 
-			if (_what & STOPMOVIE)
-			{
-				_what &= ~STOPMOVIE;
-				_mutex.unlock();
-
-				if (gif_writer) try
-					{
-						gif_writer->stopRecording();
-					}
-					catch (FileError& e)
-					{
-						showWarning("File error: %s", e.what());
-					}
-				delete gif_writer;
-				gif_writer = nullptr;
-				continue;
-			}
-
 			if (_what & REPAINT)
 			{
 				_what &= ~REPAINT;
@@ -454,6 +457,35 @@ void Screen::paint_screen(bool draw_passepartout)
 	}
 }
 
+bool Screen::rzx_scrubber_clicked(QMouseEvent* e)
+{
+	// test whether the mouse is in the scrubber of the rzx overlay
+	// and seek to the frame under the mouse
+
+	RzxOverlayPtr ov = rzx_overlay;
+	if (!ov) return false;
+
+	int zoom = minmax(1, min(width() / 256, height() / 192), 4); // as in paint_screen()
+	return ov->mousePressed(e->x() / zoom - ov->x, e->y() / zoom - ov->y);
+}
+
+void Screen::mousePressEvent(QMouseEvent* e)
+{
+	// Qt reimplement
+
+	if (e->button() == Qt::LeftButton && rzx_scrubber_clicked(e)) return;
+	QGLWidget::mousePressEvent(e);
+}
+
+void Screen::mouseMoveEvent(QMouseEvent* e)
+{
+	// Qt reimplement
+	// note: only called while a button is pressed
+
+	if ((e->buttons() & Qt::LeftButton) && rzx_scrubber_clicked(e)) return;
+	QGLWidget::mouseMoveEvent(e);
+}
+
 void Screen::setRzxOverlay(const RzxOverlayPtr& p)
 {
 	if (rzx_overlay == p) return;
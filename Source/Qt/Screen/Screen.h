@@ -5,6 +5,7 @@
 
 #include "Interfaces/IScreen.h"
 #include "Item.h"
+#include "MovieRecorder.h"
 #include "Overlays/Overlay.h"
 #include "Renderer.h"
 #include "zxsp_types.h"
@@ -33,20 +34,19 @@ protected:
 
 	QSemaphore _sema;
 	QMutex	   _mutex;
+	QMutex	   _recorder_mutex; // guards movie_recorder: the emulation thread may wait in it
 	QSemaphore _wait_repaint_sema;
 
 	uint _what;
-	enum : uint { IDLE, FFB_OR_VBI = 1, REPAINT = 2, TERMI = 4, STOPMOVIE = 8 };
-	cstr _gifmovie_filepath;
+	enum : uint { IDLE, FFB_OR_VBI = 1, REPAINT = 2, TERMI = 4 };
 	cstr _screenshot_filepath;
-	bool _gifmovie_with_bordereffects;
 
 	float frames_hit_percent;
 
 	int zoom;
 
-	Renderer*  screen_renderer;
-	GifWriter* gif_writer;
+	Renderer*	   screen_renderer;
+	MovieRecorder* movie_recorder; // emulation thread -> encoder thread
 
 	void		 do_render_thread(); // call from render_thread
 	void		 draw_rect(int x, int y, int w, int h, RgbaColor color);
@@ -63,6 +63,9 @@ protected:
 	void paintEvent(QPaintEvent*) override;	  // Qt reimplement
 	void resizeEvent(QResizeEvent*) override; // Qt reimplement
 	void initializeGL() override;			  // Qt reimplement
+	void mousePressEvent(QMouseEvent*) override;
+	void mouseMoveEvent(QMouseEvent*) override;
+	bool rzx_scrubber_clicked(QMouseEvent*);
 
 	Screen(QWidget* owner, isa_id);
 	Screen(const Screen&)			 = delete;
@@ -83,7 +86,8 @@ public:
 	void saveScreenshot(cstr path);
 	void startRecording(cstr path, bool update_border);
 	void stopRecording();
-	bool isRecording() const { return _gifmovie_filepath != nullptr; }
+	bool isRecording() const { return movie_recorder != nullptr; }
+	void audioBufferEnd(const StereoSample*, uint count) override;
 
 	bool isA(isa_id i) const volatile
 	{
@@ -27,6 +27,13 @@ bool ScreenMono::ffb_or_vbi(
 	// returns true  if new buffers must be retained and old buffers may now be reused.
 	// returns false if new buffers may be reused and old buffers must remain retained.
 
+	if (movie_recorder && cc == 0) // --> append completed frame to movie
+	{
+		_recorder_mutex.lock(); // not _mutex: writeFrame() may wait for the encoder
+		if (movie_recorder) movie_recorder->writeFrame(new_pixels, screen_w, screen_h, frame_w, frame_h, x0, y0);
+		_recorder_mutex.unlock();
+	}
+
 	_mutex.lock();
 
 	bool ffb_ready = ~_what & FFB_OR_VBI;
@@ -59,6 +66,16 @@ bool ScreenMono::sendFrame(uint8* frame_data, const zxsp::Size& frame_size, cons
 	// returns true  if new buffers must be retained and old buffers may now be reused.
 	// returns false if new buffers may be reused and old buffers must remain retained.
 
+	if (movie_recorder) // --> append frame to movie
+	{
+		_recorder_mutex.lock(); // not _mutex: writeFrame() may wait for the encoder
+		if (movie_recorder)
+			movie_recorder->writeFrame(
+				frame_data, uint(screen.width()), uint(screen.height()), uint(frame_size.width),
+				uint(frame_size.height), uint(screen.p1.x), uint(screen.p1.y));
+		_recorder_mutex.unlock();
+	}
+
 	_mutex.lock();
 
 	bool ffb_ready = ~_what & FFB_OR_VBI;
@@ -100,10 +117,10 @@ void ScreenMono::do_ffb_or_vbi()
 	if (isVisible())
 	{
 		assert(dynamic_cast<MonoRenderer*>(screen_renderer));
+		MonoRenderer* renderer = static_cast<MonoRenderer*>(screen_renderer);
 
-		static_cast<MonoRenderer*>(screen_renderer)
-			->drawScreen(new_pixels, screen_w, screen_h, frame_w, frame_h, screen_x0, screen_y0, cc);
-		paint_screen(no);
+		renderer->drawScreen(new_pixels, screen_w, screen_h, frame_w, frame_h, screen_x0, screen_y0, cc);
+		if (renderer->dirty_top < renderer->dirty_bottom) paint_screen(no); // else no row changed
 	}
 
 	if (_screenshot_filepath && cc == 0) // --> make a screenshot
@@ -123,42 +140,6 @@ void ScreenMono::do_ffb_or_vbi()
 		delete[] path;
 		delete gif;
 	}
-
-	if (_gifmovie_filepath && cc == 0) // --> start recording into an animated gif
-	{
-		cstr path		   = _gifmovie_filepath;
-		bool with_border   = _gifmovie_with_bordereffects;
-		_gifmovie_filepath = nullptr;
-
-		gif_writer = new MonoGifWriter(with_border, 50);
-		try
-		{
-			gif_writer->startRecording(path);
-		}
-		catch (FileError& e)
-		{
-			showWarning("File error: %s", e.what());
-			delete gif_writer;
-			gif_writer = nullptr;
-		}
-		delete[] path;
-	}
-
-	if (gif_writer && cc == 0) // --> record frame into gif movie file
-	{
-		try
-		{
-			assert(dynamic_cast<MonoGifWriter*>(gif_writer));
-			static_cast<MonoGifWriter*>(gif_writer)
-				->writeFrame(new_pixels, screen_w, screen_h, frame_w, frame_h, screen_x0, screen_y0);
-		}
-		catch (FileError& e)
-		{
-			showWarning("File error: %s", e.what());
-			delete gif_writer;
-			gif_writer = nullptr;
-		}
-	}
 }
 
 void ScreenMono::paint_screen(bool draw_passepartout)
@@ -208,15 +189,28 @@ void ScreenMono::paint_screen(bool draw_passepartout)
 	int			  qbx = qsx - h_border; // position of visible rect in screen_renderer.bits[]
 	int			  qby = qsy - v_border;
 
-	glRasterPos2i(zoom * h_black, zoom * v_black); // window coordinates
-	glPixelZoom(zoom, -zoom);
-	// glPixelStorei(GL_UNPACK_ALIGNMENT,1);
-	// glPixelStorei(GL_UNPACK_ROW_LENGTH,screen_renderer->width);		// number of pixels
-	glPixelStorei(GL_UNPACK_ROW_LENGTH, mono_screen_renderer->width);
-	// note: glDrawPixels(w,h,format,type,data*)
-	glDrawPixels(
-		h_border * 2 + 256, v_border * 2 + 192, GL_COLOR_INDEX, GL_BITMAP,
-		screen_renderer->mono_octets + (qbx + qby * screen_renderer->width) / 8);
+	// rows of the visible rect to upload:
+	// for a new frame only the rows which changed. the widget is single buffered: the other rows are still visible.
+	int a = 0;
+	int e = v_border * 2 + 192;
+	if (!draw_passepartout && !doubleBuffer())
+	{
+		a = max(a, mono_screen_renderer->dirty_top - qby);
+		e = min(e, mono_screen_renderer->dirty_bottom - qby);
+	}
+
+	if (a < e)
+	{
+		glRasterPos2i(zoom * h_black, zoom * (v_black + a)); // window coordinates
+		glPixelZoom(zoom, -zoom);
+		// glPixelStorei(GL_UNPACK_ALIGNMENT,1);
+		// glPixelStorei(GL_UNPACK_ROW_LENGTH,screen_renderer->width);		// number of pixels
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, mono_screen_renderer->width);
+		// note: glDrawPixels(w,h,format,type,data*)
+		glDrawPixels(
+			h_border * 2 + 256, e - a, GL_COLOR_INDEX, GL_BITMAP,
+			screen_renderer->mono_octets + (qbx + (qby + a) * screen_renderer->width) / 8);
+	}
 
 	if (draw_passepartout && (v_black | h_black))
 	{
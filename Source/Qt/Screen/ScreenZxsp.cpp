@@ -33,6 +33,17 @@ bool ScreenZxsp::ffb_or_vbi(
 	// returns true  if new buffers must be retained and old buffers may now be reused.
 	// returns false if new buffers may be reused and old buffers must remain retained.
 
+	if (movie_recorder && cc == 90000) // cc = 90000: frame flyback --> append completed frame to movie
+	{
+		uint attr_pixels_size = 32 * 24 * 8 * (id == isa_ScreenSpectra ? 3 : 2);
+		_recorder_mutex.lock(); // not _mutex: writeFrame() may wait for the encoder
+		if (movie_recorder)
+			movie_recorder->writeFrame(
+				ioinfo, ioinfo_count, attr_pixels, attr_pixels_size, cc_start_of_screenfile, cc_per_scanline,
+				flashphase);
+		_recorder_mutex.unlock();
+	}
+
 	_mutex.lock();
 
 	bool ffb_ready = ~_what & FFB_OR_VBI;
@@ -96,44 +107,6 @@ void ScreenZxsp::do_ffb_or_vbi()
 		delete[] path;
 		delete gif;
 	}
-
-	if (_gifmovie_filepath) // --> start recording into an animated gif
-	{
-		cstr path		   = _gifmovie_filepath;
-		bool with_border   = _gifmovie_with_bordereffects;
-		_gifmovie_filepath = nullptr;
-
-		gif_writer = newGifWriter(with_border, 50);
-		assert(dynamic_cast<ZxspGifWriter*>(gif_writer));
-
-		try
-		{
-			gif_writer->startRecording(path);
-		}
-		catch (FileError& e)
-		{
-			showWarning("File error: %s", e.what());
-			delete gif_writer;
-			gif_writer = nullptr;
-		}
-		delete[] path;
-	}
-
-	if (gif_writer) // --> record frame into gif movie file
-	{
-		try
-		{
-			assert(dynamic_cast<ZxspGifWriter*>(gif_writer));
-			static_cast<ZxspGifWriter*>(gif_writer)
-				->writeFrame(ioinfo, ioinfo_count, attrpixels, cc_per_scanline, cc_start_of_screenfile, flashphase);
-		}
-		catch (FileError& e)
-		{
-			showWarning("File error: %s", e.what());
-			delete gif_writer;
-			gif_writer = nullptr;
-		}
-	}
 }
 
 
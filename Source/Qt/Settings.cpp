@@ -25,6 +25,11 @@ Settings::Settings()
 	action_gifAnimateBorder->setCheckable(true);
 	action_gifAnimateBorder->setChecked(value(key_gif_movies_animate_border, yes).toBool());
 	connect(action_gifAnimateBorder, &QAction::toggled, this, &Settings::setGifAnimateBorder);
+
+	action_movieRawVideo = new QAction("Record raw video and sound (.y4m + .wav)", this);
+	action_movieRawVideo->setCheckable(true);
+	action_movieRawVideo->setChecked(value(key_movies_raw_video, no).toBool());
+	connect(action_movieRawVideo, &QAction::toggled, this, &Settings::setMovieRawVideo);
 }
 
 Settings::~Settings() {}
@@ -32,6 +37,7 @@ Settings::~Settings() {}
 
 // private slot:
 void Settings::setGifAnimateBorder(bool f) { setValue(key_gif_movies_animate_border, f); }
+void Settings::setMovieRawVideo(bool f) { setValue(key_movies_raw_video, f); }
 
 
 /*	get a string value from this settings
@@ -36,6 +36,9 @@ static constexpr char key_warn_if_audio_in_fails[]	   = "settings/warn_if_audio_
 static constexpr char key_show_joystick_overlays[]	   = "settings/show_joystick_overlays";		// bool
 static constexpr char key_auto_start_stop_tape[]	   = "settings/auto_start_stop_tape";		// bool
 static constexpr char key_fast_load_tape[]			   = "settings/fast_load_tape";				// bool
+static constexpr char key_run_ahead_frames[]		   = "settings/run_ahead_frames";			// int 0-2
+static constexpr char key_audio_buffer_size[]		   = "settings/audio_buffer_size";			// int samples
+static constexpr char key_audio_rate_control[]		   = "settings/audio_rate_control";			// bool
 static constexpr char key_new_machine_keyboard_mode[]  = "settings/new_machine_keyboard_mode";	// int
 static constexpr char key_new_snapshot_keyboard_mode[] = "settings/new_snapshot_keyboard_mode"; // int
 static constexpr char key_always_attach_soundchip[]	   = "settings/always_attach_soundchip";	// bool
@@ -56,6 +59,8 @@ static constexpr char key_framerate_tk85_60hz[]		  = "settings/key_framerate_tk8
 static constexpr char key_framerate_tk90x_60hz[]	  = "settings/key_framerate_tk90x_60hz";   // bool
 static constexpr char key_framerate_tk95_60hz[]		  = "settings/key_framerate_tk95_60hz";	   // bool
 static constexpr char key_gif_movies_animate_border[] = "settings/gif_movies_animate_border";  // bool
+static constexpr char key_movies_raw_video[]		  = "settings/movies_raw_video";			   // bool
+static constexpr char key_trace_buffer_size[]		  = "settings/trace_buffer_size";			   // int MB
 static constexpr char key_mainwindow_position[]		  = "gui/mainwindow_position/";			   // QRect: for each zoom
 static constexpr char key_toolwindow_position[]		  = "gui/toolwindow_position/";		 // QPoint: for each Item grp_id
 static constexpr char key_toolwindow_toolbar_height[] = "gui/toolwindow_toolbar_height"; // int
@@ -102,6 +107,7 @@ class Settings : public QSettings
 {
 public:
 	QAction* action_gifAnimateBorder;
+	QAction* action_movieRawVideo;
 
 	Settings();
 	~Settings() override;
@@ -123,6 +129,7 @@ public:
 
 private:
 	void setGifAnimateBorder(bool);
+	void setMovieRawVideo(bool);
 };
 
 } // namespace gui
@@ -0,0 +1,47 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "RateControl.h"
+#include "kio/kio.h"
+
+
+void RateControl::reset(Frequency nominal)
+{
+	nominal_rate = nominal;
+	rate		 = nominal;
+	t0 = t1 = 0.0;
+	s0 = s1 = 0.0;
+}
+
+Frequency RateControl::update(Time t, double s)
+{
+	// t = host time of the current buffer [seconds]
+	// s = sample time of the current buffer [samples]
+	// returns the new effective sample rate
+
+	bool restart = t1 == 0.0 || t <= t1 || t > t1 + 0.25 || s <= s1; // first call or discontinuity
+	t1			 = t;
+	s1			 = s;
+	if (restart)
+	{
+		t0 = t;
+		s0 = s;
+		return rate;
+	}
+
+	Time dt = t - t0;
+	if (dt < min_window) return rate;
+
+	Frequency measured = (s - s0) / dt;
+	Frequency target   = minmax(nominal_rate * (1 - max_deviation), measured, nominal_rate * (1 + max_deviation));
+	rate += (target - rate) * smoothing;
+
+	if (dt > window) // slide the window
+	{
+		s0 += (dt - window) * measured;
+		t0 = t - window;
+	}
+
+	return rate;
+}
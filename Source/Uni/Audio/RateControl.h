@@ -0,0 +1,40 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "zxsp_types.h"
+
+
+/*	dynamic rate control
+
+	the machines run in the audio callback: they are always in lockstep with the audio device.
+	but the sample clock of the audio device is not exactly the nominal sample rate when measured with the host clock:
+	then the emulated time drifts against real time, which is used for input events, the screen and system_time.
+
+	the audio driver passes the host time and the sample time of each buffer to update().
+	the actual sample rate is measured over a sliding window of some seconds
+	and the effective samples_per_second slowly follows it, limited to nominal rate ±0.5%.
+	a gap in the timestamps, e.g. after a change of the buffer size, restarts the measurement.
+*/
+class RateControl
+{
+	static constexpr double max_deviation = 0.005; // ±0.5%
+	static constexpr Time	window		  = 4.0;   // seconds
+	static constexpr Time	min_window	  = 1.0;   // seconds: no measurement before
+	static constexpr double smoothing	  = 0.02;  // per update
+
+	Frequency nominal_rate = 44100;
+	Frequency rate		   = 44100; // effective rate
+	Time	  t0		   = 0.0;	// host time at start of measurement
+	double	  s0		   = 0.0;	// sample time at start of measurement
+	Time	  t1		   = 0.0;	// host time of last update
+	double	  s1		   = 0.0;	// sample time of last update
+
+public:
+	void	  reset(Frequency nominal_rate);
+	Frequency update(Time host_time, double sample_time);
+
+	Frequency getRate() const { return rate; }
+	Frequency getNominalRate() const { return nominal_rate; }
+};
@@ -0,0 +1,205 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "SampleKernels.h"
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define VEC4 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  #include <arm_neon.h>
+  #define VEC4 1
+#else
+  #define VEC4 0
+#endif
+
+
+/*	4 floats = 2 StereoSamples
+	only the few operations needed here:
+*/
+#if VEC4 && !defined(__ARM_NEON)
+
+using vec4 = __m128;
+
+static inline vec4 load(const Sample* p) { return _mm_loadu_ps(p); }
+static inline void store(Sample* p, vec4 v) { _mm_storeu_ps(p, v); }
+static inline vec4 splat(Sample f) { return _mm_set1_ps(f); }
+static inline vec4 vec(Sample a, Sample b, Sample c, Sample d) { return _mm_setr_ps(a, b, c, d); }
+static inline vec4 add(vec4 a, vec4 b) { return _mm_add_ps(a, b); }
+static inline vec4 sub(vec4 a, vec4 b) { return _mm_sub_ps(a, b); }
+static inline vec4 mul(vec4 a, vec4 b) { return _mm_mul_ps(a, b); }
+static inline vec4 low_to_high(vec4 a) { return _mm_movelh_ps(_mm_setzero_ps(), a); } // [0,0,a0,a1]
+static inline vec4 high_to_both(vec4 a) { return _mm_movehl_ps(a, a); }			   // [a2,a3,a2,a3]
+static inline vec4 even(vec4 a, vec4 b) { return _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)); }
+static inline vec4 odd(vec4 a, vec4 b) { return _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)); }
+
+#elif VEC4
+
+using vec4 = float32x4_t;
+
+static inline vec4 load(const Sample* p) { return vld1q_f32(p); }
+static inline void store(Sample* p, vec4 v) { vst1q_f32(p, v); }
+static inline vec4 splat(Sample f) { return vdupq_n_f32(f); }
+static inline vec4 vec(Sample a, Sample b, Sample c, Sample d)
+{
+	const Sample f[4] = {a, b, c, d};
+	return vld1q_f32(f);
+}
+static inline vec4 add(vec4 a, vec4 b) { return vaddq_f32(a, b); }
+static inline vec4 sub(vec4 a, vec4 b) { return vsubq_f32(a, b); }
+static inline vec4 mul(vec4 a, vec4 b) { return vmulq_f32(a, b); }
+static inline vec4 low_to_high(vec4 a) { return vcombine_f32(vdup_n_f32(0), vget_low_f32(a)); }
+static inline vec4 high_to_both(vec4 a) { return vcombine_f32(vget_high_f32(a), vget_high_f32(a)); }
+static inline vec4 even(vec4 a, vec4 b) { return vuzp1q_f32(a, b); }
+static inline vec4 odd(vec4 a, vec4 b) { return vuzp2q_f32(a, b); }
+
+#endif
+
+
+static inline Sample*		floats(StereoSample* p) { return reinterpret_cast<Sample*>(p); }
+static inline const Sample* floats(const StereoSample* p) { return reinterpret_cast<const Sample*>(p); }
+
+static_assert(sizeof(StereoSample) == 2 * sizeof(Sample), "StereoSample must be 2 packed floats");
+
+
+void clearSamples(StereoSample* z, uint count) noexcept
+{
+	// memset() is as fast as it gets:
+	memset(static_cast<void*>(z), 0, count * sizeof(StereoSample));
+}
+
+void copySamples(StereoSample* z, const StereoSample* q, uint count) noexcept
+{
+	memmove(static_cast<void*>(z), q, count * sizeof(StereoSample));
+}
+
+void mixSamples(StereoSample* z, const StereoSample* q, uint count, Sample gain) noexcept
+{
+	uint i = 0;
+
+#if VEC4
+	Sample*		  zf = floats(z);
+	const Sample* qf = floats(q);
+	vec4		  g	 = splat(gain);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		store(zf + 2 * i, add(load(zf + 2 * i), mul(load(qf + 2 * i), g)));
+		store(zf + 2 * i + 4, add(load(zf + 2 * i + 4), mul(load(qf + 2 * i + 4), g)));
+	}
+#endif
+
+	for (; i < count; i++) { z[i] += q[i] * gain; }
+}
+
+void highpassSamples(StereoSample* p, uint count, StereoSample& center, Sample damping) noexcept
+{
+	// per sample:	y = x - c;  c = c + y * d
+	// which is:	c' = a * c + d * x  with  a = 1 - d
+	//
+	// the vector version does 2 samples per step. then the loop-carried dependency is only
+	// c'' = a² * c + d * (a * x0 + x1)  and the outputs are  y0 = x0 - c,  y1 = x1 - d * x0 - a * c
+
+	uint i = 0;
+
+#if VEC4
+	const Sample a = 1.0f - damping;
+
+	if (count >= 2)
+	{
+		Sample*	   f   = floats(p);
+		const vec4 d   = splat(damping);
+		const vec4 va  = splat(a);
+		const vec4 a2  = splat(a * a);
+		const vec4 a01 = vec(1.0f, 1.0f, a, a);
+		vec4	   c   = vec(center.left, center.right, center.left, center.right);
+
+		for (; i + 2 <= count; i += 2)
+		{
+			vec4 x	= load(f + 2 * i);
+			vec4 x0 = low_to_high(x); // [0,x0]
+			store(f + 2 * i, sub(sub(x, mul(d, x0)), mul(a01, c)));
+			c = add(mul(a2, c), mul(d, high_to_both(add(mul(va, x0), x))));
+		}
+
+		Sample cc[4];
+		store(cc, c);
+		center = StereoSample(cc[0], cc[1]);
+	}
+#endif
+
+	for (; i < count; i++) { center += (p[i] -= center) * damping; }
+}
+
+void writeSamples(Sample* z, const StereoSample* q, uint count, Sample volume) noexcept
+{
+	// interleaved stereo
+
+	uint i = 0;
+
+#if VEC4
+	const Sample* qf = floats(q);
+	vec4		  v	 = splat(volume);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		store(z + 2 * i, mul(load(qf + 2 * i), v));
+		store(z + 2 * i + 4, mul(load(qf + 2 * i + 4), v));
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		z[2 * i]	 = q[i].left * volume;
+		z[2 * i + 1] = q[i].right * volume;
+	}
+}
+
+void writeSamples(Sample* left, Sample* right, const StereoSample* q, uint count, Sample volume) noexcept
+{
+	// separate buffers for left and right channel
+
+	uint i = 0;
+
+#if VEC4
+	const Sample* qf = floats(q);
+	vec4		  v	 = splat(volume);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		vec4 a = load(qf + 2 * i);
+		vec4 b = load(qf + 2 * i + 4);
+		store(left + i, mul(even(a, b), v));
+		store(right + i, mul(odd(a, b), v));
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		left[i]	 = q[i].left * volume;
+		right[i] = q[i].right * volume;
+	}
+}
+
+void writeMonoSamples(Sample* z, const StereoSample* q, uint count, Sample volume) noexcept
+{
+	// mono: the average of left and right channel
+
+	uint i = 0;
+
+#if VEC4
+	const Sample* qf = floats(q);
+	vec4		  v	 = splat(volume * 0.5f);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		vec4 a = load(qf + 2 * i);
+		vec4 b = load(qf + 2 * i + 4);
+		store(z + i, mul(add(even(a, b), odd(a, b)), v));
+	}
+#endif
+
+	for (; i < count; i++) { z[i] = Sample(q[i]) * volume; }
+}
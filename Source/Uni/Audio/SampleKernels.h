@@ -0,0 +1,29 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "StereoSample.h"
+#include "kio/kio.h"
+
+
+/*	Operations on buffers of StereoSamples for the audio callback
+
+	These run once per dsp buffer on the whole buffer, after the machines have run.
+	They use SSE2 on x86_64 and NEON on arm64 and plain loops elsewhere.
+	Buffers need no special alignment.
+*/
+
+extern void clearSamples(StereoSample* z, uint count) noexcept;
+extern void copySamples(StereoSample* z, const StereoSample* q, uint count) noexcept; // may overlap
+
+// z[] += q[] * gain
+extern void mixSamples(StereoSample* z, const StereoSample* q, uint count, Sample gain) noexcept;
+
+// DC-blocking high-pass: center follows the signal bias, damping per sample e.g. 0.001
+extern void highpassSamples(StereoSample* p, uint count, StereoSample& center, Sample damping) noexcept;
+
+// write to the audio device: interleaved stereo, separate channels or mono
+extern void writeSamples(Sample* z, const StereoSample* q, uint count, Sample volume) noexcept;
+extern void writeSamples(Sample* left, Sample* right, const StereoSample* q, uint count, Sample volume) noexcept;
+extern void writeMonoSamples(Sample* z, const StereoSample* q, uint count, Sample volume) noexcept;
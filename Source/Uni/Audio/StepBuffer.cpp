@@ -0,0 +1,105 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "StepBuffer.h"
+#include "SampleKernels.h"
+#include <math.h>
+
+
+/*	the step kernel:
+	for each of the 32 sub-sample phases the Blackman-windowed impulse response of a lowpass
+	at 0.45 * samples_per_second, sampled at the integer sample positions.
+	each phase is normalized to sum 1.0 so that the integrated step has exactly the posted height.
+*/
+static struct StepKernel
+{
+	Sample k[StepBuffer::phases][StepBuffer::width];
+
+	StepKernel()
+	{
+		constexpr double fc = 0.45; // cutoff frequency, relative to the sample rate
+		constexpr int	 w	= StepBuffer::width;
+
+		for (int p = 0; p < StepBuffer::phases; p++)
+		{
+			double frac = double(p) / StepBuffer::phases;
+			double h[w];
+			double sum = 0.0;
+
+			for (int i = 0; i < w; i++)
+			{
+				double x = i - (w / 2 - 1) - frac;								  // -8 < x <= +8
+				double n = (x + w / 2) / w;										  //  0 < n <= 1
+				double s = x == 0.0 ? 2 * fc : sin(2 * M_PI * fc * x) / (M_PI * x); // sinc
+				double b = 0.42 - 0.5 * cos(2 * M_PI * n) + 0.08 * cos(4 * M_PI * n); // Blackman window
+				sum += h[i] = s * b;
+			}
+
+			for (int i = 0; i < w; i++) k[p][i] = Sample(h[i] / sum);
+		}
+	}
+} kernel;
+
+
+void StepBuffer::clear() noexcept
+{
+	level = 0.0f;
+	used  = 0;
+	for (int32 i = 0; i < size; i++) deltas[i] = 0.0f;
+}
+
+void StepBuffer::addDelta(int64 pos, const StereoSample& delta) noexcept
+{
+	// add step of height `delta` at position `pos`
+	// pos = sample position in 32.32 fixed point
+
+	int32		  i = int32(pos >> frac_bits);
+	const Sample* k = kernel.k[uint32(pos) >> (frac_bits - phase_bits)];
+
+	if (uint32(i) > uint32(size - width)) i = i < 0 ? 0 : size - width; // out of range: should not happen
+	if (i + width > used) used = i + width;
+
+	StereoSample* z = deltas + i;
+	for (int j = 0; j < width; j++) { z[j] += delta * k[j]; }
+}
+
+void StepBuffer::addDelta(int64 pos, Sample delta) noexcept
+{
+	// mono version
+
+	int32		  i = int32(pos >> frac_bits);
+	const Sample* k = kernel.k[uint32(pos) >> (frac_bits - phase_bits)];
+
+	if (uint32(i) > uint32(size - width)) i = i < 0 ? 0 : size - width; // out of range: should not happen
+	if (i + width > used) used = i + width;
+
+	StereoSample* z = deltas + i;
+	for (int j = 0; j < width; j++)
+	{
+		Sample d = delta * k[j];
+		z[j].left += d;
+		z[j].right += d;
+	}
+}
+
+void StepBuffer::readSamples(StereoSample* z, int32 count) noexcept
+{
+	// integrate the first `count` samples and add them to z[]
+	// then shift the remaining deltas down
+
+	assert(count >= 0 && count <= size - width);
+
+	StereoSample l = level;
+	for (int32 i = 0; i < count; i++)
+	{
+		l += deltas[i];
+		z[i] += l;
+	}
+	level = l;
+
+	int32 n = max(used - count, 0);
+	copySamples(deltas, deltas + count, uint(n));
+	clearSamples(deltas + n, uint(used - n));
+	used = n;
+}
@@ -0,0 +1,43 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "StereoSample.h"
+#include "zxsp_types.h"
+
+
+/*	band-limited step synthesis buffer
+
+	sound sources don't render samples but post the amplitude change of their output
+	at the time when it happens. the position is in samples since the start of the current
+	dsp buffer, in 32.32 fixed point.
+
+	each delta is spread over `width` samples with a windowed-sinc step kernel.
+	at the end of the dsp buffer the deltas are integrated in one pass and added to audio_out_buffer[].
+	the output is delayed by width/2 samples.
+*/
+class StepBuffer
+{
+public:
+	static constexpr int   frac_bits  = 32;				  // fractional bits of a position
+	static constexpr int   phase_bits = 5;				  // resolution of the kernel: 1/32 sample
+	static constexpr int   phases	  = 1 << phase_bits;  //
+	static constexpr int   width	  = 16;				  // samples per kernel
+	static constexpr int32 size		  = DSP_SAMPLES_PER_BUFFER_MAX + DSP_SAMPLES_STITCHING + width;
+
+	static constexpr double one = 4294967296.0; // 1.0 sample in 32.32 fixed point
+
+private:
+	StereoSample deltas[size];
+	StereoSample level; // integrator output at deltas[0]
+	int32		 used;	// deltas[used…] are 0: only the used part is shifted for small buffers
+
+public:
+	StepBuffer() noexcept { clear(); }
+
+	void clear() noexcept;
+	void addDelta(int64 pos, const StereoSample& delta) noexcept;
+	void addDelta(int64 pos, Sample delta) noexcept;
+	void readSamples(StereoSample* dest, int32 count) noexcept;
+};
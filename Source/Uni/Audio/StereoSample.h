@@ -44,6 +44,9 @@ public:
 	}
 
 	StereoSample operator*(float f) const noexcept { return StereoSample(left * f, right * f); }
+	StereoSample operator-(const StereoSample& q) const noexcept { return StereoSample(left - q.left, right - q.right); }
+
+	bool operator!=(const StereoSample& q) const noexcept { return left != q.left || right != q.right; }
 };
 
 
@@ -0,0 +1,112 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "FileIndex.h"
+#include "unix/FD.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+FileIndex::FileIndex() : map(nullptr), map_size(0), header(nullptr), entries(nullptr), strings(nullptr) {}
+
+FileIndex::~FileIndex() { close(); }
+
+void FileIndex::close()
+{
+	if (map) munmap(const_cast<uint8*>(map), map_size);
+	map		= nullptr;
+	map_size = 0;
+	header	= nullptr;
+	entries = nullptr;
+	strings = nullptr;
+}
+
+bool FileIndex::open(cstr path)
+{
+	close();
+
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat fs;
+	if (fstat(fd, &fs) != 0 || size_t(fs.st_size) < sizeof(FileIndexHeader))
+	{
+		::close(fd);
+		return false;
+	}
+
+	size_t size = size_t(fs.st_size);
+	void*  p	= mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (p == MAP_FAILED) return false;
+
+	map		 = reinterpret_cast<const uint8*>(p);
+	map_size = size;
+
+	// validate:
+	const FileIndexHeader* h = reinterpret_cast<const FileIndexHeader*>(map);
+	if (memcmp(h->magic, fileindex_magic, sizeof(h->magic)) != 0 || h->byte_order != 0x01020304 ||
+		h->entry_size != sizeof(FileIndexEntry) || h->strings_size == 0 ||
+		sizeof(FileIndexHeader) + uint64(h->count) * sizeof(FileIndexEntry) + h->strings_size != size)
+	{
+		close();
+		return false;
+	}
+
+	header	= h;
+	entries = reinterpret_cast<const FileIndexEntry*>(map + sizeof(FileIndexHeader));
+	strings = reinterpret_cast<cstr>(entries + h->count);
+
+	if (strings[h->strings_size - 1] != 0) // unterminated string table
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+const FileIndexEntry* FileIndex::find(cstr path) const
+{
+	// binary search: entries are sorted by path
+
+	uint a = 0, e = count();
+	while (a < e)
+	{
+		uint i = (a + e) / 2;
+		int	 c = strcmp(str(entries[i].path), path);
+		if (c == 0) return &entries[i];
+		if (c < 0) a = i + 1;
+		else e = i;
+	}
+	return nullptr;
+}
+
+void FileIndex::write(cstr path, const FileIndexEntry* entries, uint count, cstr strings, uint32 strings_size)
+{
+	// write the index to a temp file and rename it:
+	// a FileIndex which has the old file mapped is not affected.
+	// throws FileError
+
+	assert(strings_size && strings[0] == 0);
+
+	FileIndexHeader head;
+	memset(&head, 0, sizeof(head));
+	memcpy(head.magic, fileindex_magic, sizeof(head.magic));
+	head.byte_order	  = 0x01020304;
+	head.entry_size	  = sizeof(FileIndexEntry);
+	head.count		  = count;
+	head.strings_size = strings_size;
+
+	cstr tmppath = catstr(path, ".tmp");
+	{
+		FD fd(tmppath, 'w');
+		fd.write_bytes(&head, sizeof(head));
+		fd.write_bytes(entries, count * sizeof(FileIndexEntry));
+		fd.write_bytes(strings, strings_size);
+	}
+	if (rename(tmppath, path) != 0) throw FileError(path, errno);
+}
@@ -0,0 +1,73 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "kio/kio.h"
+#include "zxsp_types.h"
+
+
+/*	Index file for a collection of snapshot and tape files
+
+	Written by FileScanner, read by memory mapping the file: entries can be used in place.
+
+	file layout:
+		FileIndexHeader
+		FileIndexEntry[count]	sorted by path (strcmp)
+		char[strings_size]		string table: 0-terminated strings, starts with an empty string
+
+	all numbers are in host byte order: the index is a cache and is rebuilt if byte_order does not match.
+	strings are referenced by their offset in the string table. offset 0 is the empty string.
+*/
+
+static constexpr char fileindex_magic[12] = "zxsp-index\n";
+
+struct FileIndexHeader
+{
+	char   magic[12];	 // "zxsp-index\n" + '\0'
+	uint32 byte_order;	 // 0x01020304 in host byte order
+	uint32 entry_size;	 // sizeof(FileIndexEntry)
+	uint32 count;		 // number of entries
+	uint32 strings_size; // size of the string table
+	uint32 reserved;
+};
+
+enum FileType : uint8 { ft_unknown, ft_z80, ft_sna, ft_szx, ft_tap, ft_tzx, ft_o80, ft_p81, ft_rzx };
+
+struct FileIndexEntry
+{
+	int64  mtime;	  // file modification time: with size used to detect modified files
+	uint64 size;	  // file size
+	uint32 path;	  // string: absolute path
+	uint32 names;	  // string: tape block infos, separated by '\n'
+	uint32 thumbnail; // string: file name of the thumbnail in the thumbnail directory, or ""
+	uint32 error;	  // string: why the file could not be read, or ""
+	int8   model;	  // Model required by the file or unknown_model
+	uint8  filetype;  // FileType
+	uint8  reserved[6];
+};
+
+
+class FileIndex
+{
+	const uint8*		   map;
+	size_t				   map_size;
+	const FileIndexHeader* header;
+	const FileIndexEntry*  entries;
+	cstr				   strings;
+
+public:
+	FileIndex();
+	~FileIndex();
+	NO_COPY_MOVE(FileIndex);
+
+	bool open(cstr path); // false if the file does not exist or is no valid index
+	void close();
+
+	uint				  count() const { return header ? header->count : 0; }
+	const FileIndexEntry& operator[](uint i) const { return entries[i]; }
+	cstr				  str(uint32 offset) const { return strings + offset; }
+	const FileIndexEntry* find(cstr path) const; // nullptr if not found
+
+	static void write(cstr path, const FileIndexEntry*, uint count, cstr strings, uint32 strings_size);
+};
@@ -0,0 +1,620 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "FileScanner.h"
+#include "IoInfo.h"
+#include "MonoRenderer.h"
+#include "RzxFile.h"
+#include "TapData.h"
+#include "TapeFile.h"
+#include "Z80Head.h"
+#include "ZxspRenderer.h"
+#include "O80Data.h"
+#include "file_szx.h"
+#include "unix/FD.h"
+#include "unix/files.h"
+#include "zxsp_globals.h"
+#include "zxsp_helpers.h"
+#include <algorithm>
+#include <dirent.h>
+#include <memory>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+
+static constexpr uint32 tape_ccps  = 3500000; // for TapeFile: the value does not matter for scanning
+static constexpr uint	snalen	   = 27;
+static constexpr uint	screensize = 6912;
+
+
+static uint64 fnv1a(cstr s)
+{
+	uint64 hash = 0xcbf29ce484222325u;
+	while (*s) { hash = (hash ^ uint8(*s++)) * 0x100000001b3u; }
+	return hash;
+}
+
+
+// ---------------------------------------------------------
+//		FileInfo
+// ---------------------------------------------------------
+
+
+FileInfo::FileInfo(cstr path, int64 mtime, uint64 size, FileType filetype) :
+	path(newcopy(path)),
+	mtime(mtime),
+	size(size),
+	filetype(filetype),
+	model(unknown_model),
+	names(nullptr),
+	thumbnail(nullptr),
+	error(nullptr),
+	reused(false)
+{}
+
+FileInfo::~FileInfo()
+{
+	delete[] path;
+	delete[] names;
+	delete[] thumbnail;
+	delete[] error;
+}
+
+
+// ---------------------------------------------------------
+//		FileScanner
+// ---------------------------------------------------------
+
+
+FileScanner::FileScanner(cstr thumbs_dir) :
+	thumbs_dir(thumbs_dir ? newcopy(catstr(thumbs_dir, lastchar(thumbs_dir) == '/' ? "" : "/")) : nullptr),
+	old_index(nullptr),
+	next_file(0),
+	zx81_charset_valid(false)
+{
+	if (this->thumbs_dir) create_dir(this->thumbs_dir);
+
+	// the ZX81 thumbnails are drawn with the character set from the rom:
+	if (!appl_rsrc_path) return;
+	try
+	{
+		FD fd(catstr(appl_rsrc_path, "Roms/zx81.rom"), 'r');
+		fd.seek_fpos(0x1e00);
+		fd.read_bytes(zx81_charset, sizeof(zx81_charset));
+		zx81_charset_valid = true;
+	}
+	catch (AnyError& e)
+	{
+		logline("FileScanner: no ZX81 charset: %s", e.what());
+	}
+}
+
+FileScanner::~FileScanner()
+{
+	for (uint i = 0; i < files.count(); i++) delete files[i];
+	delete[] thumbs_dir;
+}
+
+FileType FileScanner::filetypeFromFilename(cstr path)
+{
+	cstr ext = lowerstr(extension_from_path(path));
+
+	if (eq(ext, ".z80")) return ft_z80;
+	if (eq(ext, ".sna")) return ft_sna;
+	if (eq(ext, ".szx")) return ft_szx;
+	if (eq(ext, ".tap") || eq(ext, ".tape")) return ft_tap;
+	if (eq(ext, ".tzx")) return ft_tzx;
+	if (eq(ext, ".o") || eq(ext, ".80")) return ft_o80;
+	if (eq(ext, ".p") || eq(ext, ".81") || eq(ext, ".p81")) return ft_p81;
+	if (eq(ext, ".rzx")) return ft_rzx;
+	return ft_unknown;
+}
+
+void FileScanner::addPath(cstr path)
+{
+	// add a file or all files in a directory tree
+	// files with an unknown extension and hidden files in directories are skipped
+
+	struct stat fs;
+	if (stat(path, &fs) != 0) return;
+
+	if (S_ISDIR(fs.st_mode))
+	{
+		DIR* dir = opendir(path);
+		if (!dir) return;
+
+		cstr dirpath = newcopy(catstr(path, lastchar(path) == '/' ? "" : "/"));
+		while (dirent* de = readdir(dir))
+		{
+			if (de->d_name[0] == '.') continue;
+			addPath(catstr(dirpath, de->d_name));
+		}
+		closedir(dir);
+		delete[] dirpath;
+		return;
+	}
+
+	if (!S_ISREG(fs.st_mode)) return;
+
+	FileType ft = filetypeFromFilename(path);
+	if (ft == ft_unknown) return;
+
+	files.append(new FileInfo(fullpath(path), int64(fs.st_mtime), uint64(fs.st_size), ft));
+}
+
+cstr FileScanner::thumbnail_name(cstr path) const
+{
+	// the name of the thumbnail for a file, without the directory
+	return usingstr("%016llx.gif", (unsigned long long)fnv1a(path));
+}
+
+
+void FileScanner::scan(const FileIndex* old_index, uint num_threads)
+{
+	// scan all files which are not up to date in the old index
+	// old_index may be nullptr: then all files are scanned
+
+	this->old_index = old_index;
+	next_file		= 0;
+
+	num_threads = minmax(1u, num_threads, 64u);
+	pthread_t threads[64];
+	uint	  n = 0;
+
+	for (; n < num_threads - 1; n++)
+	{
+		int e = pthread_create(&threads[n], nullptr /*attr*/, worker_proc, this /*args*/);
+		if (e)
+		{
+			logline("FileScanner: creating a worker thread failed: %s", strerror(e));
+			break;
+		}
+	}
+
+	run_worker(); // the calling thread is one of the workers
+	while (n) { pthread_join(threads[--n], nullptr); }
+
+	this->old_index = nullptr;
+}
+
+void* FileScanner::worker_proc(void* data)
+{
+	reinterpret_cast<FileScanner*>(data)->run_worker();
+	return nullptr;
+}
+
+void FileScanner::run_worker()
+{
+	for (;;)
+	{
+		uint i = next_file.fetch_add(1, std::memory_order_relaxed);
+		if (i >= files.count()) return;
+		scan_file(files[i]);
+	}
+}
+
+void FileScanner::scan_file(FileInfo* info)
+{
+	// reuse the entry from the old index if the file was not modified:
+
+	if (old_index)
+	{
+		const FileIndexEntry* e = old_index->find(info->path);
+		if (e && e->mtime == info->mtime && e->size == info->size)
+		{
+			info->model	   = Model(e->model);
+			info->reused   = true;
+			cstr names	   = old_index->str(e->names);
+			cstr thumbnail = old_index->str(e->thumbnail);
+			cstr error	   = old_index->str(e->error);
+			if (*names) info->names = newcopy(names);
+			if (*error) info->error = newcopy(error);
+			if (!*thumbnail) return;
+			if (thumbs_dir && is_file(catstr(thumbs_dir, thumbnail)))
+			{
+				info->thumbnail = newcopy(thumbnail);
+				return;
+			}
+			// else the thumbnail was deleted: scan the file again
+			delete[] info->names;
+			delete[] info->error;
+			info->names	 = nullptr;
+			info->error	 = nullptr;
+			info->reused = false;
+		}
+	}
+
+	try
+	{
+		switch (info->filetype)
+		{
+		case ft_z80: scan_z80(info, info->path); break;
+		case ft_sna: scan_sna(info, info->path); break;
+		case ft_szx: scan_szx(info, info->path); break;
+		case ft_tap:
+		case ft_tzx:
+		case ft_o80:
+		case ft_p81: scan_tape(info); break;
+		case ft_rzx: scan_rzx(info); break;
+		case ft_unknown: break;
+		}
+	}
+	catch (AnyError& e)
+	{
+		info->error = newcopy(e.what());
+	}
+	catch (std::exception& e)
+	{
+		info->error = newcopy(e.what());
+	}
+	catch (cstr msg) // file_szx.cpp
+	{
+		info->error = newcopy(msg);
+	}
+}
+
+
+// ---------------------------------------------------------
+//		snapshots
+// ---------------------------------------------------------
+
+
+static uint decompress_z80(const uint8* q, uint qsize, uint8* z, uint zsize)
+{
+	// decompress a .z80 block: "ED ED nn bb" = nn times byte bb
+	// decompresses at most zsize bytes
+	// returns the number of decompressed bytes
+
+	const uint8* q_end = q + qsize;
+	uint8*		 z0	   = z;
+	uint8*		 z_end = z + zsize;
+
+	while (z < z_end && q < q_end)
+	{
+		uint8 c = *q++;
+		if (c != 0xed || q == q_end || *q != 0xed)
+		{
+			*z++ = c;
+			continue;
+		}
+		if (q_end - q < 3) break;
+		uint n = q[1];
+		c	   = q[2];
+		q += 3;
+		while (n-- && z < z_end) *z++ = c;
+	}
+	return uint(z - z0);
+}
+
+void FileScanner::scan_z80(FileInfo* info, cstr fpath)
+{
+	FD		fd(fpath, 'r');
+	Z80Head head;
+	head.read(fd);
+	info->model = head.getZxspModel();
+
+	uint8 border = (head.data >> 1) & 7;
+	uint8 screen[screensize];
+
+	if (head.isVersion145())
+	{
+		uint32					 qsize = uint32(fd.file_remaining());
+		std::unique_ptr<uint8[]> bu {new uint8[qsize]};
+		fd.read_bytes(bu.get(), qsize);
+
+		uint n;
+		if (head.data & 0x20) n = decompress_z80(bu.get(), qsize, screen, screensize);
+		else memcpy(screen, bu.get(), n = min(qsize, screensize));
+		if (n != screensize) throw DataError("ram data truncated");
+		return save_zxsp_thumbnail(info, screen, border);
+	}
+
+	// version 2.01 or above: search the page with the visible screen
+	// page 8 = $4000 in 48k models and ram page 5 in 128k models
+	// page 10 = ram page 7 = the shadow screen in 128k models
+
+	bool  is128k = info->model != unknown_model && zx_info[info->model].isA(isa_MachineZx128);
+	uint8 page	 = is128k && (head.port_7ffd & 0x08) ? 10 : 8;
+
+	while (!fd.is_at_eof())
+	{
+		uint16 qsize = fd.read_uint16_z();
+		uint8  pg	 = fd.read_uint8();
+		uint32 n	 = qsize == 0xffff ? 0x4000 : qsize;
+		if (pg != page)
+		{
+			fd.skip_bytes(n);
+			continue;
+		}
+
+		std::unique_ptr<uint8[]> bu {new uint8[n]};
+		fd.read_bytes(bu.get(), n);
+
+		if (qsize == 0xffff) memcpy(screen, bu.get(), screensize);
+		else if (decompress_z80(bu.get(), n, screen, screensize) != screensize) throw DataError("ram page truncated");
+		return save_zxsp_thumbnail(info, screen, border);
+	}
+	// no screen page: no thumbnail
+}
+
+void FileScanner::scan_sna(FileInfo* info, cstr fpath)
+{
+	FD fd(fpath, 'r');
+	fd.seek_fpos(snalen - 1);
+	uint8 border = fd.read_uint8() & 7;
+	fd.seek_fpos(0);
+	info->model = modelForSna(fd);
+
+	// the screen is at the start of the ram dump in 48k and 128k files:
+	uint8 screen[screensize];
+	fd.seek_fpos(snalen);
+	fd.read_bytes(screen, screensize);
+	save_zxsp_thumbnail(info, screen, border);
+}
+
+void FileScanner::scan_szx(FileInfo* info, cstr fpath)
+{
+	FD fd(fpath, 'r');
+	info->model = modelForSZX(fd);
+	if (info->model == unknown_model) throw DataError("unsupported model");
+
+	// block ids as read with read_uint32_z():
+	static constexpr uint32 ZXST_SpecRegs	  = 'S' + ('P' << 8) + ('C' << 16) + ('R' << 24);
+	static constexpr uint32 ZXST_RamPage	  = 'R' + ('A' << 8) + ('M' << 16) + ('P' << 24);
+	static constexpr uint	ZXSTRF_COMPRESSED = 1;
+
+	uint8 border = 7;
+	uint8 page	 = 5;
+	bool  is128k = zx_info[info->model].isA(isa_MachineZx128);
+
+	fd.seek_fpos(8); // sizeof(SzxHeader)
+	while (!fd.is_at_eof())
+	{
+		uint32 id	= fd.read_uint32_z();
+		uint32 size = fd.read_uint32_z();
+		off_t  fpos = fd.file_position();
+
+		if (id == ZXST_SpecRegs && size >= 2)
+		{
+			border			= fd.read_uint8() & 7;
+			uint8 port_7ffd = fd.read_uint8();
+			if (is128k && (port_7ffd & 0x08)) page = 7;
+		}
+		else if (id == ZXST_RamPage && size >= 3)
+		{
+			uint16 flags   = fd.read_uint16_z();
+			uint8  page_no = fd.read_uint8();
+			if (page_no == page)
+			{
+				uint8  screen[16 kB];
+				uint32 csize = size - 3;
+				if (flags & ZXSTRF_COMPRESSED)
+				{
+					std::unique_ptr<uint8[]> cbu {new uint8[csize]};
+					fd.read_bytes(cbu.get(), csize);
+					uLongf ucsize = sizeof(screen);
+					int	   err	  = uncompress(screen, &ucsize, cbu.get(), csize);
+					if (err != Z_OK) throw DataError(usingstr("ram page %u: zlib error %i", page_no, err));
+					if (ucsize < screensize) throw DataError(usingstr("ram page %u: truncated", page_no));
+				}
+				else
+				{
+					if (csize < screensize) throw DataError(usingstr("ram page %u: truncated", page_no));
+					fd.read_bytes(screen, screensize);
+				}
+				return save_zxsp_thumbnail(info, screen, border);
+			}
+		}
+		fd.seek_fpos(fpos + size);
+	}
+	// no screen page: no thumbnail
+}
+
+void FileScanner::scan_rzx(FileInfo* info)
+{
+	// use the first snapshot in the rzx file:
+	// RzxFile extracts it into a temp file which is valid while rzx exists
+
+	RzxFile rzx;
+	rzx.readFile(info->path, yes /*snapshot only*/);
+	if (!rzx.isSnapshot()) throw DataError("no snapshot found");
+
+	cstr snapshot = rzx.getSnapshot();
+	switch (filetypeFromFilename(snapshot))
+	{
+	case ft_z80: return scan_z80(info, snapshot);
+	case ft_sna: return scan_sna(info, snapshot);
+	case ft_szx: return scan_szx(info, snapshot);
+	default: throw DataError("unsupported snapshot type");
+	}
+}
+
+
+// ---------------------------------------------------------
+//		tapes
+// ---------------------------------------------------------
+
+
+static void append_name(Array<char>& names, cstr s)
+{
+	if (!s || !*s) return;
+	if (names.count()) names.append('\n');
+	while (*s) names.append(*s++);
+}
+
+void FileScanner::scan_tape(FileInfo* info)
+{
+	TapeFile tape(tape_ccps, info->path);
+	if (tape.getFilepath() == nullptr) throw DataError("could not read tape file");
+	// note: TapeFile has already shown the reason with showAlert()
+
+	Array<char>	 names;
+	const uint8* screen				= nullptr;
+	bool		 screen_header_seen = false;
+
+	info->model = info->filetype == ft_o80 ? zx80 : info->filetype == ft_p81 ? zx81 : zxsp_i3;
+
+	for (uint i = 0; i < tape.count(); i++)
+	{
+		TapeFileDataBlock* blk = tape[i];
+		if (blk->isEmpty()) continue;
+		blk->calc_block_infos();
+		append_name(names, blk->major_block_info);
+
+		if (info->filetype == ft_o80 || info->filetype == ft_p81)
+		{
+			// .o and .p files: use the first program:
+			O80Data* o80data = blk->getO80Data();
+			if (!o80data || info->thumbnail) continue;
+			if (o80data->isZX80()) info->model = zx80;
+			if (o80data->isZX81())
+			{
+				info->model = zx81;
+				save_zx81_thumbnail(info, o80data->getData(), o80data->count());
+			}
+			continue;
+		}
+
+		TapData* tapdata = blk->getTapData();
+		if (!tapdata || tapdata->trust_level < TapeData::conversion_success) continue;
+		if (tapdata->isJupiter()) info->model = jupiter;
+
+		// SCREEN$ header: type 3, length 6912, start address $4000
+		// followed by the data block with flag byte and checksum
+		cu8ptr q = tapdata->getData();
+		uint   n = tapdata->count();
+		if (screen_header_seen && !screen && n >= screensize + 2 && q[0] == 0xff) screen = q + 1;
+		screen_header_seen = n == 19 && q[0] == 0x00 && q[1] == 3 && q[12] + 256 * q[13] == screensize &&
+							 q[14] + 256 * q[15] == 0x4000;
+		if (screen && !info->thumbnail) save_zxsp_thumbnail(info, screen, 7 /*white border*/);
+	}
+
+	if (names.count())
+	{
+		names.append(0);
+		info->names = newcopy(names.getData());
+	}
+}
+
+
+// ---------------------------------------------------------
+//		thumbnails
+// ---------------------------------------------------------
+
+
+void FileScanner::save_zxsp_thumbnail(FileInfo* info, const uint8* screen, uint8 border)
+{
+	// render a ZX Spectrum screen with ZxspGifWriter
+	// ZxspGifWriter expects pairs of pixel and attribute byte for 32 columns x 192 rows
+	// and an IoInfo list for the border which it terminates with a stopper.
+
+	if (!thumbs_dir) return;
+
+	uint8  attr_pixels[32 * 192 * 2];
+	uint8* z = attr_pixels;
+	for (uint row = 0; row < 192; row++)
+	{
+		const uint8* pixels = screen + ((row & 0xc0) << 5) + ((row & 0x07) << 8) + ((row & 0x38) << 2);
+		const uint8* attrs	= screen + 0x1800 + (row >> 3) * 32;
+		for (uint col = 0; col < 32; col++)
+		{
+			*z++ = pixels[col];
+			*z++ = attrs[col];
+		}
+	}
+
+	IoInfo ioinfo[2] = {IoInfo(0, 0xfe, border)};
+
+	cstr		  name = thumbnail_name(info->path);
+	ZxspGifWriter gif_writer(yes /*update_border*/, 50 /*fps*/);
+	gif_writer.saveScreenshot(catstr(thumbs_dir, name), ioinfo, 1, attr_pixels, 224, 14336);
+	info->thumbnail = newcopy(name);
+}
+
+void FileScanner::save_zx81_thumbnail(FileInfo* info, const uint8* data, uint32 count)
+{
+	// render the display file of a ZX81 program with MonoGifWriter
+	// data = program name + ram from $4009
+	// the ZX81 screen is generated by the cpu: the thumbnail only shows the characters in D_FILE.
+
+	if (!thumbs_dir || !zx81_charset_valid) return;
+
+	uint l = 0; // length of the program name: the last char has bit 7 set
+	while (l < count && !(data[l++] & 0x80)) {}
+
+	const uint8* mem  = data + l - 0x4009; // mem[addr]
+	uint32		 end  = 0x4009 + count - l;
+	uint32		 addr = mem[0x400c] + 256 * mem[0x400d]; // D_FILE
+	if (end < 0x400e || addr < 0x4009 || addr >= end || mem[addr] != 0x76) return;
+	addr++;
+
+	uint8 pixels[192 * 32];
+	memset(pixels, 0, sizeof(pixels));
+
+	for (uint row = 0; row < 24 && addr < end; row++, addr++) // addr++: skip the $76 at the end of each line
+	{
+		for (uint col = 0; addr < end && mem[addr] != 0x76; col++, addr++)
+		{
+			if (col >= 32) return; // corrupted display file
+			uint8 c = mem[addr];
+			if (c & 0x40) continue; // not a printable character
+			const uint8* glyph = zx81_charset + (c & 0x3f) * 8;
+			uint8		 inv   = c & 0x80 ? 0xff : 0x00;
+			for (uint y = 0; y < 8; y++) pixels[(row * 8 + y) * 32 + col] = glyph[y] ^ inv;
+		}
+	}
+
+	cstr		  name = thumbnail_name(info->path);
+	MonoGifWriter gif_writer(yes /*update_border*/, 50 /*fps*/);
+	gif_writer.saveScreenshot(catstr(thumbs_dir, name), pixels, 256, 192, 256, 192, 0, 0);
+	info->thumbnail = newcopy(name);
+}
+
+
+// ---------------------------------------------------------
+//		write the index
+// ---------------------------------------------------------
+
+
+void FileScanner::writeIndex(cstr path)
+{
+	// write all scanned files to an index file
+	// throws FileError
+
+	std::sort(files.getData(), files.getData() + files.count(), [](const FileInfo* a, const FileInfo* b) {
+		return strcmp(a->path, b->path) < 0;
+	});
+
+	Array<char> strings;
+	strings.append(0); // offset 0 = ""
+
+	auto add_string = [&strings](cstr s) -> uint32 {
+		if (!s || !*s) return 0;
+		uint32 offset = strings.count();
+		do strings.append(*s);
+		while (*s++);
+		return offset;
+	};
+
+	uint							  count = files.count();
+	std::unique_ptr<FileIndexEntry[]> entries {new FileIndexEntry[count]};
+	memset(entries.get(), 0, count * sizeof(FileIndexEntry));
+
+	for (uint i = 0; i < count; i++)
+	{
+		const FileInfo* info = files[i];
+		FileIndexEntry& e	 = entries[i];
+		e.mtime				 = info->mtime;
+		e.size				 = info->size;
+		e.path				 = add_string(info->path);
+		e.names				 = add_string(info->names);
+		e.thumbnail			 = add_string(info->thumbnail);
+		e.error				 = add_string(info->error);
+		e.model				 = int8(info->model);
+		e.filetype			 = info->filetype;
+	}
+
+	FileIndex::write(path, entries.get(), count, strings.getData(), strings.count());
+}
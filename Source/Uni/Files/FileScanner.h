@@ -0,0 +1,84 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "FileIndex.h"
+#include "Templates/Array.h"
+#include "ZxInfo/ZxInfo.h"
+#include "kio/kio.h"
+#include <atomic>
+
+
+/*	Bulk scanner for collections of snapshot and tape files
+
+	Files are parsed without creating a Machine:
+		.z80 .sna .szx	model from the header, screen from the ram pages
+		.tap .tzx		block names from the tape blocks, screen from the first SCREEN$ block
+		.o .80 .p .81	ZX80 or ZX81, screen from the display file of ZX81 programs
+		.rzx			model and screen from the first embedded snapshot
+
+	The files are scanned by a pool of worker threads. Each file is scanned by one thread only
+	and the results are only read after all threads have been joined, so FileInfo needs no locking.
+
+	Thumbnails are written as .gif files into the thumbnail directory.
+	Their name is derived from the file's path, so a rescan overwrites the old thumbnail.
+
+	Rescans are incremental: a file whose mtime and size match its entry in the old index
+	is not read again and the old entry and thumbnail are reused.
+*/
+
+
+struct FileInfo
+{
+	cstr	 path;		// allocated; absolute path
+	int64	 mtime;		// from stat()
+	uint64	 size;		// from stat()
+	FileType filetype;	// from the filename extension
+	Model	 model;		// required model or unknown_model
+	cstr	 names;		// allocated; tape block names, separated by '\n', or nullptr
+	cstr	 thumbnail; // allocated; file name in the thumbnail directory, or nullptr
+	cstr	 error;		// allocated; error message, or nullptr
+	bool	 reused;	// taken from the old index
+
+	FileInfo(cstr path, int64 mtime, uint64 size, FileType);
+	~FileInfo();
+	NO_COPY_MOVE(FileInfo);
+};
+
+
+class FileScanner
+{
+	cstr			  thumbs_dir; // allocated, with trailing '/', or nullptr: no thumbnails
+	Array<FileInfo*>  files;
+	const FileIndex*  old_index;	 // while scanning
+	std::atomic<uint> next_file;	 // while scanning: next file for a worker
+	uint8			  zx81_charset[64 * 8];
+	bool			  zx81_charset_valid;
+
+	static void* worker_proc(void*);
+	void		 run_worker();
+	void		 scan_file(FileInfo*);
+	void		 scan_z80(FileInfo*, cstr fpath);
+	void		 scan_sna(FileInfo*, cstr fpath);
+	void		 scan_szx(FileInfo*, cstr fpath);
+	void		 scan_tape(FileInfo*);
+	void		 scan_rzx(FileInfo*);
+	void		 save_zxsp_thumbnail(FileInfo*, const uint8* screen, uint8 border);
+	void		 save_zx81_thumbnail(FileInfo*, const uint8* mem, uint32 count);
+	cstr		 thumbnail_name(cstr path) const;
+
+public:
+	explicit FileScanner(cstr thumbs_dir);
+	~FileScanner();
+	NO_COPY_MOVE(FileScanner);
+
+	static FileType filetypeFromFilename(cstr);
+
+	void addPath(cstr path); // a file or a directory which is searched recursively
+	void scan(const FileIndex* old_index, uint num_threads);
+	void writeIndex(cstr path); // throws FileError
+
+	uint			count() const { return files.count(); }
+	const FileInfo& operator[](uint i) const { return *files[i]; }
+};
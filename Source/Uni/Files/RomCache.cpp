@@ -0,0 +1,155 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "RomCache.h"
+#include "Templates/Array.h"
+#include "Z80/Z80.h"
+#include "cpp/cppthreads.h"
+#include "unix/FD.h"
+#include <sys/stat.h>
+
+
+RomImage::RomImage(cstr path, uint32 size) : path(newcopy(path)), size(size), hash(0), data(new uint8[size]) {}
+
+RomImage::~RomImage()
+{
+	delete[] path;
+	delete[] data;
+}
+
+
+// ---------------------------------------------------------
+//		the cache
+// ---------------------------------------------------------
+
+
+struct RomCacheEntry
+{
+	cstr		path;
+	uint32		size;  // file size
+	int64		mtime; // file modification time
+	uint32		last_used;
+	RomImagePtr image;
+
+	RomCacheEntry(cstr path, uint32 size, int64 mtime, RomImagePtr image) :
+		path(newcopy(path)),
+		size(size),
+		mtime(mtime),
+		last_used(0),
+		image(image)
+	{}
+	~RomCacheEntry() { delete[] path; }
+	NO_COPY_MOVE(RomCacheEntry);
+};
+
+static Array<RomCacheEntry*> entries;
+static uint32				 use_count = 0;
+static PLock				 cache_lock; // guards entries[] and use_count
+
+
+static uint64 fnv1a(const uint8* q, uint32 n)
+{
+	uint64 hash = 0xcbf29ce484222325u;
+	while (n--) { hash = (hash ^ *q++) * 0x100000001b3u; }
+	return hash;
+}
+
+static void remove_entry(uint i)
+{
+	delete entries[i];
+	entries[i] = entries.last();
+	entries.drop();
+}
+
+static void purge_unused(uint32 max_size)
+{
+	// evict least recently used images until the total size is below max_size
+	// images which are still used elsewhere are not counted and not evicted
+
+	for (;;)
+	{
+		uint32 total  = 0;
+		int	   oldest = -1;
+		for (uint i = 0; i < entries.count(); i++)
+		{
+			if (entries[i]->image.use_count() > 1) continue;
+			total += entries[i]->image->size;
+			if (oldest < 0 || entries[i]->last_used < entries[oldest]->last_used) oldest = int(i);
+		}
+		if (total <= max_size) return;
+		remove_entry(uint(oldest));
+	}
+}
+
+
+RomImagePtr RomCache::getRom(cstr path) noexcept(false) // FileError
+{
+	// get the image for a rom file
+	// the file is only opened and read if it is not in the cache or if it was modified
+
+	struct stat st;
+	if (stat(path, &st) != 0) throw FileError(path, errno);
+	uint32 size	 = uint32(st.st_size);
+	int64  mtime = int64(st.st_mtime);
+
+	PLocker<PLock> lock(cache_lock);
+
+	for (uint i = 0; i < entries.count(); i++)
+	{
+		RomCacheEntry* e = entries[i];
+		if (!eq(e->path, path)) continue;
+		if (e->size == size && e->mtime == mtime)
+		{
+			e->last_used = ++use_count;
+			return e->image;
+		}
+		remove_entry(i); // file was modified
+		break;
+	}
+
+	FD fd(path, 'r'); // throws
+	size = uint32(fd.file_size());
+
+	std::shared_ptr<RomImage> image = std::make_shared<RomImage>(path, size);
+	fd.read_bytes(image->data, size); // throws
+	image->hash = fnv1a(image->data, size);
+
+	// share image with same contents from another path:
+	RomImagePtr shared = image;
+	for (uint i = 0; i < entries.count(); i++)
+	{
+		const RomImage& other = *entries[i]->image;
+		if (other.hash == image->hash && other.size == size && memcmp(other.data, image->data, size) == 0)
+		{
+			shared = entries[i]->image;
+			break;
+		}
+	}
+
+	entries.append(new RomCacheEntry(path, size, mtime, shared));
+	entries.last()->last_used = ++use_count;
+	purge_unused(max_size);
+	return shared;
+}
+
+
+void RomCache::read(cstr path, CoreByte* z, uint32 cnt) noexcept(false) // FileError, DataError
+{
+	// copy the first cnt bytes of a rom file into z[]
+	// the flags in z[] are preserved
+
+	RomImagePtr image = getRom(path);
+	if (image->size < cnt) throw DataError("rom file \"%s\" too short: %u bytes", path, image->size);
+	Z80::b2c(image->data, z, cnt);
+}
+
+
+void RomCache::read(cstr path, uint8* z, uint32 cnt) noexcept(false) // FileError, DataError
+{
+	// copy the first cnt bytes of a rom file into z[]
+
+	RomImagePtr image = getRom(path);
+	if (image->size < cnt) throw DataError("rom file \"%s\" too short: %u bytes", path, image->size);
+	memcpy(z, image->data, cnt);
+}
@@ -0,0 +1,55 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "kio/kio.h"
+#include "zxsp_types.h"
+#include <memory>
+
+
+/*	Process-wide cache of rom images
+
+	Rom files are read from disk only once, no matter how many machines or items use them.
+	Images are looked up by path and validated with a stat() of the file: the file is only opened
+	if it is not in the cache or if it's size or modification time changed.
+	Images with the same contents are shared by content hash, even if they were loaded from different paths.
+
+	An image contains the plain bytes of the rom file.
+	Machines and items copy them into their own CoreBytes, which also hold their per-machine flags
+	for patches, breakpoints and wait states: these are read by the cpu in place and can't be shared.
+
+	The cache keeps recently used images up to max_size bytes in total.
+	Images which are still referenced elsewhere are never evicted.
+
+	getRom() and read() may be called on any thread: the cache is guarded by a lock.
+*/
+
+
+class RomImage
+{
+public:
+	cstr   path; // path of the file which was first loaded into this image
+	uint32 size;
+	uint64 hash; // FNV-1a of data[]
+	uint8* data;
+
+	RomImage(cstr path, uint32 size);
+	~RomImage();
+	NO_COPY_MOVE(RomImage);
+};
+
+using RomImagePtr = std::shared_ptr<const RomImage>;
+
+
+class RomCache
+{
+	static constexpr uint32 max_size = 4 << 20; // 4 MB
+
+public:
+	static RomImagePtr getRom(cstr path) noexcept(false); // FileError
+
+	// copy cnt bytes from the rom file into z[], preserving the flags:
+	static void read(cstr path, CoreByte* z, uint32 cnt) noexcept(false); // FileError, DataError
+	static void read(cstr path, uint8* z, uint32 cnt) noexcept(false);	  // FileError, DataError
+};
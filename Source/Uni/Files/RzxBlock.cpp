@@ -4,6 +4,7 @@
 
 #include "RzxBlock.h"
 #include "RzxFile.h"
+#include "RzxSpillFile.h"
 #include "unix/files.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -48,7 +49,7 @@ void throw_zlib_error(int err) noexcept(false) // DataError
 
 	Compressed:
 
-		cbu  =	valid
+		cbu  =	valid or nullptr if moved to the spill file
 		ucbu =	nullptr,	ucsize = valid or 0
 		fpos =	0
 		apos =	0
@@ -78,7 +79,7 @@ void throw_zlib_error(int err) noexcept(false) // DataError
 
 	Recording:
 
-		cbu  =  nullptr
+		cbu  =  nullptr or deflated frames up to zpos
 		ucbu =  valid
 				ucmax = large enough for worst case (~10000 bytes at start of frame)
 		fpos =  ucsize
@@ -88,6 +89,12 @@ void throw_zlib_error(int err) noexcept(false) // DataError
 		ipos -> input data of current frame (behind ucsize)
 		epos ->	end of data of prev. frame or 0 if fpos=0
 		current_frame = num_frames
+
+	Streaming:
+
+		while recording, each frame is deflated into cbu[] when the next frame is finished.
+		the last frame is held back because amendFrame() may still modify it.
+		compress() only needs to flush the stream.
 */
 
 
@@ -134,6 +141,8 @@ void RzxBlock::kill()
 		logline("RzxBlock: delete machine snapshot: TODO"); //	TODO
 		break;
 	case IsaInputRecordingBlock:
+		if (zs) deflateEnd(zs);
+		delete zs;
 		delete[] cbu;
 		delete[] ucbu;
 		break;
@@ -181,9 +190,7 @@ void RzxBlock::scan_ucbu()
 	{
 		xlogline("first frame was marked as a repeated frame. (fixed)");
 		setInputCount(0, 0);
-		delete[] cbu;
-		cbu	  = nullptr;
-		csize = 0;
+		drop_cbu();
 	}
 
 	uint32 busize = ucsize; // original ucbu[] size
@@ -261,9 +268,7 @@ void RzxBlock::scan_ucbu()
 	{
 		xlogline("truncated frame at end: %u bytes)", busize - ucsize);
 	x:
-		delete[] cbu;
-		cbu	  = nullptr;
-		csize = 0;
+		drop_cbu();
 	}
 
 #ifdef XLOG
@@ -274,11 +279,109 @@ void RzxBlock::scan_ucbu()
 #endif
 }
 
+//	helper:
+//	invalidate cbu[]
+//	stops the deflate stream and forgets the data in the spill file
+//
+void RzxBlock::drop_cbu()
+{
+	if (zs) deflateEnd(zs);
+	delete zs;
+	zs = nullptr;
+	delete[] cbu;
+	cbu		   = nullptr;
+	csize	   = 0;
+	cmax	   = 0;
+	zpos	   = 0;
+	spill_file = nullptr;
+}
+
+//	helper:
+//	read cbu[] back from the spill file
+//
+void RzxBlock::load_cbu() noexcept(false) // FileError
+{
+	if (cbu || csize == 0) return;
+	assert(spill_file);
+
+	cbu	 = new uint8[csize];
+	cmax = csize;
+	try
+	{
+		spill_file->read(spos, cbu, csize);
+	}
+	catch (AnyError&)
+	{
+		delete[] cbu;
+		cbu	 = nullptr;
+		cmax = 0;
+		throw;
+	}
+}
+
+//	helper:
+//	feed ucbu[zpos … end] into the deflate stream and append the output to cbu[]
+//	starts the stream if needed.
+//	flush = Z_NO_FLUSH or Z_FINISH: Z_FINISH ends the stream and cbu[csize] is complete.
+//
+void RzxBlock::deflate_ucbu(uint32 end, int flush)
+{
+	assert(isaInputRecordingBlock());
+	assert(zpos <= end && end <= ucsize);
+
+	if (!zs)
+	{
+		assert(zpos == 0 && cbu == nullptr);
+		zs = new z_stream;
+		memset(zs, 0, sizeof(*zs));
+		int err = deflateInit(zs, Z_DEFAULT_COMPRESSION);
+		assert(err == Z_OK);
+	}
+
+	zs->next_in	 = ucbu + zpos;
+	zs->avail_in = end - zpos;
+
+	for (;;)
+	{
+		if (csize == cmax)
+		{
+			cmax		 = max(cmax * 2, uint32(4 kB));
+			uint8* newbu = new uint8[cmax];
+			memcpy(newbu, cbu, csize);
+			delete[] cbu;
+			cbu = newbu;
+		}
+
+		zs->next_out  = cbu + csize;
+		zs->avail_out = cmax - csize;
+		int err		  = deflate(zs, flush);
+		csize		  = cmax - zs->avail_out;
+
+		if (err == Z_STREAM_END) break;
+		assert(err == Z_OK || err == Z_BUF_ERROR);
+		if (flush == Z_NO_FLUSH && zs->avail_out) break; // all input consumed
+	}
+
+	assert(zs->avail_in == 0);
+	zpos = end;
+
+	if (flush == Z_FINISH)
+	{
+		xlogline("%u -> %u bytes (ratio = %.6g)", ucsize, csize, double(ucsize) / csize);
+		deflateEnd(zs);
+		delete zs;
+		zs	 = nullptr;
+		zpos = 0;
+	}
+}
+
 //	helper:
 //	compress ucbu[ucsize] -> cbu[csize]
 //	ucbu[] remains valid
 //
-//	If csize != 0, then it is assumed that the cbu[] is valid and nothing is done.
+//	If csize != 0 and no deflate stream is running, then it is assumed that the cbu[] is valid
+//	and nothing is done. cbu[] may be in the spill file.
+//	If a deflate stream is running, then only the remaining frames are deflated.
 //
 //	if called while recording, then the current frame is lost.
 //	(the frame can't be finalized because we don't have the icount.)
@@ -287,23 +390,12 @@ void RzxBlock::_compress()
 {
 	assert(isaInputRecordingBlock());
 	assert(ucsize <= ucmax || (ucmax == 0 && ucbu == nullptr));
-	assert(csize == 0 || cbu != nullptr);
+	assert(csize == 0 || cbu != nullptr || spill_file != nullptr);
 
-	if (csize == 0 && ucsize != 0)
+	if (zs || (csize == 0 && ucsize != 0))
 	{
 		assert(ucsize <= ucmax && ucbu != nullptr);
-
-		delete[] cbu;
-		cbu			 = nullptr;
-		uLongf zsize = compressBound(ucsize);
-		xlogline("compressBound(%u) = %u", uint(ucsize), uint(zsize));
-		std::unique_ptr<uint8[]> zbu(new uint8[zsize]);
-		int						 err = ::compress(&zbu[0], &zsize, &ucbu[0], ucsize);
-		assert(err == Z_OK);
-		cbu	  = new uint8[zsize];
-		csize = zsize;
-		memcpy(&cbu[0], &zbu[0], zsize);
-		xlogline("%u -> %u bytes (ratio = %.6g)", ucsize, csize, double(ucsize) / csize);
+		deflate_ucbu(ucsize, Z_FINISH);
 	}
 }
 
@@ -316,11 +408,15 @@ void RzxBlock::_compress()
 //	if ucsize!=0 then it is assumed that ucbu[ucsize] was formerly valid
 //		and ucsize is the uncompressed size of cbu[]
 //
-void RzxBlock::_uncompress() noexcept(false) // DataError
+void RzxBlock::_uncompress() noexcept(false) // DataError, FileError
 {
 	assert(isaInputRecordingBlock());
 	assert(ucmax == 0 || ucbu != nullptr);
 
+	// if cbu[] is in the spill file, then load it only temporarily:
+	bool spilled = cbu == nullptr && csize != 0;
+	load_cbu();
+
 	if (csize == 0) // empty
 	{
 		assert(ucsize == 0);
@@ -383,6 +479,13 @@ void RzxBlock::_uncompress() noexcept(false) // DataError
 		//
 		// if(ucmax/4 > ucsize/3 && ucmax>ucsize+50000) _resize_ucbu(ucsize);
 	}
+
+	if (spilled)
+	{
+		delete[] cbu;
+		cbu	 = nullptr;
+		cmax = 0;
+	}
 }
 
 
@@ -505,10 +608,8 @@ void RzxBlock::startFrame(uint32 cc)
 	assert(ucsize == 0 || ucbu != nullptr);
 	assert(current_frame == num_frames);
 
-	// compressed buffer becomes invalid:
-	delete[] cbu;
-	cbu	  = nullptr;
-	csize = 0;
+	// compressed buffer becomes invalid, except for the deflate stream:
+	if (!zs) drop_cbu();
 
 	// fpos = valid
 	// apos = valid
@@ -576,6 +677,10 @@ void RzxBlock::endFrame(uint icount)
 	current_frame = num_frames += 1;
 	ucsize		  = fpos;
 	// ipos invalid
+
+	// deflate all frames except this one:
+	// amendFrame() may still modify its header
+	if (apos - 4 > zpos) deflate_ucbu(apos - 4, Z_NO_FLUSH);
 }
 
 
@@ -591,9 +696,7 @@ void RzxBlock::startRecording()
 	assert(ucsize == 0 || ucbu != nullptr);
 
 	// compressed buffer becomes invalid:
-	delete[] cbu;
-	cbu	  = nullptr;
-	csize = 0;
+	drop_cbu();
 
 	// fpos valid
 	// apos valid
@@ -728,7 +831,6 @@ void RzxBlock::compress()
 	assert(isaInputRecordingBlock());
 	if (state == Compressed) return;
 
-	assert(csize == 0 || cbu != nullptr);
 	assert(ucsize == 0 || ucbu != nullptr);
 	assert(ucsize <= ucmax);
 
@@ -743,6 +845,23 @@ void RzxBlock::compress()
 }
 
 
+/*	COMPRESSED: move cbu[] to the spill file
+	cbu[] is read back when the block is uncompressed or written.
+*/
+void RzxBlock::spill(RzxSpillFile* sf)
+{
+	assert(isaInputRecordingBlock());
+	assert(state == Compressed);
+
+	if (cbu == nullptr) return; // empty or already spilled
+
+	spos	   = sf->write(cbu, csize); // takes ownership
+	spill_file = sf;
+	cbu		   = nullptr;
+	cmax	   = 0;
+}
+
+
 /*	ANY TIME: read Input Recording Block from rzx file
 	state -> Playing | EndOfBlock
 
@@ -984,8 +1103,11 @@ void RzxBlock::write(FD& fd)
 		break;
 	}
 	case IsaInputRecordingBlock:
+	{
 		xlogline("write Input Recording Block");
 		_compress();
+		bool spilled = cbu == nullptr && csize != 0;
+		load_cbu();
 		fd.write_uint8(0x80);			// block ID
 		fd.write_uint32_z(18 + csize);	// Block length (with compressed data)
 		fd.write_uint32_z(num_frames);	// Number of frames in the block
@@ -993,13 +1115,15 @@ void RzxBlock::write(FD& fd)
 		fd.write_uint32_z(cc_at_start); // T-STATES counter at the beginning
 		fd.write_uint32_z(2);			// Flags: 2 = compressed
 		fd.write_bytes(&cbu[0], csize); // Frame data (compressed)
-		if (state == Recording)
+		if (state == Recording) drop_cbu(); // deflating restarts with the next frame
+		else if (spilled)
 		{
 			delete[] cbu;
-			cbu	  = nullptr;
-			csize = 0;
+			cbu	 = nullptr;
+			cmax = 0;
 		}
 		break;
+	}
 
 	default: IERR();
 	}
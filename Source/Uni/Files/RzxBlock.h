@@ -8,6 +8,8 @@
 #include "kio/peekpoke.h"
 
 extern void throw_zlib_error(int err);
+class RzxSpillFile;
+struct z_stream_s;
 
 
 // Input Recording Block (IRB), ID=0x80
@@ -39,6 +41,15 @@ struct RzxBlock
 
 			uint8* cbu;	  // compressed input recording data as in rzx file at IRB+0x12
 			uint32 csize; // compressed data size
+			uint32 cmax;  // allocated size while streaming
+
+			// recording: ucbu[] is deflated frame by frame into cbu[]
+			struct z_stream_s* zs;	 // deflate stream or nullptr
+			uint32			   zpos; // ucbu[] data up to zpos was fed into zs
+
+			// finished blocks of a recording: cbu[] was moved to the spill file
+			RzxSpillFile* spill_file; // if cbu == nullptr && csize != 0
+			off_t		  spos;		  // position of cbu[] in the spill file
 
 			uint8* ucbu;   // uncompressed input recording data as in rzx file at IRB+0x12
 			uint32 ucsize; // uncompressed data size
@@ -46,6 +57,7 @@ struct RzxBlock
 
 			uint32 cc_at_start; // cpu cycle counter at start of block, 0=unknown
 			uint32 num_frames;
+			uint32 first_frame; // frame index: number of the first frame in the file
 
 			// current frame play/record position:
 			uint32 current_frame; // frame number
@@ -113,7 +125,8 @@ struct RzxBlock
 	void endFrame(uint);		// recording
 	void amendFrame(uint);		// recording
 	void compress();
-	int	 uncompress() noexcept(false); // data_error
+	void spill(RzxSpillFile*); // compressed
+	int	 uncompress() noexcept(false); // data_error,file_error
 
 	// read from / write to rzx file:
 	void readInputRecordingBlock(FD&, uint32 blklen);		   // file_error,data_error
@@ -126,6 +139,9 @@ private:
 	void kill();
 	void resize_ucbu(uint32 newmax);
 	void scan_ucbu();
+	void drop_cbu();
+	void load_cbu() noexcept(false); // file_error
+	void deflate_ucbu(uint32 end, int flush);
 	void _compress();
-	void _uncompress() noexcept(false); // data_error
+	void _uncompress() noexcept(false); // data_error,file_error
 };
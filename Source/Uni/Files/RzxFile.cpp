@@ -4,6 +4,8 @@
 
 #include "RzxFile.h"
 #include "RzxBlock.h"
+#include "RzxSpillFile.h"
+#include "StateBuffer.h"
 #include "kio/TestTimer.h"
 #include "unix/files.h"
 #include "version.h"
@@ -151,8 +153,10 @@ void RzxFile::init()
 	creator_minor_version = 0;
 	rzx_file_version	  = 0;
 	blocks.purge();
-	bi	  = 0; // blocks.count();
-	state = EndOfFile;
+	keyframes.purge();
+	bi		   = 0; // blocks.count();
+	spill_file = nullptr;
+	state	   = EndOfFile;
 }
 
 
@@ -162,6 +166,8 @@ void RzxFile::kill()
 {
 	delete[] creator_name;
 	delete[] filename;
+	delete spill_file; // blocks[] are purged in init()
+	for (uint i = 0; i < keyframes.count(); i++) { delete keyframes[i].state; }
 	// for(uint i=0; i<blocks.count(); i++) { blocks[i].kill(); }
 	// blocks.purge();
 }
@@ -203,6 +209,7 @@ void RzxFile::rewind()
 	if (bi < blocks.count() && blocks[bi].isaInputRecordingBlock()) blocks[bi].compress();
 
 	bi = 0;
+	index_frames();
 
 	if (blocks.count() == 0) state = EndOfFile;
 
@@ -386,6 +393,7 @@ void RzxFile::readFile(cstr filename, bool snapshotOnly) // throws DataError,fil
 	if (blocks[0].isaInputRecordingBlock()) throw DataError("file has no initial snapshot");
 
 	// bi = 0;
+	index_frames();
 	state = Snapshot; // position = Snapshotfile Block
 
 	TTest(1e-3, "RzxFile:readFile()");
@@ -454,6 +462,128 @@ int32 RzxFile::getStartCC()
 }
 
 
+/*	PLAYBACK: go to the start of a frame
+	the machine must restore a matching state, e.g. from a keyframe.
+
+	Playing | Snapshot -> Playing
+
+	return:	≥0:	icount
+			-1:	frame beyond end of file: state unchanged
+	throws:	DataError or FileError from uncompressing the block: state unchanged, may be OutOfSync
+*/
+int RzxFile::seekFrame(uint32 frame)
+{
+	assert(isPlaying() || isSnapshot());
+
+	uint i = 0;
+	while (i < blocks.count() && !(blocks[i].isaIRB() && frame < blocks[i].first_frame + blocks[i].num_frames)) i++;
+	if (i == blocks.count()) return -1;
+
+	RzxBlock& block = blocks[i];
+	int		  icount;
+
+	if (block.isCompressed()) icount = block.uncompress(); // throws
+	else icount = block.rewind();
+
+	if (bi != i && bi < blocks.count() && blocks[bi].isaIRB()) blocks[bi].compress();
+	bi = i;
+
+	while (block.current_frame < frame - block.first_frame) icount = block.nextFrame();
+
+	state = Playing;
+	return icount;
+}
+
+
+/*	ANY TIME: total number of frames
+ */
+uint32 RzxFile::frameCount() const { return frames_before(blocks.count()); }
+
+
+/*	ANY TIME: number of the current frame
+	Recording or EndOfFile: number of frames recorded so far
+*/
+uint32 RzxFile::currentFrame() const
+{
+	if (bi < blocks.count() && blocks[bi].isaIRB() && !blocks[bi].isCompressed())
+		return blocks[bi].first_frame + blocks[bi].current_frame;
+	else return frames_before(bi);
+}
+
+
+//	helper: number of frames in all blocks before blocks[bi]
+//
+uint32 RzxFile::frames_before(uint bi) const
+{
+	while (bi--)
+	{
+		if (blocks[bi].isaIRB()) return blocks[bi].first_frame + blocks[bi].num_frames;
+	}
+	return 0;
+}
+
+
+//	helper: number the frames of all input recording blocks
+//
+void RzxFile::index_frames()
+{
+	uint32 n = 0;
+	for (uint i = 0; i < blocks.count(); i++)
+	{
+		if (!blocks[i].isaIRB()) continue;
+		blocks[i].first_frame = n;
+		n += blocks[i].num_frames;
+	}
+}
+
+
+/*	PLAYBACK: is a keyframe due at the start of this frame?
+	keyframes are stored in ascending order while replaying
+*/
+bool RzxFile::needsKeyframe(uint32 frame) const
+{
+	return frame % keyframe_interval == 0 && (keyframes.count() == 0 || frame > keyframes.last().frame);
+}
+
+
+/*	PLAYBACK: add keyframe
+	takes ownership of the machine state
+*/
+void RzxFile::addKeyframe(uint32 frame, StateBuffer* state)
+{
+	assert(needsKeyframe(frame));
+
+	Keyframe& kf = keyframes.grow();
+	kf.frame	 = frame;
+	kf.state	 = state;
+}
+
+
+/*	PLAYBACK: find the nearest keyframe at or before a frame
+ */
+const RzxFile::Keyframe* RzxFile::findKeyframe(uint32 frame) const
+{
+	for (uint i = keyframes.count(); i--;)
+	{
+		if (keyframes[i].frame <= frame) return &keyframes[i];
+	}
+	return nullptr;
+}
+
+
+/*	ANY TIME: remove all keyframes behind after_frame, default: all
+	the machine must remove all keyframes if items are added or removed: their state no longer matches
+*/
+void RzxFile::purgeKeyframes(int32 after_frame)
+{
+	while (keyframes.count() && int64(keyframes.last().frame) > after_frame)
+	{
+		delete keyframes.last().state;
+		keyframes.drop();
+	}
+}
+
+
 /*	PLAYBACK: get Snapshot filename
 
 	Snapshot -> Playing | EndOfFile
@@ -501,7 +631,7 @@ void RzxFile::storeSnapshot(cstr fname)
 
 	if (bi < blocks.count())
 	{
-		if (blocks[bi].num_frames) blocks[bi++].compress();
+		if (blocks[bi].num_frames) spill(blocks[bi++]);
 		else
 		{
 			blocks[bi].kill();
@@ -529,7 +659,7 @@ void RzxFile::startBlock(int32 cc)
 
 	if (bi < blocks.count())
 	{
-		if (blocks[bi].num_frames) blocks[bi++].compress();
+		if (blocks[bi].num_frames) spill(blocks[bi++]);
 		else
 		{
 			blocks[bi].kill();
@@ -537,8 +667,10 @@ void RzxFile::startBlock(int32 cc)
 		}
 	}
 
-	RzxBlock& block = blocks.grow();
+	uint32	  first_frame = frameCount();
+	RzxBlock& block		  = blocks.grow();
 	block.init(RzxBlock::IsaInputRecordingBlock);
+	block.first_frame = first_frame;
 	block.startFrame(cc);
 	state = Recording;
 }
@@ -688,6 +820,9 @@ void RzxFile::startRecording()
 		blocks.drop();
 	}
 
+	// remove all keyframes behind the current frame:
+	purgeKeyframes(int32(currentFrame()));
+
 	// truncate current block and start recording:
 	blocks[bi].startRecording();
 	state = Recording;
@@ -812,6 +947,30 @@ void RzxFile::amendFrame(uint icount)
 }
 
 
+//	helper: compress a finished recording block and move the data to the spill file
+//	if the spill file can't be created, then the data stays in memory.
+//
+void RzxFile::spill(RzxBlock& block)
+{
+	block.compress();
+
+	if (!spill_file)
+	{
+		try
+		{
+			spill_file = new RzxSpillFile;
+		}
+		catch (AnyError& e)
+		{
+			logline("RzxFile: creating the spill file failed: %s", e.what());
+			return;
+		}
+	}
+
+	block.spill(spill_file);
+}
+
+
 // static
 cstr RzxFile::getFirstSnapshot(cstr filename)
 {
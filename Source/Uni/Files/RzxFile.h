@@ -10,6 +10,9 @@
 #include "kio/kio.h"
 #include <zlib.h>
 
+class RzxSpillFile;
+class StateBuffer;
+
 #define OurRzxLibraryVersion 0x000C // rzx file version we create
 #define MaxRzxLibraryVersion 0x000D // some changes in encryption (we don't use)
 
@@ -26,8 +29,18 @@ public:
 	uint16 rzx_file_version;
 
 	// input recording blocks:
-	Array<RzxBlock> blocks; // input recording blocks
-	uint			bi;		// current index in blocks[]
+	Array<RzxBlock> blocks;		// input recording blocks
+	uint			bi;			// current index in blocks[]
+	RzxSpillFile*	spill_file; // recording: compressed data of finished blocks
+
+	// machine states for seeking, stored by the machine while replaying:
+	static constexpr uint32 keyframe_interval = 1500; // frames: 30 sec. @ 50 Hz
+	struct Keyframe
+	{
+		uint32		 frame; // machine state at the start of this frame
+		StateBuffer* state; // owned, deleted with the RzxFile
+	};
+	Array<Keyframe> keyframes; // ascending frame numbers
 
 	enum State {
 		// state:
@@ -90,6 +103,7 @@ public:
 		getCC			Playing		--> Playing
 		getIcount		Playing		--> Playing
 		startRecording	Playing		--> Recording
+		seekFrame		Playing		--> Playing
 	*/
 
 	bool isPlaying() const { return state == Playing; }
@@ -113,6 +127,17 @@ public:
 	int	  getInput();	 // input lesen					Playing
 	int	  getIcount();	 // instr count für Frame lesen	Playing
 	int32 getStartCC();	 // CC am Frame-Start lesen		Playing
+	int	  seekFrame(uint32);	 // zum Frame springen			Playing | Snapshot -> Playing	data_error,file_error
+
+	// frame index:
+	uint32 frameCount() const;	 // any time
+	uint32 currentFrame() const; // any time
+
+	// keyframes:
+	bool			needsKeyframe(uint32 frame) const;
+	void			addKeyframe(uint32 frame, StateBuffer*);
+	const Keyframe* findKeyframe(uint32 frame) const; // nearest keyframe ≤ frame or nullptr
+	void			purgeKeyframes(int32 after_frame = -1); // remove keyframes > after_frame
 
 	void storeSnapshot(cstr);	  // Snapshot speichern			EndOfFile
 	void startBlock(int32 cc);	  // neuen Block starten			EndOfFile -> Recording
@@ -125,6 +150,9 @@ public:
 	static cstr getFirstSnapshot(cstr filename);
 
 private:
-	void init();
-	void kill();
+	void   init();
+	void   kill();
+	void   spill(RzxBlock&);
+	void   index_frames();
+	uint32 frames_before(uint bi) const;
 };
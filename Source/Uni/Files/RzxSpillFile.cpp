@@ -0,0 +1,153 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "RzxSpillFile.h"
+#include "unix/files.h"
+#include "zxsp_globals.h"
+#include <unistd.h>
+
+
+RzxSpillFile::RzxSpillFile() noexcept(false) : fsize(0), failed(false), wp(0), rp(0)
+{
+	cstr tmpdir = "/tmp/zxsp/";
+	create_dir(tmpdir);
+	cstr path = usingstr("%srzx-%i-%p.tmp", tmpdir, int(getpid()), this);
+
+	fd_w.open_file_w(path);
+	fd_r.open_file_r(path);
+	unlink(path);
+
+	slots_free.release(queue_size);
+
+	int e = pthread_create(&worker_thread, nullptr /*attr*/, worker_proc, this /*args*/);
+	if (e) throw AnyError(usingstr("Creating the rzx spill file thread failed: %s", strerror(e)));
+}
+
+
+RzxSpillFile::~RzxSpillFile()
+{
+	push_job(Job::Stop, nullptr, 0, 0);
+	pthread_join(worker_thread, nullptr);
+
+	for (uint i = 0; i < kept.count(); i++) delete[] kept[i].data;
+}
+
+
+// ---------------------------------------------------------
+//		producer
+// ---------------------------------------------------------
+
+
+void RzxSpillFile::push_job(Job::Type type, uint8* data, uint32 size, off_t fpos)
+{
+	slots_free.request(); // wait until the worker has freed a slot
+
+	Job& job = queue[wp.load(std::memory_order_relaxed) & (queue_size - 1)];
+	job.type = type;
+	job.data = data;
+	job.size = size;
+	job.fpos = fpos;
+
+	wp.store(wp.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	jobs_avail.release();
+}
+
+
+void RzxSpillFile::sync()
+{
+	// wait until all queued data is written
+
+	push_job(Job::Sync, nullptr, 0, 0);
+	synced.request();
+}
+
+
+off_t RzxSpillFile::write(uint8* data, uint32 size)
+{
+	// append data to the spill file
+	// the data is deleted by the worker thread after it was written
+	// returns the file position for read()
+
+	off_t fpos = fsize;
+	fsize += size;
+	push_job(Job::Write, data, size, fpos);
+	return fpos;
+}
+
+
+void RzxSpillFile::read(off_t fpos, uint8* data, uint32 size) noexcept(false) // FileError
+{
+	// read back data
+	// waits until all queued data is written
+
+	sync();
+
+	for (uint i = 0; i < kept.count(); i++)
+	{
+		if (kept[i].fpos != fpos) continue;
+		assert(kept[i].size == size);
+		memcpy(data, kept[i].data, size);
+		return;
+	}
+
+	fd_r.seek_fpos(fpos);
+	fd_r.read_bytes(data, size);
+}
+
+
+// ---------------------------------------------------------
+//		worker thread
+// ---------------------------------------------------------
+
+
+// static
+void* RzxSpillFile::worker_proc(void* self) { return ((RzxSpillFile*)self)->worker_proc(); }
+
+
+/*	worker thread executor:
+	- waits for jobs_avail
+	- releases the slot
+	- writes the data and deletes it
+	  or releases synced
+*/
+void* RzxSpillFile::worker_proc()
+{
+	for (;;)
+	{
+		jobs_avail.request(); // wait for next job
+
+		uint32 i = rp.load(std::memory_order_relaxed);
+		assert(i != wp.load(std::memory_order_acquire));
+		Job job = queue[i & (queue_size - 1)];
+
+		rp.store(i + 1, std::memory_order_release);
+		slots_free.release();
+
+		if (job.type == Job::Stop) return nullptr;
+
+		if (job.type == Job::Sync)
+		{
+			synced.release();
+			continue;
+		}
+
+		if (!failed)
+		{
+			try
+			{
+				fd_w.seek_fpos(job.fpos);
+				fd_w.write_bytes(job.data, job.size);
+				delete[] job.data;
+				continue;
+			}
+			catch (FileError& e)
+			{
+				showWarning("rzx recording: writing the temp file failed: %s", e.what());
+				failed = true;
+			}
+		}
+
+		kept.append(job); // keep data in memory
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "Templates/Array.h"
+#include "cpp/cppthreads.h"
+#include "kio/kio.h"
+#include "unix/FD.h"
+#include <atomic>
+#include <pthread.h>
+
+
+/*	Temp file for the compressed data of finished rzx input recording blocks.
+
+	While recording, each finished block is handed over to the spill file and its memory is released
+	by the worker thread after it was written. So the memory used by a recording stays constant,
+	no matter how long the recording runs.
+
+	The file is unlinked right after creation and vanishes when it is closed.
+	If writing fails the data is kept in memory.
+
+	There is exactly one producer and one consumer: see MovieRecorder.
+*/
+class RzxSpillFile
+{
+	static constexpr uint queue_size = 16; // must be 2^N
+
+	struct Job
+	{
+		enum Type : uint8 { Write, Sync, Stop };
+		Type   type;
+		uint8* data;
+		uint32 size;
+		off_t  fpos;
+	};
+
+	FD		   fd_w;   // worker thread
+	FD		   fd_r;   // reading thread
+	off_t	   fsize;  // file size after all queued jobs are written
+	bool	   failed; // write error: keep the data in memory
+	Array<Job> kept;   // data which could not be written
+
+	Job					queue[queue_size];
+	std::atomic<uint32> wp; // next job to write: producer
+	std::atomic<uint32> rp; // next job to read:  worker thread
+	PSemaphore			jobs_avail;
+	PSemaphore			slots_free;
+	PSemaphore			synced;
+
+	pthread_t	 worker_thread;
+	static void* worker_proc(void*);
+	void*		 worker_proc();
+
+	void push_job(Job::Type, uint8* data, uint32 size, off_t fpos);
+	void sync();
+
+public:
+	RzxSpillFile() noexcept(false); // FileError
+	~RzxSpillFile();
+	NO_COPY_MOVE(RzxSpillFile);
+
+	off_t write(uint8* data, uint32 size); // takes ownership of data[]; returns file position
+	void  read(off_t fpos, uint8* data, uint32 size) noexcept(false); // FileError
+};
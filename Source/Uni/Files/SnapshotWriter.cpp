@@ -0,0 +1,163 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "SnapshotWriter.h"
+#include "unix/FD.h"
+#include <unistd.h>
+
+
+SnapshotWriter::SnapshotWriter() noexcept(false) : wp(0), rp(0)
+{
+	slots_free.release(queue_size);
+
+	int e = pthread_create(&worker_thread, nullptr /*attr*/, worker_proc, this /*args*/);
+	if (e) throw AnyError(usingstr("Creating the snapshot writer thread failed: %s", strerror(e)));
+}
+
+
+SnapshotWriter::~SnapshotWriter()
+{
+	slots_free.request();
+	push_job(Job::Stop, nullptr);
+	pthread_join(worker_thread, nullptr);
+}
+
+
+// ---------------------------------------------------------
+//		machine thread
+// ---------------------------------------------------------
+
+
+void SnapshotWriter::push_job(Job::Type type, cstr path)
+{
+	// the caller has requested the slot
+
+	Job& job = queue[wp.load(std::memory_order_relaxed) & (queue_size - 1)];
+	job.type = type;
+	job.path = path;
+
+	wp.store(wp.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	jobs_avail.release();
+}
+
+
+Z80Snapshot& SnapshotWriter::nextSnapshot()
+{
+	// get the snapshot of the next free slot
+	// the caller must fill it and then call write()
+
+	slots_free.request(); // wait until the worker has freed a slot
+
+	Z80Snapshot& snapshot = queue[wp.load(std::memory_order_relaxed) & (queue_size - 1)].snapshot;
+	snapshot.clear();
+	return snapshot;
+}
+
+
+void SnapshotWriter::write(cstr path)
+{
+	Job& job = queue[wp.load(std::memory_order_relaxed) & (queue_size - 1)];
+	job.attached.store(true, std::memory_order_relaxed);
+	num_attached.fetch_add(1, std::memory_order_relaxed);
+
+	push_job(Job::Write, newcopy(path));
+}
+
+
+void SnapshotWriter::sync()
+{
+	slots_free.request();
+	push_job(Job::Sync, nullptr);
+	synced.request();
+}
+
+
+void SnapshotWriter::copyOnWrite(const CoreByte* p) noexcept
+{
+	// the machine is going to modify the byte at p:
+	// copy the block into all queued snapshots which still refer to it.
+	// the worker may finish jobs meanwhile but the slots are only reused by this thread.
+
+	uint32 e = wp.load(std::memory_order_relaxed);
+	for (uint32 i = rp.load(std::memory_order_acquire); i != e; i++)
+	{
+		Job& job = queue[i & (queue_size - 1)];
+		if (job.type == Job::Write && job.attached.load(std::memory_order_acquire)) job.snapshot.copyOnWrite(p);
+	}
+}
+
+
+void SnapshotWriter::detach() noexcept
+{
+	// the machine is going to modify, reallocate or delete memory in bulk:
+	// copy all pages which are not yet copied. This does not wait for compressing and writing.
+
+	uint32 e = wp.load(std::memory_order_relaxed);
+	for (uint32 i = rp.load(std::memory_order_acquire); i != e; i++)
+	{
+		Job& job = queue[i & (queue_size - 1)];
+		if (job.type == Job::Write) detach(job);
+	}
+}
+
+
+void SnapshotWriter::detach(Job& job) noexcept
+{
+	// machine thread or worker thread
+
+	if (!job.attached.load(std::memory_order_acquire)) return;
+	job.snapshot.copyPages();
+	if (job.attached.exchange(false, std::memory_order_acq_rel)) num_attached.fetch_sub(1, std::memory_order_release);
+}
+
+
+// ---------------------------------------------------------
+//		worker thread
+// ---------------------------------------------------------
+
+
+// static
+void* SnapshotWriter::worker_proc(void* self) { return ((SnapshotWriter*)self)->worker_proc(); }
+
+
+/*	worker thread executor:
+	- waits for jobs_avail
+	- copies the pages, then writes the snapshot, or releases synced
+	- releases the slot: the snapshot is used in place
+*/
+void* SnapshotWriter::worker_proc()
+{
+	for (;;)
+	{
+		jobs_avail.request(); // wait for next job
+
+		uint32 i = rp.load(std::memory_order_relaxed);
+		assert(i != wp.load(std::memory_order_acquire));
+		Job& job = queue[i & (queue_size - 1)];
+
+		if (job.type == Job::Stop) return nullptr;
+
+		if (job.type == Job::Sync) synced.release();
+		else
+		{
+			detach(job); // the machine may modify its memory again
+
+			try
+			{
+				FD fd(job.path, 'w');
+				job.snapshot.write(fd);
+			}
+			catch (AnyError& e)
+			{
+				logline("SnapshotWriter: %s: %s", job.path, e.what());
+				unlink(job.path);
+			}
+			delete[] job.path;
+			job.path = nullptr;
+		}
+
+		rp.store(i + 1, std::memory_order_release);
+		slots_free.release();
+	}
+}
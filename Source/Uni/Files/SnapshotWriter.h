@@ -0,0 +1,72 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "Z80Snapshot.h"
+#include "cpp/cppthreads.h"
+#include "kio/kio.h"
+#include <atomic>
+#include <pthread.h>
+
+
+/*	Write .z80 snapshots on a worker thread
+
+	The machine thread freezes the machine into the next free Z80Snapshot and queues it.
+	The snapshot only refers to the machine's memory: the worker thread copies the pages, then compresses
+	and writes it. Then the slot is free for the next snapshot.
+	If all slots are in use the machine thread waits for the oldest snapshot to be written.
+
+	Copy-on-write: while isPending() the machine must call copyOnWrite() before it modifies a byte.
+	The Z80 does this in POKE and in its poke() functions. Before the memory is modified in bulk,
+	reallocated or deleted the machine must call detach().
+
+	Write errors can't be reported to the caller: they are logged and the file is removed,
+	so that a later load fails with "file not found".
+	Before a queued file is read or removed the caller must sync().
+
+	There is exactly one producer and one consumer: see MovieRecorder.
+*/
+class SnapshotWriter
+{
+	static constexpr uint queue_size = 4; // must be 2^N
+
+	struct Job
+	{
+		enum Type : uint8 { Write, Sync, Stop };
+		Type		type = Write;
+		cstr		path = nullptr; // allocated
+		Z80Snapshot snapshot;
+
+		std::atomic<bool> attached {false}; // snapshot still refers to the machine's memory
+	};
+
+	Job					queue[queue_size];
+	std::atomic<uint32> wp; // next job to write: machine thread
+	std::atomic<uint32> rp; // next job to read:  worker thread
+	PSemaphore			jobs_avail;
+	PSemaphore			slots_free;
+	PSemaphore			synced;
+	std::atomic<uint32> num_attached {0}; // number of queued snapshots which refer to the machine's memory
+
+	pthread_t	 worker_thread;
+	static void* worker_proc(void*);
+	void*		 worker_proc();
+
+	void push_job(Job::Type, cstr path);
+	void detach(Job&) noexcept;
+
+public:
+	SnapshotWriter() noexcept(false); // AnyError
+	~SnapshotWriter();				  // writes all queued snapshots
+	NO_COPY_MOVE(SnapshotWriter);
+
+	// machine thread:
+	Z80Snapshot& nextSnapshot();	// waits for a free slot
+	void		 write(cstr path);		// queue the snapshot from nextSnapshot()
+	void		 sync();				// wait until all queued snapshots are written
+	void		 detach() noexcept;		// copy all pages of all queued snapshots
+
+	bool isPending() const noexcept { return num_attached.load(std::memory_order_acquire); }
+	void copyOnWrite(const CoreByte* p) noexcept; // before the machine modifies the byte at p
+};
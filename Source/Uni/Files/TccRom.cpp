@@ -172,6 +172,7 @@ TccRom::TccRom(Machine* machine, cstr path) :
 					if (r & (1 << i))
 						dock[i] = new Memory(
 							machine, usingstr("TCC Dock Bank %i", i), 0x2000);	// bank present => allocate ram
+					if (r & (1 << i)) dock[i]->is_rom = !(w & (1 << i));
 					if (d & (1 << i)) read_buffer(fd, dock[i].getData(), hash); // init data present => read it
 				}
 			}
@@ -190,6 +191,7 @@ TccRom::TccRom(Machine* machine, cstr path) :
 					if (r & (1 << i))
 						exrom[i] = new Memory(
 							machine, usingstr("TCC Exrom bank %i", i), 0x2000);	 // bank present => allocate ram
+					if (r & (1 << i)) exrom[i]->is_rom = !(w & (1 << i));
 					if (d & (1 << i)) read_buffer(fd, exrom[i].getData(), hash); // init data present => read it
 				}
 			}
@@ -205,6 +207,7 @@ TccRom::TccRom(Machine* machine, cstr path) :
 					rom = new uint8[0x4000];
 					Z80::c2b(machine->rom.getData(), rom, 0x4000);
 				}
+				if (w & 3) machine->rom->is_rom = no; // ram in the cartridge
 
 				for (int i = 0; i < 8; i++)
 				{
@@ -258,6 +261,7 @@ TccRom::~TccRom()
 	if (rom) // restore internal rom
 	{
 		Z80::b2c(rom, machine->rom.getData(), 0x4000);
+		machine->rom->is_rom = yes;
 		delete[] rom;
 	}
 
@@ -0,0 +1,168 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "Z80Snapshot.h"
+
+
+/* ----	write compressed .z80 block -------------------------------------------
+		writes block header and compressed data for v2.01 or later
+		block layout:
+			dc.w		length of data (without this header; low byte first)
+			dc.b		page number of block
+			dc.s		compressed data follows
+		compression scheme:
+			dc.b $ed, $ed, count, char
+*/
+static void write_compressed_page(FD& fd, uint8 flag, const uint8* q, uint qsize)
+{
+	xlogIn("write_compressed_page(%i)", int(flag));
+
+	assert(qsize >= 1 kB && qsize <= 64 kB);
+
+	const uint8* qe = q + qsize;
+	uint8		 bu[qsize * 5 / 3]; // worst case size: 5/3*qsize
+	uint8*		 z = bu;
+
+	while (q < qe)
+	{
+		uint8 c = *q++;
+		if (q == qe || *q != c) // single byte
+		{
+			*z++ = c;
+			// special care for compressible sequence after single 0xed:
+			if (c == 0xed && q + 2 <= qe && *q == *(q + 1)) { *z++ = *q++; }
+		}
+		else // sequence of same bytes
+		{
+			int n = 1;
+			while (n < 255 && q < qe && *q == c)
+			{
+				n++;
+				q++;
+			}
+			if (n >= 4 || c == 0xed)
+			{
+				*z++ = 0xed;
+				*z++ = 0xed;
+				*z++ = n;
+				*z++ = c;
+			} // compress ?
+			else
+			{
+				while (n--) *z++ = c;
+			} // don't compress
+		}
+	}
+
+	uint zsize = z - bu;
+	fd.write_uint16_z(zsize);
+	fd.write_char(flag);
+	fd.write_bytes(bu, zsize);
+}
+
+
+void Z80Snapshot::clear()
+{
+	head.clear();
+	while (pages.count()) pages.drop();
+	data_size = 0;
+}
+
+
+void Z80Snapshot::addPage(uint8 id, const CoreByte* q, uint32 size)
+{
+	// append a memory page
+	// only a reference to the memory is stored: the bytes are copied later by copy_block()
+	// the flags in the CoreBytes are not saved in the file
+
+	assert(size % block_size == 0);
+
+	if (data_size + size > data_max)
+	{
+		uint32				newmax	 = max(data_size + size, 2 * data_max);
+		uint8*				newdata	 = new uint8[newmax];
+		std::atomic<uint8>* newstate = new std::atomic<uint8>[newmax / block_size];
+		memcpy(newdata, data, data_size);
+		for (uint32 i = 0; i < data_size / block_size; i++) newstate[i].store(state[i].load());
+		delete[] data;
+		delete[] state;
+		data	 = newdata;
+		state	 = newstate;
+		data_max = newmax;
+	}
+
+	for (uint32 i = 0; i < size / block_size; i++) { state[data_size / block_size + i].store(Live); }
+
+	pages.append(Page {id, data_size, size, q});
+	data_size += size;
+}
+
+
+void Z80Snapshot::copy_block(const Page& page, uint32 offset) noexcept
+{
+	// copy the data bytes of one block from the machine's memory
+	// called by the machine thread and by the writer thread: whoever comes first copies the block
+
+	std::atomic<uint8>& st = state[(page.offset + offset) / block_size];
+
+	uint8 live = Live;
+	if (st.compare_exchange_strong(live, Copying, std::memory_order_acquire))
+	{
+		uint8* z = data + page.offset + offset;
+		if (page.core)
+		{
+			const CoreByte* q = page.core + offset;
+			for (uint32 i = 0; i < block_size; i++) { z[i] = uint8(q[i]); }
+		}
+		else memset(z, 0, block_size);
+		st.store(Copied, std::memory_order_release);
+	}
+	else
+	{
+		// the other thread is copying this block. this takes less than a µs:
+		while (st.load(std::memory_order_acquire) != Copied) {}
+	}
+}
+
+
+void Z80Snapshot::copyOnWrite(const CoreByte* p) noexcept
+{
+	// the machine is going to modify the byte at p:
+	// copy the block if it is in a page of this snapshot and not yet copied
+
+	for (uint i = 0; i < pages.count(); i++)
+	{
+		const Page& page = pages[i];
+		if (page.core && p >= page.core && p < page.core + page.size)
+		{
+			copy_block(page, uint32(p - page.core) & ~(block_size - 1));
+		}
+	}
+}
+
+
+void Z80Snapshot::copyPages() noexcept
+{
+	for (uint i = 0; i < pages.count(); i++)
+	{
+		const Page& page = pages[i];
+		for (uint32 offset = 0; offset < page.size; offset += block_size) { copy_block(page, offset); }
+	}
+}
+
+
+void Z80Snapshot::write(FD& fd) noexcept(false)
+{
+	// copy and compress the pages and write the file
+	// may be called on any thread
+
+	copyPages();
+
+	head.write(fd);
+	for (uint i = 0; i < pages.count(); i++)
+	{
+		const Page& page = pages[i];
+		write_compressed_page(fd, page.id, data + page.offset, page.size);
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "Templates/Array.h"
+#include "Z80Head.h"
+#include "kio/kio.h"
+#include "unix/FD.h"
+#include <atomic>
+
+using CoreByte = uint32;
+
+
+/*	A .z80 snapshot frozen in memory: the header and the memory pages
+
+	Machine.freezeZ80() fills it on the machine thread. addPage() only stores a reference to the
+	machine's memory, so freezing takes O(pages), not O(memory).
+	The bytes are copied in blocks of 1 kB: by the writer thread in copyPages() before it compresses them,
+	or by the machine thread in copyOnWrite() before the cpu modifies a byte in a block which is not yet copied.
+	Each block is copied exactly once: the threads claim it with an atomic state.
+	After copyPages() the snapshot is independent of the Machine and write() can compress the pages
+	and write the file on another thread while the machine runs on.
+
+	The page buffer only grows: a reused snapshot does not allocate memory.
+*/
+class Z80Snapshot
+{
+	static constexpr uint32 block_size = 1 kB;
+
+	struct Page
+	{
+		uint8			id; // .z80 page number
+		uint32			offset;
+		uint32			size;
+		const CoreByte* core; // the machine's memory, until all blocks are copied. nullptr = all zero
+	};
+
+	enum BlockState : uint8 { Live, Copying, Copied };
+
+	Array<Page>			pages;
+	uint8*				data	  = nullptr;
+	std::atomic<uint8>* state	  = nullptr; // BlockState per block in data[]
+	uint32				data_size = 0;		 // used
+	uint32				data_max  = 0;		 // allocated
+
+	void copy_block(const Page&, uint32 offset) noexcept;
+
+public:
+	Z80Head head;
+
+	Z80Snapshot() = default;
+	~Z80Snapshot()
+	{
+		delete[] data;
+		delete[] state;
+	}
+	NO_COPY_MOVE(Z80Snapshot);
+
+	// machine thread:
+	void clear();
+	void addPage(uint8 id, const CoreByte* q, uint32 size); // q may be nullptr for an empty page
+	void copyOnWrite(const CoreByte* p) noexcept;			  // before the byte at p is modified
+
+	// any thread:
+	void copyPages() noexcept;		 // detach from the machine's memory
+	void write(FD&) noexcept(false); // copyPages() and write the file. FileError
+};
@@ -21,67 +21,11 @@
 #include "Ula/Mmu128k.h"
 #include "Z80/Z80.h"
 #include "Z80Head.h"
+#include "Z80Snapshot.h"
 #include "ZxIf1.h"
 #include "unix/FD.h"
 
 
-/* ----	write compressed .z80 block -------------------------------------------
-		writes block header and compressed data for v2.01 or later
-		block layout:
-			dc.w		length of data (without this header; low byte first)
-			dc.b		page number of block
-			dc.s		compressed data follows
-		compression scheme:
-			dc.b $ed, $ed, count, char
-*/
-static void write_compressed_page(FD& fd, uint8 flag, const CoreByte* q, uint qsize)
-{
-	xlogIn("write_compressed_page(%i)", int(flag));
-
-	assert(qsize >= 1 kB && qsize <= 64 kB);
-
-	const CoreByte* qe = q + qsize;
-	uint8			bu[qsize * 5 / 3]; // worst case size: 5/3*qsize
-	uint8*			z = bu;
-
-	while (q < qe)
-	{
-		uint8 c = *q++;
-		if (q == qe || uint8(*q) != c) // single byte
-		{
-			*z++ = c;
-			// special care for compressible sequence after single 0xed:
-			if (c == 0xed && q + 2 <= qe && uint8(*q) == uint8(*(q + 1))) { *z++ = *q++; }
-		}
-		else // sequence of same bytes
-		{
-			int n = 1;
-			while (n < 255 && q < qe && uint8(*q) == c)
-			{
-				n++;
-				q++;
-			}
-			if (n >= 4 || c == 0xed)
-			{
-				*z++ = 0xed;
-				*z++ = 0xed;
-				*z++ = n;
-				*z++ = c;
-			} // compress ?
-			else
-			{
-				while (n--) *z++ = c;
-			} // don't compress
-		}
-	}
-
-	uint zsize = z - bu;
-	fd.write_uint16_z(zsize);
-	fd.write_char(flag);
-	fd.write_bytes(bu, zsize);
-}
-
-
 /*  read an uncompressed v1.45 block
  */
 static void read_uncompressed_page(FD& fd, CoreByte* z, uint size)
@@ -176,12 +120,24 @@ e:
 
 
 /*  save .z80 file; version 3.00
+	synchronously: Machine.saveAs() uses saveAsInBackground()
  */
 void Machine::saveZ80(FD& fd)
 {
-	xlogIn("Machine:saveZ80");
+	Z80Snapshot snapshot;
+	freezeZ80(snapshot);
+	snapshot.write(fd);
+}
 
-	Z80Head head;
+
+/*	store the machine state for a .z80 file in a Z80Snapshot
+	the memory pages are only referenced: see saveAsInBackground()
+*/
+void Machine::freezeZ80(Z80Snapshot& snapshot)
+{
+	xlogIn("Machine:freezeZ80");
+
+	Z80Head& head = snapshot.head;
 	head.setRegisters(cpu->getRegisters());
 
 	head.h2lenl = z80v3len - 2 - z80v1len;
@@ -284,9 +240,6 @@ void Machine::saveZ80(FD& fd)
 		head.port_1ffd = mmu->getPort1ffd();
 	}
 
-	// write header data to file:
-	head.write(fd);
-
 
 	/*	Now the compressed ram pages follow. Each block has a 3 byte header:
 			dc.w		length of data (without this header; low byte first)
@@ -340,7 +293,7 @@ void Machine::saveZ80(FD& fd)
 		{
 			if (pages & (1 << i))
 			{
-				write_compressed_page(fd, 3 + i, &ram[addr], 0x400 << i);
+				snapshot.addPage(3 + i, &ram[addr], 0x400 << i);
 				addr += 0x400 << i;
 			}
 		}
@@ -350,9 +303,9 @@ void Machine::saveZ80(FD& fd)
 		uint n = ram.count() / 0x4000;
 		if (n <= 3) // no paging / no port 7ffd: write pages 8, 4 and 5:
 		{
-			write_compressed_page(fd, 8, &ram[0x0000], 0x4000);
-			if (n > 1) { write_compressed_page(fd, 4, &ram[0x4000], 0x4000); }
-			if (n > 2) { write_compressed_page(fd, 5, &ram[0x8000], 0x4000); }
+			snapshot.addPage(8, &ram[0x0000], 0x4000);
+			if (n > 1) { snapshot.addPage(4, &ram[0x4000], 0x4000); }
+			if (n > 2) { snapshot.addPage(5, &ram[0x8000], 0x4000); }
 		}
 		else // paged memory		note: should work for 256k-Scorpion and Timex too
 		{
@@ -379,23 +332,21 @@ void Machine::saveZ80(FD& fd)
 					visible |= 1 << (mmu128->getPage0000());
 				}
 
-				CoreByte noram[0x4000];
-				memset(&noram[0], 0, sizeof(CoreByte) * 0x4000);
 				for (uint i = 0; i < n; i++)
-					write_compressed_page(fd, i + 3, visible & (1 << i) ? &ram[i * 0x4000] : &noram[0], 0x4000);
+					snapshot.addPage(i + 3, visible & (1 << i) ? &ram[i * 0x4000] : nullptr, 0x4000);
 			}
 			else
 			{
-				for (uint i = 0; i < n; i++) write_compressed_page(fd, i + 3, &ram[i * 0x4000], 0x4000);
+				for (uint i = 0; i < n; i++) snapshot.addPage(i + 3, &ram[i * 0x4000], 0x4000);
 			}
 		}
 	}
 
 	if (spectra)
 	{
-		if (spectra->isRomInserted()) write_compressed_page(fd, 12, &spectra->rom[0x0000], 0x4000);
-		if (spectra->shadowram_ever_used) write_compressed_page(fd, 13, &spectra->shadowram[0x0000], 0x4000);
-		if (spectra->shadowram_ever_used) write_compressed_page(fd, 14, &spectra->shadowram[0x4000], 0x4000);
+		if (spectra->isRomInserted()) snapshot.addPage(12, &spectra->rom[0x0000], 0x4000);
+		if (spectra->shadowram_ever_used) snapshot.addPage(13, &spectra->shadowram[0x0000], 0x4000);
+		if (spectra->shadowram_ever_used) snapshot.addPage(14, &spectra->shadowram[0x4000], 0x4000);
 	}
 }
 
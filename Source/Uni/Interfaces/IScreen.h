@@ -6,6 +6,7 @@
 #include "graphics/geometry.h"
 #include "isa_id.h"
 struct IoInfo;
+class StereoSample;
 
 namespace zxsp
 {
@@ -43,6 +44,9 @@ public:
 	virtual bool ffb_or_vbi(
 		IoInfo* ioinfo, uint ioinfo_count, uint8* attr_pixels, uint32 cc_start_of_screenfile, uint cc_per_scanline,
 		bool flashphase, uint32 cc) = 0;
+
+	// Sound: the samples of a dsp buffer, e.g. for recording a movie:
+	virtual void audioBufferEnd(const StereoSample*, uint /*count*/) {}
 };
 
 
@@ -55,6 +59,17 @@ public:
 };
 
 
+// for frames which are not displayed, e.g. in run-ahead:
+// the frame is dropped and the real screen keeps the buffers it retains.
+class HiddenScreen : public IScreen
+{
+public:
+	bool ffb_or_vbi(uint8*, int, int, int, int, int, int, uint32) override { return false; }
+	bool sendFrame(uint8*, const zxsp::Size&, const zxsp::Rect&) override { return false; }
+	bool ffb_or_vbi(IoInfo*, uint, uint8*, uint32, uint, bool, uint32) override { return false; }
+};
+
+
 /* 
   
   
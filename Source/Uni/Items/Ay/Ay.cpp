@@ -26,6 +26,7 @@ $BFFD	%1011.----.----.--0-	ZX128 AY reg. write -/o
 
 #include "Ay.h"
 #include "Machine.h"
+#include "StateBuffer.h"
 #include "ZxInfo/ZxInfo.h"
 
 #undef BIT
@@ -267,6 +268,18 @@ void Channel::trigger()
 }
 
 
+/* ----	channel is muted: advance the counter beyond 'now' ---------
+		whole periods are skipped, so the phase is kept as in the chip.
+		the output does not change: the volume is 0 or the mixer closed both gates.
+*/
+void Channel::skip(Time now)
+{
+	int32 n = int32((now - when) / reload) + 1;
+	when += n * reload;
+	if (n & 1) mixSoundInput(!sound_in);
+}
+
+
 /* ===============================================================
 			noise generator
 =============================================================== */
@@ -357,6 +370,17 @@ void Noise::trigger()
 }
 
 
+/* ----	noise is not used: advance the counter beyond 'now' --------
+		the shift register keeps running as in the chip.
+		the output does not change: no channel mixes the noise.
+*/
+void Noise::skip(Time now)
+{
+	do trigger();
+	while (when - now < 0);
+}
+
+
 /* ===============================================================
 			envelope generator
 =============================================================== */
@@ -396,7 +420,7 @@ void Envelope::reset(Time now)
 {
 	reload = 0x0000ffff * time_for_cycle;
 	when   = now + reload;
-	fine = coarse = 0xff;
+	fine = coarse = 0x00; // as in AYregReset
 	index		  = 0;
 	repeat = invert = off;
 	direction		= 0;
@@ -507,6 +531,188 @@ void Envelope::trigger()
 }
 
 
+/* ----	envelope is not used: advance the counter beyond 'now' -----
+		the envelope keeps running as in the chip.
+		the output does not change: no channel uses the envelope.
+*/
+void Envelope::skip(Time now)
+{
+	do trigger();
+	while (when - now < 0);
+}
+
+
+/* ===============================================================
+			integer-tick synthesis core
+=============================================================== */
+
+/*	all counters of the tick core count in ticks of 8 PSG cycles:
+	tone:	  half period = max(1,period) ticks
+	noise:	  period = max(1,period) * 2 ticks
+	envelope: step = max(1,period) * 2 ticks
+
+	the generators are rendered as runs of constant state into float buffers,
+	one buffer per generator, then mixed in a branchless loop.
+	changes of the mixed output are posted to the step buffer at integer tick positions.
+	timing matches the Time-based generators up to ±1 tick (~4.5µs @ 1.77MHz).
+*/
+
+
+// position in the step buffer in 16.48 fixed point:
+// 16 more fraction bits than the step buffer uses, so that the tick grid does not drift.
+// a buffer holds less than 2^15 samples.
+static constexpr double pos_one = 281474976710656.0; // 1.0 sample
+static inline int64		step_pos(Time t) { return int64(t * samples_per_second * pos_one); }
+
+
+/* ----	reset all generators ------------------------------------
+ */
+void AyTickCore::reset(int64 pos)
+{
+	for (int c = 0; c < 3; c++)
+	{
+		tone_count[c] = 0x0fff;
+		tone_state[c] = 0;
+	}
+	noise_count	  = 0x1f * 2;
+	shiftreg	  = 0x0001FFFF;
+	env_period	  = 0xffff * 2;
+	env_count	  = env_period;
+	env_index	  = 0;
+	env_direction = 0;
+	env_repeat = env_invert = off;
+	tick_pos				= pos;
+}
+
+
+/* ----	select new envelope shape -------------------------------
+		same as Envelope::setShape()
+*/
+void AyTickCore::setShape(uchar c, uchar fine, uchar coarse)
+{
+	if (!(c & 8)) c = c & 4 ? 0x0f : 0x09;
+
+	env_index	  = BIT(c, 2) ? 0 : 15;
+	env_direction = BIT(c, 2) ? 1 : -1;
+	env_invert	  = BIT(c, 1);
+	env_repeat	  = !BIT(c, 0);
+
+	env_period = max(1, int32(coarse) * 256 + fine) * 2;
+	env_count  = env_period;
+}
+
+
+/* ----	set envelope period -------------------------------------
+		same as Envelope::setFinePeriod() and setCoarsePeriod()
+*/
+void AyTickCore::setEnvelopePeriod(uchar fine, uchar coarse)
+{
+	if (env_direction)
+	{
+		env_period = max(1, int32(coarse) * 256 + fine) * 2;
+		if (env_count > env_period) env_count = env_period;
+	}
+}
+
+
+/* ----	envelope counter expired --------------------------------
+		same as Envelope::trigger()
+*/
+void AyTickCore::trigger_envelope()
+{
+	env_index += env_direction;
+
+	if (env_index & 0xF0) // ramp finished
+	{
+		if (env_repeat)
+		{
+			if (env_invert)
+			{
+				env_index	  = ~env_index;
+				env_direction = -env_direction;
+			}
+		}
+		else
+		{
+			env_direction = 0;
+			if (!env_invert) env_index = ~env_index;
+			env_period = 0xffff * 2;
+		}
+		env_index &= 0x0F;
+	}
+
+	env_count = env_period;
+}
+
+
+/* ----	render tone output of channel c for the next cnt ticks ---
+		tone_buf[c][i] = 0.0 or 1.0
+*/
+inline void AyTickCore::fill_tone(int c, int32 period, int32 cnt)
+{
+	Sample* p = tone_buf[c];
+	Sample* e = p + cnt;
+
+	while (p < e)
+	{
+		if (tone_count[c] == 0) // toggle at the start of this tick with the current period
+		{
+			tone_state[c] ^= 1;
+			tone_count[c] = period;
+		}
+
+		int32  n = min(tone_count[c], int32(e - p));
+		Sample v = Sample(tone_state[c]);
+		for (Sample* z = p + n; p < z;) *p++ = v;
+		tone_count[c] -= n;
+	}
+}
+
+
+/* ----	render noise output for the next cnt ticks ---------------
+		noise_buf[i] = 0.0 or 1.0
+*/
+inline void AyTickCore::fill_noise(int32 period, int32 cnt)
+{
+	Sample* p = noise_buf;
+	Sample* e = p + cnt;
+
+	while (p < e)
+	{
+		if (noise_count == 0) // shift at the start of this tick with the current period
+		{
+			shiftreg	= (shiftreg >> 1) + (((shiftreg << 16) ^ (shiftreg << 14)) & 0x10000);
+			noise_count = period;
+		}
+
+		int32  n = min(noise_count, int32(e - p));
+		Sample v = Sample(shiftreg & 1);
+		for (Sample* z = p + n; p < z;) *p++ = v;
+		noise_count -= n;
+	}
+}
+
+
+/* ----	render envelope volume for the next cnt ticks ------------
+		env_buf[i] = logVol[env_index]
+*/
+inline void AyTickCore::fill_envelope(int32 cnt)
+{
+	Sample* p = env_buf;
+	Sample* e = p + cnt;
+
+	while (p < e)
+	{
+		if (env_count == 0) trigger_envelope(); // at the start of this tick with the current period
+
+		int32  n = min(env_count, int32(e - p));
+		Sample v = logVol[env_index];
+		for (Sample* z = p + n; p < z;) *p++ = v;
+		env_count -= n;
+	}
+}
+
+
 /* ===============================================================
 			ay sound chip
 =============================================================== */
@@ -525,7 +731,11 @@ Ay::Ay(Machine* m, isa_id id, Internal internal, cstr s, cstr w, cstr r, Frequen
 	channel_B(1 / freq),
 	channel_C(1 / freq),
 	noise(1 / freq, &channel_A, &channel_B, &channel_C),
-	envelope(1 / freq, &channel_A, &channel_B, &channel_C)
+	envelope(1 / freq, &channel_A, &channel_B, &channel_C),
+	tick(),
+	use_tick_core(false),
+	verify_steps(nullptr),
+	tick_core_deviation(0.0f)
 {
 	xlogIn("new Ay");
 
@@ -546,8 +756,17 @@ Ay::Ay(Machine* m, isa_id id, Internal internal, cstr s, cstr w, cstr r, Frequen
 }
 
 /* ----	destructor ----------------------------------------
- */
-Ay::~Ay() {}
+		post the inverse of the last output level to the step buffer,
+		else the removed Ay would leave a dc offset in the machine's output.
+*/
+Ay::~Ay()
+{
+	if (verify_steps) {} // the step buffer got nothing
+	else if (use_tick_core) machine->step_buffer.addDelta(tick.tick_pos >> 16, tick.output * -1.0f);
+	else machine->outputStep(time_of_last_sample, current_output * -1.0f);
+
+	delete[] verify_steps;
+}
 
 
 /* ----	power-up reset ------------------------------------
@@ -561,13 +780,58 @@ void Ay::powerOn(/*t=0*/ int32 cc)
 	channel_C.reset(0.0);
 	noise.reset(0.0);
 	envelope.reset(0.0);
+	tick.reset(0);
 	memcpy(ay_reg, AYregReset, 16);
 	ay_reg_nr			= 0;
 	time_of_last_sample = 0.0;
+	current_output		= 0.0f; // machine.step_buffer was cleared
+	tick.output			= 0.0f;
+	tick_core_deviation = 0.0f;
+	if (verify_steps)
+	{
+		verify_steps[0].clear();
+		verify_steps[1].clear();
+	}
 
 	setVolume(1.0);
 }
 
+
+/* ----	run-ahead ------------------------------------
+		the generators contain no pointers except to the channels of this Ay
+		so they can be copied as a whole.
+		the verify step buffers are not saved.
+*/
+bool Ay::canSaveState() const { return verify_steps == nullptr; }
+
+void Ay::saveState(StateBuffer& state) const
+{
+	state.put(ay_reg_nr);
+	state.put(ay_reg);
+	state.put(channel_A);
+	state.put(channel_B);
+	state.put(channel_C);
+	state.put(noise);
+	state.put(envelope);
+	state.put(tick);
+	state.put(time_of_last_sample);
+	state.put(current_output);
+}
+
+void Ay::restoreState(StateBuffer& state)
+{
+	state.get(ay_reg_nr);
+	state.get(ay_reg);
+	state.get(channel_A);
+	state.get(channel_B);
+	state.get(channel_C);
+	state.get(noise);
+	state.get(envelope);
+	state.get(tick);
+	state.get(time_of_last_sample);
+	state.get(current_output);
+}
+
 void Ay::reset(Time t, int32 cc)
 {
 	Item::reset(t, cc);
@@ -578,12 +842,129 @@ void Ay::reset(Time t, int32 cc)
 	channel_C.reset(time_of_last_sample);
 	noise.reset(time_of_last_sample);
 	envelope.reset(time_of_last_sample);
+	tick.reset(use_tick_core || verify_steps ? tick.tick_pos : step_pos(time_of_last_sample));
 	memcpy(ay_reg, AYregReset, 16);
 	ay_reg_nr = 0;
 }
 
 
 void Ay::run_until(Time when)
+{
+	// run the selected synthesis core up to time 'when'
+
+	if (verify_steps)
+	{
+		// Time-based core posts into verify_steps[0], tick core into verify_steps[1]:
+		run_generators(when, verify_steps[0]);
+		run_ticks(when, verify_steps[1]);
+	}
+	else if (use_tick_core)
+	{
+		run_ticks(when, machine->step_buffer);
+		time_of_last_sample = max(time_of_last_sample, when);
+	}
+	else run_generators(when, machine->step_buffer);
+}
+
+
+void Ay::run_ticks(Time when, StepBuffer& out)
+{
+	// integer-tick core:
+	// render all ticks which start before 'when' and post changes of the output to the step buffer.
+	// tick boundaries are positions in the step buffer in 16.48 fixed point, so they are exact:
+	// a register change at 'when' takes effect at the next tick boundary, as in the chip.
+	// this is the only float -> int conversion per run.
+
+	const int64 spt = step_pos(time_for_cycle * 8); // samples per tick
+	const int64 end = step_pos(when);
+	int64		pos = tick.tick_pos;
+	if (end <= pos) return;
+
+	int32 n		  = int32((end - pos + spt - 1) / spt); // ticks which start before 'when'
+	tick.tick_pos = pos + n * spt;
+	assert(pos >= 0); // audioBufferEnd() ran all ticks which start in the last buffer
+
+	// per-run constants from the registers:
+	// note: new periods take effect when the counter is reloaded, as in the Time-based core.
+
+	int32 tone_period[3];
+	for (int c = 0; c < 3; c++) tone_period[c] = max(1, (ay_reg[2 * c + 1] & 0x0f) * 256 + ay_reg[2 * c]);
+	int32 noise_period = ((ay_reg[6] & 0x1f) + !(ay_reg[6] & 0x1f)) * 2;
+
+	uint8  mixer = ay_reg[7];
+	Sample tone_off[3], noise_off[3]; // 1.0 = gate permanently open
+	Sample fix_vol[3], env_vol[3];	  // channel volume = fix_vol + env_vol * envelope
+	for (int c = 0; c < 3; c++)
+	{
+		uint8 r		 = ay_reg[8 + c];
+		tone_off[c]	 = BIT(mixer, c);
+		noise_off[c] = BIT(mixer, c + 3);
+		fix_vol[c]	 = r & 0x10 ? 0.0f : logVol[r & 0x0f];
+		env_vol[c]	 = r & 0x10 ? 1.0f : 0.0f;
+	}
+
+	Sample gl[3], gr[3]; // gain of channel A, B, C for left and right output
+	switch (stereo_mix)
+	{
+	case mono: // mono: ZX 128k, +2, +3, +3A, TS2068, TC2068
+		gl[0] = gl[1] = gl[2] = gr[0] = gr[1] = gr[2] = volume;
+		break;
+	case abc_stereo: // western Europe
+		gl[0] = volume * 2;
+		gl[1] = volume;
+		gl[2] = 0;
+		gr[0] = 0;
+		gr[1] = volume;
+		gr[2] = volume * 2;
+		break;
+	case acb_stereo: // eastern Europe, Didaktik Melodik
+		gl[0] = volume * 2;
+		gl[1] = 0;
+		gl[2] = volume;
+		gr[0] = 0;
+		gr[1] = volume * 2;
+		gr[2] = volume;
+		break;
+	}
+
+	while (n > 0)
+	{
+		int32 cnt = min(n, AyTickCore::max_ticks);
+		n -= cnt;
+
+		for (int c = 0; c < 3; c++) tick.fill_tone(c, tone_period[c], cnt);
+		tick.fill_noise(noise_period, cnt); // all generators run free, as in the chip
+		tick.fill_envelope(cnt);
+
+		// mix: branchless and vectorizable:
+		Sample left[AyTickCore::max_ticks], right[AyTickCore::max_ticks];
+		for (int32 i = 0; i < cnt; i++)
+		{
+			Sample a = max(tick.tone_buf[0][i], tone_off[0]) * max(tick.noise_buf[i], noise_off[0]) *
+					   (fix_vol[0] + env_vol[0] * tick.env_buf[i]);
+			Sample b = max(tick.tone_buf[1][i], tone_off[1]) * max(tick.noise_buf[i], noise_off[1]) *
+					   (fix_vol[1] + env_vol[1] * tick.env_buf[i]);
+			Sample c = max(tick.tone_buf[2][i], tone_off[2]) * max(tick.noise_buf[i], noise_off[2]) *
+					   (fix_vol[2] + env_vol[2] * tick.env_buf[i]);
+			left[i]	 = gl[0] * a + gl[1] * b + gl[2] * c;
+			right[i] = gr[0] * a + gr[1] * b + gr[2] * c;
+		}
+
+		// post changes:
+		for (int32 i = 0; i < cnt; i++, pos += spt)
+		{
+			StereoSample v(left[i], right[i]);
+			if (v != tick.output)
+			{
+				out.addDelta(pos >> 16, v - tick.output); // 32.32
+				tick.output = v;
+			}
+		}
+	}
+}
+
+
+void Ay::run_generators(Time when, StepBuffer& out)
 {
 	Time now;
 	int	 who;
@@ -603,7 +984,7 @@ void Ay::run_until(Time when)
 				who = 1;
 				now = noise.when;
 			} // noise is next
-			else noise.when = now + 1000 * time_for_cycle;
+			else noise.skip(now);
 		}
 		if (channel_A.when - now < 0)
 		{
@@ -612,7 +993,7 @@ void Ay::run_until(Time when)
 				who = 3;
 				now = channel_A.when;
 			} // channel A is next
-			else channel_A.when = now + 1000 * time_for_cycle;
+			else channel_A.skip(now);
 		}
 		if (channel_B.when - now < 0)
 		{
@@ -621,7 +1002,7 @@ void Ay::run_until(Time when)
 				who = 4;
 				now = channel_B.when;
 			} // channel B is next
-			else channel_B.when = now + 1000 * time_for_cycle;
+			else channel_B.skip(now);
 		}
 		if (channel_C.when - now < 0)
 		{
@@ -630,7 +1011,7 @@ void Ay::run_until(Time when)
 				who = 5;
 				now = channel_C.when;
 			} // channel C is next
-			else channel_C.when = now + 1000 * time_for_cycle;
+			else channel_C.skip(now);
 		}
 		if (envelope.when - now < 0)
 		{
@@ -639,10 +1020,10 @@ void Ay::run_until(Time when)
 				who = 2;
 				now = envelope.when;
 			} // envelope is next
-			else envelope.when = now + 1000 * time_for_cycle;
+			else envelope.skip(now);
 		}
 
-		// write samples up to 'now' to DSP:
+		// post output change at time_of_last_sample:
 		if (now > time_of_last_sample)
 		{
 			StereoSample current_value;
@@ -662,7 +1043,12 @@ void Ay::run_until(Time when)
 				break;
 			}
 
-			machine->outputSamples(current_value, time_of_last_sample, now);
+			if (current_value != current_output)
+			{
+				int64 pos = int64(time_of_last_sample * samples_per_second * StepBuffer::one);
+				out.addDelta(pos, current_value - current_output);
+				current_output = current_value;
+			}
 			time_of_last_sample = now;
 		}
 
@@ -719,9 +1105,18 @@ void Ay::set_register(Time when, uint regnr, uint8 newvalue)
 	case 8: channel_A.setVolume(newvalue); break;
 	case 9: channel_B.setVolume(newvalue); break;
 	case 10: channel_C.setVolume(newvalue); break;
-	case 11: envelope.setFinePeriod(when, newvalue); break;
-	case 12: envelope.setCoarsePeriod(when, newvalue); break;
-	case 13: envelope.setShape(when, newvalue); break;
+	case 11:
+		envelope.setFinePeriod(when, newvalue);
+		tick.setEnvelopePeriod(newvalue, ay_reg[12]);
+		break;
+	case 12:
+		envelope.setCoarsePeriod(when, newvalue);
+		tick.setEnvelopePeriod(ay_reg[11], newvalue);
+		break;
+	case 13:
+		envelope.setShape(when, newvalue);
+		tick.setShape(newvalue, ay_reg[11], ay_reg[12]);
+		break;
 	case 14:
 		if (ay_reg[7] & 0x40 && ay_reg[14] != newvalue) portAOutputValueChanged(when, newvalue);
 		break;
@@ -774,7 +1169,31 @@ void Ay::input(Time t, int32 /*cc*/, uint16 addr, uint8& byte, uint8& mask)
 void Ay::audioBufferEnd(Time t)
 {
 	run_until(t);
+
+	if (verify_steps)
+	{
+		// integrate both verify step buffers, compare and play the Time-based core's output:
+
+		int32 count = min(int32(t * samples_per_second + 0.5), dsp_samples_per_buffer);
+
+		StereoSample ref[DSP_SAMPLES_PER_BUFFER_MAX] = {};
+		StereoSample tck[DSP_SAMPLES_PER_BUFFER_MAX] = {};
+		verify_steps[0].readSamples(ref, count);
+		verify_steps[1].readSamples(tck, count);
+
+		Sample err = 0;
+		for (int i = 0; i < count; i++)
+		{
+			err += fabsf(ref[i].left - tck[i].left) + fabsf(ref[i].right - tck[i].right);
+			machine->audio_out_buffer[i] += ref[i];
+		}
+		err /= 2 * max(count, 1);
+		if (err > tick_core_deviation) tick_core_deviation = err;
+		if (err > tick_core_tolerance) logline("Ay: tick core deviation %.4f", double(err));
+	}
+
 	time_of_last_sample -= t;
+	if (use_tick_core || verify_steps) tick.tick_pos -= step_pos(t); // else setTickCore() sets it
 	channel_A.when -= t;
 	channel_B.when -= t;
 	channel_C.when -= t;
@@ -783,6 +1202,54 @@ void Ay::audioBufferEnd(Time t)
 }
 
 
+/*	Synthese-Kern wählen:
+	integer-tick core or Time-based generators.
+	the generators of the other core are re-synchronized to the current time.
+*/
+void Ay::setTickCore(bool f)
+{
+	if (f == use_tick_core || verify_steps) return;
+
+	Time now = time_of_last_sample;
+	if (f) // Time-based core ran up to now: continue with ticks from now
+	{
+		tick.tick_pos = step_pos(now);
+		tick.output	  = current_output;
+	}
+	else // tick core ran up to tick.tick_pos: the Time-based generators were idle
+	{
+		now = time_of_last_sample = tick.tick_pos / (samples_per_second * pos_one);
+		current_output			  = tick.output;
+		if (channel_A.when < now) channel_A.when = now + channel_A.reload;
+		if (channel_B.when < now) channel_B.when = now + channel_B.reload;
+		if (channel_C.when < now) channel_C.when = now + channel_C.reload;
+		if (noise.when < now) noise.when = now + noise.reload;
+		if (envelope.when < now) envelope.when = now + envelope.reload;
+	}
+	use_tick_core = f;
+}
+
+
+/*	compare the integer-tick core against the Time-based generators:
+	both cores run, the Time-based core's output is played and the deviation is logged
+	and stored in tickCoreDeviation().
+	Must be set right after powerOn(): the cores are not re-synchronized.
+	setTickCore() is ignored while verifying.
+*/
+void Ay::setVerifyTickCore(bool f)
+{
+	if (f == (verify_steps != nullptr)) return;
+
+	if (f) verify_steps = new StepBuffer[2];
+	else
+	{
+		delete[] verify_steps;
+		verify_steps = nullptr;
+	}
+	tick_core_deviation = 0.0f;
+}
+
+
 /*	Eingangsfrequenz ändern.
  */
 void Ay::setClock(Frequency psg_cycles_per_second)
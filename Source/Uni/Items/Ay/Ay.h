@@ -4,6 +4,7 @@
 // https://opensource.org/licenses/BSD-2-Clause
 
 #include "Item.h"
+#include "StepBuffer.h"
 #include "StereoSample.h"
 
 //
@@ -70,6 +71,7 @@ public:
 	void setFinePeriod(uchar);
 	void setCoarsePeriod(uchar);
 	void trigger();
+	void skip(Time now);
 
 	friend class Ay;
 };
@@ -91,6 +93,7 @@ public:
 	void reset(Time now);
 	void setPeriod(uchar);
 	void trigger();
+	void skip(Time now);
 
 	friend class Ay;
 };
@@ -118,6 +121,48 @@ public:
 	void setFinePeriod(Time now, uchar);
 	void setCoarsePeriod(Time now, uchar);
 	void trigger();
+	void skip(Time now);
+
+	friend class Ay;
+};
+
+
+/* ----	integer-tick synthesis core of the ay chip -------------------------------
+		alternative to the Time-based Channel, Noise and Envelope generators above.
+		all generators count in ticks of 8 PSG cycles (the half period of a tone with pitch 1).
+		ticks are rendered in blocks and changes of the output are posted to a StepBuffer.
+*/
+class AyTickCore
+{
+	static constexpr int32 max_ticks = 256; // ticks per rendered block
+
+	int32		 tone_count[3]; // ticks until the tone output of channel A, B, C toggles
+	int32		 tone_state[3]; // 0 or 1
+	int32		 noise_count;	// ticks until next shift of the noise shift register
+	int32		 shiftreg;		// 17 bit random number shift register; bit 0 is output
+	int32		 env_count;		// ticks until next envelope step
+	int32		 env_period;	// ticks per envelope step; 0xffff*2 after a non-repeating ramp
+	int			 env_index;		// current output state: volume 0 ... 15
+	int			 env_direction; // ramping up/down/off
+	bool		 env_repeat;	// repeat ramping
+	bool		 env_invert;	// toggle ramping direction
+	int64		 tick_pos;		// start of the next tick to render: position in the step buffer in 16.48 samples
+	StereoSample output;		// last output value posted to the step buffer
+	Sample		 tone_buf[3][max_ticks];
+	Sample		 noise_buf[max_ticks];
+	Sample		 env_buf[max_ticks];
+
+	void trigger_envelope();
+	void fill_tone(int c, int32 period, int32 cnt);
+	void fill_noise(int32 period, int32 cnt);
+	void fill_envelope(int32 cnt);
+
+public:
+	AyTickCore() { reset(0); }
+
+	void reset(int64 pos);
+	void setShape(uchar shape, uchar fine, uchar coarse);
+	void setEnvelopePeriod(uchar fine, uchar coarse);
 
 	friend class Ay;
 };
@@ -148,10 +193,17 @@ protected:
 	Noise	 noise;
 	Envelope envelope;
 
+	// alternative integer-tick core:
+	AyTickCore	tick;
+	bool		use_tick_core;
+	StepBuffer* verify_steps;		 // setVerifyTickCore(): Time-based core and tick core
+	Sample		tick_core_deviation; // max. mean deviation per sample of a dsp buffer while verifying
+
 	// sample output:
 	// progress:
-	Sample volume;				// per channel: 0.0 .. 0.33
-	Time   time_of_last_sample; // bis zu diesem Zeitpunkt wurde schon Sound erzeugt
+	Sample		 volume;			  // per channel: 0.0 .. 0.33
+	Time		 time_of_last_sample; // bis zu diesem Zeitpunkt wurde schon Sound erzeugt
+	StereoSample current_output;	  // last output value of the Time-based core posted to the step buffer
 
 protected:
 	Ay(Machine*, isa_id, Internal, cstr sel, cstr wr, cstr rd, Frequency, StereoMix);
@@ -187,6 +239,8 @@ public:
 
 	// set register at runtime:
 	void run_until(Time);
+	void run_generators(Time, StepBuffer&);
+	void run_ticks(Time, StepBuffer&);
 	void set_register(Time, uint r, uint8 n);
 	void setRegister(Time, uint r, uint8 n);
 
@@ -195,6 +249,15 @@ public:
 	void	  setClock(Frequency psg_cycles_per_second);
 	Frequency getClock() const volatile { return 1.0 / time_for_cycle; }
 
+	// synthesis core:
+	void setTickCore(bool);
+	bool usesTickCore() const volatile { return use_tick_core; }
+
+	// verify the tick core against the Time-based core:
+	static constexpr Sample tick_core_tolerance = 0.02f; // max. mean deviation per sample
+	void					setVerifyTickCore(bool);
+	Sample					tickCoreDeviation() const volatile { return tick_core_deviation; }
+
 	// set stereo/mono:
 	void	  setStereoMix(StereoMix n) { stereo_mix = n; }
 	StereoMix getStereoMix() const volatile { return stereo_mix; }
@@ -212,4 +275,9 @@ protected:
 	void output(Time, int32 cc, uint16 addr, uint8 byte) override;
 	void audioBufferEnd(Time) override;
 	// void	videoFrameEnd	(int32 cc) override;
+
+public:
+	bool canSaveState() const override;
+	void saveState(StateBuffer&) const override;
+	void restoreState(StateBuffer&) override;
 };
@@ -4,6 +4,7 @@
 
 
 #include "CurrahMicroSpeech.h"
+#include "Files/RomCache.h"
 #include "Machine.h"
 #include "Memory.h"
 #include "SP0256.h"
@@ -95,11 +96,11 @@ CurrahMicroSpeech::CurrahMicroSpeech(Machine* m) // CREATOR
 {
 	xlogIn("new CurrahMicroSpeech");
 
+	// A14 and A15 are decoded => all i/o addresses and the RST7 toggle are in 0x0000 … 0x3fff:
+	claimMemory(cpu_patch | cpu_memmapped_rw, 0x0000, 0x3fff);
+
 	// load rom:
-	uint8 zbu[2048];
-	FD	  fd(catstr(appl_rsrc_path, uspeech_rom));
-	fd.read_bytes(zbu, 2048);
-	m->cpu->b2c(zbu, rom.getData(), 2048);
+	RomCache::read(catstr(appl_rsrc_path, uspeech_rom), rom.getData(), 2048);
 
 	// create sound chip:
 	sp0256 = new SP0256(machine, catstr(appl_rsrc_path, sp0256_rom), no, filter_RC);
@@ -3,6 +3,7 @@
 // https://opensource.org/licenses/BSD-2-Clause
 
 #include "DivIDE.h"
+#include "Files/RomCache.h"
 #include "IdeDevice.h"
 #include "Machine/Machine.h"
 #include "Z80/Z80.h"
@@ -42,6 +43,7 @@ DivIDE::DivIDE(Machine* machine, uint ramsize, cstr romfile) :
 	romfilepath(nullptr)
 {
 	xlogIn("new DivIDE");
+	claimMemory(cpu_patch, 0x0000, 0x3fff); // enable hooks in machine rom and 'off-area' in DivIDE rom
 	insertRom(romfile);
 }
 
@@ -389,12 +391,12 @@ cstr DivIDE::insertRom(cstr path)
 
 	try
 	{
-		FD fd(path, 'r');
+		RomImagePtr image = RomCache::getRom(path);
 
-		long sz = fd.file_size();
-		if (sz != rom.count()) return usingstr("Rom size is %u kByte, but file size is %lu", rom.count() >> 10, sz);
+		uint32 sz = image->size;
+		if (sz != rom.count()) return usingstr("Rom size is %u kByte, but file size is %u", rom.count() >> 10, sz);
 
-		read_mem(fd, rom.getData(), rom.count());
+		Z80::b2c(image->data, rom.getData(), sz);
 		delete[] romfilepath;
 		romfilepath = newcopy(path);
 		applyRomPatches();
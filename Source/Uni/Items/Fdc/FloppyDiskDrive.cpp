@@ -283,7 +283,7 @@ void FloppyDiskDrive::audioBufferEnd(Time dt)
 	{
 		if (sound_running_index < sound_running_size)
 		{
-			for (uint i = 0; i < uint(DSP_SAMPLES_PER_BUFFER); i++)
+			for (uint i = 0; i < uint(dsp_samples_per_buffer); i++)
 			{
 				machine->audio_out_buffer[i] += sound_running[sound_running_index++];
 				if (sound_running_index == sound_running_size) sound_running_index = 0;
@@ -292,13 +292,13 @@ void FloppyDiskDrive::audioBufferEnd(Time dt)
 
 		if (sound_insert_index < sound_insert_size)
 		{
-			uint n = min(uint(DSP_SAMPLES_PER_BUFFER), sound_insert_size - sound_insert_index);
+			uint n = min(uint(dsp_samples_per_buffer), sound_insert_size - sound_insert_index);
 			for (uint i = 0; i < n; i++) { machine->audio_out_buffer[i] += sound_insert[sound_insert_index++]; }
 		}
 
 		if (sound_eject_index < sound_eject_size)
 		{
-			uint n = min(uint(DSP_SAMPLES_PER_BUFFER), sound_eject_size - sound_eject_index);
+			uint n = min(uint(dsp_samples_per_buffer), sound_eject_size - sound_eject_index);
 			for (uint i = 0; i < n; i++) { machine->audio_out_buffer[i] += sound_eject[sound_eject_index++]; }
 		}
 
@@ -313,7 +313,7 @@ void FloppyDiskDrive::audioBufferEnd(Time dt)
 					i	= -ssi;
 					ssi = 0;
 				}
-				int e = min(DSP_SAMPLES_PER_BUFFER, i + sound_step_size - ssi);
+				int e = min(dsp_samples_per_buffer, i + sound_step_size - ssi);
 				while (i < e) { machine->audio_out_buffer[i++] += sound_step[ssi++]; }
 			}
 		}
@@ -336,7 +336,7 @@ void FloppyDiskDrive::step(Time t, int dir) // dir = ±1
 	{
 		if (sound_step_index[i] == sound_step_size)
 		{
-			sound_step_index[i] = -t * DSP_SAMPLES_PER_BUFFER / seconds_per_dsp_buffer(); // start sound
+			sound_step_index[i] = -t * samples_per_second; // start sound
 			break;
 		}
 	}
@@ -0,0 +1,496 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "SDCard.h"
+#include "zxsp_globals.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/*
+	SPI mode protocol summary:
+
+	command:	6 bytes: %01cccccc, 32 bit argument (msb first), %crc7.1
+				the crc is only checked if enabled with CMD59. (not at all in this implementation)
+	response:	after Ncr = 1 … 8 bytes $FF:
+				R1:	1 byte:		%0.param.addr.erase_seq.crc.illegal.erase_reset.idle
+				R2:	R1 + 1 byte status
+				R3:	R1 + 4 bytes OCR
+				R7:	R1 + 4 bytes: voltage accepted and check pattern
+	read data:	after Nac bytes $FF: data token $FE, data, crc16
+				or error token %0000.range.ecc.cc.error
+	write data:	host sends data token $FE (CMD24) or $FC (CMD25), data, crc16
+				card responds %xxx0.sss1: sss = %010 accepted, %101 crc error, %110 write error
+				then the card is busy and sends $00 until the block is written
+				CMD25 is terminated by the stop token $FD
+*/
+
+
+static constexpr uint	nac_bytes		 = 32;		 // $FF before a data token
+static constexpr uint	busy_bytes		 = 64;		 // $00 after a block was written
+static constexpr uint	init_acmd41s	 = 4;		 // ACMD41 until the card leaves the idle state
+static constexpr uint32 sdsc_max_sectors = 0x400000; // 2 GB
+
+// R1 bits:
+static constexpr uint8 r1_illegal_command = 0x04;
+static constexpr uint8 r1_address_error	  = 0x20;
+static constexpr uint8 r1_parameter_error = 0x40;
+
+// tokens:
+static constexpr uint8 token_start_block  = 0xFE; // single block read or write, multi block read
+static constexpr uint8 token_start_multi  = 0xFC; // multi block write
+static constexpr uint8 token_stop_tran	  = 0xFD; // end of multi block write
+static constexpr uint8 token_out_of_range = 0x08; // data error token
+static constexpr uint8 data_accepted	  = 0x05;
+static constexpr uint8 data_write_error	  = 0x0D;
+
+
+static uint8 crc7(const uint8* p, uint count)
+{
+	uint8 crc = 0;
+	while (count--)
+	{
+		uint8 byte = *p++;
+		for (uint i = 0; i < 8; i++, byte <<= 1)
+		{
+			crc <<= 1;
+			if ((byte ^ crc) & 0x80) crc ^= 0x09;
+		}
+	}
+	return crc & 0x7F;
+}
+
+static uint16 crc16(const uint8* p, uint count)
+{
+	uint16 crc = 0;
+	while (count--)
+	{
+		crc ^= uint16(*p++ << 8);
+		for (uint i = 0; i < 8; i++) crc = crc & 0x8000 ? uint16(crc << 1) ^ 0x1021 : uint16(crc << 1);
+	}
+	return crc;
+}
+
+static void set_bits(uint8* reg16, uint msb, uint lsb, uint32 value)
+{
+	// set bits in a 128 bit register: bit 127 is the msb of reg16[0]
+
+	for (uint i = lsb; i <= msb; i++, value >>= 1)
+	{
+		uint8& byte = reg16[15 - i / 8];
+		uint8  mask = uint8(1 << (i % 8));
+		if (value & 1) byte |= mask;
+		else byte &= ~mask;
+	}
+}
+
+
+// ---------------------------------------------------------
+//		creator & similar
+// ---------------------------------------------------------
+
+
+SDCard::SDCard(cstr fpath) :
+	filepath(newcopy(fpath)),
+	image(nullptr),
+	image_size(0),
+	total_sectors(0),
+	is_sdhc(no),
+	file_writable(no),
+	writable(no),
+	zero_latency(no)
+{
+	int fd = open(fpath, O_RDWR);
+	if (fd >= 0) file_writable = yes;
+	else fd = open(fpath, O_RDONLY);
+
+	struct stat fs;
+	if (fd < 0 || fstat(fd, &fs) != 0)
+	{
+		showAlert("Open SD card image failed:\n%s", strerror(errno));
+		if (fd >= 0) close(fd);
+		return;
+	}
+
+	image_size	  = size_t(fs.st_size) & ~size_t(511);
+	total_sectors = uint32(min(image_size / 512, size_t(0xFFFFFFFFu)));
+	is_sdhc		  = total_sectors > sdsc_max_sectors;
+
+	if (total_sectors == 0) showAlert("The SD card image is empty or not a regular file");
+	else
+	{
+		int	  prot = file_writable ? PROT_READ | PROT_WRITE : PROT_READ;
+		void* p	   = mmap(nullptr, image_size, prot, MAP_SHARED, fd, 0);
+		if (p == MAP_FAILED) showAlert("Mapping the SD card image failed:\n%s", strerror(errno));
+		else image = reinterpret_cast<uint8*>(p);
+	}
+	close(fd); // the mapping remains valid
+
+	writable = file_writable && image;
+	xlogline("SDCard: loaded \"%s\": %u sectors, %s", fpath, total_sectors, is_sdhc ? "SDHC" : "SDSC");
+	init();
+}
+
+SDCard::~SDCard()
+{
+	if (image) munmap(image, image_size); // writes back modified pages
+	delete[] filepath;
+}
+
+void SDCard::init()
+{
+	// power-on
+
+	state	   = st_command;
+	idle	   = yes;
+	app_cmd	   = no;
+	crc_on	   = no;
+	init_count = 0;
+	cmd_len	   = 0;
+	sector	   = 0;
+	multiblock = no;
+	rpos = rcnt = 0;
+	data		= nullptr;
+	data_cnt	= 0;
+	busy_cnt	= 0;
+	wcnt		= 0;
+}
+
+
+// ---------------------------------------------------------
+//		registers
+// ---------------------------------------------------------
+
+
+void SDCard::make_csd(uint8* csd) const
+{
+	memset(csd, 0, 16);
+
+	if (is_sdhc) // CSD version 2.0: capacity = (C_SIZE+1) * 512 kB
+	{
+		set_bits(csd, 127, 126, 1);						 // CSD_STRUCTURE
+		set_bits(csd, 69, 48, total_sectors / 1024 - 1); // C_SIZE
+		set_bits(csd, 83, 80, 9);						 // READ_BL_LEN
+		set_bits(csd, 25, 22, 9);						 // WRITE_BL_LEN
+	}
+	else // CSD version 1.0: capacity = (C_SIZE+1) * 2^(C_SIZE_MULT+2) * 2^READ_BL_LEN
+	{
+		uint shift = 2; // sectors per unit = 2^shift
+		while ((total_sectors >> shift) > 4096 && shift < 2 + 7 + 2) shift++;
+		uint mult	= min(shift - 2, 7u);
+		uint bl_len = 9 + shift - 2 - mult;
+
+		set_bits(csd, 127, 126, 0);									// CSD_STRUCTURE
+		set_bits(csd, 83, 80, bl_len);								// READ_BL_LEN
+		set_bits(csd, 79, 79, 1);									// READ_BL_PARTIAL
+		set_bits(csd, 73, 62, max(total_sectors >> shift, 1u) - 1); // C_SIZE
+		set_bits(csd, 61, 50, 0xFFF);								// VDD_R/W_CURR_MIN/MAX
+		set_bits(csd, 49, 47, mult);								// C_SIZE_MULT
+		set_bits(csd, 25, 22, bl_len);								// WRITE_BL_LEN
+	}
+
+	set_bits(csd, 119, 112, 0x0E);	  // TAAC: 1 ms
+	set_bits(csd, 103, 96, 0x32);	  // TRAN_SPEED: 25 MHz
+	set_bits(csd, 95, 84, 0x5B5);	  // CCC: classes 0, 2, 4, 5, 7, 8, 10
+	set_bits(csd, 46, 46, 1);		  // ERASE_BLK_EN
+	set_bits(csd, 45, 39, 0x7F);	  // SECTOR_SIZE: 64 kB
+	set_bits(csd, 28, 26, 2);		  // R2W_FACTOR
+	set_bits(csd, 12, 12, !writable); // TMP_WRITE_PROTECT
+	csd[15] = uint8(crc7(csd, 15) << 1) | 1;
+}
+
+void SDCard::make_cid(uint8* cid) const
+{
+	memset(cid, 0, 16);
+	cid[0] = 0x5A;									// MID
+	memcpy(cid + 1, "ZX", 2);						// OID
+	memcpy(cid + 3, "ZXSP ", 5);					// PNM
+	cid[8] = 0x10;									// PRV: 1.0
+	set_bits(cid, 55, 24, total_sectors);			// PSN
+	set_bits(cid, 19, 8, ((2023 - 2000) << 4) + 1); // MDT: 2023-01
+	cid[15] = uint8(crc7(cid, 15) << 1) | 1;
+}
+
+
+// ---------------------------------------------------------
+//		response helpers
+// ---------------------------------------------------------
+
+
+void SDCard::put_gap(uint n)
+{
+	assert(rcnt + n <= sizeof(rbu));
+	memset(rbu + rcnt, 0xFF, n);
+	rcnt += n;
+}
+
+void SDCard::put_block_header()
+{
+	// Nac and data token
+
+	put_gap(zero_latency ? 1 : nac_bytes);
+	put(token_start_block);
+}
+
+void SDCard::put_crc16(const uint8* p, uint count)
+{
+	// real cards always send the crc, but hosts only check it if enabled with CMD59:
+
+	uint16 crc = crc_on ? crc16(p, count) : 0xFFFF;
+	put(uint8(crc >> 8));
+	put(uint8(crc));
+}
+
+void SDCard::put_register(const uint8* reg16)
+{
+	// CSD or CID: sent like a data block
+
+	put_block_header();
+	memcpy(rbu + rcnt, reg16, 16);
+	rcnt += 16;
+	put_crc16(reg16, 16);
+}
+
+void SDCard::start_read(uint32 n)
+{
+	// append next block to the response
+	// the data is sent directly from the mapped image
+
+	if (n >= total_sectors)
+	{
+		put_gap(1);
+		put(token_out_of_range);
+		multiblock = no;
+		return;
+	}
+
+	put_block_header();
+	sector	 = n;
+	data	 = image + size_t(n) * 512;
+	data_cnt = 512;
+}
+
+void SDCard::write_block()
+{
+	// block incl. crc received in wbu[]
+
+	if (writable && sector < total_sectors)
+	{
+		memcpy(image + size_t(sector) * 512, wbu, 512);
+		put(data_accepted);
+		busy_cnt = zero_latency ? 0 : busy_bytes;
+		sector++;
+	}
+	else
+	{
+		put(data_write_error);
+		multiblock = no;
+	}
+}
+
+
+// ---------------------------------------------------------
+//		SPI
+// ---------------------------------------------------------
+
+
+uint8 SDCard::input()
+{
+	if (rpos < rcnt) return rbu[rpos++];
+
+	if (data_cnt)
+	{
+		uint8 byte = *data++;
+		if (--data_cnt == 0)
+		{
+			rpos = rcnt = 0;
+			put_crc16(data - 512, 512);
+			if (multiblock) start_read(sector + 1); // CMD18: continue until CMD12
+		}
+		return byte;
+	}
+
+	if (busy_cnt)
+	{
+		busy_cnt--;
+		return 0x00;
+	}
+
+	return 0xFF;
+}
+
+void SDCard::output(uint8 byte)
+{
+	switch (state)
+	{
+	case st_write_token:
+		if (byte == token_stop_tran && multiblock)
+		{
+			// end of CMD25:
+			rpos = rcnt = 0;
+			put_gap(1);
+			busy_cnt   = zero_latency ? 0 : busy_bytes;
+			multiblock = no;
+			state	   = st_command;
+		}
+		else if (byte == (multiblock ? token_start_multi : token_start_block))
+		{
+			wcnt  = 0;
+			state = st_write_data;
+		}
+		return; // else wait for token
+
+	case st_write_data:
+		wbu[wcnt++] = byte;
+		if (wcnt < sizeof(wbu)) return;
+		rpos = rcnt = 0;
+		write_block();
+		state = multiblock ? st_write_token : st_command;
+		return;
+
+	case st_command:
+		if (cmd_len == 0 && (byte & 0xC0) != 0x40) return; // not a command start byte, e.g. $FF
+		cmd[cmd_len++] = byte;
+		if (cmd_len < 6) return;
+		cmd_len = 0;
+		handle_command();
+		return;
+	}
+}
+
+void SDCard::handle_command()
+{
+	// a new command aborts the current response:
+	// CMD12 is sent during a CMD18 multi-block read
+
+	rpos = rcnt = 0;
+	data		= nullptr;
+	data_cnt	= 0;
+	busy_cnt	= 0;
+
+	uint   c	= cmd[0] & 0x3F;
+	uint32 arg	= uint32(cmd[1] << 24) | uint32(cmd[2] << 16) | uint32(cmd[3] << 8) | cmd[4];
+	bool   acmd = app_cmd;
+	app_cmd		= no;
+
+	xxlogline("SDCard: %sCMD%u $%08x", acmd ? "A" : "", c, arg);
+
+	put_gap(1); // Ncr
+
+	if (acmd)
+	{
+		switch (c)
+		{
+		case 23: // SET_WR_BLK_ERASE_COUNT
+			put(r1());
+			return;
+
+		case 41: // SD_SEND_OP_COND
+			// bit 30 = HCS: host supports SDHC. SDHC cards remain idle if the host doesn't.
+			if (!is_sdhc || (arg & 0x40000000))
+			{
+				if (zero_latency || ++init_count >= init_acmd41s) idle = no;
+			}
+			put(r1());
+			return;
+		}
+		// else handle as normal command
+	}
+
+	// block address for read and write commands:
+	uint32 n = is_sdhc ? arg : arg / 512;
+
+	switch (c)
+	{
+	case 0: // GO_IDLE_STATE
+		init();
+		put_gap(1);
+		put(r1());
+		return;
+
+	case 8: // SEND_IF_COND => R7
+		put(r1());
+		put(0x00);
+		put(0x00);
+		put((arg >> 8) & 0x0F); // voltage accepted
+		put(arg & 0xFF);		// check pattern
+		return;
+
+	case 9:	 // SEND_CSD
+	case 10: // SEND_CID
+	{
+		put(r1());
+		uint8 reg[16];
+		if (c == 9) make_csd(reg);
+		else make_cid(reg);
+		put_register(reg);
+		return;
+	}
+
+	case 12: // STOP_TRANSMISSION
+		multiblock = no;
+		put_gap(1); // stuff byte
+		put(r1());
+		return;
+
+	case 13: // SEND_STATUS => R2
+		put(r1());
+		put(0x00);
+		return;
+
+	case 16: // SET_BLOCKLEN: only 512 supported, ignored by SDHC cards
+		put(r1(is_sdhc || arg == 512 ? 0 : r1_parameter_error));
+		return;
+
+	case 17: // READ_SINGLE_BLOCK
+	case 18: // READ_MULTIPLE_BLOCK
+		if (idle) break;
+		if (!is_sdhc && arg % 512)
+		{
+			put(r1(r1_address_error));
+			return;
+		}
+		put(r1());
+		multiblock = c == 18;
+		start_read(n);
+		return;
+
+	case 24: // WRITE_BLOCK
+	case 25: // WRITE_MULTIPLE_BLOCK
+		if (idle) break;
+		if (!is_sdhc && arg % 512)
+		{
+			put(r1(r1_address_error));
+			return;
+		}
+		put(r1());
+		sector	   = n;
+		multiblock = c == 25;
+		state	   = st_write_token;
+		return;
+
+	case 55: // APP_CMD
+		app_cmd = yes;
+		put(r1());
+		return;
+
+	case 58: // READ_OCR => R3
+		put(r1());
+		put((idle ? 0x00 : 0x80) | (is_sdhc && !idle ? 0x40 : 0x00)); // power up status, CCS
+		put(0xFF);													   // 2.7 … 3.6 V
+		put(0x80);
+		put(0x00);
+		return;
+
+	case 59: // CRC_ON_OFF
+		crc_on = arg & 1;
+		put(r1());
+		return;
+	}
+
+	// unknown command or not allowed in idle state:
+	put(r1(r1_illegal_command));
+}
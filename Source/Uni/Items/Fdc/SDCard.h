@@ -0,0 +1,95 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "kio/kio.h"
+#include "zxsp_types.h"
+
+
+/*	SD card in SPI mode
+
+	The card is backed by a disk image file which is memory mapped:
+	sectors are read directly from the mapping and written with one memcpy per block.
+	Images up to 2 GB are presented as SDSC card (byte addressing), larger images as SDHC card (block addressing).
+
+	SPI transfers are full duplex, but the interface sees them as separate reads and writes:
+		output(): the byte sent by the host
+		input():  the next byte sent by the card, $FF if it has nothing to send
+	input() and output() must only be called while the card is selected.
+
+	Supported commands:
+		CMD0, CMD8, CMD9, CMD10, CMD12, CMD13, CMD16, CMD17, CMD18, CMD24, CMD25, CMD55, CMD58, CMD59
+		ACMD23, ACMD41
+	other commands are rejected with 'illegal command'.
+
+	Latency:
+	by default the card inserts some $FF bytes before data tokens, returns 'busy' after writing a block
+	and needs a few ACMD41 until it leaves the idle state, similar to a real card.
+	With zero latency the card responds as fast as the protocol permits.
+	This makes large file copies under the card's firmware run at host speed.
+*/
+class SDCard
+{
+	cstr   filepath;
+	uint8* image;		  // memory mapped image file
+	size_t image_size;	  // bytes
+	uint32 total_sectors; // from image_size
+	bool   is_sdhc;		  // block addressing
+	bool   file_writable; // image is mapped for r/w => card may be write enabled
+	bool   writable;	  // card is writable
+	bool   zero_latency;
+
+	// state:
+	enum State { st_command, st_write_token, st_write_data };
+	State  state;
+	bool   idle;	   // R1 'in idle state': until ACMD41 succeeds
+	bool   app_cmd;	   // previous command was CMD55
+	bool   crc_on;	   // CMD59
+	uint   init_count; // ACMD41 until leaving idle state
+	uint8  cmd[6];	   // command being received
+	uint   cmd_len;
+	uint32 sector;	   // next sector for multi-block read or write
+	bool   multiblock; // CMD18 or CMD25 active
+
+	// bytes to send:
+	uint8		 rbu[128]; // response bytes
+	uint		 rpos, rcnt;
+	const uint8* data; // sector data after the response bytes
+	uint		 data_cnt;
+	uint		 busy_cnt; // $00 bytes after the response bytes and data
+
+	// block being written:
+	uint8 wbu[512 + 2];
+	uint  wcnt;
+
+	void  put(uint8 n) { rbu[rcnt++] = n; }
+	void  put_gap(uint n);
+	void  put_block_header();
+	void  put_crc16(const uint8*, uint count);
+	void  put_register(const uint8* reg16);
+	void  start_read(uint32 sector);
+	void  write_block();
+	void  handle_command();
+	uint8 r1(uint8 err = 0) const { return err | (idle ? 0x01 : 0x00); }
+
+	void make_csd(uint8* csd) const;
+	void make_cid(uint8* cid) const;
+
+public:
+	explicit SDCard(cstr filepath);
+	~SDCard();
+	NO_COPY_MOVE(SDCard);
+
+	void  init();
+	void  output(uint8);
+	uint8 input();
+
+	cstr getFilepath() const { return filepath; }
+	bool isLoaded() const { return image != nullptr; }
+	bool isWritable() const { return writable; }
+	void setWritable(bool f) { writable = f && file_writable; }
+	bool isZeroLatency() const { return zero_latency; }
+	void setZeroLatency(bool f) { zero_latency = f; }
+	bool isBusy() const { return busy_cnt || data_cnt || state != st_command; }
+};
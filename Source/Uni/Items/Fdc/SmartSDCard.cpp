@@ -5,9 +5,9 @@
 #include "SmartSDCard.h"
 #include "Machine.h"
 #include "Memory.h"
-#include "Settings.h"
 #include "Z80/Z80.h"
 #include "kio/kio.h"
+#include "unix/files.h"
 
 /*	Questions:
 
@@ -332,6 +332,7 @@ SmartSDCard::SmartSDCard(Machine* m, uint dip_switches) :
 	joystick_id(usb_joystick0),
 	sd_card(nullptr),
 	sio(nullptr),
+	card_zero_latency(no),
 	config(),
 	//	dip_joystick_enabled(gui::settings.get_bool(key_smart_card_joystick_enabled, yes)),
 	//	dip_memory_enabled(gui::settings.get_bool(key_smart_card_memory_enabled, yes)),
@@ -362,6 +363,9 @@ SmartSDCard::SmartSDCard(Machine* m, uint dip_switches) :
 	// TODO: evtl. load custom rom
 	// TODO: evtl. save/restore $3000 - $3fff
 
+	// the flash_dummy_page and the rom page-out bits may be mapped to any address:
+	claimMemory(cpu_patch | cpu_memmapped_rw, 0x0000, 0xffff);
+
 	if (dip_joystick_enabled) insertJoystick(usb_joystick0);
 }
 
@@ -1022,6 +1026,45 @@ void SmartSDCard::videoFrameEnd(int32 cc) { cc_flash_write_end -= cc; }
 //{}
 
 
+void SmartSDCard::ejectCard()
+{
+	assert(isMainThread());
+	assert(is_locked());
+
+	delete sd_card;
+	sd_card = nullptr;
+}
+
+void SmartSDCard::insertCard(cstr path)
+{
+	// note: SDCard shows alerts on error
+
+	assert(isMainThread());
+	assert(is_locked());
+
+	if (sd_card) ejectCard();
+	sd_card = new SDCard(path);
+	if (!sd_card->isLoaded()) ejectCard(); // open file failed!
+	else sd_card->setZeroLatency(card_zero_latency);
+}
+
+cstr SmartSDCard::getCardFilename() const
+{
+	if (!sd_card) return nullptr;
+	return basename_from_path(sd_card->getFilepath());
+}
+
+void SmartSDCard::toggleCardWritable()
+{
+	if (sd_card) sd_card->setWritable(!sd_card->isWritable());
+}
+
+void SmartSDCard::setCardZeroLatency(bool f)
+{
+	card_zero_latency = f;
+	if (sd_card) sd_card->setZeroLatency(f);
+}
+
 void SmartSDCard::setMemoryEnabled(bool) {}
 
 void SmartSDCard::setForceBankB(bool) {}
@@ -5,6 +5,7 @@
 
 #include "MassStorage.h"
 #include "Memory.h"
+#include "SDCard.h"
 #include "Z80/Z80.h"
 
 
@@ -17,14 +18,6 @@ public:
 	void init() {}
 };
 
-class SDCard
-{
-public:
-	void  output(uint8) {}
-	uint8 input() { return 0; }
-	void  init() {}
-};
-
 enum FlashCommandState {
 	flash_writing,
 	flash_idle,
@@ -45,6 +38,7 @@ class SmartSDCard final : public MassStorage
 	JoystickID joystick_id;
 	SDCard*	   sd_card;
 	Sio*	   sio;
+	bool	   card_zero_latency; // SD card responds without latency
 
 	// i/o registers:
 	// ram_config = config & 0x00FF
@@ -79,6 +73,16 @@ public:
 	void setForceBankB(bool);
 	void enableFlashWrite(bool);
 
+	// SD card:
+	void insertCard(cstr path);
+	void ejectCard();
+	bool isCardInserted() const volatile { return sd_card != nullptr; }
+	cstr getCardFilename() const;
+	bool isCardWritable() const { return sd_card && sd_card->isWritable(); }
+	void toggleCardWritable();
+	bool isCardZeroLatency() const volatile { return card_zero_latency; }
+	void setCardZeroLatency(bool);
+
 	// Joystick handling:
 	void	   enableJoystick(bool f) { dip_joystick_enabled = f; }
 	void	   insertJoystick(JoystickID id) { joystick_id = id; }
@@ -96,11 +96,21 @@ Item::~Item()
 	xlogIn("~Item: %s", name);
 	assert(isMainThread());
 
+	machine->memmapped_handlers.release(this);
 	delete[] ioinfo;
 	if (_prev) _prev->_next = _next;
 	if (_next) _next->_prev = _prev;
 }
 
+void Item::claimMemory(CoreByte kinds, uint16 a, uint16 e)
+{
+	// register this item as handler for rom patches and memory mapped i/o in the cpu address range a … e:
+	// if it is the only claimant of a cpu page then the Machine calls handleRomPatch(), readMemory()
+	// and writeMemory() of this item directly, else it starts at the last item of the daisy chain.
+
+	machine->memmapped_handlers.claim(this, kinds, a, e);
+}
+
 void Item::powerOn(int32)
 {
 	xlogline("Item:init: %s", name);
@@ -128,6 +138,22 @@ void Item::grow_ioinfo()
 }
 
 
+void Item::save_ioinfo(StateBuffer& state) const
+{
+	state.put(ioinfo_count);
+	state.write(ioinfo, ioinfo_count * sizeof(IoInfo));
+}
+
+void Item::restore_ioinfo(StateBuffer& state)
+{
+	uint count;
+	state.get(count);
+	while (ioinfo_size < count) grow_ioinfo();
+	state.read(ioinfo, count * sizeof(IoInfo));
+	ioinfo_count = count;
+}
+
+
 bool Item::is_locked() const volatile { return machine->is_locked(); }
 
 void Item::lock() const volatile { machine->lock(); }
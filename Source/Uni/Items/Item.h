@@ -7,6 +7,7 @@
 #include "IsaObject.h"
 #include "zxsp_types.h"
 
+class StateBuffer;
 
 extern uint16 bitsForSpec(cstr s);
 extern uint16 maskForSpec(cstr s);
@@ -43,6 +44,10 @@ protected:
 	void record_ioinfo(int32 cc, uint16 addr, uint8 byte, uint8 mask = 0xff);
 
 	void showMessage(MessageStyle s, cstr text);
+	void claimMemory(CoreByte kinds, uint16 a = 0x0000, uint16 e = 0xffff); // cpu_patch | cpu_memmapped_rw
+
+	void save_ioinfo(StateBuffer&) const;
+	void restore_ioinfo(StateBuffer&);
 
 
 	// ---------------- P U B L I C -------------------
@@ -81,6 +86,13 @@ public:
 	//			an Item that uses romdis must override romCS().
 	virtual void ramCS(bool active); // RAM_CS:  ZX80, ZX81
 	virtual void romCS(bool active); // ROM_CS:  ZX81, ZXSP, ZX128, +2; ROMCS1+ROMCS2: +2A, +3
+
+	// In-memory state for run-ahead, see Machine::run_ahead():
+	// canSaveState() must only return true if saveState() saves all state which is modified by running the machine.
+	// Items without such state just return true. The state is saved at the start of a frame.
+	virtual bool canSaveState() const { return no; }
+	virtual void saveState(StateBuffer&) const {}
+	virtual void restoreState(StateBuffer&) {}
 };
 
 
@@ -106,6 +118,7 @@ inline void Item::videoFrameEnd(int32) {}
 inline void Item::triggerNmi() { _prev->triggerNmi(); }
 
 // memory r/w/x patches:
+// items must claim the addresses they handle with claimMemory() in their constructor.
 // methods must forward call to prev() if not hit
 // chain ends in Mmu
 inline uint8 Item::handleRomPatch(uint16 pc, uint8 o) { return _prev->handleRomPatch(pc, o); }
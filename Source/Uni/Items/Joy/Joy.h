@@ -33,4 +33,5 @@ protected:
 
 	// Item interface
 	void input(Time t, int32 cc, uint16 addr, uint8& byte, uint8& mask) override = 0;
+	bool canSaveState() const override { return yes; } // not modified by the machine
 };
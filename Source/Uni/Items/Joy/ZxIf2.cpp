@@ -3,6 +3,7 @@
 // https://opensource.org/licenses/BSD-2-Clause
 
 #include "ZxIf2.h"
+#include "Files/RomCache.h"
 #include "Machine.h"
 #include "Z80/Z80.h"
 #include "zxsp_helpers.h"
@@ -64,12 +65,12 @@ void ZxIf2::insertRom(cstr path)
 
 	ejectRom();
 
-	FD	   fd(path, 'r');
-	uint32 sz = uint32(fd.file_size());
-	if (sz > 0x4000) sz = 0x4000;
-	rom = new Memory(machine, basename_from_path(path), 0x4000);
+	RomImagePtr image = RomCache::getRom(path);
+	rom				  = new Memory(machine, basename_from_path(path), 0x4000);
+	rom->is_rom		  = yes;
 
-	read_mem(fd, rom.getData(), sz);
+	uint32 sz = min(image->size, 0x4000u);
+	Z80::b2c(image->data, rom.getData(), sz);
 	if (sz <= 0x2000) memcpy(rom.getData() + 0x2000, rom.getData(), 0x2000);
 
 	filepath = newcopy(path);
@@ -17,6 +17,7 @@ protected:
 
 	// Item interface:
 	void input(Time t, int32 cc, uint16 addr, uint8& byte, uint8& mask) override;
+	bool canSaveState() const override { return yes; } // not modified by the machine
 
 public:
 	explicit KempstonMouse(Machine*);
@@ -58,6 +58,7 @@ protected:
 
 	// Item interface:
 	void powerOn(int32 cc) override;
+	bool canSaveState() const override { return yes; } // not modified by the machine
 
 private:
 	virtual void convert_to_matrix(Keymap&) {}
@@ -3,6 +3,7 @@
 // https://opensource.org/licenses/BSD-2-Clause
 
 #include "Multiface.h"
+#include "Files/RomCache.h"
 #include "Machine.h"
 
 
@@ -13,10 +14,7 @@ Multiface::Multiface(Machine* m, isa_id id, cstr romfile, cstr o_addr, cstr i_ad
 	nmi_pending(no),
 	paged_in(no)
 {
-	uint8 bu[8 kB];
-	FD	  fd(catstr(appl_rsrc_path, romfile));
-	fd.read_bytes(bu, 8 kB);
-	m->cpu->b2c(bu, rom.getData(), 8 kB);
+	RomCache::read(catstr(appl_rsrc_path, romfile), rom.getData(), 8 kB);
 }
 
 
@@ -7,7 +7,6 @@
 #include "Items/Joy/KempstonJoy.h"
 #include "Machine.h"
 #include "Memory.h"
-#include "Settings.h"
 
 
 //    WoS:
@@ -98,7 +97,9 @@ Multiface1::Multiface1(Machine* m, bool enable_joystick) :
 	Multiface(m, isa_Multiface1, "Roms/mf1.rom", o_addr, i_addr),
 	joystick_id(usb_joystick0),
 	joystick_enabled(enable_joystick)
-{}
+{
+	claimMemory(cpu_patch, 0x0066, 0x0067); // NMI
+}
 
 
 void Multiface1::powerOn(/*t=0*/ int32 cc)
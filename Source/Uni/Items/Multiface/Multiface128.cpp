@@ -64,7 +64,9 @@ Multiface128::Multiface128(Machine* m) :
 	Multiface(m, isa_Multiface128, "Roms/mf128.rom", o_addr, i_addr),
 	mf_enabled(),
 	videopage()
-{}
+{
+	claimMemory(cpu_patch, 0x0066, 0x0067); // NMI
+}
 
 
 void Multiface128::powerOn(/*t=0*/ int32 cc)
@@ -97,7 +97,9 @@ Multiface3::Multiface3(Machine* m) :
 	Multiface(m, isa_Multiface3, "Roms/mf3.rom", o_addr, i_addr),
 	mf_enabled(),
 	all_ram()
-{}
+{
+	claimMemory(cpu_patch, 0x0066, 0x0066); // NMI
+}
 
 
 void Multiface3::powerOn(/*t=0*/ int32 cc)
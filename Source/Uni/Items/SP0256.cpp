@@ -4,8 +4,8 @@
 
 
 #include "SP0256.h"
+#include "Files/RomCache.h"
 #include "Machine.h"
-#include "unix/FD.h"
 #include <math.h>
 
 
@@ -203,17 +203,17 @@ inline uint8 X4(uint8 n)
 SP0256::SP0256(Machine* m, cstr romfilepath, bool is_bitswapped, float rc) :
 	machine(m),
 	rc(rc),											 // filter factor for RC; e.g. RC = 33kΩ * 22nF:
-	ff(1.0 - exp(-(1.0 / samples_per_second) / rc)), // see comments at output_filtered()
+	ff(float32(1.0 - exp(-(312 / 3.12e6) / rc))),	 // see comments at output_filtered()
 	time_per_sample(312 / 3.12e6),
 	volume(0),
 	amplification(0),
 	hifi(yes),
 	sm_state(0),
 	time(0.0),
-	time_sample_end(0),
-	sample(0),
 	sample_at_c1(0),
 	sample_at_c2(0),
+	sample_posted(0),
+	pcm_count(0),
 	current_opcode(0),
 	repeat(0),
 	pitch(0),
@@ -234,15 +234,16 @@ SP0256::SP0256(Machine* m, cstr romfilepath, bool is_bitswapped, float rc) :
 	stand_by(0),
 	command_valid(0),
 	byte(0),
-	bits(0)
+	bits(0),
+	cached(nullptr),
+	command_started(no)
 {
 	xlogline("new SP0256: romfile = %s", romfilepath);
 
 	if (debug)
 		for (uint i = 0; i < 8; i++) { assert(X8(1 << i) == (128 >> i)); };
 
-	FD fd(romfilepath);
-	fd.read_data(rom, 2048);
+	RomCache::read(romfilepath, rom, 2048);
 
 	// make non-reversed rom:
 	if (is_bitswapped)
@@ -279,10 +280,19 @@ SP0256::~SP0256()
 				s.max_sample_at_c2);
 		}
 	}
+
+	for (uint i = 0; i < 64; i++) delete[] allophone_cache[i].pcm;
+
+	// remove the last output level from the step buffer: else it would leave a dc offset
+	machine->outputStep(time, -sample_posted);
 }
 
 
-void SP0256::set_clock(Frequency xtal) { time_per_sample = 312.0 / xtal; }
+void SP0256::set_clock(Frequency xtal)
+{
+	time_per_sample = 312.0 / xtal;
+	ff				= float32(1.0 - exp(-time_per_sample / rc)); // filter runs at the SP0256 sample rate
+}
 
 void SP0256::set_volume(Sample volume)
 {
@@ -299,8 +309,11 @@ void SP0256::powerOn(Sample volume, Frequency xtal)
 {
 	xlogIn("SP0256::init");
 
-	sm_state = 0;	// restart state machine
-	time	 = 0.0; // up to which time we ran
+	sm_state	  = 0;	 // restart state machine
+	time		  = 0.0; // up to which time we ran
+	sample_at_c1  = 0;
+	sample_at_c2  = 0;
+	sample_posted = 0; // machine.step_buffer was cleared
 	set_clock(xtal);
 	set_volume(volume);
 }
@@ -385,7 +398,6 @@ bool SP0256::audioBufferEnd(Time t)
 	xxlogIn("SP0256::audioBufferEnd");
 	run_statemachine(t);
 	time -= t;
-	time_sample_end -= t;
 	return stand_by;
 }
 
@@ -560,9 +572,10 @@ void SP0256::cmdSetPage(uint llll)
 		{
 			xxlogline(
 				"SP0256: RTS: next command = %u = %s", command, command < 64 ? al2_allophone_names[command] : "???");
-			pc			  = 0x1000 + (command << 1);
-			command_valid = no;
-			stand_by	  = no;
+			pc				= 0x1000 + (command << 1);
+			command_valid	= no;
+			stand_by		= no;
+			command_started = yes;
 			if (PRINT_STATISTICS) current_command = command;
 			return;
 		}
@@ -1203,6 +1216,140 @@ inline int coeff(uint c) { return c & 0x80 ? coeff_tab[(-c) & 0x7F] : -coeff_tab
 #define FINISH }
 
 
+/*	load next microcode:
+	set/update repeat, pitch, pitch_incr, amplitude, amplitude_incr and
+	filter coefficients c[] & _c[] and clear feed-back values _z[]
+	returns false for opcodes which produce no sound: SETPAGE/RTS, SETMODE, JMP and JSR
+*/
+bool SP0256::next_microcode()
+{
+	// the sequencer receives a serial bit stream.
+	// for the opcode we need 8 bits:
+	// the low (1st) nibble contains inline data, the high (2nd) nibble is the instruction
+	uint instr	   = next8();
+	current_opcode = instr >> 4;
+
+	switch (instr >> 4)
+	{
+	case SETPAGE: cmdSetPage(instr); return false; // and RTS
+	case SETMODE: cmdSetMode(instr); return false;
+	case JMP: cmdJmp(instr); return false;
+	case JSR: cmdJsr(instr); return false;
+	case PAUSE: cmdPause(); break;
+	case LOADALL: cmdLoadAll(); break;
+	case LOAD_2: cmdLoad2(); break;
+	case LOAD_4: cmdLoad4(); break;
+	case LOAD_C: cmdLoadC(); break;
+	case LOAD_E: cmdLoadE(); break;
+	case SETMSB3: cmdSetMsb3(); break;
+	case SETMSB5: cmdSetMsb5(); break;
+	case SETMSB6: cmdSetMsb6(); break;
+	case SETMSBA: cmdSetMsbA(); break;
+	case DELTA_9: cmdDelta9(); break;
+	case DELTA_D: cmdDeltaD(); break;
+	}
+
+	// mockup parameters:
+	repeat += (instr & 15);
+	assert(repeat < 0x40); // repeat &= 0x3F;		6 bit
+	// assert(pitch<0x100);  	// pitch &= 0xff;		8 bit
+
+	// repeat==0 is an ill. condition
+	// it does never happen in the AL2 rom
+	// it is unclear what the real device did in this case
+	if (repeat == 0)
+	{
+		logline("SP0256: repeat=0");
+		return false;
+	}
+
+	// convert coefficients: 8 bit -> 10 bit signed
+	for (uint i = 0; i < 12; i++)
+	{
+		_c[i] = coeff(c[i]);
+		_z[i] = 0; // clear feed-back values.		((note: verified))
+	}
+	return true;
+}
+
+
+/*	render one pitch period into z[]:
+	run pulse or noise through the filters and update feedback values.
+	the samples are not yet multiplied with the amplification.
+	returns the number of samples: pitch, or 64 for noise
+*/
+uint SP0256::render_period(Sample* z)
+{
+	uint n = pitch ? pitch : 0x40;
+
+	for (uint i = n; i; i--)
+	{
+		int z0 = 0; // sample value moving through the filter
+
+		// note: SP0250: pitch.bit6 activates white noise)
+		// note: SP0256: pitch==0 activates noise with pitch=64)
+		if (pitch == 0) // set z0 from noise:
+		{
+			// this is the rng from MAME. makes no difference from my version, but anyway:
+			_shiftreg = (_shiftreg >> 1) ^ (_shiftreg & 1 ? 0x4001 : 0);
+			z0		  = _shiftreg & 1 ? ampl(amplitude) : -ampl(amplitude);
+		}
+		else // vocal: set z0 for single pulse:
+		{
+			if (i == pitch) z0 = ampl(amplitude);
+		}
+
+		// apply 6x 2-pole filter:
+		for (uint j = 0; j < 12;)
+		{
+			z0 += _z[j] * _c[j] / 512;
+			_z[j] = _z[j + 1];
+			j++;
+			z0 += _z[j] * _c[j] / 256;
+			_z[j] = z0;
+			j++;
+		}
+
+		if (hifi) // don't limit output to 8 bit
+		{
+			if (z0 > +0x1FFF) xlogline("filter output > 14 bit");
+			if (z0 < -0x2000) xlogline("filter output > 14 bit");
+			// limit(-8192,z0,8191);	// 14 bit resolution
+		}
+		else // original 8 bit resolution
+		{
+			limit(-2048, z0, 2047);
+			z0 &= ~0xF;
+		}
+
+		*z++ = Sample(z0);
+	}
+
+	return n;
+}
+
+
+/*	play samples q[0…n) from this.time on, as far as they start before t:
+	each sample is run through the RC filter and posted to the step buffer at its start time.
+	this.time is advanced to the end of the last played sample and may overshoot t.
+	returns the number of played samples.
+*/
+uint SP0256::play_samples(const Sample* q, uint n, Time t)
+{
+	if (time >= t) return 0;
+
+	uint m = uint(min(double(n), ceil((t - time) / time_per_sample)));
+
+	int64		pos = int64(time * samples_per_second * StepBuffer::one);
+	const int64 spt = int64(time_per_sample * samples_per_second * StepBuffer::one);
+
+	for (uint i = 0; i < m; i++, pos += spt) { output_filtered(q[i] * amplification, pos); }
+
+	time += m * time_per_sample;
+	return m;
+}
+
+
 void SP0256::run_statemachine(Time t)
 {
 	xxlogIn("SP0256::run_statemachine");
@@ -1219,6 +1366,7 @@ void SP0256::run_statemachine(Time t)
 	stand_by		= yes; // 1 = stand by (utterance completed)
 	command_valid	= no;  // 1 = command valid == !LRQ (load request)
 	current_command = 0;
+	command_started = no;
 
 	pitch		   = 0;
 	amplitude	   = 0;
@@ -1252,137 +1400,53 @@ void SP0256::run_statemachine(Time t)
 
 			xxlogline(
 				"SP0256: SBY: next command = %u = %s", command, command < 64 ? al2_allophone_names[command] : "???");
-			pc			  = 0x1000 + (command << 1);
-			command_valid = no;
-			stand_by	  = no;
+			pc				= 0x1000 + (command << 1);
+			command_valid	= no;
+			stand_by		= no;
+			command_started = yes;
 			if (PRINT_STATISTICS) current_command = command;
 		}
 
-		if (stand_by) { repeat = 1; }
-		else // load next microcode
+		// play allophone from the cache:
+		if (command_started)
 		{
-			// set/update repeat, pitch, pitch_incr, amplitude, amplitude_incr and
-			// filter coefficients c[] & _c[] and clears feed-back values _z[]
-			//
-			// the sequencer receives a serial bit stream.
-			// for the opcode we need 8 bits:
-			// the low (1st) nibble contains inline data, the high (2nd) nibble is the instruction
-			uint instr	   = next8();
-			current_opcode = instr >> 4;
-
-			switch (instr >> 4)
+			command_started = no;
+			cached			= cached_allophone(command);
+			if (cached)
 			{
-			case SETPAGE: cmdSetPage(instr); continue; // and RTS
-			case SETMODE: cmdSetMode(instr); continue;
-			case JMP: cmdJmp(instr); continue;
-			case JSR: cmdJsr(instr); continue;
-			case PAUSE: cmdPause(); break;
-			case LOADALL: cmdLoadAll(); break;
-			case LOAD_2: cmdLoad2(); break;
-			case LOAD_4: cmdLoad4(); break;
-			case LOAD_C: cmdLoadC(); break;
-			case LOAD_E: cmdLoadE(); break;
-			case SETMSB3: cmdSetMsb3(); break;
-			case SETMSB5: cmdSetMsb5(); break;
-			case SETMSB6: cmdSetMsb6(); break;
-			case SETMSBA: cmdSetMsbA(); break;
-			case DELTA_9: cmdDelta9(); break;
-			case DELTA_D: cmdDeltaD(); break;
-			}
-
-			// mockup parameters:
-			repeat += (instr & 15);
-			assert(repeat < 0x40); // repeat &= 0x3F;		6 bit
-			// assert(pitch<0x100);  	// pitch &= 0xff;		8 bit
+				for (_i = 0; _i < cached->count;)
+				{
+					_i += play_samples(cached->pcm + _i, cached->count - _i, t);
+					if (_i < cached->count) WAIT; // co-routine
+				}
 
-			// repeat==0 is an ill. condition
-			// it does never happen in the AL2 rom
-			// it is unclear what the real device did in this case
-			if (repeat == 0)
-			{
-				logline("SP0256: repeat=0");
+				// continue with the final RTS:
+				restore_state(cached->end);
+				for (uint32 i = 0; i < cached->noise_steps; i++)
+				{
+					_shiftreg = (_shiftreg >> 1) ^ (_shiftreg & 1 ? 0x4001 : 0);
+				}
 				continue;
 			}
-
-			// convert coefficients: 8 bit -> 10 bit signed
-			for (uint i = 0; i < 12; i++)
-			{
-				_c[i] = coeff(c[i]);
-				_z[i] = 0; // clear feed-back values.		((note: verified))
-			}
 		}
 
+		if (stand_by) { repeat = 1; }
+		else if (!next_microcode()) continue; // no sound from this opcode
+
 		// for the given number of repetitions:
 		for (; repeat; --repeat)
 		{
-			// for the given number of samples per pulse:
-			for (_i = pitch ? pitch : 0x40; _i; _i--)
+			// render one pitch period and play it:
+			// es scheint so, als ob ein Filterdurchlauf 312 Takte dauert
+			// Die Ausgabefrequenz ist dann genau 10 kHz
+			// Note: SP0256 S.13: Speech Code Generation:
+			//	 "The analog speech signal from a tape recording is … sampled at a 10 kHz rate."
+
+			pcm_count = render_period(pcm);
+			for (_i = 0; _i < pcm_count;)
 			{
-				// generate next sample:
-				// run pulse through filters and update feedback values:
-				{
-					int z0 = 0; // sample value moving through the filter
-
-					// note: SP0250: pitch.bit6 activates white noise)
-					// note: SP0256: pitch==0 activates noise with pitch=64)
-					if (pitch == 0) // set z0 from noise:
-					{
-						// this is the rng from MAME. makes no difference from my version, but anyway:
-						_shiftreg = (_shiftreg >> 1) ^ (_shiftreg & 1 ? 0x4001 : 0);
-						z0		  = _shiftreg & 1 ? ampl(amplitude) : -ampl(amplitude);
-					}
-					else // vocal: set z0 for single pulse:
-					{
-						if (_i == pitch) z0 = ampl(amplitude);
-					}
-
-					// apply 6x 2-pole filter:
-					for (uint j = 0; j < 12;)
-					{
-						z0 += _z[j] * _c[j] / 512;
-						_z[j] = _z[j + 1];
-						j++;
-						z0 += _z[j] * _c[j] / 256;
-						_z[j] = z0;
-						j++;
-					}
-
-					if (hifi) // don't limit output to 8 bit
-					{
-						if (z0 > +0x1FFF) xlogline("filter output > 14 bit");
-						if (z0 < -0x2000) xlogline("filter output > 14 bit");
-						// limit(-8192,z0,8191);	// 14 bit resolution
-					}
-					else // original 8 bit resolution
-					{
-						limit(-2048, z0, 2047);
-						z0 &= ~0xF;
-					}
-
-					sample = z0 * amplification;
-				}
-
-				// output one sample:
-				// es scheint so, als ob ein Filterdurchlauf 312 Takte dauert
-				// Die Ausgabefrequenz ist dann genau 10 kHz
-				// Note: SP0256 S.13: Speech Code Generation:
-				//	 "The analog speech signal from a tape recording is … sampled at a 10 kHz rate."
-
-				// bis this.time haben wir schon sound ausgegeben
-				// jetzt ein sample anhängen, max. aber bis t
-
-				time_sample_end = time + time_per_sample;
-
-				while (time_sample_end > t) // dieses Sample bringt den Puffer zum Überlauf
-				{
-					output_filtered(sample, t);
-					WAIT; // co-routine
-				}
-
-				// whole|remaining sample fits in remaining time or buffer[]
-				{
-					output_filtered(sample, time_sample_end);
-				}
+				_i += play_samples(pcm + _i, pcm_count - _i, t);
+				if (_i < pcm_count) WAIT; // co-routine: this period overlaps the buffer end
 			}
 
 			// apply increments:
@@ -1396,10 +1460,10 @@ void SP0256::run_statemachine(Time t)
 
 
 /*	output samples to DSP output buffer with double RC filter
-	• Filtert und speichert den übergebenen Sample-Wert ab dem letzten Zeitpunkt in this.time
-	  bis zum angegebenen neuen Zeitpunkt ee.
-	• ee darf nicht über den dsp output buffer (plus stitching) hinausgehen
-	• Aktualisiert time aus ee.
+	• Filtert den übergebenen Sample-Wert mit der Samplerate des SP0256 (10 kHz)
+	  und übergibt die Änderung am Filterausgang an der Position 'pos' an machine.step_buffer.
+	• pos = Sample-Position im dsp output buffer, 32.32 fixed point; darf nicht über den Puffer (plus stitching)
+	  hinausgehen
 	• Das Filter hat bei 1 kHz eine Dämpfung von ca. 24 dB, also etwas etwa: Sample(out) = Sample(in) / 12.
 	  Das sollte vorkompensiert werden.
 	  Die untere Übergangsfrequenz (-3 dB) ist 139 Hz.
@@ -1474,69 +1538,16 @@ void SP0256::run_statemachine(Time t)
 		vergleichsweise niederohmigen Eingang (10kΩ) läuft.
 		hmm...
 */
-void SP0256::output_filtered(Sample sample, Time ee)
+void SP0256::output_filtered(Sample sample, int64 pos)
 {
-	Time aa = time; // aa = start time
-	time	= ee;	// ee = end time
-
-	aa *= samples_per_second; // index in audio_out_buffer[] (fractional)
-	ee *= samples_per_second; // index in audio_out_buffer[] (fractional)
-
-	int32 a = int32(aa); // index in audio_out_buffer[] (integer)
-	int32 e = int32(ee); // index in audio_out_buffer[] (integer)
-
-	assert(a >= 0);
-	assert(e >= a);
-	assert(e < DSP_SAMPLES_PER_BUFFER + DSP_SAMPLES_STITCHING);
-
-	//	Time sps = 1.0 / samples_per_second;	// Zeit für ein Sample (seconds per sample)
-	//	float64 RC = 33e3 * 22e-9;				// Konstante aus R/Ω und C/F
-	//	float64 a = sps/RC;						// "horizontaler Skalierungsfaktor"
-	//	float64 U = exp(-a);					// Wert der skalierten e-Funktion nach t = sps
-	//	float64 f = 1.0 - U;					// Das Gegenstück, die Änderung:
-	//											// Um diesen Bruchteil ändert sich im Verlauf eines Samples
-	//											// der Ausgangslevel in Richtung des Zielwertes
-	//
-	//	float64 ff = 1.0 - exp( -(1.0/samples_per_second) / (33e3 * 22e-9) );
-
-
-	float  ff2; // scratch: partial ff for partial samples
 	Sample d;
+	sample_at_c1 += (sample - sample_at_c1) * ff;
+	sample_at_c2 += d = (sample_at_c1 - sample_at_c2) * ff;
+	sample_at_c1 -= d;
+	if (fabsf(sample_at_c2) > 2.0f) xxlog("sample>2");
 
-	if (a == e)
-	{
-		ff2 = ff * float(ee - aa); // note: im sub-Sample-Bereich wird ff einfach interpoliert
-		sample_at_c1 += (sample - sample_at_c1) * ff2;
-		sample_at_c2 += d = (sample_at_c1 - sample_at_c2) * ff2;
-		sample_at_c1 -= d;
-		if (fabsf(sample_at_c2) > 2.0f) xxlog("sample>2");
-		machine->audio_out_buffer[a] += sample_at_c2 * float(ee - aa);
-	}
-	else
-	{
-		ff2 = ff * float(1.0 - (aa - floor(aa)));
-		sample_at_c1 += (sample - sample_at_c1) * ff2;
-		sample_at_c2 += d = (sample_at_c1 - sample_at_c2) * ff2;
-		sample_at_c1 -= d;
-		if (fabsf(sample_at_c2) > 2.0f) xxlog("sample>2");
-		machine->audio_out_buffer[a++] += sample_at_c2 * (1.0f - float(aa - floor(aa)));
-
-		while (a < e)
-		{
-			sample_at_c1 += (sample - sample_at_c1) * ff;
-			sample_at_c2 += d = (sample_at_c1 - sample_at_c2) * ff;
-			sample_at_c1 -= d;
-			if (fabsf(sample_at_c2) > 2.0f) xxlog("sample>2");
-			machine->audio_out_buffer[a++] += sample_at_c2;
-		}
-
-		ff2 = ff * float(ee - floor(ee));
-		sample_at_c1 += (sample - sample_at_c1) * ff2;
-		sample_at_c2 += d = (sample_at_c1 - sample_at_c2) * ff2;
-		sample_at_c1 -= d;
-		if (fabsf(sample_at_c2) > 2.0f) xxlog("sample>2");
-		machine->audio_out_buffer[a] += sample_at_c2 * float(ee - floor(ee));
-	}
+	machine->step_buffer.addDelta(pos, sample_at_c2 - sample_posted);
+	sample_posted = sample_at_c2;
 
 	if (PRINT_STATISTICS && current_opcode < 16)
 	{
@@ -1555,6 +1566,154 @@ void SP0256::output_filtered(Sample sample, Time ee)
 }
 
 
+// --------------------------------------------------------------
+//						allophone cache
+// --------------------------------------------------------------
+
+
+void SP0256::save_state(SeqState& s) const
+{
+	s.current_opcode = current_opcode;
+	s.repeat		 = repeat;
+	s.pitch			 = pitch;
+	s.amplitude		 = amplitude;
+	s.pitch_incr	 = pitch_incr;
+	s.amplitude_incr = amplitude_incr;
+	memcpy(s.c, c, sizeof(c));
+	memcpy(s._c, _c, sizeof(_c));
+	memcpy(s._z, _z, sizeof(_z));
+	s.mode	= mode;
+	s.page	= page;
+	s.pc	= pc;
+	s.stack = stack;
+	s.byte	= byte;
+	s.bits	= bits;
+}
+
+void SP0256::restore_state(const SeqState& s)
+{
+	current_opcode = s.current_opcode;
+	repeat		   = s.repeat;
+	pitch		   = s.pitch;
+	amplitude	   = s.amplitude;
+	pitch_incr	   = s.pitch_incr;
+	amplitude_incr = s.amplitude_incr;
+	memcpy(c, s.c, sizeof(c));
+	memcpy(_c, s._c, sizeof(_c));
+	memcpy(_z, s._z, sizeof(_z));
+	mode  = s.mode;
+	page  = s.page;
+	pc	  = s.pc;
+	stack = s.stack;
+	byte  = s.byte;
+	bits  = s.bits;
+}
+
+
+/*	test whether the current state is the start state s of a cached allophone
+	_c[] and _z[] don't matter: the first sound opcode sets _c[] and clears _z[].
+*/
+bool SP0256::is_start_state(const SeqState& s) const
+{
+	return repeat == s.repeat && pitch == s.pitch && amplitude == s.amplitude && pitch_incr == s.pitch_incr &&
+		   amplitude_incr == s.amplitude_incr && memcmp(c, s.c, sizeof(c)) == 0 && mode == s.mode &&
+		   page == s.page && pc == s.pc && stack == s.stack && byte == s.byte && bits == s.bits;
+}
+
+
+/*	get allophone for command from the cache
+	called when the command was started by SBY or RTS: pc is already set.
+	the allophone is (re-)rendered if the start state or the hifi setting differs from the cached one.
+	after SBY the start state is always the same, after RTS it depends on the previous allophone.
+	returns nullptr if the allophone can't be played from the cache.
+*/
+SP0256::AllophoneCache* SP0256::cached_allophone(uint cmd)
+{
+	if (PRINT_STATISTICS || cmd >= 64) return nullptr;
+
+	AllophoneCache& ac = allophone_cache[cmd];
+	if (ac.status == AllophoneCache::not_cacheable && ac.hifi == hifi) return nullptr; // noise
+	if (ac.status == AllophoneCache::empty || ac.hifi != hifi || !is_start_state(ac.start)) render_allophone(ac);
+	return ac.status == AllophoneCache::cached ? &ac : nullptr;
+}
+
+
+/*	render the allophone at pc into the cache
+	runs the micro sequencer up to the final RTS and restores the current state afterwards.
+	allophones with audible noise are not cacheable, because the noise depends on the shift register.
+	pitch and amplitude deltas are no problem: they are part of the start state.
+*/
+void SP0256::render_allophone(AllophoneCache& ac)
+{
+	xlogIn("SP0256::render_allophone");
+
+	SeqState& start = ac.start;
+	save_state(start);
+	uint16 shiftreg = _shiftreg;
+
+	uint32	capacity	= 0x1000;
+	Sample* z			= new Sample[capacity];
+	uint32	count		= 0;
+	uint32	noise_steps = 0;
+	bool	ok			= yes;
+
+	for (uint n = 0; ok; n++)
+	{
+		SeqState before;
+		save_state(before);
+
+		if (!next_microcode())
+		{
+			if (stand_by) // final RTS
+			{
+				ac.end = before;
+				break;
+			}
+			if (n > 1000) ok = no; // endless JMP loop?
+			continue;
+		}
+
+		for (; repeat; --repeat)
+		{
+			if (pitch == 0)
+			{
+				if (ampl(amplitude)) ok = no; // audible noise
+				noise_steps += 0x40;
+			}
+
+			if (count + 0x100 > capacity)
+			{
+				Sample* zz = new Sample[capacity * 2];
+				memcpy(zz, z, count * sizeof(Sample));
+				delete[] z;
+				z = zz;
+				capacity *= 2;
+			}
+
+			count += render_period(z + count);
+			pitch += pitch_incr;
+			amplitude += amplitude_incr;
+		}
+
+		if (count > 0x40000) ok = no; // > 26 sec: endless loop?
+	}
+
+	delete[] ac.pcm;
+	ac.pcm		   = ok ? z : nullptr;
+	ac.count	   = ok ? count : 0;
+	ac.noise_steps = noise_steps;
+	ac.status	   = ok ? AllophoneCache::cached : AllophoneCache::not_cacheable;
+	ac.hifi		   = hifi;
+	if (!ok) delete[] z;
+
+	xlogline("allophone %s: %u samples", ok ? "cached" : "not cacheable", count);
+
+	restore_state(start);
+	_shiftreg = shiftreg;
+	stand_by  = no;
+}
+
+
 void SP0256::disassAllophones()
 {
 	logIn("SP0256: allophone rom disassembly");
@@ -12,22 +12,26 @@ class SP0256
 	Machine* const machine;
 
 	const float32 rc;			   // RC value (for both stages), e.g. RC = 33kΩ * 22nF
-	const float32 ff;			   // filter factor per audio-out sample (for both filter stages)
+	float32		  ff;			   // filter factor per SP0256 sample (for both filter stages)
 	Time		  time_per_sample; // SP0256: time[seconds] per sample = 1.0 / (XTAL/312)
 	Sample		  volume;
 	Sample		  amplification; // volume setting (incl. all other factors)
 	bool		  hifi;
 
 	// coroutine state machine
-	uint   sm_state;		// for coroutine macros
-	Time   time;			// up to which time the state machine ran:
-	Time   time_sample_end; // time when the currently rendered 10kHz sample ends
-	Sample sample;
-	Sample sample_at_c1; // current filtered output value at C1 (output of filter stage 1)
-	Sample sample_at_c2; // current filtered output value at C2 (output of filter stage 2)
+	uint   sm_state;	  // for coroutine macros
+	Time   time;		  // up to which time the state machine ran: end of the last played sample
+	Sample sample_at_c1;  // current filtered output value at C1 (output of filter stage 1)
+	Sample sample_at_c2;  // current filtered output value at C2 (output of filter stage 2)
+	Sample sample_posted; // filter output last posted to machine.step_buffer
+	Sample pcm[0x100];	  // the current pitch period, rendered at 10 kHz
+	uint   pcm_count;	  // samples in pcm[]
 
 	void run_statemachine(Time);
-	void output_filtered(Sample, Time);
+	bool next_microcode();
+	uint render_period(Sample*);
+	uint play_samples(const Sample*, uint n, Time);
+	void output_filtered(Sample, int64 pos);
 
 	// 17 sound and filter registers:
 	uint  current_opcode;
@@ -60,6 +64,39 @@ class SP0256
 	uint  byte; // current/last byte read from rom, remaining valid bits are right-aligned
 	uint  bits; // number of valid bits remaining
 
+	// allophone cache:
+	// an allophone started from the same sequencer state always produces the same samples:
+	// it is rendered once and then played from the cache.
+	struct SeqState // microsequencer and filter state
+	{
+		uint  current_opcode, repeat;
+		uint8 pitch, amplitude, c[12];
+		int8  pitch_incr, amplitude_incr;
+		int	  _c[12], _z[12];
+		uint  mode, page, pc, stack, byte, bits;
+	};
+	struct AllophoneCache
+	{
+		enum Status : uint8 { empty, cached, not_cacheable };
+
+		Sample*	 pcm		 = nullptr; // filter output at 10 kHz, without amplification
+		uint32	 count		 = 0;		// samples in pcm[]
+		uint32	 noise_steps = 0;		// steps of the (silent) noise generator
+		SeqState start;					// state after the command was started
+		SeqState end;					// state before the final RTS
+		Status	 status = empty;
+		bool	 hifi	= false; // rendered with this setting
+	};
+	AllophoneCache	allophone_cache[64];
+	AllophoneCache* cached;			 // currently playing
+	bool			command_started; // set by SBY or RTS when the next command was started
+
+	void			save_state(SeqState&) const;
+	void			restore_state(const SeqState&);
+	bool			is_start_state(const SeqState&) const;
+	AllophoneCache* cached_allophone(uint cmd);
+	void			render_allophone(AllophoneCache&);
+
 public:
 	// Statistics
 	struct Stats
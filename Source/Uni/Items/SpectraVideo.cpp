@@ -3,6 +3,7 @@
 // https://opensource.org/licenses/BSD-2-Clause
 
 #include "SpectraVideo.h"
+#include "Files/RomCache.h"
 #include "Items/Z80/Z80options.h"
 #include "Machine.h"
 #include "Ula/Mmu.h"
@@ -207,6 +208,7 @@ SpectraVideo::SpectraVideo(Machine* m, uint dip_switches) :
 	assert(machine->isA(isa_MachineZxsp));
 
 	video_ram = &shadowram[0];
+	claimMemory(cpu_patch, 0x0000, 0x3fff); // IF1 rom hooks in machine rom and SPECTRA rom
 }
 
 
@@ -640,13 +642,12 @@ void SpectraVideo::insertRom(cstr path)
 
 	ejectRom();
 
-	FD	   fd(path, 'r');
-	uint32 sz = fd.file_size();
-	if (sz > 0x4000) sz = 0x4000;
+	RomImagePtr image = RomCache::getRom(path);
 	//	rom.grow(0x4000);
 	rom = new Memory(machine, basename_from_path(path), 0x4000);
 
-	read_mem(fd, rom.getData(), sz);
+	uint32 sz = min(image->size, 0x4000u);
+	Z80::b2c(image->data, rom.getData(), sz);
 	if (sz <= 0x2000) memcpy(&rom[0x2000], &rom[0], 0x2000); // miror 8k roms
 	filepath = newcopy(path);
 
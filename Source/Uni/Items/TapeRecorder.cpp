@@ -140,6 +140,7 @@ Plus2aTapeRecorder::Plus2aTapeRecorder(Machine* machine, bool auto_start, bool f
 
 TapeRecorder::~TapeRecorder()
 {
+	speaker.stop();
 	delete tapefile; // will also write to file if modified
 
 	for (uint i = 0; i < NELEM(sound); i++)
@@ -259,10 +260,10 @@ void TapeRecorder::audioBufferEnd(Time)
 		int32 zi = 0;
 		if (qi < 0)
 		{
-			zi = min(DSP_SAMPLES_PER_BUFFER, -qi);
+			zi = min(dsp_samples_per_buffer, -qi);
 			qi -= zi;
 		}																   // dest index in audio_out_buffer[]
-		int32 ze = min(DSP_SAMPLES_PER_BUFFER, zi + sound_count[id] - qi); // dest end index
+		int32 ze = min(dsp_samples_per_buffer, zi + sound_count[id] - qi); // dest end index
 		while (zi < ze) { machine->audio_out_buffer[zi++] += data[qi++]; } // copy audio data
 
 		active_sound[i].index = qi;
@@ -282,7 +283,7 @@ void TapeRecorder::audioBufferEnd(Time)
 
 		int32 zi = 0; // dest index in audio_out_buffer[]
 	r:
-		int32 ze = min(DSP_SAMPLES_PER_BUFFER, zi + sound_count[id] - qi); // dest end index
+		int32 ze = min(dsp_samples_per_buffer, zi + sound_count[id] - qi); // dest end index
 		while (zi < ze) { machine->audio_out_buffer[zi++] += data[qi++]; } // copy audio data
 		if (qi == sound_count[id])
 		{
@@ -400,27 +401,14 @@ void TapeRecorder::storeBlock(TapeData* q) noexcept
 		tapefile->writeTapeDataBlock(q);
 		tapefile_record(current_cc());
 	}
+	speaker.reserve(tapefile->cnt);
 }
 
 
 void TapeRecorder::play_block()
 {
-	const uint count = DSP_SAMPLES_PER_BUFFER;
-
-	double	zpos  = 0.0;
-	uint&	block = speaker.blk;
-	uint32& qpos  = speaker.pos;
-	double& qoffs = speaker.offs;
-
-	while (block < tapefile->cnt)
-	{
-		CswBuffer* bu = (*tapefile)[block]->cswdata;
-		bu->addToAudioBuffer(machine->audio_out_buffer, count, ::samples_per_second, zpos, qpos, qoffs, speaker.volume);
-		if (zpos == count) return;
-		block++;
-		qpos  = 0;
-		qoffs = 0;
-	}
+	// the speaker renders the tape ahead on it's own thread:
+	speaker.mix(machine->audio_out_buffer, uint(dsp_samples_per_buffer));
 }
 
 /*	stop tape file
@@ -433,8 +421,11 @@ void TapeRecorder::tapefile_stop(int32 cc, bool mute)
 {
 	assert(!tapefile->isStopped());
 
+	bool recording = tapefile->isRecording();
 	if (tapefile->isPlaying() && !mute) play_block();
+	speaker.stop();
 	tapefile->stop(cc);
+	if (recording) speaker.reserve(tapefile->cnt); // make room for the recorded block
 }
 
 void TapeRecorder::tapefile_play(int32 cc)
@@ -442,10 +433,7 @@ void TapeRecorder::tapefile_play(int32 cc)
 	assert(tapefile->isStopped());
 
 	tapefile->startPlaying(cc);
-
-	speaker.blk	 = tapefile->pos;
-	speaker.pos	 = tapefile->current_block->cswdata->pos;
-	speaker.offs = tapefile->current_block->cswdata->cc_offset;
+	speaker.start(tapefile);
 }
 
 void TapeRecorder::tapefile_record(int32 cc)
@@ -507,7 +495,9 @@ void TapeRecorder::insert(TapeFile* newtapefile)
 	assert(!isLoaded());
 
 	stop();
-	tapefile = newtapefile;
+	tapefile			= newtapefile;
+	block_info.tapefile = nullptr; // the new tape file may have the same address
+	if (tapefile) speaker.reserve(tapefile->cnt);
 	play_sound(newtapefile ? sound_close_deck_loaded : sound_close_deck_empty);
 }
 
@@ -536,9 +526,40 @@ void TapeRecorder::insert(cstr filepath)
 
 	state = stopped;
 
+	speaker.stop();
 	delete tapefile;
-	tapefile = nullptr;
-	tapefile = new TapeFile(machine_ccps, filepath);
+	tapefile			= nullptr;
+	tapefile			= new TapeFile(machine_ccps, filepath);
+	block_info.tapefile = nullptr; // the new tape file may have the same address
+	speaker.reserve(tapefile->cnt);
+}
+
+static void copy_info(char* z, uint size, cstr q)
+{
+	// copy block info: truncate, nullptr -> ""
+
+	if (!q) q = "";
+	uint n = min(uint(strlen(q)), size - 1);
+	memcpy(z, q, n);
+	z[n] = 0;
+}
+
+void TapeRecorder::update_block_info() noexcept
+{
+	// the tape file or its current block changed:
+	// this happens at block boundaries or if the tape was modified or wound
+
+	assert(tapefile);
+
+	block_info.tapefile				 = tapefile;
+	block_info.serial				 = tapefile->blk_serial;
+	block_info.recording			 = tapefile->mode == TapeFile::recording;
+	block_info.other_blocks_playtime = tapefile->getTotalPlaytime() - tapefile->getPlaytimeOfBlock();
+
+	copy_info(block_info.major_info, sizeof(block_info.major_info), tapefile->getMajorBlockInfo());
+	copy_info(
+		block_info.minor_info, sizeof(block_info.minor_info),
+		block_info.recording ? nullptr : tapefile->getMinorBlockInfo());
 }
 
 void TapeRecorder::setFilename(cstr new_filename) noexcept
@@ -18,6 +18,7 @@
 #include "Item.h"
 #include "Machine.h"
 #include "TapeFile.h"
+#include "TapeSpeaker.h"
 
 
 /*  Implementation Notes
@@ -75,6 +76,23 @@ private:
 	// tapefile must only be deleted on main thread while locked.
 	TapeFile* tapefile;
 
+public:
+	// info about the tape file for Machine.publishState():
+	// cached, because it is not O(1) and may allocate. see getBlockInfo()
+	struct BlockInfo
+	{
+		const TapeFile* tapefile			  = nullptr; // \ cache key
+		uint32			serial				  = 0;		 // /
+		bool			recording			  = no;		 // recording into the current block
+		Time			other_blocks_playtime = 0;		 // total playtime of all blocks except the current one
+		char			major_info[64]		  = "";		 // of the current block
+		char			minor_info[64]		  = "";		 // of the current block, "" while recording
+	};
+
+private:
+	BlockInfo block_info;
+	void	  update_block_info() noexcept;
+
 	// action sounds:
 	// data is accessed on main thread and audio interrupt
 	// => access must be locked via list_lock.
@@ -113,15 +131,7 @@ protected:
 	};
 
 	// TR speaker / Ula mic in:
-	struct Speaker
-	{
-		Sample volume; // 0.0 ... 1.0
-		// last play position:
-		uint   blk;	 // block index in TapeFile
-		uint32 pos;	 // pulse index in CswBuffer
-		double offs; // cc_offset in pulse (fractional)
-		Speaker() : volume(0.05f), blk(0), pos(0), offs(0) {}
-	} speaker;
+	TapeSpeaker speaker;
 
 private:
 	int32 current_cc() { return machine->current_cc(); }
@@ -140,6 +150,7 @@ protected:
 	void output(Time, int32, uint16, uint8) override {}
 	void audioBufferEnd(Time t) override;
 	void videoFrameEnd(int32 cc) override;
+	bool canSaveState() const override { return isStopped(); } // the tape file is not saved
 
 public:
 	TapeRecorder(Machine*, isa_id, const cstr audio_names[], bool auto_start = yes, bool fast_load = yes);
@@ -167,6 +178,15 @@ public:
 	Time getCurrentPosition() const noexcept { return tapefile ? tapefile->getCurrentPosition() : 0; }
 	cstr getMajorBlockInfo() const noexcept { return tapefile ? tapefile->getMajorBlockInfo() : nullptr; }
 	cstr getMinorBlockInfo() const noexcept { return tapefile ? tapefile->getMinorBlockInfo() : nullptr; }
+	Time getPlaytimeOfBlock() const noexcept { return tapefile ? tapefile->getPlaytimeOfBlock() : 0; }
+	Time getPositionInBlock() const noexcept { return tapefile ? tapefile->current_block->getCurrentTimePos() : 0; }
+
+	// O(1) unless the tape file or the current block changed. must be loaded:
+	const BlockInfo& getBlockInfo() noexcept
+	{
+		if (block_info.tapefile != tapefile || block_info.serial != tapefile->blk_serial) update_block_info();
+		return block_info;
+	}
 	bool isNearEndOfTape(Time proximity) const
 	{
 		return tapefile->isLastBlock() && tapefile->getPlaytimeOfBlock() < proximity;
@@ -125,6 +125,18 @@ void Mmu128k::output(Time, int32 /*cc*/, uint16 /*addr*/, uint8 byte)
 //	MMU.ROMCS handles paging of internal ROM.
 //	=> no need to forward it's own ROMCS state as well.
 //
+void Mmu128k::saveState(StateBuffer& state) const { state.put(port_7ffd); }
+
+void Mmu128k::restoreState(StateBuffer& state)
+{
+	// setPort7ffd() also works if the port is locked
+
+	uint8 byte;
+	state.get(byte);
+	if (byte != port_7ffd) setPort7ffd(byte);
+}
+
+
 void Mmu128k::romCS(bool f)
 {
 	if (f == romdis_in) return; // no change
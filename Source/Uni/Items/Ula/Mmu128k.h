@@ -30,6 +30,9 @@ protected:
 	void powerOn(/*t=0*/ int32 cc) override;
 	void reset(Time t, int32 cc) override;
 	void output(Time t, int32 cc, uint16 addr, uint8 byte) override;
+	bool canSaveState() const override { return yes; }
+	void saveState(StateBuffer&) const override;
+	void restoreState(StateBuffer&) override;
 
 	// Mmu interface:
 	void romCS(bool active) override; // from rear-item: daisy chain
@@ -277,6 +277,21 @@ void MmuPlus3::set_port_7ffd_and_1ffd(uint8 new_7ffd, uint8 new_1ffd)
 }
 
 
+void MmuPlus3::saveState(StateBuffer& state) const
+{
+	state.put(port_7ffd);
+	state.put(port_1ffd);
+}
+
+void MmuPlus3::restoreState(StateBuffer& state)
+{
+	uint8 new_7ffd, new_1ffd;
+	state.get(new_7ffd);
+	state.get(new_1ffd);
+	if (new_7ffd != port_7ffd || new_1ffd != port_1ffd) set_port_7ffd_and_1ffd(new_7ffd, new_1ffd);
+}
+
+
 void MmuPlus3::output(Time t, int32 /*cc*/, uint16 addr, uint8 byte)
 {
 	xlogIn("MmuPlus3:Output($%4x,$%2x)", uint(addr), uint(byte));
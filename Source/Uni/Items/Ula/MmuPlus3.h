@@ -35,6 +35,8 @@ protected:
 	void powerOn(/*t=0*/ int32 cc) override;
 	void reset(Time t, int32 cc) override;
 	void output(Time t, int32 cc, uint16 addr, uint8 byte) override;
+	void saveState(StateBuffer&) const override;
+	void restoreState(StateBuffer&) override;
 
 	// Mmu interface:
 	void romCS(bool disable) override; // from rear-item: daisy chain
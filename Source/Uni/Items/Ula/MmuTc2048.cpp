@@ -77,3 +77,7 @@ void MmuTc2048::input(Time, int32 /*cc*/, uint16 /*addr*/, uint8& byte, uint8& m
 /*	write port F4
  */
 void MmuTc2048::output(Time, int32, uint16 /*addr*/, uint8 byte) { port_F4 = byte; }
+
+void MmuTc2048::saveState(StateBuffer& state) const { state.put(port_F4); }
+
+void MmuTc2048::restoreState(StateBuffer& state) { state.get(port_F4); }
@@ -27,6 +27,8 @@ protected:
 	void output(Time t, int32 cc, uint16 addr, uint8 byte) override;
 	// void	audioBufferEnd	(Time t) override;
 	// void	videoFrameEnd	(int32 cc) override;
+	void saveState(StateBuffer&) const override;
+	void restoreState(StateBuffer&) override;
 
 	bool  hasPortF4() const volatile noexcept override { return yes; } // see note on Basic64-Demo.tzx in *.cpp
 	uint8 getPortF4() const volatile override { return port_F4; }	   // seems to be present but
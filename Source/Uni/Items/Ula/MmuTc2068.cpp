@@ -444,6 +444,35 @@ void MmuTc2068::set_port_f4(uint8 f4_neu, uint8 toggled)
 }
 
 
+/*	in-memory state for run-ahead
+	the cartridge's memory is saved by the machine
+*/
+void MmuTc2068::saveState(StateBuffer& state) const
+{
+	state.put(port_F4);
+	state.put(exrom_selected);
+	state.put(hold);
+	state.put(bna);
+	state.put(port_FD);
+}
+
+void MmuTc2068::restoreState(StateBuffer& state)
+{
+	uint8 f4;
+	bool  f;
+	state.get(f4);
+	state.get(f);
+	state.get(hold);
+	state.get(bna);
+	state.get(port_FD);
+
+	uint8 toggled = f4 ^ port_F4;
+	if (f != exrom_selected) toggled |= f4; // banks which switch between EXROM and DOCK
+	exrom_selected = f;
+	if (toggled) set_port_f4(f4, toggled);
+}
+
+
 void MmuTc2068::ejectCartridge()
 {
 	assert(is_locked());
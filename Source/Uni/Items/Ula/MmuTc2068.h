@@ -56,6 +56,9 @@ protected:
 	void output(Time t, int32 cc, uint16 addr, uint8 byte) override;
 	// void	audioBufferEnd	(Time t) override;
 	// void	videoFrameEnd	(int32 cc) override;
+	bool canSaveState() const override { return yes; }
+	void saveState(StateBuffer&) const override;
+	void restoreState(StateBuffer&) override;
 
 	// Mmu interface:
 	// bool	hasPortF4() volatile const noexcept	override { return yes; }
@@ -22,6 +22,7 @@ protected:
 	// void	output			(Time t, int32 cc, uint16 addr, uint8 byte) override;
 	// void	audioBufferEnd	(Time t) override;
 	// void	videoFrameEnd	(int32 cc) override;
+	bool canSaveState() const override { return yes; } // no state
 
 	// Mmu interface:
 	void mapMem() override;
@@ -18,35 +18,45 @@ Ula::Ula(Machine* m, isa_id id, cstr o_addr, cstr i_addr) :
 	Crtc(m, id, isa_Ula, internal, o_addr, i_addr),
 	ula_out_byte(0),
 	beeper_volume(1.0),
-	beeper_current_sample(0.0),
-	beeper_last_sample_time(0.0)
+	beeper_current_sample(0.0)
 {}
 
 void Ula::powerOn(int32 cc)
 {
 	Crtc::powerOn(cc);
 
-	ula_out_byte			= 0;
-	beeper_current_sample	= 0.0f; // current beeper elongation
-	beeper_last_sample_time = 0.0;
+	ula_out_byte		  = 0;
+	beeper_current_sample = 0.0f; // current beeper elongation; machine.step_buffer was cleared
 	keymap.clear();
 }
 
-void Ula::audioBufferEnd(Time t)
+void Ula::set_beeper_sample(int32 cc, Sample new_sample)
 {
-	if (t > beeper_last_sample_time)
-	{
-		machine->outputSamples(beeper_current_sample, beeper_last_sample_time, t);
-		beeper_last_sample_time = t;
-	}
-	beeper_last_sample_time -= t;
+	// post the change of the beeper elongation to the machine's step buffer
+
+	machine->outputStep(cc, new_sample - beeper_current_sample);
+	beeper_current_sample = new_sample;
+}
+
+void Ula::saveState(StateBuffer& state) const
+{
+	state.put(ula_out_byte);
+	state.put(border_color);
+	state.put(beeper_current_sample);
+}
+
+void Ula::restoreState(StateBuffer& state)
+{
+	state.get(ula_out_byte);
+	state.get(border_color);
+	state.get(beeper_current_sample); // the machine restores the step buffer
 }
 
 void Ula::setBeeperVolume(Sample new_vol)
 {
 	if (new_vol > 1.0f) new_vol = 1.0f;
 	if (new_vol < -1.0f) new_vol = -1.0f;
-	beeper_current_sample *= new_vol / beeper_volume;
+	set_beeper_sample(machine->current_cc(), beeper_current_sample * new_vol / beeper_volume);
 	beeper_volume = new_vol;
 }
 
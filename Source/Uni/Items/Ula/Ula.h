@@ -15,9 +15,9 @@ protected:
 	uint8 ula_out_byte; // last out byte to ula: border, beeper, ear_out
 
 	// Beeper/tape out:
+	// changes are posted as steps to machine->step_buffer
 	Sample beeper_volume;		  // 0.0 ... 1.0
 	Sample beeper_current_sample; // current beeper elongation
-	Time   beeper_last_sample_time;
 
 public:
 	Keymap keymap; // keyboard matrix as seen by ula
@@ -27,6 +27,7 @@ protected:
 	~Ula() override = default;
 
 	uint8		 readKeyboard(uint16 addr); // read bits from keyboard matrix
+	void		 set_beeper_sample(int32 cc, Sample);
 	virtual void setupTiming() = 0;
 
 public:
@@ -35,8 +36,10 @@ public:
 	// void	reset			(Time t, int32 cc) override;
 	// void	input			(Time t, int32 cc, uint16 addr, uint8& byte, uint8& mask) override;
 	// void	output			(Time t, int32 cc, uint16 addr, uint8 byte) override;
-	void audioBufferEnd(Time t) override;
+	// void	audioBufferEnd	(Time t) override;
 	// void	videoFrameEnd	(int32 cc) override;
+	void saveState(StateBuffer&) const override;
+	void restoreState(StateBuffer&) override;
 
 	Sample getBeeperVolume() { return beeper_volume; }
 	void   setBeeperVolume(Sample);
@@ -67,6 +67,21 @@ void Ula128k::setPort7ffd(uint8 byte)
 }
 
 
+void Ula128k::saveState(StateBuffer& state) const
+{
+	UlaZxsp::saveState(state);
+	state.put(port_7ffd);
+}
+
+void Ula128k::restoreState(StateBuffer& state)
+{
+	UlaZxsp::restoreState(state);
+	uint8 byte;
+	state.get(byte);
+	if (byte != port_7ffd) setPort7ffd(byte);
+}
+
+
 void Ula128k::markVideoRam()
 {
 #define SET(A, SZ)    \
@@ -27,4 +27,6 @@ protected:
 	void  reset(Time t, int32 cc) override;
 	void  markVideoRam() override;
 	int32 addWaitCycles(int32 cc, uint16 addr) const volatile override;
+	void  saveState(StateBuffer&) const override;
+	void  restoreState(StateBuffer&) override;
 };
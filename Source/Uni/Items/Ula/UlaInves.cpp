@@ -149,10 +149,10 @@ void UlaInves::input(Time now, int32 cc, uint16 addr, uint8& byte, uint8& mask)
 																	 machine->model_info->earin_threshold_mic_hi;
 
 			uint32 a = uint32(now * samples_per_second);
-			if (a >= DSP_SAMPLES_PER_BUFFER + DSP_SAMPLES_STITCHING)
+			if (a >= uint32(dsp_samples_per_buffer + DSP_SAMPLES_STITCHING))
 			{
 				assert(int32(a) >= 0);
-				showAlert("Sample input beyond dsp buffer: +%i\n", int(a - DSP_SAMPLES_PER_BUFFER));
+				showAlert("Sample input beyond dsp buffer: +%i\n", int(a) - dsp_samples_per_buffer);
 				if (0.0 < threshold) byte &= ~EAR_IN_MASK;
 			}
 			else
@@ -247,7 +247,7 @@ void UlaJupiter::drawVideoBeamIndicator(int32 /*cc*/)
 	//	TODO();
 }
 
-void UlaJupiter::output(Time now, int32 cc, uint16 addr, uint8 byte)
+void UlaJupiter::output(Time /*now*/, int32 cc, uint16 addr, uint8 byte)
 {
 	assert(~addr & 0x0001); // not my address
 
@@ -265,12 +265,7 @@ void UlaJupiter::output(Time now, int32 cc, uint16 addr, uint8 byte)
 	Sample new_sample = audio_mode == mixed_audio							? beeper_volume - beeper_current_sample :
 						audio_mode == speaker_only || (byte & MIC_OUT_MASK) ? beeper_current_sample :
 																			  0.0;
-	if (new_sample != beeper_current_sample)
-	{
-		machine->outputSamples(beeper_current_sample, beeper_last_sample_time, now);
-		beeper_last_sample_time = now;
-		beeper_current_sample	= new_sample;
-	}
+	if (new_sample != beeper_current_sample) set_beeper_sample(cc, new_sample);
 
 	ula_out_byte = byte;
 }
@@ -292,12 +287,7 @@ void UlaJupiter::input(Time now, int32 cc, uint16 addr, uint8& byte, uint8& mask
 	//		mic_out_only:	in(FE) does not affect audio-out
 	//		speaker_only:	set audio-out to OFF
 	//		mixed_audio:	set audio-out to OFF
-	if (beeper_current_sample != 0.0 && audio_mode != mic_out_only)
-	{
-		machine->outputSamples(beeper_current_sample, beeper_last_sample_time, now);
-		beeper_last_sample_time = now;
-		beeper_current_sample	= 0.0;
-	}
+	if (beeper_current_sample != 0.0 && audio_mode != mic_out_only) set_beeper_sample(cc, 0.0);
 
 	// insert bit from mic socket
 	// signal from EAR input is read into bit 5.
@@ -311,10 +301,10 @@ void UlaJupiter::input(Time now, int32 cc, uint16 addr, uint8& byte, uint8& mask
 	{
 		const Sample threshold = 0.01; // to be verified
 		uint32		 a		   = uint32(now * samples_per_second);
-		if (a >= DSP_SAMPLES_PER_BUFFER + DSP_SAMPLES_STITCHING)
+		if (a >= uint32(dsp_samples_per_buffer + DSP_SAMPLES_STITCHING))
 		{
 			assert(int32(a) >= 0);
-			showAlert("Sample input beyond dsp buffer: +%i\n", int(a - DSP_SAMPLES_PER_BUFFER));
+			showAlert("Sample input beyond dsp buffer: +%i\n", int(a) - dsp_samples_per_buffer);
 			if (0.0 < threshold) byte &= ~EAR_IN_MASK;
 		}
 		else
@@ -110,10 +110,10 @@ void UlaPlus3::input(Time now, int32 cc, uint16 addr, uint8& byte, uint8& mask)
 	else if (machine->audio_in_enabled)
 	{
 		uint32 a = uint32(now * samples_per_second);
-		if (a >= DSP_SAMPLES_PER_BUFFER + DSP_SAMPLES_STITCHING)
+		if (a >= uint32(dsp_samples_per_buffer + DSP_SAMPLES_STITCHING))
 		{
 			assert(int32(a) >= 0);
-			showAlert("Sample input beyond dsp buffer: +%i\n", int(a - DSP_SAMPLES_PER_BUFFER));
+			showAlert("Sample input beyond dsp buffer: +%i\n", int(a) - dsp_samples_per_buffer);
 			if (0.0f < threshold) byte &= ~EAR_IN_MASK;
 		}
 		else
@@ -268,6 +268,26 @@ int32 UlaTc2048::doFrameFlyback(int32)
 }
 
 
+void UlaTc2048::saveState(StateBuffer& state) const
+{
+	UlaZxsp::saveState(state);
+	state.put(byte_ff);
+}
+
+void UlaTc2048::restoreState(StateBuffer& state)
+{
+	// note: the interrupt is restored by the cpu
+
+	UlaZxsp::restoreState(state);
+	uint8 byte;
+	state.get(byte);
+	if (byte == byte_ff) return;
+	byte_ff = byte;
+	markVideoRam();
+	static_cast<MmuTc2048*>(machine->mmu)->selectEXROM(byte >> 7);
+}
+
+
 void UlaTc2048::markVideoRam()
 {
 	//	Port 0xFF: set display mode:
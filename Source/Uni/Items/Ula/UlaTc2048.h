@@ -24,6 +24,8 @@ protected:
 	int32 updateScreenUpToCycle(int32 cc) override;
 	// void	drawVideoBeamIndicator	(int32 cc) override;
 	void markVideoRam() override;
+	void saveState(StateBuffer&) const override;
+	void restoreState(StateBuffer&) override;
 	// int32	addWaitCycles			(int32 cc, uint16 addr) volatile const override;	TODO ?
 
 public:
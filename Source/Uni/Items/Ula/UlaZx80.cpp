@@ -66,10 +66,10 @@ void UlaZx80::powerOn(int32 cc)
 	assert(screen);
 	tv_decoder.reset(screen);
 	set60Hz(is60hz);
-	beeper_volume		  = 0.0025f;
-	beeper_current_sample = -beeper_volume;
-	lcntr				  = 0; // 3 bit scanline counter
-	vsync				  = off;
+	beeper_volume = 0.0025f;
+	set_beeper_sample(cc, -beeper_volume);
+	lcntr = 0; // 3 bit scanline counter
+	vsync = off;
 }
 
 void UlaZx80::reset(Time t, int32 cc)
@@ -95,15 +95,13 @@ void UlaZx80::set60Hz(bool is_60hz)
 
 void UlaZx80::enableMicOut(bool f)
 {
-	beeper_volume		  = f ? 0.05f : 0.0025f;
-	beeper_current_sample = beeper_current_sample > 0.0f ? beeper_volume : -beeper_volume;
+	beeper_volume = f ? 0.05f : 0.0025f;
+	set_beeper_sample(machine->current_cc(), beeper_current_sample > 0.0f ? beeper_volume : -beeper_volume);
 }
 
-void UlaZx80::mic_out(Time now, int32 cc, bool bit)
+void UlaZx80::mic_out(Time, int32 cc, bool bit)
 {
-	machine->outputSamples(beeper_current_sample, beeper_last_sample_time, now);
-	beeper_last_sample_time = now;
-	beeper_current_sample	= bit ? beeper_volume : -beeper_volume;
+	set_beeper_sample(cc, bit ? beeper_volume : -beeper_volume);
 
 	if (machine->taperecorder->isRecording()) machine->taperecorder->output(cc, bit);
 }
@@ -117,10 +115,10 @@ bool UlaZx80::mic_in(Time now, int32 cc)
 	if (machine->audio_in_enabled)
 	{
 		uint32 a = uint32(now * samples_per_second);
-		if (unlikely(a >= DSP_SAMPLES_PER_BUFFER + DSP_SAMPLES_STITCHING))
+		if (unlikely(a >= uint32(dsp_samples_per_buffer + DSP_SAMPLES_STITCHING)))
 		{
 			assert(int32(a) >= 0);
-			showAlert("Sample input beyond dsp buffer: +%i\n", int(a - DSP_SAMPLES_PER_BUFFER));
+			showAlert("Sample input beyond dsp buffer: +%i\n", int(a) - dsp_samples_per_buffer);
 		}
 		else { return machine->audio_in_buffer[a] >= threshold; }
 	}
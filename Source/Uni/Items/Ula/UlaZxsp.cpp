@@ -269,7 +269,7 @@ uint8 UlaZxsp::getFloatingBusByte(int32 cc)
 				Output to ULA
 --------------------------------------------------------------- */
 
-void UlaZxsp::output(Time now, int32 cc, uint16 addr, uint8 byte)
+void UlaZxsp::output(Time /*now*/, int32 cc, uint16 addr, uint8 byte)
 {
 	assert(~addr & 1);
 
@@ -293,12 +293,10 @@ void UlaZxsp::output(Time now, int32 cc, uint16 addr, uint8 byte)
 	// --- BEEPER ---
 	if (x & (MIC_OUT_MASK | EAR_OUT_MASK))
 	{
-		machine->outputSamples(beeper_current_sample, beeper_last_sample_time, now);
-		beeper_last_sample_time = now;
-
-		uint bb = byte ^ MIC_OUT_MASK; // mic pin is low active
-		beeper_current_sample =
-			beeper_volume * -0.25 * ((bb & EAR_OUT_MASK) * 3 / EAR_OUT_MASK + (bb & MIC_OUT_MASK) * 1 / MIC_OUT_MASK);
+		uint   bb = byte ^ MIC_OUT_MASK; // mic pin is low active
+		Sample s  = beeper_volume * -0.25f *
+				   ((bb & EAR_OUT_MASK) * 3 / EAR_OUT_MASK + (bb & MIC_OUT_MASK) * 1 / MIC_OUT_MASK);
+		set_beeper_sample(cc, s);
 	}
 
 	// --- BORDER ---
@@ -353,10 +351,10 @@ void UlaZxsp::input(Time now, int32 cc, uint16 addr, uint8& byte, uint8& mask)
 			// TODO: simulate capacitor
 
 			uint32 a = uint32(now * samples_per_second);
-			if (a >= DSP_SAMPLES_PER_BUFFER + DSP_SAMPLES_STITCHING)
+			if (a >= uint32(dsp_samples_per_buffer + DSP_SAMPLES_STITCHING))
 			{
 				assert(int32(a) >= 0);
-				showAlert("Sample input beyond dsp buffer: +%i\n", int(a - DSP_SAMPLES_PER_BUFFER));
+				showAlert("Sample input beyond dsp buffer: +%i\n", int(a) - dsp_samples_per_buffer);
 				if (0.0 < threshold) byte &= ~EAR_IN_MASK;
 			}
 			else
@@ -440,6 +438,26 @@ int32 UlaZxsp::doFrameFlyback(int32 /*cc*/) // called from runForSound()
 	return cc_frame_end; // cc_per_frame for last frame
 }
 
+/*	save & restore the state for run-ahead
+	the state is saved at the start of a frame: nothing is drawn in attr_pixel[] yet.
+	the buffers are not restored: the screen may have taken attr_pixel[] in doFrameFlyback() while running ahead.
+*/
+void UlaZxsp::saveState(StateBuffer& state) const
+{
+	Ula::saveState(state);
+	state.put(current_frame);
+	state.put(ccx);
+	save_ioinfo(state);
+}
+
+void UlaZxsp::restoreState(StateBuffer& state)
+{
+	Ula::restoreState(state);
+	state.get(current_frame);
+	state.get(ccx);
+	restore_ioinfo(state);
+}
+
 void UlaZxsp::drawVideoBeamIndicator(int32 cc) // called from runForSound()
 {
 	updateScreenUpToCycle(cc);
@@ -67,6 +67,9 @@ public:
 	void output(Time t, int32 cc, uint16 addr, uint8 byte) override;
 	// void		audioBufferEnd		(Time t) override;
 	// void		videoFrameEnd		(int32 cc) override;
+	bool canSaveState() const override { return yes; }
+	void saveState(StateBuffer&) const override;
+	void restoreState(StateBuffer&) override;
 
 
 	// Ula interface:
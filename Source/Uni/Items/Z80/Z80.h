@@ -9,8 +9,12 @@
 
 #define Z80_H
 #include "Item.h"
+#include "Z80_Breakpoints.h"
+#include "Z80_Trace.h"
 #include "Z80options.h"
 
+class SnapshotWriter;
+
 
 // ----	memory pages ----
 
@@ -104,6 +108,9 @@ public:
 	// void	output			(Time t, int32 cc, uint16 addr, uint8 byte);
 	// void	audioBufferEnd	(Time t);
 	void videoFrameEnd(int32 cc) override;
+	bool canSaveState() const override { return yes; }
+	void saveState(StateBuffer&) const override;
+	void restoreState(StateBuffer&) override;
 
 
 	// Run the Cpu:
@@ -163,6 +170,15 @@ public:
 
 	void setCrtc(Crtc* item) { crtc = item; }
 
+	// Conditions for breakpoints: must only be modified while the machine is locked
+	Z80Breakpoints& getBreakpoints() { return breakpoints; }
+
+	// Instruction trace: recorded if option cpu_trace is set
+	void startTrace(cstr path, uint32 cpu_clock, uint32 buffer_size) noexcept(false); // FileError, AnyError
+	void stopTrace();
+	bool isTracing() const volatile { return trace != nullptr; }
+	void traceFrameEnd() { trace->frameEnd(); } // at the end of a real frame, not in run-ahead
+
 	// Registers:
 	Z80Regs&				getRegisters() { return registers; }
 	Z80Regs const volatile& getRegisters() const volatile { return registers; }
@@ -196,7 +212,7 @@ public:
 	bool	  hasWrPtr2(uint16 addr) { return getPage(addr).core_w2; }
 
 	uint8  peek(uint16 addr) const { return const_cast<Z80*>(this)->getPage(addr).both_r(addr); }
-	void   poke(uint16 addr, uint8 c) { getPage(addr).data_w(addr) = c; }
+	void   poke(uint16 addr, uint8 c);
 	uint16 peek2(uint16 addr);
 	void   poke2(uint16 addr, uint16 n);
 	uint16 pop2();
@@ -211,6 +227,9 @@ public:
 	void readRamFromFile(FD&, uint16 z_addr, uint16 _cnt);
 	void writeRamToFile(FD&, uint16 q_addr, uint16 _cnt);
 
+	// Background snapshots: all functions above which write to memory call copy_on_write()
+	void setSnapshotWriter(SnapshotWriter* w) { snapshot_writer = w; }
+
 	// Debugger:
 	void   setStackBreakpoint(uint16 sp) { stack_breakpoint = sp; }
 	uint16 break_addr;
@@ -251,14 +270,18 @@ public:
 protected:
 	char* _xword(uint8 n, uint16& ip) const; // Disassembler
 	void  reset_registers();
-
-	Crtc*	crtc;			  // video controller, updated when writing to video ram
-	PgInfo	page[CPU_PAGES];  // attached memory
-	Z80Regs registers;		  // z80 registers
-	int32	cpu_cycle;		  // cpu T cycle counter
-	int32	instr_cnt;		  // instruction counter
-	int32	cc_irpt_on;		  // interrupt signal start cycle
-	int32	cc_irpt_off;	  // interrupt signal end cycle
-	int32	cc_nmi;			  // cycle for nmi trigger
-	uint16	stack_breakpoint; //
+	void  copy_on_write(const CoreByte* p, uint n = 1) noexcept;
+
+	Crtc*			crtc;					   // video controller, updated when writing to video ram
+	PgInfo			page[CPU_PAGES];		   // attached memory
+	Z80Breakpoints	breakpoints;			   // conditions for breakpoints
+	Z80Trace*		trace			= nullptr; // instruction trace recorder, if options & cpu_trace
+	SnapshotWriter* snapshot_writer = nullptr; // pending background snapshots: see copy_on_write()
+	Z80Regs			registers;				   // z80 registers
+	int32			cpu_cycle;				   // cpu T cycle counter
+	int32			instr_cnt;				   // instruction counter
+	int32			cc_irpt_on;				   // interrupt signal start cycle
+	int32			cc_irpt_off;			   // interrupt signal end cycle
+	int32			cc_nmi;					   // cycle for nmi trigger
+	uint16			stack_breakpoint;		   //
 };
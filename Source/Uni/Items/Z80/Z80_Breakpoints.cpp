@@ -0,0 +1,619 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "Z80_Breakpoints.h"
+#include "Z80.h"
+#include <ctype.h>
+#include <strings.h>
+
+
+// bytecode:
+// a stack machine with int64 values: 32 bit numbers and registers can't overflow.
+// + - unary- and << wrap around explicitly in uint64, so even nonsense can't cause undefined behavior.
+// NUM is followed by 4 bytes (little endian), REG by 1 byte
+
+enum BcOp : uint8 {
+	END,
+	NUM,
+	REG,
+	VALUE,
+	COUNT,
+	PEEK,
+	PEEKW,
+	NEG,
+	NOT,
+	CPL,
+	ADD,
+	SUB,
+	SHL,
+	SHR,
+	AND,
+	OR,
+	XOR,
+	EQ,
+	NE,
+	LT,
+	LE,
+	GT,
+	GE,
+	LAND,
+	LOR
+};
+
+static constexpr uint stack_size = 16;
+
+enum Reg : uint8 { rA, rF, rB, rC, rD, rE, rH, rL, rI, rR, rAF, rBC, rDE, rHL, rIX, rIY, rSP, rPC, rXH, rXL, rYH, rYL };
+
+static const cstr reg_names[] = {"a",  "f",	 "b",  "c",	 "d",  "e",	 "h",  "l",	 "i",  "r",	 "af",
+								 "bc", "de", "hl", "ix", "iy", "sp", "pc", "xh", "xl", "yh", "yl"};
+static constexpr uint num_regs = NELEM(reg_names);
+
+
+// ---------------------------------------------------------
+//		compiler
+// ---------------------------------------------------------
+
+
+class BcCompiler
+{
+	cstr		 p; // parse position
+	Array<uint8> code;
+	uint		 depth	   = 0;
+	uint		 max_depth = 0;
+
+	[[noreturn]] void error(cstr msg) { throw DataError("condition: %s at \"%s\"", msg, *p ? p : "end of text"); }
+
+	void skip_space()
+	{
+		while (*p == ' ' || *p == '\t') p++;
+	}
+
+	bool test(cstr op)
+	{
+		// test for operator and skip it
+		// e.g. "&" must not match "&&", "<" must not match "<<" or "<=", "!" must not match "!="
+
+		skip_space();
+		uint n = uint(strlen(op));
+		if (strncmp(p, op, n) != 0) return false;
+		if (n == 1 && strchr("&|<>", op[0]) && p[1] == op[0]) return false;
+		if (n == 1 && strchr("<>!", op[0]) && p[1] == '=') return false;
+		p += n;
+		return true;
+	}
+
+	void expect(char c)
+	{
+		skip_space();
+		if (*p != c) error(usingstr("'%c' expected", c));
+		p++;
+	}
+
+	void emit(BcOp op) { code.append(op); }
+	void push(BcOp op)
+	{
+		code.append(op);
+		if (++depth > max_depth) max_depth = depth;
+	}
+	void push_num(uint32 n)
+	{
+		push(NUM);
+		code.append(uint8(n));
+		code.append(uint8(n >> 8));
+		code.append(uint8(n >> 16));
+		code.append(uint8(n >> 24));
+	}
+	void push_reg(uint r)
+	{
+		push(REG);
+		code.append(uint8(r));
+	}
+	void binary(BcOp op)
+	{
+		code.append(op);
+		depth--;
+	}
+
+	static bool is_name_char(char c) { return isalnum(uchar(c)) || c == '_'; }
+
+	cstr get_name();
+	bool get_number(uint32& n);
+	bool try_indirection();
+	void value();
+	void unary();
+	void add_sub();
+	void shift();
+	void relational();
+	void equality();
+	void bit_and();
+	void bit_xor();
+	void bit_or();
+	void log_and();
+	void log_or();
+
+public:
+	explicit BcCompiler(cstr s) : p(s) {}
+	uint8* compile() noexcept(false); // DataError
+};
+
+
+static int reg_index(cstr name)
+{
+	for (uint i = 0; i < num_regs; i++)
+	{
+		if (eq(name, reg_names[i])) return int(i);
+	}
+	return -1;
+}
+
+cstr BcCompiler::get_name()
+{
+	// get identifier in lower case or nullptr
+
+	skip_space();
+	if (!isalpha(uchar(*p)) && *p != '_') return nullptr;
+	cstr a = p;
+	while (is_name_char(*p)) p++;
+	return lowerstr(substr(a, p));
+}
+
+bool BcCompiler::get_number(uint32& n)
+{
+	// decimal, $hex, 0xhex, %binary
+	// 32 bit, e.g. for COUNT
+
+	skip_space();
+	uint base = 10;
+	if (*p == '$') { base = 16; p += 1; }
+	else if (*p == '%') { base = 2; p += 1; }
+	else if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) { base = 16; p += 2; }
+	else if (!isdigit(uchar(*p))) return false;
+
+	cstr   a = p;
+	uint64 m = 0;
+	for (;; p++)
+	{
+		uint v = isdigit(uchar(*p)) ? uint(*p - '0') : isxdigit(uchar(*p)) ? uint((*p | 0x20) - 'a' + 10) : 99;
+		if (v >= base) break;
+		m = m * base + v;
+		if (m > 0xffffffffu) error("number too large");
+	}
+	if (p == a || is_name_char(*p)) error("number expected");
+	n = uint32(m);
+	return true;
+}
+
+bool BcCompiler::try_indirection()
+{
+	// after '(': test for Z80 addressing: (nn) (rr) (rr+n) (rr-n)
+	// returns false and restores the parse position if it's a parenthesized expression
+
+	cstr   a = p;
+	uint32 n = 0;
+	int	   r = -1;
+	char   o = 0;
+
+	if (get_number(n)) {}
+	else if (cstr name = get_name())
+	{
+		r = reg_index(name);
+		if (r < rAF || r > rPC) goto no;
+		skip_space();
+		if ((*p == '+' || *p == '-') && p[1] != p[0])
+		{
+			o = *p++;
+			if (!get_number(n)) goto no;
+		}
+	}
+	else goto no;
+
+	skip_space();
+	if (*p != ')') goto no;
+	if (n > 0xffff) error(r < 0 ? "address too large" : "offset too large");
+	p++;
+
+	if (r < 0) push_num(n);
+	else push_reg(uint(r));
+	if (o)
+	{
+		push_num(n);
+		binary(o == '+' ? ADD : SUB);
+	}
+	emit(PEEK);
+	return true;
+
+no:
+	p = a;
+	return false;
+}
+
+void BcCompiler::value()
+{
+	// number, register, VALUE, COUNT, peek(), peekw(), (indirection) or (expression)
+
+	uint32 n;
+	if (get_number(n)) return push_num(n);
+
+	skip_space();
+	if (*p == '(')
+	{
+		p++;
+		if (try_indirection()) return;
+		log_or();
+		return expect(')');
+	}
+
+	cstr a	  = p;
+	cstr name = get_name();
+	if (!name) error("value expected");
+
+	int r = reg_index(name);
+	if (r >= 0) return push_reg(uint(r));
+	if (eq(name, "value")) return push(VALUE);
+	if (eq(name, "count")) return push(COUNT);
+	if (eq(name, "peek") || eq(name, "peekw"))
+	{
+		expect('(');
+		log_or();
+		expect(')');
+		return emit(name[4] ? PEEKW : PEEK);
+	}
+	p = a;
+	error(usingstr("unknown name \"%s\"", name));
+}
+
+void BcCompiler::unary()
+{
+	BcOp op = test("-") ? NEG : test("!") ? NOT : test("~") ? CPL : test("+") ? END : NUM;
+	if (op == NUM) return value();
+	unary();
+	if (op != END) emit(op);
+}
+
+void BcCompiler::add_sub()
+{
+	unary();
+	for (;;)
+	{
+		if (test("+")) { unary(); binary(ADD); }
+		else if (test("-")) { unary(); binary(SUB); }
+		else return;
+	}
+}
+
+void BcCompiler::shift()
+{
+	add_sub();
+	for (;;)
+	{
+		if (test("<<")) { add_sub(); binary(SHL); }
+		else if (test(">>")) { add_sub(); binary(SHR); }
+		else return;
+	}
+}
+
+void BcCompiler::relational()
+{
+	shift();
+	for (;;)
+	{
+		if (test("<=")) { shift(); binary(LE); }
+		else if (test(">=")) { shift(); binary(GE); }
+		else if (test("<")) { shift(); binary(LT); }
+		else if (test(">")) { shift(); binary(GT); }
+		else return;
+	}
+}
+
+void BcCompiler::equality()
+{
+	relational();
+	for (;;)
+	{
+		if (test("==")) { relational(); binary(EQ); }
+		else if (test("!=")) { relational(); binary(NE); }
+		else return;
+	}
+}
+
+void BcCompiler::bit_and()
+{
+	equality();
+	while (test("&")) { equality(); binary(AND); }
+}
+
+void BcCompiler::bit_xor()
+{
+	bit_and();
+	while (test("^")) { bit_and(); binary(XOR); }
+}
+
+void BcCompiler::bit_or()
+{
+	bit_xor();
+	while (test("|")) { bit_xor(); binary(OR); }
+}
+
+void BcCompiler::log_and()
+{
+	bit_or();
+	while (test("&&")) { bit_or(); binary(LAND); }
+}
+
+void BcCompiler::log_or()
+{
+	log_and();
+	while (test("||")) { log_and(); binary(LOR); }
+}
+
+uint8* BcCompiler::compile() noexcept(false)
+{
+	log_or();
+	skip_space();
+	if (*p) error("operator expected");
+	if (max_depth > stack_size) error("expression too complex");
+	assert(depth == 1);
+
+	emit(END);
+	uint8* bu = new uint8[code.count()];
+	memcpy(bu, code.getData(), code.count());
+	return bu;
+}
+
+
+// ---------------------------------------------------------
+//		evaluation
+// ---------------------------------------------------------
+
+
+static int64 reg_value(const Z80Regs& regs, uint r)
+{
+	switch (r)
+	{
+	case rA: return regs.a;
+	case rF: return regs.f;
+	case rB: return regs.b;
+	case rC: return regs.c;
+	case rD: return regs.d;
+	case rE: return regs.e;
+	case rH: return regs.h;
+	case rL: return regs.l;
+	case rI: return regs.i;
+	case rR: return regs.r;
+	case rAF: return regs.af;
+	case rBC: return regs.bc;
+	case rDE: return regs.de;
+	case rHL: return regs.hl;
+	case rIX: return regs.ix;
+	case rIY: return regs.iy;
+	case rSP: return regs.sp;
+	case rPC: return regs.pc;
+	case rXH: return regs.xh;
+	case rXL: return regs.xl;
+	case rYH: return regs.yh;
+	case rYL: return regs.yl;
+	default: IERR();
+	}
+}
+
+static bool evaluate(const uint8* ip, Z80& cpu, uint8 value, uint32 count)
+{
+	// run the bytecode
+	// the compiler has checked the stack depth
+
+	const Z80Regs& regs = cpu.getRegisters();
+	int64		   stack[stack_size];
+	int64*		   sp = stack; // next free
+
+	for (;;)
+	{
+		switch (*ip++)
+		{
+		case END: return sp[-1] != 0;
+		case NUM:
+			*sp++ = int64(ip[0] | ip[1] << 8 | ip[2] << 16 | uint32(ip[3]) << 24);
+			ip += 4;
+			continue;
+		case REG: *sp++ = reg_value(regs, *ip++); continue;
+		case VALUE: *sp++ = value; continue;
+		case COUNT: *sp++ = int64(count); continue;
+		case PEEK: sp[-1] = cpu.peek(uint16(sp[-1])); continue;
+		case PEEKW: sp[-1] = cpu.peek2(uint16(sp[-1])); continue;
+		case NEG: sp[-1] = int64(0 - uint64(sp[-1])); continue;
+		case NOT: sp[-1] = !sp[-1]; continue;
+		case CPL: sp[-1] = ~sp[-1]; continue;
+		}
+
+		int64 b = *--sp;
+		int64 a = sp[-1];
+		switch (ip[-1])
+		{
+		case ADD: a = int64(uint64(a) + uint64(b)); break;
+		case SUB: a = int64(uint64(a) - uint64(b)); break;
+		case SHL: a = b >= 0 && b < 64 ? int64(uint64(a) << b) : 0; break;
+		case SHR: a = b >= 0 && b < 64 ? a >> b : a < 0 ? -1 : 0; break;
+		case AND: a = a & b; break;
+		case OR: a = a | b; break;
+		case XOR: a = a ^ b; break;
+		case EQ: a = a == b; break;
+		case NE: a = a != b; break;
+		case LT: a = a < b; break;
+		case LE: a = a <= b; break;
+		case GT: a = a > b; break;
+		case GE: a = a >= b; break;
+		case LAND: a = a && b; break;
+		case LOR: a = a || b; break;
+		default: IERR();
+		}
+		sp[-1] = a;
+	}
+}
+
+
+// ---------------------------------------------------------
+//		breakpoint list
+// ---------------------------------------------------------
+
+
+Z80Breakpoints::Condition::Condition(cstr source, uint8* code, bool log_only) :
+	source(newcopy(source)),
+	code(code),
+	count(0),
+	log_only(log_only),
+	refs(0)
+{}
+
+Z80Breakpoints::Condition::~Condition()
+{
+	delete[] source;
+	delete[] code;
+}
+
+
+uint8* Z80Breakpoints::compile(cstr condition, bool* log_only) noexcept(false)
+{
+	// compile condition into bytecode
+	// a leading "log" makes it a tracepoint
+	// an empty condition is always true
+
+	while (*condition == ' ') condition++;
+	*log_only = strncasecmp(condition, "log", 3) == 0 && !isalnum(uchar(condition[3])) && condition[3] != '_';
+	if (*log_only) condition += 3;
+	while (*condition == ' ') condition++;
+
+	if (*condition == 0) condition = "1";
+	return BcCompiler(condition).compile();
+}
+
+
+static inline bool less(const CoreByte* cb1, CoreByte kind1, const CoreByte* cb2, CoreByte kind2)
+{
+	// sort order of the list
+	return cb1 != cb2 ? uintptr_t(cb1) < uintptr_t(cb2) : kind1 < kind2;
+}
+
+uint Z80Breakpoints::lower_bound(const CoreByte* cb, CoreByte kind) const
+{
+	// binary search: index of the first breakpoint which is not less than cb and kind
+
+	uint a = 0, e = list.count();
+	while (a < e)
+	{
+		uint m = (a + e) / 2;
+		if (less(list[m].cb, list[m].kind, cb, kind)) a = m + 1;
+		else e = m;
+	}
+	return a;
+}
+
+int Z80Breakpoints::index_of(const CoreByte* cb, CoreByte kind) const
+{
+	uint i = lower_bound(cb, kind);
+	return i < list.count() && list[i].cb == cb && list[i].kind == kind ? int(i) : -1;
+}
+
+void Z80Breakpoints::remove_at(uint i)
+{
+	Condition* c = list[i].condition;
+	if (--c->refs == 0) delete c;
+	list.remove(i);
+}
+
+void Z80Breakpoints::set(const CoreByte* cb, CoreByte kinds, cstr condition) noexcept(false)
+{
+	set(&cb, 1, kinds, condition);
+}
+
+void Z80Breakpoints::set(const CoreByte* const* cbs, uint count, CoreByte kinds, cstr condition) noexcept(false)
+{
+	// attach condition to the breakpoints of these kinds at all bytes cbs[]
+	// the bytes share one condition per kind, e.g. the bytes of an instruction: they have one COUNT
+	// the caller sets the flags in the CoreBytes
+	// an empty condition removes the condition: then the breakpoint always stops
+
+	assert((kinds & ~cpu_break_rwx) == 0);
+
+	bool   log_only;
+	uint8* code = compile(condition, &log_only); // throws
+	delete[] code;
+
+	for (uint i = 0; i < count; i++) remove(cbs[i], kinds);
+	while (*condition == ' ') condition++;
+	if (*condition == 0 || count == 0) return;
+
+	for (CoreByte kind = cpu_break_x; kind <= cpu_break_r; kind <<= 1)
+	{
+		if (~kinds & kind) continue;
+		Condition* c = new Condition(condition, compile(condition, &log_only), log_only);
+		for (uint i = 0; i < count; i++)
+		{
+			if (index_of(cbs[i], kind) >= 0) continue; // same byte twice
+			list.insertat(lower_bound(cbs[i], kind), Breakpoint {cbs[i], kind, c});
+			c->refs++;
+		}
+	}
+}
+
+void Z80Breakpoints::remove(const CoreByte* cb, CoreByte kinds)
+{
+	uint i = lower_bound(cb, 0);
+	while (i < list.count() && list[i].cb == cb)
+	{
+		if (list[i].kind & kinds) remove_at(i);
+		else i++;
+	}
+}
+
+void Z80Breakpoints::removeRange(CoreByte* a, uint32 size)
+{
+	// memory is removed or reallocated:
+	// remove all conditions and clear the breakpoints which had one
+
+	uint i = lower_bound(a, 0);
+	while (i < list.count() && list[i].cb < a + size)
+	{
+		a[list[i].cb - a] &= ~list[i].kind;
+		remove_at(i);
+	}
+}
+
+void Z80Breakpoints::purge()
+{
+	while (list.count()) remove_at(list.count() - 1);
+}
+
+const Z80Breakpoints::Breakpoint* Z80Breakpoints::find(const CoreByte* cb, CoreByte kind) const
+{
+	int i = index_of(cb, kind);
+	return i >= 0 ? &list[uint(i)] : nullptr;
+}
+
+cstr Z80Breakpoints::conditionAt(const CoreByte* cb, CoreByte kind) const
+{
+	const Breakpoint* bp = find(cb, kind);
+	return bp ? bp->condition->source : nullptr;
+}
+
+
+bool Z80Breakpoints::hit(Z80& cpu, const CoreByte* cb, CoreByte kind, uint16 addr, uint8 value)
+{
+	// called by the cpu if a breakpoint fired
+	// the cpu has saved the registers
+	// returns true if the cpu shall stop
+
+	if (list.count() == 0) return true;
+	int i = index_of(cb, kind);
+	if (i < 0) return true;
+
+	Condition* c = list[uint(i)].condition;
+	if (!evaluate(c->code, cpu, value, ++c->count)) return false;
+	if (!c->log_only) return true;
+
+	const Z80Regs& r = cpu.getRegisters();
+	logline(
+		"tracepoint %c $%04X #%u: value=$%02X pc=$%04X af=$%04X bc=$%04X de=$%04X hl=$%04X ix=$%04X iy=$%04X sp=$%04X",
+		kind == cpu_break_x ? 'x' : kind == cpu_break_w ? 'w' : 'r', addr, c->count, value, r.pc, r.af, r.bc, r.de,
+		r.hl, r.ix, r.iy, r.sp);
+	return false;
+}
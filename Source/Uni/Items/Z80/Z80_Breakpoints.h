@@ -0,0 +1,98 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "Templates/Array.h"
+#include "kio/kio.h"
+
+class Z80;
+using CoreByte = uint32;
+
+
+/*	Conditions for breakpoints
+
+	Breakpoints are the cpu_break_r, cpu_break_w and cpu_break_x bits in the CoreBytes.
+	A condition can be attached to a flagged byte for each of these bits.
+	The condition is compiled into a small bytecode which is evaluated by the cpu when the breakpoint fires:
+	the cpu only stops if the condition is true. Bytes without a condition always stop the cpu.
+	All bytes of an instruction can share one condition: then COUNT counts the hits on any of them.
+	The breakpoints are sorted by address, so the cpu finds the condition with a binary search.
+
+	A condition may be prefixed with "log": then it is a tracepoint which logs the registers
+	and never stops the cpu.
+
+	Syntax: C expressions with operators
+		|| && | ^ & == != < <= > >= << >> + - ! ~ unary-
+	operands:
+		numbers:	decimal, hex with '$' or '0x', binary with '%', up to 32 bit
+		registers:	A F B C D E H L I R AF BC DE HL IX IY SP PC XH XL YH YL
+		VALUE:		the byte which is read, written or executed
+					for reads the byte from the floating bus or a memory mapped port, if so
+		COUNT:		number of times this breakpoint fired, including this time
+		(nn) (rr) (rr+n) (rr-n):	byte in memory, Z80 addressing syntax
+		peek(expr) peekw(expr):		byte or word in memory
+	names are case insensitive.
+
+	e.g.:	A==$3F && (HL)>=$80
+			COUNT==100
+			log BC>$4000
+
+	The expression is evaluated in int64 with wrap-around, so no input can cause an overflow.
+
+	The registers are the state when the breakpoint fires:
+	for execute breakpoints at the start of the instruction, for read and write breakpoints mid-instruction.
+
+	The list must only be modified while the machine is locked.
+*/
+class Z80Breakpoints
+{
+public:
+	struct Condition
+	{
+		cstr   source;	 // condition as entered by the user
+		uint8* code;	 // compiled condition
+		uint32 count;	 // number of times the breakpoint fired
+		bool   log_only; // tracepoint
+		uint   refs;	 // number of Breakpoints which share this condition
+
+		Condition(cstr source, uint8* code, bool log_only);
+		~Condition();
+		NO_COPY_MOVE(Condition);
+	};
+
+	struct Breakpoint
+	{
+		const CoreByte* cb;		   // the flagged byte
+		CoreByte		kind;	   // cpu_break_r, cpu_break_w or cpu_break_x
+		Condition*		condition; // may be shared with the other bytes of the instruction
+	};
+
+private:
+	Array<Breakpoint> list; // sorted by cb and kind
+
+	uint lower_bound(const CoreByte*, CoreByte kind) const;
+	int	 index_of(const CoreByte*, CoreByte kind) const;
+	void remove_at(uint i);
+
+public:
+	Z80Breakpoints() = default;
+	~Z80Breakpoints() { purge(); }
+	NO_COPY_MOVE(Z80Breakpoints);
+
+	static uint8* compile(cstr condition, bool* log_only) noexcept(false); // DataError
+
+	// modify:
+	void set(const CoreByte*, CoreByte kinds, cstr condition) noexcept(false);					  // DataError
+	void set(const CoreByte* const*, uint count, CoreByte kinds, cstr condition) noexcept(false); // shared; DataError
+	void remove(const CoreByte*, CoreByte kinds);
+	void removeRange(CoreByte* a, uint32 size); // also clears the flags of these breakpoints
+	void purge();
+
+	const Breakpoint* find(const CoreByte*, CoreByte kind) const;
+	cstr			  conditionAt(const CoreByte*, CoreByte kind) const; // nullptr if none
+
+	// cpu:
+	bool hit(Z80&, const CoreByte*, CoreByte kind, uint16 addr, uint8 value); // true = stop
+};
+
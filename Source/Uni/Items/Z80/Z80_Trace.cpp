@@ -0,0 +1,208 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "Z80_Trace.h"
+#include "zxsp_globals.h"
+
+
+Z80Trace::Z80Trace(cstr path, uint32 cpu_clock, uint32 buffer_size) noexcept(false) :
+	num_chunks(2),
+	wp(0),
+	rp(0),
+	stopping(false),
+	failed(false),
+	dropped(0),
+	gap(0),
+	frame(0)
+{
+	// start recording
+	// buffer_size = size of the ring in bytes: rounded down to 2^N chunks, min. 2 chunks
+	// the file header is written immediately
+
+	while (num_chunks < max_chunks && num_chunks * 2 * chunk_size * sizeof(Z80TraceRecord) <= buffer_size)
+		num_chunks *= 2;
+
+	file.open_file_w(path); // throws
+
+	Z80TraceHeader head;
+	memcpy(head.magic, z80trace_magic, sizeof(head.magic));
+	head.byte_order	 = 0x01020304;
+	head.record_size = sizeof(Z80TraceRecord);
+	head.cpu_clock	 = cpu_clock;
+	file.write_bytes(&head, sizeof(head)); // throws
+
+	queue = new Z80TraceRecord*[num_chunks];
+	count = new uint32[num_chunks];
+	for (uint i = 0; i < num_chunks; i++) { queue[i] = new Z80TraceRecord[chunk_size]; }
+	discard = new Z80TraceRecord[discard_size];
+	memset(&dummy, 0, sizeof(dummy));
+
+	current = queue[0];
+	end		= current + chunk_size;
+	last	= &dummy;
+
+	int e = pthread_create(&worker_thread, nullptr /*attr*/, worker_proc, this /*args*/);
+	if (e)
+	{
+		for (uint i = 0; i < num_chunks; i++) { delete[] queue[i]; }
+		delete[] queue;
+		delete[] count;
+		delete[] discard;
+		throw AnyError(usingstr("Creating the trace recorder thread failed: %s", strerror(e)));
+	}
+}
+
+
+Z80Trace::~Z80Trace()
+{
+	// stop recording
+	// writes the current chunk and waits until the file is closed
+	// the caller must make sure that the cpu no longer writes records
+
+	if (end == discard + discard_size) dropped += uint64(current - discard);
+	else push_chunk(uint32(current - queue[wp.load(std::memory_order_relaxed) & (num_chunks - 1)]));
+	stopping.store(true, std::memory_order_release);
+	chunks_avail.release();
+	pthread_join(worker_thread, nullptr);
+
+	for (uint i = 0; i < num_chunks; i++) { delete[] queue[i]; }
+	delete[] queue;
+	delete[] count;
+	delete[] discard;
+
+	if (dropped) showWarning("Instruction trace: %llu records were dropped", (unsigned long long)dropped);
+}
+
+
+// ---------------------------------------------------------
+//		emulation thread
+// ---------------------------------------------------------
+
+
+void Z80Trace::push_chunk(uint32 n)
+{
+	uint32 i = wp.load(std::memory_order_relaxed);
+	count[i & (num_chunks - 1)] = n;
+	wp.store(i + 1, std::memory_order_release);
+	chunks_avail.release();
+}
+
+
+bool Z80Trace::slot_free() const noexcept
+{
+	// the chunk at wp is free if it is not in the queue
+	// the worker increments rp after it has written a chunk
+
+	return wp.load(std::memory_order_relaxed) - rp.load(std::memory_order_acquire) < num_chunks;
+}
+
+
+void Z80Trace::next_chunk()
+{
+	// the current chunk is full: pass it to the worker and start the next one
+	// if the worker is behind by all chunks then the following records go into the discard chunk.
+	// the cpu never waits for the worker.
+	// note: the last record is not yet finished if an interrupt acknowledge follows:
+	//		 this is called lazily from next(), so writes are never added to a chunk in the queue
+
+	bool dropping = end == discard + discard_size;
+	if (dropping)
+	{
+		dropped += discard_size;
+		gap += discard_size;
+	}
+	else push_chunk(chunk_size);
+
+	if (slot_free())
+	{
+		current = queue[wp.load(std::memory_order_relaxed) & (num_chunks - 1)];
+		end		= current + chunk_size;
+		if (dropping) put_marker(); // tell the reader where records are missing
+	}
+	else
+	{
+		current = discard;
+		end		= discard + discard_size;
+	}
+	last = &dummy;
+}
+
+
+void Z80Trace::put_marker()
+{
+	// append a marker with the current frame and the number of records dropped since the last marker
+	// the last record is not changed: writes of an interrupt acknowledge are still added to it
+
+	if (current == end) next_chunk();
+	if (end == discard + discard_size) return; // dropping: the next chunk starts with a marker
+
+	Z80TraceMarker m;
+	memset(&m, 0, sizeof(m));
+	m.cc	  = z80trace_marker;
+	m.frame	  = frame;
+	m.dropped = uint32(min(gap, uint64(0xffffffffu)));
+	memcpy(current++, &m, sizeof(m));
+	gap = 0;
+}
+
+
+void Z80Trace::frameEnd()
+{
+	// the cc of the following records restarts:
+	// the reader counts frames with these markers, so a gap does not shift the frame numbers
+
+	frame++;
+	put_marker();
+}
+
+
+// ---------------------------------------------------------
+//		worker thread
+// ---------------------------------------------------------
+
+
+// static
+void* Z80Trace::worker_proc(void* self) { return ((Z80Trace*)self)->worker_proc(); }
+
+
+/*	worker thread executor:
+	- waits for chunks_avail
+	- appends the chunk to the file or closes the file if all chunks are written and stopping is set
+	- releases the slot: the cpu polls rp
+*/
+void* Z80Trace::worker_proc()
+{
+	for (;;)
+	{
+		chunks_avail.request(); // wait for next chunk
+
+		uint32 i = rp.load(std::memory_order_relaxed);
+		if (i == wp.load(std::memory_order_acquire))
+		{
+			assert(stopping.load(std::memory_order_acquire));
+			try
+			{
+				if (!failed) file.close_file();
+			}
+			catch (FileError& e)
+			{
+				showWarning("File error: %s", e.what());
+			}
+			return nullptr;
+		}
+
+		try
+		{
+			uint32 n = count[i & (num_chunks - 1)];
+			if (!failed) file.write_bytes(queue[i & (num_chunks - 1)], n * sizeof(Z80TraceRecord));
+		}
+		catch (FileError& e)
+		{
+			showWarning("File error: %s", e.what());
+			failed = true;
+		}
+
+		rp.store(i + 1, std::memory_order_release); // release the slot
+	}
+}
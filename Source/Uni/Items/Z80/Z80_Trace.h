@@ -0,0 +1,85 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "Z80_TraceRecord.h"
+#include "cpp/cppthreads.h"
+#include "kio/kio.h"
+#include "unix/FD.h"
+#include <atomic>
+#include <pthread.h>
+
+
+/*	Record an instruction trace of the Z80 into a file on a worker thread.
+
+	The cpu appends one Z80TraceRecord per instruction to the current chunk, see Z80::run().
+	Full chunks are passed to the worker thread which appends them to the file.
+	The chunks form a ring of buffer_size bytes, which is set when recording starts.
+	If all chunks are in use the cpu does not wait for the worker: the records are dropped until a chunk is free.
+	Then a Z80TraceMarker with the current frame and the number of dropped records starts the next chunk.
+	A marker is also written at the end of each frame. The number of dropped records is reported when recording stops.
+
+	There is exactly one producer and one consumer:
+	the queue indexes are not locked, the semaphore is only used to wait for a chunk or for stop.
+
+	The file can be queried with the command line tool zxsp-trace, see Tools/zxsp-trace/.
+*/
+class Z80Trace
+{
+	static constexpr uint chunk_size   = 1 << 16; // records per chunk: 1.5 MB
+	static constexpr uint discard_size = 1 << 10; // records per discard chunk
+	static constexpr uint max_chunks   = 1 << 10; // 1.5 GB
+
+	uint				num_chunks;	// 2^N
+	Z80TraceRecord**	queue;		// [num_chunks]
+	uint32*				count;		// [num_chunks]: records in chunk
+	std::atomic<uint32>	wp;			// next chunk to write: emulation thread
+	std::atomic<uint32>	rp;			// next chunk to read:  worker thread
+	std::atomic<bool>	stopping;	// no more chunks follow
+	PSemaphore			chunks_avail;
+
+	FD	 file;
+	bool failed; // file error: discard all chunks
+
+	Z80TraceRecord* current; // next record in current chunk
+	Z80TraceRecord* end;	 // end of current chunk
+	Z80TraceRecord* last;	 // last record: memory writes are added here
+	Z80TraceRecord	dummy;	 // last record before the first one
+	Z80TraceRecord* discard; // [discard_size]: current chunk while the ring is full
+	uint64			dropped; // records written to the discard chunk
+	uint64			gap;	 // records dropped since the last marker
+	uint32			frame;	 // current frame, counted from 0
+
+	void put_marker();
+
+	pthread_t	 worker_thread;
+	static void* worker_proc(void*);
+	void*		 worker_proc();
+
+	void push_chunk(uint32 n);
+	void next_chunk();
+	bool slot_free() const noexcept;
+
+public:
+	Z80Trace(cstr path, uint32 cpu_clock, uint32 buffer_size) noexcept(false); // FileError, AnyError
+	~Z80Trace();
+	NO_COPY_MOVE(Z80Trace);
+
+	// emulation thread:
+	Z80TraceRecord* next()
+	{
+		if (current == end) next_chunk();
+		return last = current++;
+	}
+	void frameEnd(); // the cc of the following records restarts
+	void write(uint16 addr, uint8 byte)
+	{
+		if (last->nwrites == 0)
+		{
+			last->waddr	 = addr;
+			last->wvalue = byte;
+		}
+		if (last->nwrites != 255) last->nwrites++;
+	}
+};
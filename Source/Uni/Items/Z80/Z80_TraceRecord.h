@@ -0,0 +1,72 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+/*
+	Z80 instruction trace file format
+
+	This header is also used by the command line tool zxsp-trace
+	and must not depend on anything but the standard library.
+
+	file layout:
+		Z80TraceHeader
+		Z80TraceRecord[]	up to end of file, mixed with Z80TraceMarkers
+
+	all values are stored in host byte order. the header's magic tells the byte order.
+*/
+
+#include <stdint.h>
+
+using uint8	 = uint8_t;
+using uint16 = uint16_t;
+using uint32 = uint32_t;
+using int32	 = int32_t;
+
+
+struct Z80TraceHeader
+{
+	char   magic[12];	// "zxsp-trace\n" + '\0'
+	uint32 byte_order;	// 0x01020304 in host byte order
+	uint32 record_size; // sizeof(Z80TraceRecord)
+	uint32 cpu_clock;	// cpu cycles per second
+};
+
+
+/*	one record per instruction:
+	registers are the values before execution.
+	the first memory write of the instruction is recorded, nwrites counts all.
+	writes of an interrupt or nmi acknowledge are added to the instruction before.
+	prefixed instructions are one record.
+*/
+struct Z80TraceRecord
+{
+	int32  cc;		// cpu cycle at start of instruction, relative to start of frame
+	uint16 pc;		// address of the instruction
+	uint16 af, bc, de, hl, sp;
+	uint8  op[4];	// opcode bytes at pc: 1 .. 4 bytes are used
+	uint16 waddr;	// address of first memory write
+	uint8  wvalue;	// value of first memory write
+	uint8  nwrites; // number of memory writes, saturating at 255
+};
+
+static_assert(sizeof(Z80TraceRecord) == 24, "Z80TraceRecord size");
+
+
+/*	a marker is written at the end of each frame, where the cc of the records restarts,
+	and where records are missing because the recorder could not keep up.
+	it has the size of a Z80TraceRecord and is recognized by cc == z80trace_marker.
+*/
+struct Z80TraceMarker
+{
+	int32  cc;		  // z80trace_marker
+	uint32 frame;	  // frame of the following records, counted from 0 at the start of the recording
+	uint32 dropped;	  // records missing right before this marker, saturating
+	uint32 unused[3]; // 0
+};
+
+static_assert(sizeof(Z80TraceMarker) == sizeof(Z80TraceRecord), "Z80TraceMarker size");
+
+static constexpr int32 z80trace_marker = INT32_MIN;
+
+static constexpr char z80trace_magic[12] = "zxsp-trace\n";
@@ -81,22 +81,34 @@
 	c		   = uint8(z32);                                                       \
 	if ((z32 &= options))                                                          \
 	{                                                                              \
-	  if (z32 & cpu_break_r)                                                       \
-	  {                                                                            \
-		break_addr = A;                                                            \
-		result	   = cpu_exit_r;                                                   \
-		ic_max	   = 0;                                                            \
-	  }                                                                            \
 	  if (z32 & cpu_waitmap) { CC_WAIT_R(cc + 2); }                                \
 	  if (z32 & cpu_r_access) { pg.both_r(A) -= cpu_r_access; }                    \
 	  if (z32 & cpu_floating_bus) { c = machine->ula->getFloatingBusByte(cc); }    \
 	  if (z32 & cpu_memmapped_r) { c = machine->readMemMappedPort(cc + 2, A, c); } \
+	  if (z32 & cpu_break_r) /* VALUE = the byte which the cpu actually reads */   \
+	  {                                                                            \
+		SAVE_REGISTERS;                                                            \
+		if (breakpoints.hit(*this, &pg.both_r(A), cpu_break_r, A, c))              \
+		{                                                                          \
+		  break_addr = A;                                                          \
+		  result	 = cpu_exit_r;                                                 \
+		  ic_max	 = 0;                                                          \
+		}                                                                          \
+	  }                                                                            \
 	};                                                                             \
 	cc += 3;                                                                       \
 	R = c;                                                                         \
   }                                                                                \
   while (0)
 
+/*	copy-on-write for pending background snapshots: see SnapshotWriter
+ */
+#define COPY_ON_WRITE(P)                                                   \
+  do {                                                                     \
+	if (snapshot_writer && snapshot_writer->isPending()) copy_on_write(P); \
+  }                                                                        \
+  while (0)
+
 /*	write byte to ram:
 	unconditionally write to primary page_w
 	write to secondary page_w2 if not null
@@ -106,14 +118,19 @@
   do {                                                                        \
 	cc += 2;                                                                  \
 	PgInfo& pg = getPage(A);                                                  \
+	COPY_ON_WRITE(&pg.both_w(A));                                             \
 	if ((z32 = pg.both_w(A) & options))                                       \
 	{                                                                         \
 	  if (z32 & cpu_waitmap) { CC_WAIT_W(cc); }                               \
 	  if (z32 & cpu_break_w)                                                  \
 	  {                                                                       \
-		break_addr = A;                                                       \
-		result	   = cpu_exit_w;                                              \
-		ic_max	   = 0;                                                       \
+		SAVE_REGISTERS;                                                       \
+		if (breakpoints.hit(*this, &pg.both_w(A), cpu_break_w, A, R))         \
+		{                                                                     \
+		  break_addr = A;                                                     \
+		  result	 = cpu_exit_w;                                            \
+		  ic_max	 = 0;                                                     \
+		}                                                                     \
 	  }                                                                       \
 	  if (z32 & cpu_crtc)                                                     \
 	  {                                                                       \
@@ -121,16 +138,22 @@
 	  }                                                                       \
 	  if (z32 & cpu_w_access) { pg.both_w(A) -= cpu_w_access; }               \
 	  if (z32 & cpu_memmapped_w) { machine->writeMemMappedPort(cc, A, R); }   \
+	  if (z32 & cpu_trace) { trace->write(A, R); }                            \
 	};                                                                        \
 	if (pg.core_w2)                                                           \
 	{                                                                         \
+	  COPY_ON_WRITE(&pg.both_w2(A));                                          \
 	  if ((z32 = pg.both_w2(A) & options))                                    \
 	  {                                                                       \
 		if (z32 & cpu_break_w)                                                \
 		{                                                                     \
-		  break_addr = A;                                                     \
-		  result	 = cpu_exit_w;                                            \
-		  ic_max	 = 0;                                                     \
+		  SAVE_REGISTERS;                                                     \
+		  if (breakpoints.hit(*this, &pg.both_w2(A), cpu_break_w, A, R))      \
+		  {                                                                   \
+			break_addr = A;                                                   \
+			result	   = cpu_exit_w;                                          \
+			ic_max	   = 0;                                                   \
+		  }                                                                   \
 		}                                                                     \
 		if (z32 & cpu_crtc)                                                   \
 		{                                                                     \
@@ -173,9 +196,13 @@
 		if (machine->break_ptr == &pg.both_r(pc)) { machine->break_ptr = nullptr; } \
 		else                                                                        \
 		{                                                                           \
-		  break_addr = pc;                                                          \
-		  result	 = cpu_exit_x;                                                  \
-		  EXIT;                                                                     \
+		  SAVE_REGISTERS;                                                           \
+		  if (breakpoints.hit(*this, &pg.both_r(pc), cpu_break_x, pc, R))           \
+		  {                                                                         \
+			break_addr = pc;                                                        \
+			result	   = cpu_exit_x;                                                \
+			EXIT;                                                                   \
+		  }                                                                         \
 		}                                                                           \
 	  }                                                                             \
 	  if (z32 & cpu_patch)                                                          \
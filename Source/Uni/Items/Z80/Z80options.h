@@ -38,6 +38,7 @@ enum Z80Option : uint32 {
 	cpu_memmapped_w	 = 1u << 20, // extensions: callback for memory mapped io
 	cpu_memmapped_rw = 3u << 19, // extensions: callback for memory mapped io				for convenience
 	cpu_floating_bus = 1u << 21, // unmapped memory: CPU may see what the CRTC is reading
+	cpu_trace		 = 1u << 22, // debugger: record instruction trace; bit in CoreByte: record writes to this byte
 
 	// just flags, bit in CoreByte not used:
 	cpu_break_sp = 1u << 30, // debugger: check stack_watchpoint in RET and POP
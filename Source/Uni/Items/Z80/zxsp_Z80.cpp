@@ -31,6 +31,7 @@
 	2013-06-12 kio	added bits 3 and 5 to zlog_table[]  ((thanks to Rob Probin for the hint))
 */
 
+#include "Files/SnapshotWriter.h"
 #include "Machine.h"
 #include "Z80.h"			// major header file
 #include "Z80/Z80opcodes.h" // opcode enumeration
@@ -76,7 +77,11 @@ Z80::Z80(Machine* m) : Item(m, isa_Z80, isa_Z80, internal, nullptr, nullptr)
 }
 
 
-Z80::~Z80() { xlogIn("~Z80"); }
+Z80::~Z80()
+{
+	xlogIn("~Z80");
+	delete trace;
+}
 
 
 void Z80::powerOn(int32 cc)
@@ -133,11 +138,75 @@ void Z80::videoFrameEnd(int32 cc)
 }
 
 
+/*	save & restore the state for run-ahead
+	memory is saved by the Machine
+*/
+void Z80::saveState(StateBuffer& state) const
+{
+	state.put(registers);
+	state.put(cpu_cycle);
+	state.put(instr_cnt);
+	state.put(cc_irpt_on);
+	state.put(cc_irpt_off);
+	state.put(cc_nmi);
+}
+
+void Z80::restoreState(StateBuffer& state)
+{
+	state.get(registers);
+	state.get(cpu_cycle);
+	state.get(instr_cnt);
+	state.get(cc_irpt_on);
+	state.get(cc_irpt_off);
+	state.get(cc_nmi);
+}
+
+
 // ======================================================================
 
 
+void Z80::startTrace(cstr path, uint32 cpu_clock, uint32 buffer_size) noexcept(false)
+{
+	// start recording an instruction trace
+	// buffer_size = size of the ring buffer in bytes: if it is full then records are dropped
+	// the caller must also set cpu_trace in the cpu options and in the CoreBytes of all memory
+
+	assert(trace == nullptr);
+	trace = new Z80Trace(path, cpu_clock, buffer_size); // throws
+}
+
+
+void Z80::stopTrace()
+{
+	// stop recording the instruction trace and close the file
+	// the cpu must no longer be called with option cpu_trace
+
+	delete trace;
+	trace = nullptr;
+}
+
+
+/*	copy-on-write for pending background snapshots:
+	called before bytes p[0 .. n-1] are modified
+	the snapshot copies blocks of 1 kB: so it is sufficient to test one byte per kB and the last byte
+*/
+void Z80::copy_on_write(const CoreByte* p, uint n) noexcept
+{
+	if (!snapshot_writer || !snapshot_writer->isPending()) return;
+
+	for (uint i = 0; i < n; i += 1 kB) { snapshot_writer->copyOnWrite(p + i); }
+	snapshot_writer->copyOnWrite(p + n - 1);
+}
+
+
 uint16 Z80::peek2(uint16 addr) { return uint16(peek(addr)) + uint16(uint16(peek(addr + 1)) << 8); }
 
+void Z80::poke(uint16 addr, uint8 c)
+{
+	copy_on_write(wrPtr(addr));
+	getPage(addr).data_w(addr) = c;
+}
+
 void Z80::poke2(uint16 addr, uint16 n)
 {
 	poke(addr, uint8(n));
@@ -180,8 +249,13 @@ void Z80::copyBufferToRam(const uint8* q, uint16 z, uint16 cnt) noexcept
 	uint16 n = CPU_PAGESIZE - (z & CPU_PAGEMASK);
 	do {
 		if (n > cnt && cnt) n = cnt;
+		copy_on_write(wrPtr(z), n);
 		b2c(q, (FourBytes*)wrPtr(z), n);
-		if (hasWrPtr2(z)) b2c(q, (FourBytes*)wrPtr2(z), n);
+		if (hasWrPtr2(z))
+		{
+			copy_on_write(wrPtr2(z), n);
+			b2c(q, (FourBytes*)wrPtr2(z), n);
+		}
 		q += n;
 		z += n;
 		cnt -= n;
@@ -213,8 +287,13 @@ void Z80::copyBufferToRam(const CoreByte* q, uint16 z, uint16 cnt) noexcept
 	uint16 n = CPU_PAGESIZE - (z & CPU_PAGEMASK);
 	do {
 		if (n > cnt && cnt) n = cnt;
+		copy_on_write(wrPtr(z), n);
 		c2c(q, wrPtr(z), n);
-		if (hasWrPtr2(z)) c2c(q, wrPtr2(z), n);
+		if (hasWrPtr2(z))
+		{
+			copy_on_write(wrPtr2(z), n);
+			c2c(q, wrPtr2(z), n);
+		}
 		q += n;
 		z += n;
 		cnt -= n;
@@ -230,8 +309,13 @@ void Z80::readRamFromFile(FD& fd, uint16 z, uint16 cnt)
 	do {
 		if (n > cnt && cnt) n = cnt;
 		fd.read_bytes(bu, n);
+		copy_on_write(wrPtr(z), n);
 		b2c(bu, (FourBytes*)wrPtr(z), n);
-		if (hasWrPtr2(z)) b2c(bu, (FourBytes*)wrPtr2(z), n);
+		if (hasWrPtr2(z))
+		{
+			copy_on_write(wrPtr2(z), n);
+			b2c(bu, (FourBytes*)wrPtr2(z), n);
+		}
 		z += n;
 		cnt -= n;
 		n = CPU_PAGESIZE;
@@ -564,6 +648,8 @@ void Z80::unmapRam(uint16 addr, uint16 size, const uint8* waitmap, int wm_size)
 */
 void Z80::unmapMemory(CoreByte* a, uint32 size)
 {
+	breakpoints.removeRange(a, size); // memory is removed or reallocated
+
 	CoreByte* e = a + size;
 	CoreByte* p;
 
@@ -806,6 +892,23 @@ nxtcmnd:
 	if (cc < cc_max && ic < ic_max) // fast loop exit test
 	{
 	loop_ei:
+		if (options & cpu_trace)
+		{
+			// record the instruction trace:
+			// writes are added by POKE for bytes with flag cpu_trace set
+			// also the instruction after EI and after an ineffective IX/IY prefix
+			Z80TraceRecord* t = trace->next();
+			t->cc			  = cc;
+			t->pc			  = pc;
+			t->af			  = uint16(ra << 8 | rf);
+			t->bc			  = BC;
+			t->de			  = DE;
+			t->hl			  = HL;
+			t->sp			  = SP;
+			t->nwrites		  = 0;
+			for (uint i = 0; i < 4; i++) { t->op[i] = getPage(uint16(pc + i)).data_r(uint16(pc + i)); }
+		}
+
 #include "Z80codes.h"
 		IERR();
 	}
@@ -0,0 +1,71 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "kio/kio.h"
+#include "zxsp_types.h"
+#include <atomic>
+
+
+/*	Input events from the GUI for the emulation thread
+
+	The GUI pushes keyboard, joystick and mouse events with the real time when they happened.
+	Machine::runForSound() applies each event at the cpu cycle which corresponds to this time
+	in the time slice of the previous audio buffer: the input is delayed by exactly one audio buffer
+	but has no jitter, and it is seen by the cpu at the same position as on the real machine.
+
+	There is exactly one producer (the GUI thread) and one consumer (the thread running the machine):
+	the queue indexes are not locked.
+	If the queue is full the event is dropped. This can only happen if the machine is not running for long.
+*/
+
+struct InputEvent
+{
+	enum Type : uint8 { KeyDown, KeyUp, AllUp, Joystick, MouseMove, MouseButtons };
+
+	Time   time; // real time, see now()
+	Type   type;
+	uint8  oskeycode; // KeyDown, KeyUp
+	uint16 unicode;	  // KeyDown, KeyUp
+	uint8  modifiers; // KeyDown, KeyUp: KeyboardModifiers
+	uint8  joystick;  // Joystick: JoystickID
+	uint8  and_mask;  // Joystick: buttons = buttons & and_mask | or_mask
+	uint8  or_mask;	  // Joystick; MouseButtons: new buttons
+	int16  dx, dy;	  // MouseMove
+};
+
+
+class InputQueue
+{
+	static constexpr uint queue_size = 256; // must be 2^N
+
+	InputEvent			queue[queue_size];
+	std::atomic<uint32> wp {0}; // next event to write: GUI thread
+	std::atomic<uint32> rp {0}; // next event to read:  emulation thread
+
+public:
+	InputQueue() = default;
+	NO_COPY_MOVE(InputQueue);
+
+	// GUI thread:
+	bool push(const InputEvent& e) volatile
+	{
+		InputQueue& q = *const_cast<InputQueue*>(this);
+
+		uint32 i = q.wp.load(std::memory_order_relaxed);
+		if (i - q.rp.load(std::memory_order_acquire) >= queue_size) return false; // full
+		q.queue[i & (queue_size - 1)] = e;
+		q.wp.store(i + 1, std::memory_order_release);
+		return true;
+	}
+
+	// emulation thread:
+	const InputEvent* front() const
+	{
+		uint32 i = rp.load(std::memory_order_relaxed);
+		if (i == wp.load(std::memory_order_acquire)) return nullptr; // empty
+		return &queue[i & (queue_size - 1)];
+	}
+	void pop() { rp.store(rp.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+};
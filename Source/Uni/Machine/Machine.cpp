@@ -13,12 +13,13 @@
 #include "Fdc/FdcJLO.h"
 #include "Fdc/FdcPlus3.h"
 #include "Fdc/FdcPlusD.h"
+#include "Files/RomCache.h"
 #include "Files/RzxFile.h"
+#include "Files/SnapshotWriter.h"
 #include "Files/Z80Head.h"
 #include "Files/file_szx.h"
 #include "Grafpad.h"
 #include "IcTester.h"
-#include "Inspector/Inspector.h"
 #include "Joy/CursorJoy.h"
 #include "Joy/DktronicsDualJoy.h"
 #include "Joy/InvesJoy.h"
@@ -182,7 +183,9 @@ Machine::Machine(IMachineController* parent, Model model, isa_id id) :
 	cpu_clock(model_info->cpu_cycles_per_second),
 	tcc0(0.0),	 // realtime t (offset to dsp buffer start) at frame start (cc=0)  --> powerOn()
 	beam_cnt(0), // video beam indicator
-	beam_cc(0)
+	beam_cc(0),
+	step_tcc0(0),
+	step_per_cc(0)
 {
 	// create Machine with 'model'
 	// Create Ram and Rom
@@ -200,6 +203,7 @@ Machine::Machine(IMachineController* parent, Model model, isa_id id) :
 	if (model_info->tape_load_routine) cpu_options |= cpu_patch;
 
 	// Rom:
+	rom->is_rom = yes;
 	load_rom();
 
 	// flag Contended Ram:
@@ -243,8 +247,8 @@ void Machine::load_rom()
 {
 	try
 	{
-		FD fd(catstr(appl_rsrc_path, "Roms/", model_info->rom_filename)); // throws
-		read_mem(fd, rom.getData(), rom.count());						  // throws
+		cstr path = catstr(appl_rsrc_path, "Roms/", model_info->rom_filename);
+		RomCache::read(path, rom.getData(), rom.count()); // throws
 	}
 	catch (AnyError& e)
 	{
@@ -259,6 +263,9 @@ Machine::~Machine()
 	assert(isMainThread());
 
 	is_power_on = no;
+	delete snapshot_writer; // writes all queued snapshots
+	snapshot_writer = nullptr;
+	cpu->setSnapshotWriter(nullptr);
 
 	// remove from back to front:
 	while (all_items.count())
@@ -305,9 +312,52 @@ void Machine::memoryModified(Memory* m, uint how)
 	assert(isMainThread());
 	assert(is_locked());
 
+	if (how != 1 && cpu_options & cpu_trace) set_trace_flags(m, yes);
+	if (rzx_file) rzx_file->purgeKeyframes(); // the saved states don't match the new memory
 	controller->memoryModified(m, how);
 }
 
+void Machine::set_trace_flags(Memory* m, bool f)
+{
+	// set or clear the cpu_trace flag in all bytes of a memory:
+	// POKE records writes to bytes with this flag in the instruction trace
+
+	CoreByte* p = m->getData();
+	CoreByte* e = p + m->count();
+	if (f)
+		while (p < e) *p++ |= cpu_trace;
+	else
+		while (p < e) *p++ &= ~cpu_trace;
+}
+
+void Machine::startTrace(cstr path, uint32 buffer_size) noexcept(false)
+{
+	// start recording an instruction trace
+	// buffer_size = size of the ring buffer in bytes
+	// throws FileError or AnyError
+
+	assert(isMainThread());
+	assert(is_locked());
+
+	if (cpu->isTracing()) return;
+	cpu->startTrace(path, uint32(cpu_clock), buffer_size); // throws
+	for (uint i = 0; i < memory.count(); i++) { set_trace_flags(memory[i], yes); }
+	cpu_options |= cpu_trace;
+}
+
+void Machine::stopTrace()
+{
+	// stop recording the instruction trace and close the file
+
+	assert(isMainThread());
+	assert(is_locked());
+
+	if (!cpu->isTracing()) return;
+	cpu_options &= ~cpu_trace;
+	for (uint i = 0; i < memory.count(); i++) { set_trace_flags(memory[i], no); }
+	cpu->stopTrace();
+}
+
 bool Machine::suspend()
 {
 	// suspend machine
@@ -362,9 +412,17 @@ void Machine::saveAs(cstr filepath)
 {
 	assert(is_locked());
 
-	FD	 fd(filepath, 'w');
 	cstr ext = lowerstr(extension_from_path(filepath));
 
+	if (eq(ext, ".z80"))
+	{
+		FD(filepath, 'w'); // report errors for the file path now
+		saveAsInBackground(filepath);
+		return;
+	}
+
+	FD fd(filepath, 'w');
+
 	if (eq(ext, ".rom"))
 	{
 		saveRom(fd);
@@ -385,11 +443,6 @@ void Machine::saveAs(cstr filepath)
 		saveAce(fd);
 		return;
 	} // MachineJupiter.cpp
-	if (eq(ext, ".z80"))
-	{
-		saveZ80(fd);
-		return;
-	}
 	if (eq(ext, ".o"))
 	{
 		saveO80(fd);
@@ -418,6 +471,7 @@ void Machine::saveAs(cstr filepath)
 
 	if (eq(ext, ".rzx"))
 	{
+		syncSnapshots(); // the rzx file contains the snapshots
 		if (rzx_file) rzx_file->writeFile(filepath);
 		else showAlert("No rzx file in place.");
 		return;
@@ -426,6 +480,39 @@ void Machine::saveAs(cstr filepath)
 	showAlert("Unsupported file format");
 }
 
+void Machine::saveAsInBackground(cstr filepath)
+{
+	// save a .z80 snapshot without pausing the machine for copying, compressing and writing:
+	// only the registers and references to the memory pages are stored here.
+	// The memory is copied by the snapshot_writer or before the cpu modifies it: see Z80::copy_on_write().
+	// write errors are only logged: the file won't exist. Call syncSnapshots() before reading it.
+
+	assert(is_locked());
+	assert(eq(lowerstr(extension_from_path(filepath)), ".z80"));
+
+	if (!snapshot_writer)
+	{
+		snapshot_writer = new SnapshotWriter; // throws AnyError
+		cpu->setSnapshotWriter(snapshot_writer);
+	}
+
+	freezeZ80(snapshot_writer->nextSnapshot());
+	snapshot_writer->write(filepath);
+}
+
+void Machine::syncSnapshots()
+{
+	if (snapshot_writer) snapshot_writer->sync();
+}
+
+void Machine::detachSnapshots()
+{
+	// copy all memory pages of the queued snapshots
+	// must be called before memory is modified other than by the cpu, or reallocated or deleted
+
+	if (snapshot_writer) snapshot_writer->detach();
+}
+
 void Machine::_power_on(int32 start_cc)
 {
 	// Reset the Machine via Power On-Off-On
@@ -447,6 +534,8 @@ void Machine::_power_on(int32 start_cc)
 
 	tcc0 = -start_cc / cpu_clock;
 	assert(t_for_cc(start_cc) == 0.0);
+	update_step_timebase();
+	step_buffer.clear();
 
 	crtc = find<Crtc>();
 	assert(crtc);
@@ -545,6 +634,8 @@ Item* Machine::addItem(Item* item)
 
 	all_items.append(RCPtr<Item>(item));
 
+	if (rzx_file) rzx_file->purgeKeyframes(); // the saved states don't match the new items
+
 	if (auto* i = dynamic_cast<Z80*>(item)) cpu = i;
 	if (auto* i = dynamic_cast<Mmu*>(item)) mmu = i;
 	if (auto* i = dynamic_cast<Ula*>(item)) crtc = ula = i;
@@ -573,6 +664,7 @@ void Machine::removeItem(Item* item)
 	if (!item) return;
 
 	controller->itemRemoved(item);
+	if (rzx_file) rzx_file->purgeKeyframes(); // the saved states don't match the remaining items
 
 	uint i = all_items.indexof(item);
 	assert(i != ~0u);					// must be in list
@@ -797,7 +889,8 @@ uint8 Machine::handleRomPatch(uint16 pc, uint8 opcode)
 	// called with all z80 registers stored
 	// return new opcode to execute, which may be the one passed in
 
-	opcode = all_items.last()->handleRomPatch(pc, opcode);
+	Item* item = memmapped_handlers.patchHandler(pc);
+	opcode	   = (item ? item : all_items.last())->handleRomPatch(pc, opcode);
 
 	CoreByte* instrptr = cpu->rdPtr(pc);
 
@@ -901,14 +994,16 @@ uint8 Machine::readMemMappedPort(int32 cc, uint16 addr, uint8 byte)
 {
 	// for memory mapped i/o
 
-	return all_items.last()->readMemory(t_for_cc_lim(cc), cc, addr, byte);
+	Item* item = memmapped_handlers.readHandler(addr);
+	return (item ? item : all_items.last())->readMemory(t_for_cc_lim(cc), cc, addr, byte);
 }
 
 void Machine::writeMemMappedPort(int32 cc, uint16 addr, uint8 byte)
 {
 	// for memory mapped i/o
 
-	all_items.last()->writeMemory(t_for_cc_lim(cc), cc, addr, byte);
+	Item* item = memmapped_handlers.writeHandler(addr);
+	(item ? item : all_items.last())->writeMemory(t_for_cc_lim(cc), cc, addr, byte);
 }
 
 void Machine::videoFrameEnd(int32 cc)
@@ -919,6 +1014,12 @@ void Machine::videoFrameEnd(int32 cc)
 void Machine::audioBufferEnd(Time t)
 {
 	for (uint i = all_items.count(); i--;) { all_items[i]->audioBufferEnd(t); }
+
+	// integrate the posted steps:
+	int32 count = min(int32(t * samples_per_second + 0.5), dsp_samples_per_buffer);
+	step_buffer.readSamples(audio_out_buffer, count);
+
+	if (crtc && crtc->getScreen()) crtc->getScreen()->audioBufferEnd(audio_out_buffer, uint(count));
 }
 
 /* ----	The Main Thing ----
@@ -943,6 +1044,13 @@ void Machine::audioBufferEnd(Time t)
 			but is slightly ahead (-> overshoot).
 */
 void Machine::runForSound(const StereoBuffer audio_in_buffer, StereoBuffer audio_out_buffer, int32 cc_final)
+{
+	bool seeking = rzx_seeking || rzx_seek_request.load(std::memory_order_relaxed) >= 0;
+	if (seeking && cc_final == 0 && rzx_file) rzx_seek(audio_in_buffer, audio_out_buffer);
+	else run_for_sound(audio_in_buffer, audio_out_buffer, cc_final);
+}
+
+void Machine::run_for_sound(const StereoBuffer audio_in_buffer, StereoBuffer audio_out_buffer, int32 cc_final)
 {
 	xxlogIn("Machine:runForSound");
 	assert(this->is_locked());
@@ -951,13 +1059,25 @@ void Machine::runForSound(const StereoBuffer audio_in_buffer, StereoBuffer audio
 
 	this->audio_in_buffer  = audio_in_buffer;
 	this->audio_out_buffer = audio_out_buffer;
+	update_step_timebase();
+
+	bool realtime = cc_final == 0; // not the debugger
+	if (realtime)				   // time slice of one audio buffer:
+	{
+		cc_final = cc_up_for_t(seconds_per_dsp_buffer());
+		input_t0 = input_t1;
+		input_t1 = ::now();
+		input_t0 = max(input_t0, input_t1 - seconds_per_dsp_buffer()); // after pause
+	}
+	else applyPendingInputEvents(); // debugger
 
-	if (!cc_final) cc_final = cc_up_for_t(seconds_per_dsp_buffer());
 	int	   result = 0;
 	int32& cc	  = cpu->cpuCycleRef();
 
 	if (rzx_file && rzx_file->isPlaying())
 	{
+		apply_input_events(cc_final); // input is taken from the rzx file
+
 		int32& ic	  = cpu->instrCountRef();
 		int32  ic_end = rzx_file->getIcount();
 
@@ -1042,7 +1162,8 @@ void Machine::runForSound(const StereoBuffer audio_in_buffer, StereoBuffer audio
 				{
 					if (cc < 60000) xlogline("WARNING: ffb at cc = %u", cc);
 
-					int32 cc_per_frame = crtc->doFrameFlyback(cc); // finish drawing, get cc_per_frame
+					// finish drawing, get cc_per_frame. while seeking the frames are not displayed:
+					int32 cc_per_frame = rzx_seeking ? hidden_frame_flyback(cc) : crtc->doFrameFlyback(cc);
 					// cc/frame varies with the rzx source
 					// cc sollte jetzt etwas größer sein als cc_per_frame
 					// legal expected values: 1 .. 48
@@ -1060,15 +1181,25 @@ void Machine::runForSound(const StereoBuffer audio_in_buffer, StereoBuffer audio
 					}
 
 					videoFrameEnd(cc_per_frame);	  // announce cc shift
+					if (cpu_options & cpu_trace) cpu->traceFrameEnd();
 					cc_final -= cc_per_frame;		  // shift cc for lvars
 					tcc0 += cc_per_frame / cpu_clock; // shift start of current frame
+					update_step_timebase();
 					total_frames += 1;				  // info
 					total_cc += cc_per_frame;		  // info
 													  // cc -= cc_per_frame;			// done by Item Z80
+					publishState();
 				}
 				else { xlogline("late interrupt"); }
 
 				if (ic == 0) cpu->setInterrupt(cc, cc + 3); // darf nur direkt nach rzx-frame-start feuern
+
+				if (ic == 0) // start of frame:
+				{
+					uint32 frame = rzx_file->currentFrame();
+					if (rzx_file->needsKeyframe(frame)) rzxStoreKeyframe(frame);
+					if (rzx_seeking && frame >= rzx_seek_frame) break;
+				}
 			}
 		}
 		while (cc < cc_final && result == 0);
@@ -1077,38 +1208,24 @@ void Machine::runForSound(const StereoBuffer audio_in_buffer, StereoBuffer audio
 	else // no rzx file attached or rzx.recording:
 	{
 	a:
-		int32		cc_ffb	  = ula->cpuCycleOfFrameFlyback();
-		const int32 unlimited = 1 << 30;
+		int32 cc_ffb = ula->cpuCycleOfFrameFlyback();
 
 		do {
-			if (auto* crtc_zxsp = dynamic_cast<UlaZxsp*>(ula))
-			{
-				int32 cc_end = min(cc_final, crtc_zxsp->getWaitmapStart());
-				if (cc < cc_end) result = cpu->run(cc_end, unlimited, cpu_options & ~(cpu_waitmap | cpu_crtc));
-
-				cc_end = min(cc_final, crtc_zxsp->getWaitmapEnd());
-				if (result == 0 && cc < cc_end)
-				{
-					result = cpu->run(cc_end, unlimited, cpu_options);
-					crtc->updateScreenUpToCycle(cc);
-				}
-
-				cc_end = min(cc_final, cc_ffb);
-				if (result == 0 && cc < cc_end)
-					result = cpu->run(cc_end, unlimited, cpu_options & ~(cpu_waitmap | cpu_crtc));
-			}
-			else // TODO: video handling for other models
-			{
-				int32 cc_end = min(cc_final, cc_ffb);
-				if (cc < cc_end) result = cpu->run(cc_end, unlimited, cpu_options);
-			}
+			apply_input_events(cc);
+			result = run_cpu(min(cc_final, next_input_cc()), cc_ffb, cpu_options); // stop at next input event
 
 			if (cc >= cc_ffb)
 			{
-				int32 cc_per_frame = crtc->doFrameFlyback(cc); // finish drawing, get cc_per_frame
+				// with run-ahead the real frame is not displayed but a frame run_ahead_frames ahead:
+				bool ahead = realtime && run_ahead_frames && result == 0 && canSaveState();
+
+				int32 cc_per_frame = ahead ? hidden_frame_flyback(cc) : // finish drawing, get cc_per_frame
+										 crtc->doFrameFlyback(cc);
 				videoFrameEnd(cc_per_frame);				   // announce cc shift
+				if (cpu_options & cpu_trace) cpu->traceFrameEnd();
 				cc_final -= cc_per_frame;					   // shift cc for lvars
 				tcc0 += cc_per_frame / cpu_clock;			   // shift start of current frame
+				update_step_timebase();
 				total_frames += 1;							   // info
 				total_cc += cc_per_frame;					   // info
 
@@ -1118,6 +1235,9 @@ void Machine::runForSound(const StereoBuffer audio_in_buffer, StereoBuffer audio
 					rzx_file->startFrame(cc);
 				}
 				cpu->setInstrCount(0); // muss auch ohne rzx alle ~30 Minuten resettet werden!
+
+				if (ahead) run_ahead(cc_ffb);
+				publishState();
 			}
 		}
 		while (cc < cc_final && result == 0);
@@ -1161,6 +1281,192 @@ void Machine::runForSound(const StereoBuffer audio_in_buffer, StereoBuffer audio
 	total_buffers += 1;
 	total_realtime += t;
 	tcc0 -= t;
+	update_step_timebase();
+	publishState();
+}
+
+int Machine::run_cpu(int32 cc_stop, int32 cc_ffb, uint32 options)
+{
+	// run the cpu up to cc_stop but not beyond the frame flyback
+	// returns the cpu's exit code
+
+	int32&		cc		  = cpu->cpuCycleRef();
+	const int32 unlimited = 1 << 30;
+	int			result	  = 0;
+
+	if (auto* crtc_zxsp = dynamic_cast<UlaZxsp*>(ula))
+	{
+		int32 cc_end = min(cc_stop, crtc_zxsp->getWaitmapStart());
+		if (cc < cc_end) result = cpu->run(cc_end, unlimited, options & ~(cpu_waitmap | cpu_crtc));
+
+		cc_end = min(cc_stop, crtc_zxsp->getWaitmapEnd());
+		if (result == 0 && cc < cc_end)
+		{
+			result = cpu->run(cc_end, unlimited, options);
+			crtc->updateScreenUpToCycle(cc);
+		}
+
+		cc_end = min(cc_stop, cc_ffb);
+		if (result == 0 && cc < cc_end) result = cpu->run(cc_end, unlimited, options & ~(cpu_waitmap | cpu_crtc));
+	}
+	else // TODO: video handling for other models
+	{
+		int32 cc_end = min(cc_stop, cc_ffb);
+		if (cc < cc_end) result = cpu->run(cc_end, unlimited, options);
+	}
+
+	return result;
+}
+
+
+/* ----	Run-ahead ----
+
+	The emulated machine sees the input at the earliest in the frame after it happened
+	and many games poll the input only once per frame and need one or two more frames to show the result.
+	With run-ahead the real frame is not displayed. Instead the machine state is saved at the frame flyback,
+	the machine runs run_ahead_frames frames ahead with the current input, the last of these frames is displayed
+	and then the state is restored. The sound is taken from the real frames only.
+
+	Run-ahead is only possible if all items can save their state, else it is paused: see the note in Preferences.
+	In the frames run ahead breakpoints, rom patches, instruction trace and access logging are disabled.
+*/
+static HiddenScreen hidden_screen;
+
+int32 Machine::hidden_frame_flyback(int32 cc)
+{
+	// do the frame flyback but don't display the frame:
+
+	IScreen* screen	   = crtc->screen;
+	crtc->screen	   = &hidden_screen;
+	int32 cc_per_frame = crtc->doFrameFlyback(cc);
+	crtc->screen	   = screen;
+	return cc_per_frame;
+}
+
+void Machine::run_ahead(int32 cc_ffb)
+{
+	int32& cc	   = cpu->cpuCycleRef();
+	uint32 options = cpu_options & ~(cpu_break_rwx | cpu_break_sp | cpu_patch | cpu_trace | cpu_access);
+
+	run_ahead_state.clear();
+	saveState(run_ahead_state);
+
+	for (uint i = 1; i <= run_ahead_frames; i++)
+	{
+		int result = 0;
+		while (result == 0 && cc < cc_ffb) { result = run_cpu(cc_ffb, cc_ffb, options); }
+		if (result) break;
+
+		int32 cc_per_frame = i == run_ahead_frames ? crtc->doFrameFlyback(cc) : hidden_frame_flyback(cc);
+		videoFrameEnd(cc_per_frame);
+		tcc0 += cc_per_frame / cpu_clock;
+		update_step_timebase();
+		cpu->setInstrCount(0);
+	}
+
+	run_ahead_state.rewind();
+	restoreState(run_ahead_state);
+}
+
+bool Machine::canSaveState() const
+{
+	// run-ahead: the input of a playing rzx file can't be run ahead
+	return rzx_file == nullptr && itemsCanSaveState();
+}
+
+bool Machine::itemsCanSaveState() const
+{
+	for (uint i = 0; i < all_items.count(); i++)
+	{
+		if (!all_items[i]->canSaveState()) return no;
+	}
+	return yes;
+}
+
+void Machine::saveState(StateBuffer& state) const
+{
+	// the memory is saved without the flags of the CoreBytes:
+	// breakpoints and other flags are not modified by running the machine.
+	// rom is not saved: the cpu can't write it.
+
+	state.put(tcc0);
+	state.put(step_buffer);
+	for (uint i = 0; i < all_items.count(); i++) { all_items[i]->saveState(state); }
+
+	for (uint i = 0; i < memory.count(); i++)
+	{
+		if (memory[i]->is_rom) continue;
+		const CoreByte* q = memory[i]->getData();
+		uint			n = memory[i]->count();
+		uint8*			z = state.writePtr(n);
+		for (uint j = 0; j < n; j++) { z[j] = uint8(q[j]); }
+	}
+}
+
+void Machine::restoreState(StateBuffer& state)
+{
+	detachSnapshots();
+
+	state.get(tcc0);
+	state.get(step_buffer);
+	update_step_timebase();
+	for (uint i = 0; i < all_items.count(); i++) { all_items[i]->restoreState(state); }
+
+	for (uint i = 0; i < memory.count(); i++)
+	{
+		if (memory[i]->is_rom) continue;
+		CoreByte*	 z = memory[i]->getData();
+		uint		 n = memory[i]->count();
+		const uint8* q = state.readPtr(n);
+		for (uint j = 0; j < n; j++) { z[j] = (z[j] & ~0xffu) | q[j]; }
+	}
+}
+
+void Machine::publishState()
+{
+	// publish state for the inspectors
+	// called at frame end and buffer end in runForSound() and by runMachinesForSound() while suspended
+
+	MachineState* z = published_state.beginWrite();
+	if (!z) return; // another thread is publishing
+	MachineState& s = *z;
+
+	s.cpu_clock	   = cpu_clock;
+	s.total_frames = total_frames;
+	s.suspended	   = is_suspended;
+
+	s.regs		  = cpu->getRegisters();
+	s.cc		  = cpu->cpuCycle();
+	s.nmi_pending = cpu->nmiPending();
+	s.int_pending = cpu->interruptPending();
+
+	// tape info: only O(1) queries and copying from the cached block info
+	TapeRecorder* tr  = taperecorder;
+	s.tape.present	  = tr != nullptr;
+	s.tape.loaded	  = tr && tr->isLoaded();
+	s.tape.pause_down = tr && tr->isPauseDown();
+	s.tape.state	  = tr ? uint8(tr->state) : uint8(TapeRecorder::stopped);
+	if (s.tape.loaded)
+	{
+		const TapeRecorder::BlockInfo& info = tr->getBlockInfo();
+		s.tape.position						= tr->getCurrentPosition();
+		s.tape.playtime						= info.other_blocks_playtime + tr->getPlaytimeOfBlock();
+		s.tape.recording					= info.recording;
+		s.tape.block_position				= tr->getPositionInBlock();
+		memcpy(s.tape.major_info, info.major_info, sizeof(s.tape.major_info));
+		memcpy(s.tape.minor_info, info.minor_info, sizeof(s.tape.minor_info));
+	}
+	else
+	{
+		s.tape.position		  = 0;
+		s.tape.playtime		  = 0;
+		s.tape.recording	  = no;
+		s.tape.block_position = 0;
+		s.tape.major_info[0]  = 0;
+		s.tape.minor_info[0]  = 0;
+	}
+
+	published_state.endWrite();
 }
 
 void Machine::runCpuCycles(int32 cc)
@@ -1327,6 +1633,7 @@ void Machine::setSpeedFromCpuClock(Frequency new_cpu_clock)
 	tcc0 += cc / cpu_clock - cc / new_cpu_clock;
 
 	cpu_clock = new_cpu_clock;
+	update_step_timebase();
 
 	// bei extrem niedergetakteter Maschine würde runForSound einige Aufrufe lang nichts tun:
 	while (now() >= seconds_per_dsp_buffer())
@@ -1334,6 +1641,7 @@ void Machine::setSpeedFromCpuClock(Frequency new_cpu_clock)
 		Time t = seconds_per_dsp_buffer();
 		audioBufferEnd(t); // announce time shift, force audio output
 		tcc0 -= t;
+		update_step_timebase();
 	}
 }
 
@@ -1397,6 +1705,8 @@ void Machine::rzxLoadSnapshot(int32& cc_final, int32& ic_end)
 	// EndOfFile --> caller must display message and MUST change rzx state to Recording or OutOfSync!
 	// Playing   --> no state change
 
+	syncSnapshots(); // the snapshot may still be written
+
 	cstr   filename = rzx_file->getSnapshot();
 	cstr   ext		= lowerstr(extension_from_path(filename));
 	int32& cc		= cpu->cpuCycleRef();
@@ -1448,6 +1758,7 @@ void Machine::rzxLoadSnapshot(int32& cc_final, int32& ic_end)
 	{
 		int32 dcc = rzx_file->getStartCC() - cc;
 		tcc0 -= dcc / cpu_clock;
+		update_step_timebase();
 		cc += dcc;
 	}
 	cc_final += cc - old_cc;
@@ -1457,6 +1768,116 @@ void Machine::rzxLoadSnapshot(int32& cc_final, int32& ic_end)
 	ic	   = 0;
 }
 
+void Machine::rzxLoadKeyframe(const RzxFile::Keyframe& kf)
+{
+	// restore the machine and the rzx position at the start of a frame
+	// Playing | Snapshot --> Playing | OutOfSync
+
+	try
+	{
+		if (rzx_file->seekFrame(kf.frame) < 0) throw DataError("frame not found");
+	}
+	catch (AnyError& e)
+	{
+		rzxOutOfSync(usingstr("RZX file: load keyframe: %s", e.what()));
+		return;
+	}
+
+	// restoreState() also restores tcc0 from the time when the keyframe was stored:
+	// connect the cpu cycle of the keyframe with the current time instead:
+	int32 old_cc   = cpu->cpuCycle();
+	Time  old_tcc0 = tcc0;
+
+	kf.state->rewind();
+	restoreState(*kf.state);
+
+	tcc0 = old_tcc0 + (old_cc - cpu->cpuCycle()) / cpu_clock;
+	update_step_timebase();
+}
+
+void Machine::rzxStoreKeyframe(uint32 frame)
+{
+	// store a keyframe at the start of the current frame while replaying
+	// keyframes are only stored if all items can save their state, else a seek replays from the snapshot
+
+	if (!itemsCanSaveState()) return;
+
+	StateBuffer* state = new StateBuffer;
+	saveState(*state);
+	rzx_file->addKeyframe(frame, state);
+}
+
+void Machine::rzx_start_seek(uint32 frame)
+{
+	// start seeking to the start of a frame of the rzx file:
+	// restore the nearest keyframe or the start snapshot. the remaining frames are replayed by rzx_seek().
+	// Playing --> Playing | OutOfSync
+
+	rzx_seeking = no;
+	if (!rzx_file || !rzx_file->isPlaying()) return;
+	uint32 count = rzx_file->frameCount();
+	if (count == 0) return;
+	frame = min(frame, count - 1);
+
+	uint32					 current = rzx_file->currentFrame();
+	const RzxFile::Keyframe* kf		 = rzx_file->findKeyframe(frame);
+
+	if (kf && (kf->frame > current || current > frame)) { rzxLoadKeyframe(*kf); }
+	else if (current > frame) // restart:
+	{
+		rzx_file->rewind(); // --> Snapshot
+		if (!rzx_file->isSnapshot()) return rzxOutOfSync("I'm sorry, but the rzx file is unusable.");
+		int32 cc_final = 0, ic_end = 0;	   // dummy
+		rzxLoadSnapshot(cc_final, ic_end); // --> Playing | EndOfFile | OutOfSync
+	}
+	if (!rzx_file || !rzx_file->isPlaying()) return;
+
+	rzx_seeking	   = rzx_file->currentFrame() < frame;
+	rzx_seek_frame = frame;
+}
+
+/*	Seeking in the rzx file
+
+	The GUI thread only posts the target frame with rzxSeekFrame().
+	Then runForSound() calls rzx_seek() instead of running the machine in real time:
+	rzx_seek() restores the nearest keyframe and replays the remaining frames unpaced
+	for half of the time of the audio buffer in each call. The frames are not displayed and the audio is silent.
+	A new target frame cancels the running seek and starts from the nearest keyframe again.
+
+	Keyframes are machine states in memory, stored every RzxFile::keyframe_interval frames.
+	When a file is loaded, a first pass replays the whole file this way to store all keyframes
+	and then seeks back to frame 0. A seek while the first pass runs cancels it.
+*/
+void Machine::rzx_seek(const StereoBuffer audio_in_buffer, StereoBuffer audio_out_buffer)
+{
+	Time end = ::now() + seconds_per_dsp_buffer() / 2;
+
+	do {
+		int32 frame = rzx_seek_request.exchange(-1);
+		if (frame >= 0)
+		{
+			rzx_first_pass = no;
+			rzx_start_seek(uint32(frame));
+		}
+		if (!rzx_seeking) break;
+
+		run_for_sound(audio_in_buffer, audio_out_buffer, 0); // stops at the start of rzx_seek_frame
+
+		if (!rzx_file || !rzx_file->isPlaying() || rzx_file->currentFrame() >= rzx_seek_frame)
+		{
+			rzx_seeking = no;
+			if (rzx_first_pass)
+			{
+				rzx_first_pass = no;
+				rzx_start_seek(0);
+			}
+		}
+	}
+	while (rzx_seeking && !is_suspended && ::now() < end);
+
+	clearSamples(audio_out_buffer, uint(dsp_samples_per_buffer + DSP_SAMPLES_STITCHING));
+}
+
 void Machine::rzxStoreSnapshot()
 {
 	// store snapshot at current position
@@ -1468,7 +1889,7 @@ void Machine::rzxStoreSnapshot()
 	try
 	{
 		cstr snafilepath = catstr("/tmp/zxsp/", tostr(now()), ".z80");
-		saveAs(snafilepath);
+		saveAsInBackground(snafilepath);
 		rzx_file->storeSnapshot(snafilepath);
 		cpu->setInstrCount(0);
 		rzx_file->startBlock(cpu->cpuCycle());
@@ -1492,8 +1913,12 @@ void Machine::rzxOutOfSync(cstr msg, bool red)
 
 void Machine::rzxDispose()
 {
+	syncSnapshots(); // the RzxFile removes its snapshot files
 	delete rzx_file;
-	rzx_file = nullptr;
+	rzx_file	   = nullptr;
+	rzx_seeking	   = no;
+	rzx_first_pass = no;
+	rzx_seek_request.store(-1);
 }
 
 void Machine::rzxStopPlaying(cstr msg, bool yellow)
@@ -1540,8 +1965,14 @@ void Machine::rzxPlayFile(RzxFile* rzx, bool auto_start_recording)
 			int32& cc  = cpu->cpuCycleRef();
 			int32  dcc = rzx->getStartCC() - cc;
 			tcc0 -= dcc / cpu_clock;
+			update_step_timebase();
 			cc += dcc;
 		}
+		if (itemsCanSaveState()) // first pass: store the keyframes
+		{
+			rzx_first_pass = yes;
+			rzx_start_seek(rzx->frameCount());
+		}
 		return;
 	}
 }
@@ -1563,7 +1994,11 @@ void Machine::rzxStartRecording(cstr msg, bool yellow)
 	{
 	default: return rzxOutOfSync(usingstr("Start RZX recording: unexpected file state %i", rzx_file->state), yes);
 
-	case RzxFile::Playing: rzx_file->startRecording(); break;
+	case RzxFile::Playing:
+		rzx_seeking	   = no;
+		rzx_first_pass = no;
+		rzx_file->startRecording();
+		break;
 
 	case RzxFile::Recording: return;
 
@@ -1588,69 +2023,160 @@ void Machine::rzxStopRecording(cstr msg, bool yellow)
 }
 
 
-void Machine::allKeysAndButtonsUp()
+/*	Input events:
+
+	The GUI thread pushes events with the real time when they happened.
+	runForSound() maps the real time interval of the previous call onto the time slice of the current call
+	and applies the events at the corresponding cpu cycle.
+	So the input is delayed by one audio buffer but the spacing of the events is preserved,
+	e.g. a short key press is not lost or stretched to a whole buffer.
+	Events which are newer than the previous call wait for the next call.
+	runCpuCycles() and the debugger apply all pending events immediately.
+*/
+
+void Machine::push_input_event(InputEvent& e) volatile
 {
-	if (keyboard) keyboard->allKeysUp();
-	mouse_buttons = 0;
-	memset(joystick_buttons, 0, sizeof(joystick_buttons));
+	e.time = ::now();
+	if (!input_queue.push(e)) logline("Machine: input queue full: event dropped");
 }
 
-void Machine::keyDown(uint16 unicode, uint8 oskeycode, KeyboardModifiers modifiers)
+void Machine::keyDown(uint16 unicode, uint8 oskeycode, KeyboardModifiers modifiers) volatile
 {
-	assert(keyboard);
-	keyboard->realKeyDown(unicode, oskeycode, modifiers);
+	InputEvent e {};
+	e.type		= InputEvent::KeyDown;
+	e.unicode	= unicode;
+	e.oskeycode = oskeycode;
+	e.modifiers = uint8(modifiers);
+	push_input_event(e);
 }
 
-void Machine::keyUp(uint16 unicode, uint8 oskeycode, KeyboardModifiers modifiers)
+void Machine::keyUp(uint16 unicode, uint8 oskeycode, KeyboardModifiers modifiers) volatile
 {
-	assert(keyboard);
-	keyboard->realKeyUp(unicode, oskeycode, modifiers);
+	InputEvent e {};
+	e.type		= InputEvent::KeyUp;
+	e.unicode	= unicode;
+	e.oskeycode = oskeycode;
+	e.modifiers = uint8(modifiers);
+	push_input_event(e);
 }
 
-void Machine::outputSamples(const StereoSample& sample, Time aa /*start [seconds]*/, Time ee /*end [seconds]*/)
+void Machine::allKeysAndButtonsUp() volatile
 {
-	// Output sample value to audio_out_buffer[]:
+	InputEvent e {};
+	e.type = InputEvent::AllUp;
+	push_input_event(e);
+}
 
-	aa *= samples_per_second; // sample-based
-	ee *= samples_per_second; // ""
+void Machine::updateJoystickButtons(JoystickID id, uint8 btns) volatile
+{
+	InputEvent e {};
+	e.type	   = InputEvent::Joystick;
+	e.joystick = uint8(id);
+	e.and_mask = 0;
+	e.or_mask  = btns;
+	push_input_event(e);
+}
 
-	int32 a = int32(aa);
-	int32 e = int32(ee);
+void Machine::joystickButtonsDown(JoystickID id, uint8 mask) volatile
+{
+	InputEvent e {};
+	e.type	   = InputEvent::Joystick;
+	e.joystick = uint8(id);
+	e.and_mask = 0xff;
+	e.or_mask  = mask;
+	push_input_event(e);
+}
 
-	assert(a >= 0);
-	assert(e >= a);
-	assert(e < DSP_SAMPLES_PER_BUFFER + DSP_SAMPLES_STITCHING);
+void Machine::joystickButtonsUp(JoystickID id, uint8 mask) volatile
+{
+	InputEvent e {};
+	e.type	   = InputEvent::Joystick;
+	e.joystick = uint8(id);
+	e.and_mask = uint8(~mask);
+	e.or_mask  = 0;
+	push_input_event(e);
+}
 
-	StereoSample* pa = audio_out_buffer + a;
-	*pa -= sample * Sample(aa - floor(aa));
+void Machine::updateMouseButtons(MouseButtons btns) volatile
+{
+	InputEvent e {};
+	e.type	  = InputEvent::MouseButtons;
+	e.or_mask = uint8(btns);
+	push_input_event(e);
+}
 
-	StereoSample* pe = audio_out_buffer + e;
-	*pe += sample * Sample(ee - floor(ee));
+void Machine::mouseMoved(zxsp::Dist d) volatile
+{
+	InputEvent e {};
+	e.type = InputEvent::MouseMove;
+	e.dx   = int16(minmax(-0x8000, d.dx, 0x7fff));
+	e.dy   = int16(minmax(-0x8000, d.dy, 0x7fff));
+	push_input_event(e);
+}
 
-	while (pa < pe) { *pa++ += sample; }
+void Machine::apply_input_event(const InputEvent& e)
+{
+	switch (e.type)
+	{
+	case InputEvent::KeyDown:
+		if (keyboard) keyboard->realKeyDown(e.unicode, e.oskeycode, KeyboardModifiers(e.modifiers));
+		break;
+	case InputEvent::KeyUp:
+		if (keyboard) keyboard->realKeyUp(e.unicode, e.oskeycode, KeyboardModifiers(e.modifiers));
+		break;
+	case InputEvent::AllUp:
+		if (keyboard) keyboard->allKeysUp();
+		mouse_buttons = 0;
+		memset(joystick_buttons, 0, sizeof(joystick_buttons));
+		break;
+	case InputEvent::Joystick:
+		assert(e.joystick < NELEM(joystick_buttons));
+		joystick_buttons[e.joystick] = (joystick_buttons[e.joystick] & e.and_mask) | e.or_mask;
+		break;
+	case InputEvent::MouseMove: //
+		mouse_position += zxsp::Dist(e.dx, e.dy);
+		break;
+	case InputEvent::MouseButtons: //
+		mouse_buttons = e.or_mask;
+		break;
+	}
 }
 
-void Machine::outputSamples(Sample sample, Time aa /*start [seconds]*/, Time ee /*end [seconds]*/)
+int32 Machine::next_input_cc()
 {
-	// Output sample value to audio_out_buffer[]:
+	// get cpu cycle of the next pending event in the current time slice
+	// returns 1<<30 if there is none
 
-	aa *= samples_per_second; // sample-based
-	ee *= samples_per_second; // ""
+	const InputEvent* e = input_queue.front();
+	if (!e || e->time >= input_t1) return 1 << 30;
 
-	int32 a = int32(aa);
-	int32 e = int32(ee);
+	Time t = input_t1 > input_t0 ? (e->time - input_t0) / (input_t1 - input_t0) * seconds_per_dsp_buffer() : 0.0;
+	return cc_up_for_t(max(t, 0.0));
+}
 
-	assert(a >= 0);
-	assert(e >= a);
-	assert(e < DSP_SAMPLES_PER_BUFFER + DSP_SAMPLES_STITCHING);
+void Machine::apply_input_events(int32 cc)
+{
+	// apply all pending events up to cpu cycle cc
 
-	StereoSample* pa = audio_out_buffer + a;
-	*pa -= sample * Sample(aa - floor(aa));
+	while (next_input_cc() <= cc)
+	{
+		apply_input_event(*input_queue.front());
+		input_queue.pop();
+	}
+}
+
+void Machine::applyPendingInputEvents()
+{
+	// apply all pending events immediately
+	// used by the debugger and if the machine is suspended or powered off
 
-	StereoSample* pe = audio_out_buffer + e;
-	*pe += sample * Sample(ee - floor(ee));
+	assert(is_locked() || isSuspended());
 
-	while (pa < pe) { *pa++ += sample; }
+	while (const InputEvent* e = input_queue.front())
+	{
+		apply_input_event(*e);
+		input_queue.pop();
+	}
 }
 
 void Machine::showMessage(MessageStyle ms, cstr text)
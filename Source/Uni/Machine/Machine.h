@@ -5,30 +5,42 @@
 
 #include "Fdc/DivIDE.h"
 #include "Files/RzxFile.h"
+#include "InputQueue.h"
 #include "Interfaces/IMachineController.h"
 #include "Joy/ZxIf2.h"
+#include "MachineState.h"
+#include "MemMappedHandlers.h"
 #include "Memory.h"
 #include "Multiface/Multiface1.h"
 #include "Ram/ExternalRam.h"
+#include "SeqLock.h"
 #include "SpectraVideo.h"
+#include "StateBuffer.h"
+#include "StepBuffer.h"
 #include "StereoSample.h"
+#include "SampleKernels.h"
 #include "Templates/NVPtr.h"
 #include "Templates/RCPtr.h"
 #include "Ula/Ula.h"
 #include "Ula/UlaZx80.h"
 #include "Z80/Z80.h"
 #include "zxsp_globals.h"
+#include <atomic>
 #include <math.h>
 
 
-inline double samples_per_dsp_buffer() { return DSP_SAMPLES_PER_BUFFER; }
-inline Time	  seconds_per_dsp_buffer() { return DSP_SAMPLES_PER_BUFFER / samples_per_second; }
+inline double samples_per_dsp_buffer() { return dsp_samples_per_buffer; }
+inline Time	  seconds_per_dsp_buffer() { return dsp_samples_per_buffer / samples_per_second; }
 inline Time	  seconds_per_dsp_buffer_max()
 {
-	return (DSP_SAMPLES_PER_BUFFER + DSP_SAMPLES_STITCHING - 0.01) / samples_per_second;
+	return (dsp_samples_per_buffer + DSP_SAMPLES_STITCHING - 0.01) / samples_per_second;
 }
 
 
+class SnapshotWriter;
+class Z80Snapshot;
+
+
 class Items : private Array<RCPtr<Item>>
 {
 public:
@@ -102,6 +114,18 @@ private:
 	class RzxFile* rzx_file;					  // Rzx Replay and Recording
 	void		   rzxLoadSnapshot(int32& cc_final, int32& ic_end);
 	void		   rzxStoreSnapshot();
+	void		   rzxLoadKeyframe(const RzxFile::Keyframe&);
+	void		   rzxStoreKeyframe(uint32 frame);
+
+	// seeking in the rzx file: see rzx_seek()
+	bool			   rzx_seeking	  = no;	  // replaying unpaced up to rzx_seek_frame
+	bool			   rzx_first_pass = no;	  // seeking to the end to store keyframes, then back to frame 0
+	uint32			   rzx_seek_frame = 0;	  // stop at the start of this frame
+	std::atomic<int32> rzx_seek_request {-1}; // set by the GUI thread: next seek target or -1
+	void			   rzx_start_seek(uint32 frame);
+	void			   rzx_seek(const StereoBuffer audio_in_buffer, StereoBuffer audio_out_buffer);
+
+	SnapshotWriter* snapshot_writer = nullptr; // saveAsInBackground(): created on first use
 
 public:
 	// all memory in the machine:
@@ -113,6 +137,14 @@ public:
 	void memoryRemoved(Memory*);
 	void memoryModified(Memory*, uint how = 2); // 0=added, 1=removed, 2=modified
 
+	// instruction trace:
+	void startTrace(cstr path, uint32 buffer_size) noexcept(false); // FileError, AnyError
+	void stopTrace();
+	bool isTracing() const volatile { return cpu_options & cpu_trace; }
+
+private:
+	void set_trace_flags(Memory*, bool);
+
 
 public:
 	// All components:
@@ -131,6 +163,9 @@ public:
 	Crtc*		  crtc; // mostly same as ula. not update by addItem()/removeItem()!
 	Item*		  last_item() const { return all_items.count() ? all_items.last().get() : nullptr; }
 
+private:
+	MemMappedHandlers memmapped_handlers; // see Item::claimMemory()
+
 public:
 	Item*		  addItem(Item*);
 	Item*		  addExternalItem(isa_id);
@@ -182,25 +217,46 @@ public:
 	uint  beam_cnt; // for drawVideoBeamIndicator()
 	int32 beam_cc;	// ""
 
-	StereoSample*		audio_out_buffer = nullptr; //[DSP_SAMPLES_PER_BUFFER + DSP_SAMPLES_STITCHING] = {0};
-	const StereoSample* audio_in_buffer	 = nullptr; //[DSP_SAMPLES_PER_BUFFER + DSP_SAMPLES_STITCHING]  = {0};
+	StereoSample*		audio_out_buffer = nullptr; //[dsp_samples_per_buffer + DSP_SAMPLES_STITCHING] = {0};
+	const StereoSample* audio_in_buffer	 = nullptr; //[dsp_samples_per_buffer + DSP_SAMPLES_STITCHING]  = {0};
+
+	// when several machines share the audio device, each one runs into it's own buffer
+	// which is then mixed into the device's buffer. see MachineList.runMachinesForSound().
+	StereoBuffer own_audio_out_buffer; // keeps this machine's stitching
+	Sample		 audio_gain = 1.0f;	   // gain when mixed into the device's buffer
+
+	StepBuffer step_buffer; // band-limited steps from beeper, ay and sp0256: integrated in audioBufferEnd()
+	int64	   step_tcc0;	// tcc0 in samples, 32.32 fixed point
+	int64	   step_per_cc; // samples per cpu cycle, 32.32 fixed point
 
 public:
 	//bool isAudioInputDeviceEnabled() const volatile noexcept { return audio_input_device_enabled; }
 	//bool isAudioOutputDeviceEnabled() const volatile noexcept { return audio_output_device_enabled; }
 	//Sample getOutputVolume() const volatile noexcept { return audio_output_volume; }
 
-	void outputSamples(const StereoSample&, Time start, Time end);
-	void outputSamples(Sample, Time start, Time end);
-
-	void shiftBuffer(StereoSample* bu)
+	// post amplitude change to step_buffer:
+	void outputStep(int32 cc, Sample delta) { step_buffer.addDelta(step_tcc0 + cc * step_per_cc, delta); }
+	void outputStep(int32 cc, const StereoSample& delta) { step_buffer.addDelta(step_tcc0 + cc * step_per_cc, delta); }
+	void outputStep(Time t, Sample delta)
+	{
+		step_buffer.addDelta(int64(t * samples_per_second * StepBuffer::one), delta);
+	}
+	void outputStep(Time t, const StereoSample& delta)
 	{
-		for (int i = 0; i < DSP_SAMPLES_STITCHING; i++) bu[i] = bu[DSP_SAMPLES_PER_BUFFER + i];
+		step_buffer.addDelta(int64(t * samples_per_second * StepBuffer::one), delta);
 	}
+	void update_step_timebase() // after any change to tcc0 or cpu_clock
+	{
+		step_tcc0	= int64(tcc0 * samples_per_second * StepBuffer::one);
+		step_per_cc = int64(samples_per_second / cpu_clock * StepBuffer::one);
+	}
+
+	void shiftBuffer(StereoSample* bu) { copySamples(bu, bu + dsp_samples_per_buffer, DSP_SAMPLES_STITCHING); }
 	void clearBuffer(StereoSample* bu) // preserves stitching at buffer start
 	{
-		for (int i = DSP_SAMPLES_STITCHING; i < DSP_SAMPLES_PER_BUFFER + DSP_SAMPLES_STITCHING; i++) bu[i] = 0.0;
+		clearSamples(bu + DSP_SAMPLES_STITCHING, uint(dsp_samples_per_buffer));
 	}
+	void setAudioGain(Sample gain) volatile { audio_gain = max(gain, 0.0f); }
 
 protected:
 	Time   t_for_cc(int32 cc) { return tcc0 + cc / cpu_clock; }
@@ -236,6 +292,11 @@ public:
 	void rzxOutOfSync(cstr msg, bool alert = no);
 	void rzxSetAutoStartRecording(bool f) volatile { rzx_auto_start_recording = f; }
 
+	// seek without locking the machine: the emulation thread replays, a new seek cancels the previous one:
+	void   rzxSeekFrame(uint32 frame) volatile { rzx_seek_request.store(int32(frame)); }
+	uint32 rzxFrameCount() const { return rzx_file ? rzx_file->frameCount() : 0; }
+	uint32 rzxCurrentFrame() const { return rzx_file ? rzx_file->currentFrame() : 0; }
+
 	// in Files/*.cpp:
 	virtual void loadAce(FD& fd);			// MachineJupiter.cpp
 	virtual void saveAce(FD& fd);			// MachineJupiter.cpp
@@ -249,10 +310,11 @@ public:
 	virtual void saveP81(FD& fd, bool p81); // MachineZx81.cpp
 	// virtual void loadTap(FD& fd);		// MachineZxsp.cpp
 
-	void loadSZX(FD&);	  // file_szx.cpp
-	void saveSZX(FD&);	  // file_szx.cpp
-	void loadZ80(FD& fd); // file_z80.cpp
-	void saveZ80(FD& fd); // file_z80.cpp
+	void loadSZX(FD&);			  // file_szx.cpp
+	void saveSZX(FD&);			  // file_szx.cpp
+	void loadZ80(FD& fd);		  // file_z80.cpp
+	void saveZ80(FD& fd);		  // file_z80.cpp
+	void freezeZ80(Z80Snapshot&); // file_z80.cpp
 	void loadRom(FD& fd);
 	void saveRom(FD& fd);
 
@@ -277,6 +339,9 @@ public:
 	~Machine() override;
 
 	void saveAs(cstr filepath);
+	void saveAsInBackground(cstr filepath); // .z80 only
+	void syncSnapshots();					// wait for saveAsInBackground()
+	void detachSnapshots();					// copy the memory for saveAsInBackground()
 
 	// Time & Utilities:
 	int32 current_cc() { return cpu->cpuCycle(); }
@@ -325,18 +390,37 @@ public:
 	void set50Hz() { set60Hz(0); } // 100%, ~50fps, stored in prefs
 	void set60Hz(bool = 1);		   // 100%, ~60fps, stored in prefs
 
+	// run-ahead: display the frame which is N frames ahead to hide the input latency of the emulated machine:
+	static constexpr uint max_run_ahead_frames = 4;
+	void setRunAheadFrames(uint n) volatile { run_ahead_frames = min(n, max_run_ahead_frames); }
+	uint getRunAheadFrames() const volatile { return run_ahead_frames; }
+
+	// in-memory state for run-ahead and rzx keyframes:
+	bool canSaveState() const;
+	bool itemsCanSaveState() const;
+	void saveState(StateBuffer&) const;
+	void restoreState(StateBuffer&);
+
+	// state for the inspectors: the GUI thread reads it without locking the machine:
+	void   publishState(); // emulation thread
+	uint32 getPublishedState(MachineState& z) const volatile { return published_state.read(z); }
+
 	//Handle Input Devices:
 	uint8		joystick_buttons[MAX_USB_JOYSTICKS + 2] = {0}; // state of real-world joysticks
 	uint8		kbd_joystick_active						= 0;   // set to ff whenever read
 	uint8		mouse_buttons							= 0;
 	zxsp::Point mouse_position							= {0, 0};
 
-	void keyDown(uint16 unicode, uint8 oskeycode, KeyboardModifiers);
-	void keyUp(uint16 unicode, uint8 oskeycode, KeyboardModifiers);
-	void allKeysAndButtonsUp();
-	void updateJoystickButtons(JoystickID id, JoystickButtons btns) volatile { joystick_buttons[id] = btns; }
-	void updateMouseButtons(MouseButtons btns) volatile { mouse_buttons = btns; }
-	void mouseMoved(zxsp::Dist d) volatile { NV(mouse_position) += d; }
+	// GUI thread: events are queued and applied in runForSound() at the matching cpu cycle:
+	void keyDown(uint16 unicode, uint8 oskeycode, KeyboardModifiers) volatile;
+	void keyUp(uint16 unicode, uint8 oskeycode, KeyboardModifiers) volatile;
+	void allKeysAndButtonsUp() volatile;
+	void updateJoystickButtons(JoystickID, uint8 btns) volatile;
+	void joystickButtonsDown(JoystickID, uint8 mask) volatile;
+	void joystickButtonsUp(JoystickID, uint8 mask) volatile;
+	void updateMouseButtons(MouseButtons) volatile;
+	void mouseMoved(zxsp::Dist) volatile;
+	void applyPendingInputEvents(); // while not running
 
 	Keymap getKeymap() const volatile;
 	uint8  getJoystickButtons(JoystickID id) // FUDLR
@@ -348,6 +432,26 @@ public:
 	uint8		peekJoystickButtons(JoystickID id) const volatile { return joystick_buttons[id]; } // FUDLR
 	uint8		getMouseButtons() const volatile { return mouse_buttons; }
 	zxsp::Point getMousePosition() const volatile { return NV(mouse_position); }
+
+private:
+	SeqLock<MachineState> published_state; // see publishState()
+
+	InputQueue input_queue;
+	Time	   input_t0 = 0.0; // real time of the previous time slice: mapped to the current time slice
+	Time	   input_t1 = 0.0; // ""
+
+	void  push_input_event(InputEvent&) volatile;
+	void  apply_input_event(const InputEvent&);
+	void  apply_input_events(int32 cc);
+	int32 next_input_cc();
+
+	uint		run_ahead_frames = 0;
+	StateBuffer run_ahead_state;
+
+	void  run_for_sound(const StereoBuffer audio_in_buffer, StereoBuffer audio_out_buffer, int32 cc_final);
+	int	  run_cpu(int32 cc_end, int32 cc_ffb, uint32 options);
+	int32 hidden_frame_flyback(int32 cc);
+	void  run_ahead(int32 cc_ffb);
 };
 
 
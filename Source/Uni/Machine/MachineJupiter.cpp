@@ -4,7 +4,6 @@
 
 #include "MachineJupiter.h"
 #include "Keyboard.h"
-#include "Settings.h"
 #include "TapData.h"
 #include "TapeRecorder.h"
 #include "Ula/MmuJupiter.h"
@@ -0,0 +1,47 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "Z80/Z80.h"
+#include "kio/kio.h"
+#include "zxsp_types.h"
+
+
+/*	State of a Machine as seen by the inspectors
+
+	Published by the emulation thread with Machine.publishState() at each frame end,
+	at the end of runForSound() and for a suspended machine on each audio buffer.
+	Inspectors read it with Machine.getPublishedState() and never lock the Machine
+	in their updateWidgets(): this would make runMachinesForSound() skip the machine.
+
+	The data is copied: strings are truncated to fit.
+*/
+struct MachineState
+{
+	// machine:
+	Frequency cpu_clock;
+	int32	  total_frames;
+	bool	  suspended;
+
+	// cpu:
+	Z80Regs regs;
+	int32	cc;
+	bool	nmi_pending;
+	bool	int_pending;
+
+	// tape recorder:
+	struct
+	{
+		bool  present; // machine has a tape recorder
+		bool  loaded;
+		bool  pause_down;
+		uint8 state; // TapeRecorder::TRState
+		bool  recording;
+		Time  position;
+		Time  playtime;
+		Time  block_position; // position in the current block: the inspector shows it while recording
+		char  major_info[64]; // "" if n.avail.
+		char  minor_info[64]; // "" if n.avail. or recording
+	} tape;
+};
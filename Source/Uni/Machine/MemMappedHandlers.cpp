@@ -0,0 +1,78 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "MemMappedHandlers.h"
+#include "Items/Item.h"
+
+
+MemMappedHandlers::MemMappedHandlers() noexcept
+{
+	memset(patch_handler, 0, sizeof(patch_handler));
+	memset(read_handler, 0, sizeof(read_handler));
+	memset(write_handler, 0, sizeof(write_handler));
+}
+
+void MemMappedHandlers::claim(Item* item, CoreByte kinds, uint16 a, uint16 e)
+{
+	// claim addresses a … e (inclusive) for handleRomPatch(), readMemory() and/or writeMemory()
+
+	assert(item);
+	assert(a <= e);
+	assert((kinds & ~(cpu_patch | cpu_memmapped_rw)) == 0);
+
+	claims.append(Claim {item, kinds, a, e});
+	rebuild();
+}
+
+void MemMappedHandlers::release(Item* item)
+{
+	// remove all claims of this item
+
+	bool removed = no;
+	for (uint i = claims.count(); i--;)
+	{
+		if (claims[i].item != item) continue;
+		claims.remove(i);
+		removed = yes;
+	}
+	if (removed) rebuild();
+}
+
+static void set_handler(Item** handler, bool* multiple, uint pg, Item* item)
+{
+	if (handler[pg] && handler[pg] != item) multiple[pg] = yes;
+	handler[pg] = item;
+}
+
+void MemMappedHandlers::rebuild()
+{
+	// set the handler of all pages with exactly one claimant
+	// pages with more than one claimant get no handler: the Machine walks the daisy chain
+
+	bool multiple_patch[num_pages] = {};
+	bool multiple_read[num_pages]  = {};
+	bool multiple_write[num_pages] = {};
+
+	memset(patch_handler, 0, sizeof(patch_handler));
+	memset(read_handler, 0, sizeof(read_handler));
+	memset(write_handler, 0, sizeof(write_handler));
+
+	for (uint i = 0; i < claims.count(); i++)
+	{
+		const Claim& c = claims[i];
+		for (uint pg = c.a >> CPU_PAGEBITS; pg <= uint(c.e >> CPU_PAGEBITS); pg++)
+		{
+			if (c.kinds & cpu_patch) set_handler(patch_handler, multiple_patch, pg, c.item);
+			if (c.kinds & cpu_memmapped_r) set_handler(read_handler, multiple_read, pg, c.item);
+			if (c.kinds & cpu_memmapped_w) set_handler(write_handler, multiple_write, pg, c.item);
+		}
+	}
+
+	for (uint pg = 0; pg < num_pages; pg++)
+	{
+		if (multiple_patch[pg]) patch_handler[pg] = nullptr;
+		if (multiple_read[pg]) read_handler[pg] = nullptr;
+		if (multiple_write[pg]) write_handler[pg] = nullptr;
+	}
+}
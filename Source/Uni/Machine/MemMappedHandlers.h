@@ -0,0 +1,59 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "Templates/Array.h"
+#include "Z80/Z80options.h"
+#include "kio/kio.h"
+#include "zxsp_types.h"
+
+class Item;
+
+
+/*	Registry of the items which handle memory mapped i/o and rom patches
+
+	Items which override handleRomPatch(), readMemory() or writeMemory() claim the cpu address ranges
+	where they set cpu_patch, cpu_memmapped_r or cpu_memmapped_w bits. If exactly one item claimed
+	a cpu page, the Machine calls this item directly instead of starting at the last item of the daisy chain.
+	The item still forwards to prev() as before for addresses it doesn't handle.
+
+	Pages with no claimant or with more than one claimant have no handler: then the Machine starts at
+	the last item of the daisy chain as before. So an item which sets the bits without a claim still works.
+
+	Claims are static: an item claims all addresses where it may ever set the bits
+	and still checks the address and its own state in the handler.
+	Claims are made in the constructor and released in ~Item().
+	Modifications must only be done while the machine is locked.
+*/
+class MemMappedHandlers
+{
+	static constexpr uint num_pages = 0x10000 >> CPU_PAGEBITS;
+
+	struct Claim
+	{
+		Item*	 item;
+		CoreByte kinds; // cpu_patch | cpu_memmapped_r | cpu_memmapped_w
+		uint16	 a, e;	// first and last address
+	};
+
+	Array<Claim> claims;
+
+	Item* patch_handler[num_pages];
+	Item* read_handler[num_pages];
+	Item* write_handler[num_pages];
+
+	void rebuild();
+
+public:
+	MemMappedHandlers() noexcept;
+	NO_COPY_MOVE(MemMappedHandlers);
+
+	void claim(Item*, CoreByte kinds, uint16 a, uint16 e);
+	void release(Item*);
+
+	// the only claimant or nullptr:
+	Item* patchHandler(uint16 addr) const { return patch_handler[addr >> CPU_PAGEBITS]; }
+	Item* readHandler(uint16 addr) const { return read_handler[addr >> CPU_PAGEBITS]; }
+	Item* writeHandler(uint16 addr) const { return write_handler[addr >> CPU_PAGEBITS]; }
+};
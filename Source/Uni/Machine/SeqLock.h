@@ -0,0 +1,65 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "kio/kio.h"
+#include <atomic>
+#include <sched.h>
+#include <type_traits>
+
+
+/*	Sequence lock: publish a struct from one writer thread to any number of reader threads
+
+	The writer never waits. Readers never block the writer: they copy the data and retry if the
+	sequence number changed meanwhile. An odd sequence number means a write is in progress.
+
+	Normally there is only one writer: the thread which runs the Machine.
+	A second writer, e.g. the debugger stepping a suspended machine, does not wait either:
+	if it finds a write in progress then it skips it's update. The other writer publishes the same state.
+
+	T must be trivially copyable: readers may copy a half-written T, which is discarded.
+*/
+template<typename T>
+class SeqLock
+{
+	static_assert(std::is_trivially_copyable<T>::value, "SeqLock<T>: T must be trivially copyable");
+
+	std::atomic<uint32> seq {0};
+	T					data;
+
+public:
+	SeqLock() { memset(&data, 0, sizeof(T)); }
+	NO_COPY_MOVE(SeqLock);
+
+	// writer:
+	// modify the data in place between beginWrite() and endWrite().
+	// beginWrite() returns nullptr if another write is in progress: then don't call endWrite().
+	T* beginWrite()
+	{
+		uint32 s = seq.load(std::memory_order_relaxed);
+		if (s & 1 || !seq.compare_exchange_strong(s, s + 1, std::memory_order_relaxed)) return nullptr;
+		std::atomic_thread_fence(std::memory_order_release);
+		return &data;
+	}
+	void endWrite() { seq.fetch_add(1, std::memory_order_release); }
+
+	// reader:
+	// copy the latest data and return the number of writes so far.
+	// the caller can compare the result with it's last value to skip unchanged data.
+	uint32 read(T& z) const volatile
+	{
+		for (;;)
+		{
+			uint32 s = seq.load(std::memory_order_acquire);
+			if (s & 1)
+			{
+				sched_yield();
+				continue;
+			}
+			memcpy(&z, const_cast<const T*>(&data), sizeof(T));
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (seq.load(std::memory_order_relaxed) == s) return s / 2;
+		}
+	}
+};
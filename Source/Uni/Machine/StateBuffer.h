@@ -0,0 +1,62 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "Templates/Array.h"
+#include "kio/kio.h"
+
+
+/*	In-memory state of a running machine
+
+	Used for run-ahead: the state is saved at the start of a frame and restored after running ahead.
+	Items append their state in the order of Machine.all_items and read it back in the same order.
+	The buffer keeps its size when cleared: after the first use saving the state does not allocate memory.
+	There is no file format and no versioning: the data is only valid for the same machine with the same items.
+*/
+class StateBuffer
+{
+	Array<uint8> data;
+	uint32		 wpos = 0; // end of written data
+	uint32		 rpos = 0; // next byte to read
+
+public:
+	StateBuffer() = default;
+	NO_COPY_MOVE(StateBuffer);
+
+	void   clear() { wpos = rpos = 0; }
+	void   rewind() { rpos = 0; }
+	uint32 size() const { return wpos; }
+
+	uint8* writePtr(uint32 n)
+	{
+		if (wpos + n > data.count()) data.grow(max(wpos + n, 2 * data.count()));
+		uint8* p = data.getData() + wpos;
+		wpos += n;
+		return p;
+	}
+
+	void write(const void* q, uint32 n) { memcpy(writePtr(n), q, n); }
+
+	const uint8* readPtr(uint32 n)
+	{
+		assert(rpos + n <= wpos);
+		const uint8* p = data.getData() + rpos;
+		rpos += n;
+		return p;
+	}
+
+	void read(void* z, uint32 n) { memcpy(z, readPtr(n), n); }
+
+	template<typename T>
+	void put(const T& n)
+	{
+		write(&n, sizeof(T));
+	}
+
+	template<typename T>
+	void get(T& n)
+	{
+		read(&n, sizeof(T));
+	}
+};
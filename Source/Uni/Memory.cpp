@@ -29,7 +29,8 @@
 Memory::Memory(Machine* machine, cstr name, uint size) noexcept :
 	data(min(size, MAXSIZE)),
 	name(newcopy(name)),
-	machine(machine)
+	machine(machine),
+	is_rom(no)
 {
 	assert(isMainThread());
 	assert(machine != nullptr);
@@ -45,6 +46,7 @@ Memory::~Memory()
 	assert(isMainThread());
 	assert(machine->is_locked());
 
+	machine->detachSnapshots(); // queued snapshots may refer to this memory
 	if (machine->cpu) machine->cpu->unmapMemory(data.getData(), data.count());
 	machine->memoryRemoved(this);
 	delete[] name;
@@ -62,6 +64,7 @@ void Memory::shrink(uint new_cnt) noexcept // shrinks only
 
 	if (new_cnt >= data.count()) return;
 
+	machine->detachSnapshots(); // queued snapshots may refer to this memory
 	if (machine->cpu) machine->cpu->unmapMemory(data.getData(), data.count());
 	data.shrink(new_cnt);
 	machine->memoryModified(this);
@@ -80,6 +83,7 @@ void Memory::grow(uint new_cnt) noexcept
 
 	if (new_cnt <= data.count()) return;
 
+	machine->detachSnapshots(); // queued snapshots may refer to this memory
 	if (machine->cpu) machine->cpu->unmapMemory(data.getData(), data.count());
 	data.grow(new_cnt);
 	machine->memoryModified(this);
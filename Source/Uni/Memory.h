@@ -31,6 +31,7 @@ public:
 	Array<CoreByte> data;
 	cstr			name; // e.g. "internal ram"
 	Machine*		machine;
+	bool			is_rom; // not writable by the cpu: not saved for run-ahead
 
 
 public:
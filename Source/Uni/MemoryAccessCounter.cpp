@@ -0,0 +1,198 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "MemoryAccessCounter.h"
+#include "Z80/Z80options.h"
+#include "cpp/cppthreads.h"
+
+
+MemoryAccessCounter::MemoryAccessCounter(MemoryPtr m) noexcept : mem(m), serial(1)
+{
+	assert(cpu_r_access == 1 << 16);
+	assert(cpu_w_access == cpu_r_access << 1);
+	assert(cpu_x_access == cpu_r_access << 2);
+
+	pages.resize((mem.count() + page_size - 1) >> page_bits);
+	for (uint i = 0; i < pages.count(); i++) pages[i] = nullptr;
+}
+
+
+MemoryAccessCounter::~MemoryAccessCounter() { purge(); }
+
+
+void MemoryAccessCounter::setMemory(MemoryPtr m)
+{
+	// the memory was replaced or resized
+	// all counters are discarded
+
+	assert(isMainThread());
+
+	purge();
+	mem = m;
+	pages.resize((mem.count() + page_size - 1) >> page_bits);
+	for (uint i = 0; i < pages.count(); i++) pages[i] = nullptr;
+}
+
+
+void MemoryAccessCounter::purge()
+{
+	// disarm all pages
+
+	while (armed.count()) disarm_page(armed.last());
+	dirty.purge();
+}
+
+
+void MemoryAccessCounter::arm_page(uint i)
+{
+	// start tracking page i:
+	// allocate counters and set the access flags of all bytes
+
+	Page* page			= new Page;
+	page->armed_serial	= serial;
+	page->active		= false;
+	page->dirty			= false;
+	pages[i]			= page;
+	armed.append(i);
+	memset(page->counter, 0, sizeof(page->counter));
+
+	CoreByte* p = mem.getData() + (i << page_bits);
+	CoreByte* e = min(p + page_size, mem.getData() + mem.count());
+	while (p < e) *p++ |= cpu_access;
+}
+
+
+void MemoryAccessCounter::disarm_page(uint i)
+{
+	// stop tracking page i:
+	// clear the access flags of all bytes and discard the counters
+
+	assert(pages[i] != nullptr);
+
+	CoreByte* p = mem.getData() + (i << page_bits);
+	CoreByte* e = min(p + page_size, mem.getData() + mem.count());
+	while (p < e) *p++ &= ~cpu_access;
+
+	delete pages[i];
+	pages[i] = nullptr;
+
+	for (uint j = armed.count(); j--;)
+	{
+		if (armed[j] != i) continue;
+		armed[j] = armed.last();
+		armed.drop();
+		break;
+	}
+}
+
+
+void MemoryAccessCounter::arm(uint32 offset, uint32 size)
+{
+	// arm all pages in range [offset .. offset+size[
+	// pages which are already armed keep their counters
+
+	assert(isMainThread());
+
+	uint32 end = min(offset + size, mem.count());
+	for (uint32 i = offset >> page_bits; i < (end + page_size - 1) >> page_bits; i++)
+	{
+		if (pages[i]) pages[i]->armed_serial = serial;
+		else arm_page(i);
+	}
+}
+
+
+void MemoryAccessCounter::disarmUnused()
+{
+	// disarm all pages which were not armed since the last call
+
+	assert(isMainThread());
+
+	for (uint j = armed.count(); j--;)
+	{
+		uint i = armed[j];
+		if (pages[i]->armed_serial != serial) disarm_page(i);
+	}
+	serial++;
+}
+
+
+void MemoryAccessCounter::update(uint increment, uint decay)
+{
+	// collect the access flags of all armed pages:
+	// decay all counters, then add increment for each access flag cleared by the cpu
+	// counters saturate at 0 and 255
+	// pages with changed counters are added to the dirty list
+
+	assert(isMainThread());
+	assert(increment <= 255 && decay <= 255);
+
+	for (uint j = 0; j < armed.count(); j++)
+	{
+		uint	  i		  = armed[j];
+		Page*	  page	  = pages[i];
+		CoreByte* p		  = mem.getData() + (i << page_bits);
+		uint	  n		  = min(page_size, mem.count() - (i << page_bits));
+		bool	  changed = page->active && decay != 0;
+		bool	  active  = false;
+
+		for (uint k = 0; k < n; k++)
+		{
+			Counter& c = page->counter[k];
+
+			if (decay && page->active)
+			{
+				c.r = c.r > decay ? c.r - decay : 0;
+				c.w = c.w > decay ? c.w - decay : 0;
+				c.x = c.x > decay ? c.x - decay : 0;
+			}
+
+			uint bits = ~p[k] & cpu_access; // flags cleared by the cpu since last update?
+			if (bits)
+			{
+				p[k] |= cpu_access;
+				changed = true;
+				if (bits & cpu_r_access) c.r = uint8(min(255u, c.r + increment));
+				if (bits & cpu_w_access) c.w = uint8(min(255u, c.w + increment));
+				if (bits & cpu_x_access) c.x = uint8(min(255u, c.x + increment));
+			}
+
+			active |= (c.r | c.w | c.x) != 0;
+		}
+
+		page->active = active;
+		if (changed && !page->dirty)
+		{
+			page->dirty = true;
+			dirty.append(i);
+		}
+	}
+}
+
+
+bool MemoryAccessCounter::isDirty(uint32 offset) const
+{
+	Page* page = pages[offset >> page_bits];
+	return page && page->dirty;
+}
+
+
+void MemoryAccessCounter::clearDirty()
+{
+	for (uint j = 0; j < dirty.count(); j++)
+	{
+		if (Page* page = pages[dirty[j]]) page->dirty = false;
+	}
+	dirty.purge();
+}
+
+
+const MemoryAccessCounter::Counter* MemoryAccessCounter::counters(uint32 offset) const
+{
+	// get pointer to the counter for the byte at offset
+	// the following counters up to the end of the page are valid too
+
+	Page* page = pages[offset >> page_bits];
+	return page ? page->counter + (offset & (page_size - 1)) : nullptr;
+}
@@ -0,0 +1,76 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "Memory.h"
+#include "Templates/Array.h"
+#include "kio/kio.h"
+
+
+/*	Access counters for the MemoryAccessInspector
+
+	Counts reads, writes and opcode fetches of each byte in saturating counters which decay over time.
+	Counters are only allocated for pages which are armed for tracking, e.g. the pages visible in the inspector.
+
+	The cpu clears the cpu_r_access, cpu_w_access or cpu_x_access flag of a byte when it accesses it,
+	see PEEK, POKE and GET_INSTR in Z80macros.h. Only bytes in armed pages have these flags set:
+	all other bytes cost the cpu nothing.
+	update() collects the cleared flags of all armed pages, adds them to the counters and sets the flags again.
+	So a counter measures in how many updates the byte was accessed, weighted by the decay.
+
+	Pages whose counters changed are added to a list of dirty pages:
+	the inspector only repaints these pages.
+
+	must only be used on the main thread.
+*/
+class MemoryAccessCounter
+{
+public:
+	static constexpr uint page_bits = 8;
+	static constexpr uint page_size = 1 << page_bits;
+
+	struct Counter // saturating counters, 0 = not accessed
+	{
+		uint8 r, w, x, _;
+	};
+
+private:
+	struct Page
+	{
+		Counter counter[page_size];
+		uint32	armed_serial; // serial of last arm(): disarmed if not armed again
+		bool	active;		  // any counter != 0
+		bool	dirty;		  // counters changed since clearDirty()
+	};
+
+	MemoryPtr	 mem;
+	Array<Page*> pages; // one for each page of mem; nullptr if not armed
+	Array<uint>	 armed; // indexes of the armed pages
+	Array<uint>	 dirty; // indexes of the dirty pages
+	uint32		 serial;
+
+	void arm_page(uint i);
+	void disarm_page(uint i);
+
+public:
+	explicit MemoryAccessCounter(MemoryPtr) noexcept;
+	~MemoryAccessCounter();
+	NO_COPY_MOVE(MemoryAccessCounter);
+
+	void setMemory(MemoryPtr); // after memory was resized: disarms all pages
+	void purge();			   // disarm all pages
+
+	// arming: call arm() for all pages to track, then disarmUnused():
+	void arm(uint32 offset, uint32 size); // arm all pages in this range of mem
+	void disarmUnused();				  // disarm pages which were not armed since last disarmUnused()
+
+	void update(uint increment, uint decay); // collect access flags of all armed pages
+
+	const Array<uint>& dirtyPages() const { return dirty; }
+	bool			   isDirty(uint32 offset) const;
+	void			   clearDirty();
+
+	const Counter* counters(uint32 offset) const; // nullptr if page is not armed
+	uint32		   count() const { return mem.count(); }
+};
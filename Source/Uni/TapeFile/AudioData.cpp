@@ -320,7 +320,7 @@ AudioData::AudioData(const CswBuffer& q, uint32 sps) :
 	xlogIn("AudioData(CswBuffer)");
 
 	// duration of CswBuffer measured in cpu cycles:
-	uint32 total_cc = q.getTotalCc();
+	CC total_cc = q.getTotalCc();
 
 	// conversion factor cc -> samples:
 	double samples_per_cc = (double)samples_per_second / (double)q.ccPerSecond();
@@ -344,7 +344,7 @@ AudioData::AudioData(const CswBuffer& q, uint32 sps) :
 
 	double sa, se = 0; // fractional indexes in samples[]
 
-	for (uint32 cc = 0; cc < total_cc;)
+	for (CC cc = 0; cc < total_cc;)
 	{
 		cc += q.readPulse();
 
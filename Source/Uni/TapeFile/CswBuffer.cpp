@@ -5,6 +5,8 @@
 #include "CswBuffer.h"
 #include "StereoSample.h"
 #include "TapeData.h"
+#include <algorithm>
+#include <new>
 
 
 /*
@@ -59,6 +61,7 @@ void CswBuffer::purge() noexcept
 	end		  = 0;		 // used size
 	cc_end	  = 0;		 // total samples up to 'end'
 	recording = no;
+	index_cnt = 0; // the index buffer is kept
 
 	pos		  = 0; // current index in 'data'
 	cc_pos	  = 0; // total samples up to 'pos' (excl.)
@@ -115,14 +118,14 @@ CswBuffer::CswBuffer(const CswBuffer& q, uint32 ccps) :
 	const uint cc_max = uint(65535 / f); // cc_max < 65536/f - 0.5
 	for (uint32 i = 0; i < end;)
 	{
-		uint32 cc = q.data[i++];
+		CC cc = q.data[i++];
 		while (i + 1 < end && q.data[i] == 0)
 		{
 			i++;
 			cc += q.data[i++];
 			max -= 2;
 		}
-		if (cc > cc_max) max += (uint32(cc * f + 0.5)) / 0xffff * 2;
+		if (cc > cc_max) max += uint32(CC(cc * f + 0.5) / 0xffff * 2);
 	}
 
 	// allocate:
@@ -133,13 +136,13 @@ CswBuffer::CswBuffer(const CswBuffer& q, uint32 ccps) :
 	uint32 zi = 0, qi = 0;
 	while (qi < end)
 	{
-		uint32 cc = q.data[qi++];
+		CC cc = q.data[qi++];
 		while (qi + 1 < end && q.data[qi] == 0)
 		{
 			qi++;
 			cc += q.data[qi++];
 		}
-		cc = uint32(cc * f + 0.5);
+		cc = CC(cc * f + 0.5);
 		cc_end += cc;
 		while (cc > 0xffff)
 		{
@@ -197,6 +200,62 @@ void CswBuffer::grow(uint32 n)
 }
 
 
+/*  grow the index[] buffer
+	returns false if the allocation failed: then seeking falls back to scanning the pulses
+*/
+// private
+bool CswBuffer::grow_index(uint32 n) const noexcept
+{
+	if (n <= index_max) return true;
+
+	uint32 m = index_max + (index_max >> 1) + 16;
+	if (n < m) n = m;
+	CC* z = new (std::nothrow) CC[n];
+	if (!z) return false;
+	if (index_cnt) memcpy(z, index, index_cnt * sizeof(CC));
+	delete[] index;
+	index	  = z;
+	index_max = n;
+	return true;
+}
+
+/*  extend the index to cover all pulses up to 'end'
+	normally the index is extended in writePulseCc().
+	this catches up after the data[] was filled or modified otherwise.
+*/
+// private
+void CswBuffer::update_index() const noexcept
+{
+	uint32 n = (end >> index_shift) + 1; // required entries
+	if (index_cnt >= n) return;
+	if (!grow_index(n)) return;
+
+	if (index_cnt == 0) index[index_cnt++] = 0;
+
+	uint32 i  = (index_cnt - 1) << index_shift;
+	CC	   cc = index[index_cnt - 1];
+	while (index_cnt < n)
+	{
+		for (uint32 e = i + index_mask + 1; i < e; i++) cc += data[i];
+		index[index_cnt++] = cc;
+	}
+}
+
+/*  move pos to checkpoint i
+	cc_offset is not updated
+*/
+// private
+void CswBuffer::seek_checkpoint(uint32 i) const noexcept
+{
+	assert(i < index_cnt);
+
+	uint32 newpos = i << index_shift;
+	if ((newpos ^ pos) & 1) phase = !phase;
+	pos	   = newpos;
+	cc_pos = index[i];
+}
+
+
 /*  grow the data[] buffer:
 	does not shrink the buffer
 */
@@ -264,6 +323,14 @@ CC CswBuffer::seekCc(CC cc) const noexcept
 			return cc_end;
 		}
 
+		// jump to the last checkpoint ≤ cc unless the current position is between this checkpoint and cc:
+		update_index();
+		if (index_cnt)
+		{
+			uint32 i = uint32(std::upper_bound(index, index + index_cnt, cc) - index) - 1;
+			if (pos < i << index_shift || cc_pos > cc) seek_checkpoint(i);
+		}
+
 		while (cc > cc_pos) skip();
 		while (cc < cc_pos) rskip();
 	}
@@ -290,6 +357,11 @@ void CswBuffer::seekPos(uint32 newpos) const noexcept
 		return;
 	}
 
+	// jump to the checkpoint before newpos if it is nearer than the current position:
+	update_index();
+	uint32 i = newpos >> index_shift;
+	if (i < index_cnt && (pos < i << index_shift || pos > newpos)) seek_checkpoint(i);
+
 	if ((newpos ^ pos) & 1) phase = !phase;
 
 	while (newpos > pos) cc_pos += data[pos++];
@@ -304,7 +376,7 @@ void CswBuffer::seekPos(uint32 newpos) const noexcept
 // &&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&&
 
 
-bool CswBuffer::inputCc(uint32 cc) const noexcept
+bool CswBuffer::inputCc(CC cc) const noexcept
 {
 	assert(!recording);
 	assert(cc >= cc_pos + cc_offset);
@@ -330,7 +402,7 @@ bool CswBuffer::inputTime(Time s) const noexcept
 	return phase;
 }
 
-void CswBuffer::outputCc(uint32 cc, bool bit)
+void CswBuffer::outputCc(CC cc, bool bit)
 {
 	assert(recording);
 	assert(cc >= cc_pos + cc_offset);
@@ -372,6 +444,7 @@ void CswBuffer::startRecording(CC cc) noexcept
 	cc_end	  = cc_pos;
 	end		  = pos;
 	recording = yes;
+	invalidate_index(pos);
 }
 
 
@@ -384,11 +457,11 @@ void CswBuffer::startRecording(CC cc) noexcept
 	and step to next pulse.
 	Returns 0 at buffer end
 */
-uint32 CswBuffer::readPulse() const noexcept
+CC CswBuffer::readPulse() const noexcept
 {
 	if (pos >= end) return 0;
 
-	uint32 cc = data[pos];
+	CC cc = data[pos];
 	while (++pos < end && data[pos] == 0 && pos + 1 < end) { cc += data[++pos]; }
 	assert(pos <= end);
 	assert(pos <= max);
@@ -404,7 +477,7 @@ void CswBuffer::putbackPulse() const noexcept
 	assert(pos > 0);
 
 	// step back 1 pos:
-	uint32 cc = data[--pos];
+	CC cc = data[--pos];
 
 	// step back N*2 more pos if pulses separated by 0-length pulses:
 	// note: there may be a lonely 0-pulse at data[0]
@@ -416,7 +489,7 @@ void CswBuffer::putbackPulse() const noexcept
 
 /*  append pulse
  */
-void CswBuffer::writePulseCc(uint32 cc)
+void CswBuffer::writePulseCc(CC cc)
 {
 	while (cc >> 16)
 	{
@@ -429,16 +502,24 @@ void CswBuffer::writePulseCc(uint32 cc)
 	assert(pos <= end);
 	assert(pos < max);
 
-	data[pos++] = cc;
+	invalidate_index(pos);
+	data[pos++] = uint16(cc);
 
 	end	   = pos;
 	cc_end = cc_pos += cc;
 	phase  = !phase;
+
+	// append checkpoint:
+	if ((pos & index_mask) == 0)
+	{
+		if (index_cnt == 0 && grow_index(1)) index[index_cnt++] = 0;
+		if (index_cnt == pos >> index_shift && grow_index(index_cnt + 1)) index[index_cnt++] = cc_pos;
+	}
 }
 
 /*  elongate last pulse
  */
-void CswBuffer::appendToPulseCc(uint32 cc)
+void CswBuffer::appendToPulseCc(CC cc)
 {
 	if (pos == 0) phase = !phase;
 	else
@@ -454,7 +535,7 @@ void CswBuffer::appendToPulseCc(uint32 cc)
 	else elongate the last pulse.
 	Can be used as first pulse to set starting polarity of this buffer
 */
-void CswBuffer::writePulseCc(uint32 cc, bool bit)
+void CswBuffer::writePulseCc(CC cc, bool bit)
 {
 	if (bit == phase) writePulseCc(cc); // new pulse
 	else appendToPulseCc(cc);			// append
@@ -541,11 +622,11 @@ void CswBuffer::skipSilence(uint N) const noexcept
 {
 a:
 	uint32 a	= pos;	  // a = potential end of silence / start of data signal
-	uint32 cc_a = cc_pos; // cc at a
+	CC	   cc_a = cc_pos; // cc at a
 
 	for (uint n = 0; n < N; n++) // at most N short pulses
 	{
-		uint32 cc = readPulse();
+		CC cc = readPulse();
 		if (cc == 0) return;		  // end of buffer
 		if (cc >= ccps / 500) goto a; // ≥ 2ms
 	}
@@ -571,7 +652,7 @@ a:
 	for (int n = 0; n < n_max; n++) // at most n_max short pulses
 	{
 		if (pos == end) return yes;
-		uint32 cc = data[pos];
+		CC cc = data[pos];
 		while (++pos < end && data[pos] == 0 && pos + 1 < end) { cc += data[++pos]; }
 		assert(pos <= end);
 		assert(pos <= max);
@@ -628,9 +709,10 @@ void CswBuffer::splitAtCurrentPos(CswBuffer& other)
 
 	// truncate this buffer:
 
+	invalidate_index(pos);
 	if (cc_offset) // truncate split pulse
 	{
-		data[pos++] = cc_offset;
+		data[pos++] = uint16(cc_offset);
 		cc_offset	= 0;
 		phase ^= 1;
 	}
@@ -698,7 +780,8 @@ CswBuffer* CswBuffer::normalize() noexcept
 	end = z - data;
 
 	// fix pos, cc_pos and cc_offset:
-	uint32 ccpos = cc_pos;
+	index_cnt = 0;
+	CC ccpos  = cc_pos;
 	seekStart();
 	seekCc(ccpos);
 
@@ -731,29 +814,30 @@ bool CswBuffer::is_normalized() const noexcept
 	sps		  = samples/second
 	zpos	  = start offset in ss[] (fractional)
 	qpos+qoffs= start position in this CswBuffer: pulse index and cc offset inside pulse
+	phase0	  = phase of the first pulse, as returned by getPhase0()
 	return:
 	  zpos, qpos and qoffs updated:
 		zpos == count && qpos<count: there is more audio in this CswBuffer
 		zpos < count && qpos==count: the end of this CswBuffer was reached
+
+	only data[] and end are read, not the current read position:
+	this may be called on another thread while the machine reads from this CswBuffer.
 */
 void CswBuffer::addToAudioBuffer(
-	StereoSample* ss, uint count, double sps, double& zpos, uint32& qpos, double& qoffs, Sample volume)
+	Sample* ss, uint count, double sps, double& zpos, uint32& qpos, double& qoffs, bool phase0,
+	Sample volume) const noexcept
 {
 	assert(zpos >= 0 && zpos <= count);
 	assert(qpos <= end);
 
-	if (qoffs < 0.0)
-	{
-		logline("CswBuffer:addAudioToBuffer: qpos=%12g", qoffs); // -> rounding error
-		qoffs = 0.0;
-	}
+	if (qoffs < 0.0) qoffs = 0.0; // rounding error
 
 	assert(qoffs >= 0 && qoffs <= (qpos < end ? data[qpos] : 0));
 
 	if (qpos >= end) return;
 
 	const double sspcc = sps / ccps;					// sspcc = stereosample / cc
-	if ((qpos ^ pos ^ phase ^ 1) & 1) volume = -volume; // volume & phase
+	if ((qpos ^ phase0 ^ 1) & 1) volume = -volume;		// volume & phase
 
 	double ss_a = zpos;								   // current pulse start index in ss[] (fractional)
 	double ss_e = zpos + (data[qpos] - qoffs) * sspcc; // current pulse end index in ss[] (fractional)
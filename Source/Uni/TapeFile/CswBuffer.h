@@ -55,7 +55,9 @@
 
 /*  Notes:
 
-	total samples = 2^32-1  ==  20 minutes at 3.5MHz
+	total samples are counted in 64 bit: recordings are only limited by memory
+	seeking uses a checkpoint index with the sample count for every 256th pulse:
+		a seek is a binary search in the index plus a scan over at most 256 pulses
 	pre-growing with 1100000 pulses is almost always sufficient (zxsp, 64k)
 	pre-growing with 2600000 pulses is almost always sufficient (zx81, 16k)
 	or pre-grow with 10000+16*size_of_tap_file (zxsp)
@@ -91,13 +93,14 @@
 */
 
 
-using CC = uint32;
+using CC = uint64;
 
 
 class CswBuffer
 {
 	friend class TapeFileDataBlock;
 	friend class TapeRecorder;
+	friend class TapeSpeaker;
 
 	uint16* data;	// buffer
 	uint32	max;	// allocated size
@@ -112,12 +115,35 @@ class CswBuffer
 	mutable bool   phase;	  // current phase
 	mutable CC	   cc_offset; // current CC offset inside current sample
 
+	// checkpoint index for seeking:
+	// index[i] = total samples up to data[i << index_shift] (excl.)
+	// the phase at a checkpoint is derived from the current phase and pos.
+	// entries [0 .. index_cnt[ are valid. the index is extended while pulses are written
+	// and on demand for buffers which were filled otherwise.
+	static constexpr uint	index_shift = 8;
+	static constexpr uint32 index_mask	= (1 << index_shift) - 1;
+	mutable CC*				index		= nullptr;
+	mutable uint32			index_max	= 0; // allocated size
+	mutable uint32			index_cnt	= 0; // valid entries
+
 	void skip() const noexcept;
 	void rskip() const noexcept;
 	void grow(uint32);
+	bool grow_index(uint32) const noexcept;
+	void update_index() const noexcept;
+	void invalidate_index(uint32 pos) const noexcept
+	{
+		// data[pos] will be modified:
+		if (index_cnt > (pos >> index_shift) + 1) index_cnt = (pos >> index_shift) + 1;
+	}
+	void seek_checkpoint(uint32 i) const noexcept;
 
 public:
-	~CswBuffer() noexcept { delete[] data; }
+	~CswBuffer() noexcept
+	{
+		delete[] data;
+		delete[] index;
+	}
 	CswBuffer(uint32 ccps, bool phase0, int foo);
 	CswBuffer(const TapData&, uint32 ccps);	  // implemented in TapData.cpp
 	CswBuffer(const TzxData&, uint32 ccps);	  // implemented in TzxData.cpp
@@ -166,8 +192,8 @@ public:
 
 	void splitAtCurrentPos(CswBuffer&);
 	void addToAudioBuffer(
-		StereoSample*, uint count, double samples_per_second, double& zpos, uint32& qpos, double& qoffs,
-		Sample volume = 0.32f); // 0.32 ~ -10dB
+		Sample*, uint count, double samples_per_second, double& zpos, uint32& qpos, double& qoffs, bool phase0,
+		Sample volume = 0.32f) const noexcept; // 0.32 ~ -10dB
 
 	// read / write with CPU input / output:
 
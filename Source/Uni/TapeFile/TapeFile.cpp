@@ -45,6 +45,7 @@ void TapeFile::update_blk_info()
 {
 	assert(pos < this->count());
 
+	blk_serial++;
 	current_block = data[pos];
 	blk_cswbuffer = current_block->cswdata;
 	blk_cc_size	  = current_block->getTotalCc();
@@ -97,6 +98,7 @@ TapeFile::TapeFile(uint32 machine_ccps, cstr filename) :
 	modified(no),
 	mode(stopped),
 	pos(0),
+	blk_serial(0),
 	current_block(nullptr),
 	blk_cswbuffer(nullptr),
 	blk_cc_size(0),
@@ -286,6 +288,7 @@ void TapeFile::stop(int32 cc)
 
 	if (mode == recording)
 	{
+		blk_serial++;
 		blk_cc_size = current_block->getTotalCc();		   // update_blk_info();
 		if (current_block == last()) append_empty_block(); // allow ">>" to "End of file"
 	}
@@ -318,6 +321,7 @@ void TapeFile::startRecording(int32 cc)
 
 	mode	 = recording;
 	modified = yes;
+	blk_serial++;
 
 	// for auto block splitting:
 	current_phase	= current_block->cswdata->getCurrentPhase();
@@ -357,7 +361,7 @@ bool TapeFile::input(int32 machine_cc)
 	assert(blk_cswbuffer && blk_cswbuffer == current_block->cswdata);
 
 a:
-	int32 blk0_cc = machine_cc + blk_cc_offset;
+	int64 blk0_cc = machine_cc + blk_cc_offset;
 	if (blk0_cc <= blk_cc_size) return blk_cswbuffer->inputCc(blk0_cc);
 
 	// End of tape?
@@ -68,6 +68,7 @@ note:
 class TapeFile : protected Array<TapeFileDataBlock*>
 {
 	friend class TapeRecorder;
+	friend class TapeSpeaker;
 	using Array<TapeFileDataBlock*>::cnt; // make cnt and data visible
 	using Array<TapeFileDataBlock*>::data;
 
@@ -78,13 +79,14 @@ class TapeFile : protected Array<TapeFileDataBlock*>
 	enum State { stopped = 0, playing, recording };
 	State mode;
 
-	uint pos; // aktueller Block in data[]
+	uint   pos;		   // aktueller Block in data[]
+	uint32 blk_serial; // incremented when the current block or its info changes: see TapeRecorder.getBlockInfo()
 	// cached values:
 	TapeFileDataBlock* current_block; // aktueller Block; secondary pointer
 	CswBuffer*		   blk_cswbuffer; // aktueller Block; secondary pointer
-	int32			   blk_cc_size;	  // aktueller Block; block size in tapeblock_cc's
+	int64			   blk_cc_size;	  // aktueller Block; block size in tapeblock_cc's
 	Time			   blk_starttime; // aktueller Block;
-	int32			   blk_cc_offset; // aktueller Block; cc_base in tapeblock_cc's; valid during play/record
+	int64			   blk_cc_offset; // aktueller Block; cc_base in tapeblock_cc's; valid during play/record
 
 	// while recording:
 	bool  current_phase;
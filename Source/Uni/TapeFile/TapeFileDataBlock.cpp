@@ -51,6 +51,7 @@ TapeFileDataBlock::TapeFileDataBlock(CswBuffer* p) :
 {
 	assert(cswdata);
 	calc_block_infos();
+	cswdata->update_index(); // don't allocate it later while winding on the audio thread
 }
 
 
@@ -65,6 +66,7 @@ TapeFileDataBlock::TapeFileDataBlock(TapeData* q, uint32 ccps) :
 	mode(stopped)
 {
 	calc_block_infos();
+	cswdata->update_index();
 }
 
 TapeFileDataBlock::TapeFileDataBlock(TapeData* q, CswBuffer* csw) :
@@ -79,6 +81,7 @@ TapeFileDataBlock::TapeFileDataBlock(TapeData* q, CswBuffer* csw) :
 {
 	assert(cswdata);
 	calc_block_infos();
+	cswdata->update_index();
 }
 
 
@@ -154,7 +157,7 @@ a:
 }
 
 
-void TapeFileDataBlock::videoFrameEnd(uint32 cc)
+void TapeFileDataBlock::videoFrameEnd(CC cc)
 {
 	assert(cswdata);
 	assert(mode != stopped);
@@ -167,7 +170,7 @@ void TapeFileDataBlock::videoFrameEnd(uint32 cc)
 }
 
 
-void TapeFileDataBlock::startPlaying(uint32 cc)
+void TapeFileDataBlock::startPlaying(CC cc)
 {
 	assert(cswdata);
 	assert(cswdata->ccPerSecond());
@@ -182,7 +185,7 @@ void TapeFileDataBlock::startPlaying(uint32 cc)
 	• purge block
 	• start recording at cc (should be 0)
 */
-void TapeFileDataBlock::startRecording(uint32 cc)
+void TapeFileDataBlock::startRecording(CC cc)
 {
 	assert(cswdata);
 	assert(cswdata->ccPerSecond());
@@ -58,7 +58,7 @@ public:
 	bool isPlaying() { return mode == playing; }
 
 	// block info:
-	uint32 getTotalCc() const noexcept { return cswdata->getTotalCc(); }
+	CC	   getTotalCc() const noexcept { return cswdata->getTotalCc(); }
 	Time   getTotalTime() const noexcept { return cswdata->getTotalTime(); }
 	bool   isEmpty() const noexcept { return cswdata->getTotalCc() == 0; }
 	bool   isNotEmpty() const noexcept { return cswdata->getTotalCc() != 0; }
@@ -104,7 +104,7 @@ public:
 		assert(cswdata);
 		return getTimeRemaining() <= proximity;
 	}
-	uint32 getCurrentCcPos()
+	CC getCurrentCcPos()
 	{
 		assert(cswdata);
 		return cswdata->getCurrentCc();
@@ -126,7 +126,7 @@ public:
 		assert(mode == stopped);
 		cswdata->seekTime(t);
 	}
-	void seekCcPos(uint32 cc)
+	void seekCcPos(CC cc)
 	{
 		assert(cswdata);
 		assert(mode == stopped);
@@ -147,20 +147,20 @@ public:
 
 	// play & record:
 	// cswdata must be valid
-	void startPlaying(uint32 cc);
-	void startRecording(uint32 cc);
-	void stop(uint32 cc);
-	bool input(uint32 cc)
+	void startPlaying(CC cc);
+	void startRecording(CC cc);
+	void stop(CC cc);
+	bool input(CC cc)
 	{
 		assert(cswdata);
 		assert(mode == playing);
 		return cswdata->inputCc(cc);
 	}
-	void output(uint32 cc, bool b)
+	void output(CC cc, bool b)
 	{
 		assert(cswdata);
 		assert(mode == recording);
 		cswdata->outputCc(cc, b);
 	}
-	void videoFrameEnd(uint32 cc);
+	void videoFrameEnd(CC cc);
 };
@@ -0,0 +1,207 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "TapeSpeaker.h"
+#include "TapeFile.h"
+#include "TapeFileDataBlock.h"
+#include "zxsp_globals.h"
+
+
+TapeSpeaker::TapeSpeaker() noexcept(false) :
+	wp(0),
+	rp(0),
+	rp_offs(0),
+	tapefile(nullptr),
+	blk(0),
+	num_blocks(0),
+	qpos(0),
+	qoffs(0),
+	phase0(nullptr),
+	phase0_max(0),
+	stopping(false),
+	quit(false),
+	volume(0.05f)
+{
+	int e = pthread_create(&producer_thread, nullptr /*attr*/, producer_proc, this /*args*/);
+	if (e) throw AnyError(usingstr("Creating the tape speaker thread failed: %s", strerror(e)));
+}
+
+
+TapeSpeaker::~TapeSpeaker()
+{
+	{
+		std::lock_guard<std::mutex> lock(render_lock);
+		tapefile = nullptr;
+		quit	 = true;
+	}
+	wake.release();
+	pthread_join(producer_thread, nullptr);
+
+	delete[] phase0;
+}
+
+
+// ---------------------------------------------------------
+//		producer thread
+// ---------------------------------------------------------
+
+
+void* TapeSpeaker::producer_proc(void* self) { return reinterpret_cast<TapeSpeaker*>(self)->producer_proc(); }
+
+
+void* TapeSpeaker::producer_proc()
+{
+	// render segments until the ring is full, then wait for mix() to free one.
+	// the lock is released after each segment: stop() waits for at most one segment.
+	// while the emulation thread waits for the lock the producer does not take it again.
+
+	for (;;)
+	{
+		wake.request();
+		if (quit) return nullptr;
+
+		for (;;)
+		{
+			if (stopping.load(std::memory_order_acquire)) break; // start() will wake us
+			std::lock_guard<std::mutex> lock(render_lock);
+			if (!tapefile || wp.load(std::memory_order_relaxed) - rp.load(std::memory_order_acquire) == num_segments)
+				break;
+			render_segment();
+		}
+	}
+}
+
+
+void TapeSpeaker::render_segment()
+{
+	// render the next segment of the tape into the ring
+	// the caller holds the render_lock and has checked that a slot is free.
+	// behind the end of the tape the segment is silent.
+
+	Sample* z = ring[wp.load(std::memory_order_relaxed) & (num_segments - 1)];
+	memset(z, 0, sizeof(ring[0]));
+
+	double zpos = 0.0;
+	while (tapefile && blk < num_blocks)
+	{
+		const CswBuffer* bu = (*tapefile)[blk]->cswdata;
+		bu->addToAudioBuffer(z, segment_samples, ::samples_per_second, zpos, qpos, qoffs, phase0[blk], volume);
+		if (zpos == segment_samples) break;
+		blk++;
+		qpos  = 0;
+		qoffs = 0;
+	}
+
+	wp.store(wp.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+
+// ---------------------------------------------------------
+//		emulation thread
+// ---------------------------------------------------------
+
+
+void TapeSpeaker::lock_render() noexcept
+{
+	// lock the render_lock without blocking in the kernel:
+	// the producer finishes it's current segment and then keeps off until we are done.
+
+	stopping.store(true, std::memory_order_seq_cst);
+	while (!render_lock.try_lock()) {}
+	stopping.store(false, std::memory_order_relaxed);
+}
+
+
+void TapeSpeaker::reserve(uint num_blocks)
+{
+	// make room for the phases of num_blocks blocks
+	// called when a tape is inserted and when blocks were recorded, so that start() never allocates.
+	// grows by at least 2x: recording one block after another does not allocate every time.
+
+	if (num_blocks <= phase0_max) return;
+
+	uint  n = max(num_blocks, phase0_max * 2);
+	bool* p = new bool[n];
+
+	lock_render();
+	std::swap(phase0, p);
+	phase0_max = n;
+	render_lock.unlock();
+
+	delete[] p;
+}
+
+
+void TapeSpeaker::start(TapeFile* tf)
+{
+	// start playing at the current position of the TapeFile
+	// the TapeFile has just started playing: it's read positions are not yet moved by the machine.
+
+	lock_render();
+
+	num_blocks = min(tf->cnt, phase0_max); // else blocks were added but not reserve()d
+	for (uint i = 0; i < num_blocks; i++) { phase0[i] = (*tf)[i]->cswdata->getPhase0(); }
+	blk		 = tf->pos;
+	qpos	 = tf->current_block->cswdata->pos;
+	qoffs	 = tf->current_block->cswdata->cc_offset;
+	tapefile = tf;
+
+	// discard old segments:
+	rp_offs = 0;
+	rp.store(wp.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+	render_lock.unlock();
+	wake.release();
+}
+
+
+void TapeSpeaker::stop()
+{
+	// stop rendering
+	// must be called before the TapeFile is stopped, modified or deleted
+
+	lock_render();
+	tapefile = nullptr;
+	render_lock.unlock();
+}
+
+
+void TapeSpeaker::mix(StereoSample* out, uint count)
+{
+	// add the next count samples to out[]
+	// on underrun the segment is rendered here
+
+	bool freed = false;
+
+	while (count)
+	{
+		uint32 r = rp.load(std::memory_order_relaxed);
+		if (wp.load(std::memory_order_acquire) == r)
+		{
+			// underrun: the producer holds the lock only while it renders the missing segment.
+			// don't block: try again until we get the lock or the segment is ready.
+
+			if (!render_lock.try_lock()) continue;
+			if (wp.load(std::memory_order_relaxed) == r && tapefile) render_segment();
+			render_lock.unlock();
+			if (wp.load(std::memory_order_relaxed) == r) break; // stopped
+		}
+
+		const Sample* q = ring[r & (num_segments - 1)] + rp_offs;
+		uint		  n = min(count, segment_samples - rp_offs);
+		for (uint i = 0; i < n; i++) { out[i] += StereoSample(q[i]); }
+		out += n;
+		count -= n;
+		rp_offs += n;
+
+		if (rp_offs == segment_samples)
+		{
+			rp_offs = 0;
+			rp.store(r + 1, std::memory_order_release);
+			freed = true;
+		}
+	}
+
+	if (freed) wake.release();
+}
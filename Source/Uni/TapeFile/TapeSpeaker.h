@@ -0,0 +1,80 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "StereoSample.h"
+#include "cpp/cppthreads.h"
+#include "kio/kio.h"
+#include <atomic>
+#include <mutex>
+#include <pthread.h>
+
+class TapeFile;
+
+
+/*	The TapeRecorder's speaker: the sound of the tape while it is playing
+
+	A producer thread renders the pulses of the tape ahead into a ring of segments at the dsp sample rate.
+	The emulation thread only mixes the ready segments into the audio output in runForSound().
+	Crossing block boundaries needs no allocation, no block bookkeeping and no strings:
+	the phase of all blocks is taken when playing starts.
+
+	While the TapeFile is playing, the blocks and their pulse data are not modified:
+	only the TapeFile's and CswBuffers' read positions move, and the speaker does not read them.
+	start() and stop() must be called while the TapeFile is stopped, resp. before it is stopped or deleted.
+
+	If the producer falls behind, mix() renders the missing segment itself:
+	the output depends only on the tape and the play position, not on thread timing.
+
+	The emulation thread runs on the audio thread: it never blocks on the render_lock and never allocates
+	in start(), stop() or mix(). It only try-locks and spins: the producer holds the lock for at most one
+	segment and does not take it again while `stopping` is set.
+	phase0[] is grown when a tape is inserted and when blocks are recorded. If blocks were added otherwise,
+	the blocks behind phase0_max are silent.
+*/
+class TapeSpeaker
+{
+	static constexpr uint segment_samples = 256; // samples per segment
+	static constexpr uint num_segments	  = 16;	 // must be 2^N
+
+	// ring: +1: addToAudioBuffer() may touch the sample after the end
+	Sample				ring[num_segments][segment_samples + 1];
+	std::atomic<uint32> wp; // next segment to render: producer, or mix() on underrun
+	std::atomic<uint32> rp; // next segment to mix: emulation thread
+	uint				rp_offs;
+
+	// render position:
+	TapeFile* tapefile;	  // nullptr = stopped
+	uint	  blk;		  // block index in TapeFile
+	uint	  num_blocks; // blocks to play: limited by phase0_max
+	uint32	  qpos;		  // pulse index in CswBuffer
+	double	  qoffs;	  // cc_offset in pulse (fractional)
+	bool*	  phase0;	  // phase of the first pulse of each block
+	uint	  phase0_max; // allocated size
+
+	std::mutex		  render_lock; // protects the render position and the ring's write side
+	std::atomic<bool> stopping;	   // emulation thread waits for the render_lock
+	PSemaphore		  wake;		   // segment freed or start() or quit
+	bool			  quit;
+
+	pthread_t	 producer_thread;
+	static void* producer_proc(void*);
+	void*		 producer_proc();
+
+	void render_segment();
+	void lock_render() noexcept;
+
+public:
+	Sample volume; // 0.0 ... 1.0
+
+	TapeSpeaker() noexcept(false); // AnyError
+	~TapeSpeaker();
+	NO_COPY_MOVE(TapeSpeaker);
+
+	// emulation thread:
+	void reserve(uint num_blocks);
+	void start(TapeFile*);
+	void stop();
+	void mix(StereoSample*, uint count);
+};
@@ -9,6 +9,35 @@
 #include "version.h"
 
 
+static inline bool update_row(uint8* z, const uint8* q, int n)
+{
+	// copy n bytes if they differ
+	// returns true if z[] was modified
+
+	if (n <= 0 || memcmp(z, q, size_t(n)) == 0) return false;
+	memcpy(z, q, size_t(n));
+	return true;
+}
+
+static const struct Expand1bpp
+{
+	// lookup table to expand 8 pixels of a 1 bpp scanline to 8 bytes with color index 0 or 1, msbit first:
+	// the bytes of one octet are stored with a single 8-byte write.
+
+	uint64 bytes[256];
+
+	Expand1bpp()
+	{
+		for (uint b = 0; b < 256; b++)
+		{
+			uint8 z[8];
+			for (uint i = 0; i < 8; i++) { z[i] = (b >> (7 - i)) & 1; }
+			memcpy(&bytes[b], z, 8);
+		}
+	}
+} expand_1bpp;
+
+
 /*	rendere Ausgaben der B&W Ula in mono_octets[].
  */
 void MonoRenderer::drawScreen(
@@ -48,35 +77,50 @@ void MonoRenderer::drawScreen(
 	zh = min(zh, height - zy);
 
 	// use smaller width and height:
-	int w = min(qw, zw) / 8;
-	int h = min(qh, zh);
+	int w = max(0, min(qw, zw) / 8);
+	int h = max(0, min(qh, zh));
 
-	// offset to add to pointers after each row:
-	int qo = q_width / 8 - w;
-	int zo = width / 8 - w;
+	// copy frame buffer row by row and paint pixels outside the frame buffer data with black color.
+	// rows which are the same as in the last frame are not written
+	// and dirty_top and dirty_bottom tell the Screen which rows must be uploaded:
 
-	// source, destination and dest_end pointers:
-	const uint8* qp = new_pixels + qy * q_width / 8 + qx / 8;
-	uint8*		 zp = mono_octets;
-	uint8*		 ze;
-
-	// paint pixels before frame buffer data with black color:
-	for (ze = zp + zy * width / 8 + zx / 8; zp < ze;) *zp++ = 0;
+	constexpr int	   bpl		  = width / 8; // bytes per row
+	static const uint8 zeros[bpl] = {0};
+	const int		   x0		  = zx / 8;
+	const uint8*	   qp		  = new_pixels + qy * q_width / 8 + qx / 8;
+	int				   top		  = height;
+	int				   bottom	  = 0;
 
-	// copy frame buffer:
-	for (ze = zp + h * width / 8; zp < ze;)
+	for (int y = 0; y < height; y++)
 	{
-		// copy one row:
-		for (uint8* ze = zp + w; zp < ze;) *zp++ = *qp++;
-		// skip reminder of bytes in row
-		for (uint8* ze = zp + zo; zp < ze;) *zp++ = 0;
-		qp += qo;
+		uint8* zp = mono_octets + y * bpl;
+		bool   changed;
+
+		if (y < zy || y >= zy + h) changed = update_row(zp, zeros, bpl);
+		else
+		{
+			changed = update_row(zp, zeros, x0);
+			changed |= update_row(zp + x0, qp, w);
+			changed |= update_row(zp + x0 + w, zeros, bpl - x0 - w);
+			qp += q_width / 8;
+		}
+
+		if (changed)
+		{
+			if (top == height) top = y;
+			bottom = y + 1;
+		}
 	}
 
-	// paint pixels behind frame buffer data with black color:
-	for (ze = mono_octets + height * width / 8; zp < ze;) *zp++ = 0;
+	if (!valid) // first frame: everything is new
+	{
+		valid  = yes;
+		top	   = 0;
+		bottom = height;
+	}
 
-	assert(ze == mono_octets + width * height / 8);
+	dirty_top	 = top;
+	dirty_bottom = max(top, bottom);
 }
 
 
@@ -157,11 +201,7 @@ void MonoGifWriter::drawScreen(
 	for (ze = min(zee, zp + h * width); zp < ze;)
 	{
 		// copy one row:
-		for (uint8* ze = zp + w; zp < ze;)
-		{
-			uint8 pixels = *qp++;
-			for (uint s = 8; s--;) { *zp++ = (pixels >> s) & 1; }
-		}
+		for (uint8* ze = zp + w; zp < ze; zp += 8) { memcpy(zp, &expand_1bpp.bytes[*qp++], 8); }
 		// skip reminder of bytes in row
 		for (uint8* ze = min(zee, zp + zo); zp < ze;) *zp++ = 0;
 		qp += qo;
@@ -180,6 +220,14 @@ void MonoGifWriter::drawScreen(
 void MonoGifWriter::writeFrame(
 	uint8* new_pixels, uint screen_w, uint screen_h, uint frame_h, uint frame_w, uint screen_x0, uint screen_y0)
 {
+	if (raw_video) // .y4m: every frame in full
+	{
+		bits->setFrame(0, 0, width, height);
+		drawScreen(new_pixels, screen_w, screen_h, frame_h, frame_w, screen_x0, screen_y0);
+		write_bits_to_raw_file();
+		return;
+	}
+
 	assert(gif_encoder.imageInProgress());
 	assert(bits && bits2 && diff && diff2);
 
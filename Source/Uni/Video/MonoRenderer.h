@@ -26,6 +26,12 @@ public:
 	// cc_screen	= screen_width/pixel_per_cc,	// 128 -> 256 pixel
 	// cc_h_border  = h_border/pixel_per_cc			// 32  -> 64 pixel
 
+	// rows in mono_octets[] modified by the last drawScreen(): dirty_top ..< dirty_bottom
+	// unmodified rows need not be uploaded again:
+	int	 dirty_top	  = 0;
+	int	 dirty_bottom = height;
+	bool valid		  = no; // mono_octets[] contains a frame
+
 	explicit MonoRenderer(isa_id id = isa_MonoRenderer) :
 		Renderer(id, screen_width, screen_height, h_border, v_border, no /*!color*/)
 	{}
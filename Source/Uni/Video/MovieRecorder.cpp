@@ -0,0 +1,284 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "MovieRecorder.h"
+#include "MonoRenderer.h"
+#include "ZxspRenderer.h"
+#include "unix/files.h"
+#include "zxsp_globals.h"
+
+
+// helper: grow buffer of a queue slot:
+template<typename T>
+static void grow(T*& buffer, uint& size, uint min_size)
+{
+	if (size >= min_size) return;
+	delete[] buffer;
+	buffer = new T[min_size];
+	size   = min_size;
+}
+
+
+MovieRecorder::MovieRecorder(GifWriter* gif_writer, cstr path, bool raw_video) noexcept(false) :
+	gif_writer(gif_writer),
+	raw_video(raw_video),
+	failed(false),
+	wav_samples(0),
+	wp(0),
+	rp(0)
+{
+	// start recording
+	// path = gif movie or .y4m file: a .wav file is written next to it
+	// takes ownership of the GifWriter
+
+	try
+	{
+		gif_writer->startRecording(path, raw_video);
+		if (raw_video) start_wav_file(catstr(directory_from_path(path), basename_from_path(path), ".wav"));
+	}
+	catch (FileError&)
+	{
+		delete gif_writer;
+		throw;
+	}
+
+	// allocate the slot buffers now, not while the emulation thread is running:
+	for (uint i = 0; i < queue_size; i++)
+	{
+		Job& job = queue[i];
+		grow(job.ioinfo, job.ioinfo_size, ioinfo_presize);
+		grow(job.data, job.data_size, data_presize);
+		if (raw_video) grow(job.samples, job.samples_size, DSP_SAMPLES_PER_BUFFER_MAX);
+	}
+	slots_free.release(queue_size);
+
+	int e = pthread_create(&worker_thread, nullptr /*attr*/, worker_proc, this /*args*/);
+	if (e)
+	{
+		delete gif_writer;
+		throw AnyError(usingstr("Creating the movie recorder thread failed: %s", strerror(e)));
+	}
+}
+
+
+MovieRecorder::~MovieRecorder()
+{
+	// stop recording
+	// waits until all queued frames are encoded and the files are closed
+	// the caller must make sure that the emulation thread no longer writes frames
+
+	next_free_job().type = Job::Stop;
+	push_job();
+	pthread_join(worker_thread, nullptr);
+
+	delete gif_writer;
+}
+
+
+// ---------------------------------------------------------
+//		emulation thread
+// ---------------------------------------------------------
+
+
+MovieRecorder::Job& MovieRecorder::next_free_job()
+{
+	// get the next free slot
+	// if the worker is behind by queue_size jobs then wait until it has finished the oldest job
+
+	slots_free.request();
+	uint32 i = wp.load(std::memory_order_relaxed);
+	assert(i - rp.load(std::memory_order_acquire) < queue_size);
+	return queue[i & (queue_size - 1)];
+}
+
+
+void MovieRecorder::push_job()
+{
+	wp.store(wp.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	jobs_avail.release();
+}
+
+
+void MovieRecorder::writeFrame(
+	const IoInfo* ioinfo, uint ioinfo_count, const uint8* attr_pixels, uint attr_pixels_size,
+	uint32 cc_start_of_screenfile, uint cc_per_scanline, bool flashphase)
+{
+	// append a frame of a color screen
+	// the frame is copied: the caller may reuse the buffers immediately
+	// waits if the queue is full
+
+	Job& job = next_free_job();
+
+	grow(job.ioinfo, job.ioinfo_size, ioinfo_count + 1); // +1: the Renderer appends a stopper
+	grow(job.data, job.data_size, attr_pixels_size);
+	memcpy(job.ioinfo, ioinfo, ioinfo_count * sizeof(IoInfo));
+	memcpy(job.data, attr_pixels, attr_pixels_size);
+
+	job.type				   = Job::ColorFrame;
+	job.ioinfo_count		   = ioinfo_count;
+	job.cc_start_of_screenfile = cc_start_of_screenfile;
+	job.cc_per_scanline		   = cc_per_scanline;
+	job.flashphase			   = flashphase;
+
+	push_job();
+}
+
+
+void MovieRecorder::writeFrame(
+	const uint8* pixels, uint screen_w, uint screen_h, uint frame_w, uint frame_h, uint screen_x0, uint screen_y0)
+{
+	// append a frame of a b&w screen
+	// frame_w and frame_h in pixels
+	// the frame is copied: the caller may reuse the buffer immediately
+	// waits if the queue is full
+
+	Job& job = next_free_job();
+
+	uint size = frame_w / 8 * frame_h;
+	grow(job.data, job.data_size, size);
+	memcpy(job.data, pixels, size);
+
+	job.type	  = Job::MonoFrame;
+	job.screen_w  = screen_w;
+	job.screen_h  = screen_h;
+	job.frame_w	  = frame_w;
+	job.frame_h	  = frame_h;
+	job.screen_x0 = screen_x0;
+	job.screen_y0 = screen_y0;
+
+	push_job();
+}
+
+
+void MovieRecorder::writeSound(const StereoSample* samples, uint count)
+{
+	// append the samples of one dsp buffer
+	// only recorded for raw video
+	// waits if the queue is full
+
+	if (!raw_video || count == 0) return;
+
+	Job& job = next_free_job();
+	grow(job.samples, job.samples_size, count);
+	memcpy(job.samples, samples, count * sizeof(StereoSample));
+	job.type		  = Job::Sound;
+	job.samples_count = count;
+
+	push_job();
+}
+
+
+// ---------------------------------------------------------
+//		worker thread
+// ---------------------------------------------------------
+
+
+// static
+void* MovieRecorder::worker_proc(void* self) { return ((MovieRecorder*)self)->worker_proc(); }
+
+
+/*	worker thread executor:
+	- waits for jobs_avail
+	- draws and encodes the frame or writes the sound
+	- releases the slot and slots_free
+*/
+void* MovieRecorder::worker_proc()
+{
+	for (;;)
+	{
+		jobs_avail.request(); // wait for next job
+
+		uint32 i = rp.load(std::memory_order_relaxed);
+		assert(i != wp.load(std::memory_order_acquire));
+		Job& job = queue[i & (queue_size - 1)];
+
+		try
+		{
+			if (job.type == Job::Stop)
+			{
+				if (!failed) gif_writer->stopRecording();
+				if (!failed && raw_video) stop_wav_file();
+				return nullptr;
+			}
+
+			if (failed) {} // discard
+			else if (job.type == Job::ColorFrame)
+			{
+				assert(dynamic_cast<ZxspGifWriter*>(gif_writer));
+				static_cast<ZxspGifWriter*>(gif_writer)
+					->writeFrame(
+						job.ioinfo, job.ioinfo_count, job.data, job.cc_per_scanline, job.cc_start_of_screenfile,
+						job.flashphase);
+			}
+			else if (job.type == Job::MonoFrame)
+			{
+				assert(dynamic_cast<MonoGifWriter*>(gif_writer));
+				static_cast<MonoGifWriter*>(gif_writer)
+					->writeFrame(
+						job.data, job.screen_w, job.screen_h, job.frame_w, job.frame_h, job.screen_x0, job.screen_y0);
+			}
+			else write_sound(job);
+		}
+		catch (FileError& e)
+		{
+			showWarning("File error: %s", e.what());
+			failed = true;
+			if (job.type == Job::Stop) return nullptr;
+		}
+
+		rp.store(i + 1, std::memory_order_release); // release the slot
+		slots_free.release();
+	}
+}
+
+
+void MovieRecorder::start_wav_file(cstr path)
+{
+	// write the .wav file header
+	// the chunk sizes are updated in stop_wav_file()
+
+	uint32 rate = uint32(samples_per_second + 0.5);
+
+	wav_file.open_file_w(path);
+	wav_file.write_bytes("RIFF", 4);
+	wav_file.write_uint32_z(36); // file size - 8
+	wav_file.write_bytes("WAVEfmt ", 8);
+	wav_file.write_uint32_z(16);		// fmt chunk size
+	wav_file.write_uint16_z(1);			// PCM
+	wav_file.write_uint16_z(2);			// channels
+	wav_file.write_uint32_z(rate);		// samples per second
+	wav_file.write_uint32_z(rate * 4);	// bytes per second
+	wav_file.write_uint16_z(4);			// bytes per frame
+	wav_file.write_uint16_z(16);		// bits per sample
+	wav_file.write_bytes("data", 4);
+	wav_file.write_uint32_z(0);			// data chunk size
+}
+
+
+void MovieRecorder::write_sound(const Job& job)
+{
+	int16 bu[2 * DSP_SAMPLES_PER_BUFFER_MAX];
+
+	for (uint i = 0; i < job.samples_count;)
+	{
+		uint n = min(job.samples_count - i, uint(DSP_SAMPLES_PER_BUFFER_MAX));
+		for (uint j = 0; j < n; j++, i++)
+		{
+			bu[2 * j]	  = int16(minmax(-32767.0f, job.samples[i].left * 32767.0f, 32767.0f));
+			bu[2 * j + 1] = int16(minmax(-32767.0f, job.samples[i].right * 32767.0f, 32767.0f));
+		}
+		wav_file.write_bytes(bu, n * 4);
+		wav_samples += n;
+	}
+}
+
+
+void MovieRecorder::stop_wav_file()
+{
+	wav_file.seek_fpos(4);
+	wav_file.write_uint32_z(36 + wav_samples * 4);
+	wav_file.seek_fpos(40);
+	wav_file.write_uint32_z(wav_samples * 4);
+	wav_file.close_file(1);
+}
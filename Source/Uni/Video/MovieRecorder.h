@@ -0,0 +1,97 @@
+#pragma once
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+#include "IoInfo.h"
+#include "StereoSample.h"
+#include "cpp/cppthreads.h"
+#include "unix/FD.h"
+#include "zxsp_types.h"
+#include <atomic>
+#include <pthread.h>
+
+
+/*	Record a gif movie or a raw video (.y4m) plus sound (.wav) on a worker thread.
+
+	The emulation thread copies each frame into a bounded queue and returns.
+	The worker thread draws and encodes the frames in order.
+	If the queue is full the emulation thread waits for a free slot: no frame and no sound is dropped,
+	so the .y4m video and the .wav file stay in sync. The Screen calls us without holding its mutex,
+	so a waiting emulation thread doesn't block the render thread.
+	The slot buffers are allocated when recording starts and only grow for unusually large frames.
+
+	There is exactly one producer and one consumer:
+	the queue indexes are not locked, the semaphores are only used to wait for a job or a free slot.
+*/
+class MovieRecorder
+{
+	static constexpr uint queue_size	 = 64;		// must be 2^N: ~0.25 sec. of 50 frames + 220 sound jobs per sec.
+	static constexpr uint ioinfo_presize = 400 + 1; // +1: the Renderer appends a stopper
+	static constexpr uint data_presize	 = 32 kB;	// attr_pixels of a color frame or pixels of a b&w frame
+
+	struct Job
+	{
+		enum Type : uint8 { ColorFrame, MonoFrame, Sound, Stop };
+		Type type;
+
+		// ColorFrame: ioinfo[] and attr_pixels in data[]
+		// MonoFrame:  pixels in data[]
+		// Sound:      samples[]
+		IoInfo*		  ioinfo		= nullptr;
+		uint		  ioinfo_size	= 0;
+		uint		  ioinfo_count	= 0;
+		uint8*		  data			= nullptr;
+		uint		  data_size		= 0;
+		StereoSample* samples		= nullptr;
+		uint		  samples_size	= 0;
+		uint		  samples_count = 0;
+
+		uint32 cc_start_of_screenfile;
+		uint   cc_per_scanline;
+		bool   flashphase;
+		uint   screen_w, screen_h, frame_w, frame_h, screen_x0, screen_y0;
+
+		~Job()
+		{
+			delete[] ioinfo;
+			delete[] data;
+			delete[] samples;
+		}
+	};
+
+	GifWriter* gif_writer;
+	bool	   raw_video; // .y4m + .wav
+	bool	   failed;	  // file error: discard all jobs
+	FD		   wav_file;
+	uint32	   wav_samples;
+
+	Job					queue[queue_size];
+	std::atomic<uint32> wp; // next job to write: emulation thread
+	std::atomic<uint32> rp; // next job to read:  worker thread
+	PSemaphore			jobs_avail;
+	PSemaphore			slots_free;
+
+	pthread_t	 worker_thread;
+	static void* worker_proc(void*);
+	void*		 worker_proc();
+
+	Job& next_free_job(); // waits for a free slot
+	void push_job();
+	void write_sound(const Job&);
+	void start_wav_file(cstr path);
+	void stop_wav_file();
+
+public:
+	MovieRecorder(GifWriter*, cstr path, bool raw_video) noexcept(false); // FileError
+	~MovieRecorder();
+	NO_COPY_MOVE(MovieRecorder);
+
+	// emulation thread:
+	void writeFrame(
+		const IoInfo* ioinfo, uint ioinfo_count, const uint8* attr_pixels, uint attr_pixels_size,
+		uint32 cc_start_of_screenfile, uint cc_per_scanline, bool flashphase);
+	void writeFrame(
+		const uint8* pixels, uint screen_w, uint screen_h, uint frame_w, uint frame_h, uint screen_x0, uint screen_y0);
+	void writeSound(const StereoSample*, uint count);
+};
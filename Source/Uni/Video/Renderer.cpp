@@ -44,7 +44,9 @@ GifWriter::GifWriter(
 	update_border(update_border),
 	frames_per_second(frames_per_second),
 	frames_per_flashphase(16),
-	global_colormap(colormap)
+	global_colormap(colormap),
+	raw_video(false),
+	raw_buffer(nullptr)
 {}
 
 
@@ -59,11 +61,59 @@ void GifWriter::write_diff2_to_file()
 }
 
 
-void GifWriter::startRecording(cstr path)
+// helper: write bits[] as one frame to the .y4m file:
+void GifWriter::write_bits_to_raw_file()
+{
+	// YCbCr for all colors in the colormap: BT.601, limited range:
+	uint8 y[256], cb[256], cr[256];
+	for (int i = 0; i < 256; i++)
+	{
+		float r = 0, g = 0, b = 0;
+		if (i < global_colormap.usedColors())
+		{
+			const Comp* rgb = global_colormap[i];
+			r				= rgb[0];
+			g				= rgb[1];
+			b				= rgb[2];
+		}
+		y[i]  = uint8(16.5f + (65.738f * r + 129.057f * g + 25.064f * b) / 256);
+		cb[i] = uint8(128.5f + (-37.945f * r - 74.494f * g + 112.439f * b) / 256);
+		cr[i] = uint8(128.5f + (112.439f * r - 94.154f * g - 18.285f * b) / 256);
+	}
+
+	const GifColor* q = bits->getData();
+	uint			n = width * height;
+	uint8*			z = raw_buffer;
+
+	memcpy(z, "FRAME\n", 6);
+	z += 6;
+	for (uint i = 0; i < n; i++) { z[i] = y[q[i]]; }
+	z += n;
+	for (uint i = 0; i < n; i++) { z[i] = cb[q[i]]; }
+	z += n;
+	for (uint i = 0; i < n; i++) { z[i] = cr[q[i]]; }
+
+	raw_file.write_bytes(raw_buffer, 6 + 3 * n);
+}
+
+
+void GifWriter::startRecording(cstr path, bool raw_video)
 {
 	assert(!gif_encoder.imageInProgress());
 	assert(!bits && !bits2 && !diff && !diff2);
 
+	this->raw_video = raw_video;
+	if (raw_video)
+	{
+		raw_file.open_file_w(path);
+		cstr header = usingstr("YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C444\n", width, height, frames_per_second);
+		raw_file.write_bytes(header, strlen(header));
+
+		bits	   = new Pixelmap(width, height);
+		raw_buffer = new uint8[6 + 3 * width * height];
+		return;
+	}
+
 	gif_encoder.openFile(path);
 	gif_encoder.writeScreenDescriptor(width, height, 16);
 	gif_encoder.writeCommentBlock(
@@ -80,6 +130,16 @@ void GifWriter::startRecording(cstr path)
 
 void GifWriter::stopRecording()
 {
+	if (raw_video)
+	{
+		raw_file.close_file(1);
+		delete bits;
+		bits = nullptr;
+		delete[] raw_buffer;
+		raw_buffer = nullptr;
+		return;
+	}
+
 	assert(gif_encoder.imageInProgress());
 
 	if (frame_count) write_diff2_to_file();
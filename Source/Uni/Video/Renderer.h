@@ -6,6 +6,7 @@
 #include "IoInfo.h"
 #include "IsaObject.h"
 #include "graphics/gif/GifEncoder.h"
+#include "unix/FD.h"
 
 
 using RgbaColor = uint32;					 // RGBA for OpenGL
@@ -65,6 +66,7 @@ public:
 
 /*	Base class for Gif Writer.
 	Sub classes must provide drawScreen(…), writeFrame(…) and saveScreenShot(…).
+	Movies can also be recorded as raw video (.y4m, YUV 4:4:4) for lossless encoding with external tools.
 */
 class GifWriter : public IsaObject
 {
@@ -88,13 +90,20 @@ protected:					  // values for 32 column mode:
 	const Colormap& global_colormap;
 	GifEncoder		gif_encoder;
 
+	bool   raw_video;  // recording a .y4m file
+	FD	   raw_file;   // the .y4m file
+	uint8* raw_buffer; // one .y4m frame
+
 	void write_diff2_to_file();
+	void write_bits_to_raw_file();
 
 	GifWriter(
 		isa_id id, const Colormap&, uint screen_width, uint screen_height, uint h_border, uint v_border,
 		bool update_border, uint frames_per_second);
 
 public:
-	void startRecording(cstr path);
+	~GifWriter() override { delete[] raw_buffer; }
+
+	void startRecording(cstr path, bool raw_video = false);
 	void stopRecording();
 };
@@ -114,7 +114,7 @@ void TVDecoderMono::clear_pixels(int32 cca, int32 cce, uint8 color)
 		p++;
 	}
 
-	while (p < e) { *p++ = color; }
+	if (p < e) memset(p, color, e - p);
 }
 
 inline void TVDecoderMono::next_line(int32 cc)
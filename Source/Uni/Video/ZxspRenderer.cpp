@@ -246,6 +246,14 @@ void ZxspGifWriter::writeFrame(
 	IoInfo* ioinfo, uint ioinfo_count, uint8* attr_pixels, uint cc_per_scanline, uint32 cc_start_of_screenfile,
 	bool flashphase)
 {
+	if (raw_video) // .y4m: every frame in full
+	{
+		bits->setFrame(0, 0, width, height);
+		drawScreen(ioinfo, ioinfo_count, attr_pixels, cc_per_scanline, cc_start_of_screenfile, flashphase);
+		write_bits_to_raw_file();
+		return;
+	}
+
 	assert(gif_encoder.imageInProgress());
 	assert(bits && bits2 && diff && diff2);
 
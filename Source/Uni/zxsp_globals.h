@@ -18,7 +18,8 @@ extern void showMessage(MessageStyle, cstr text);
 
 // externally provided global data:
 
-extern Frequency samples_per_second; // for audio output channel
+extern Frequency samples_per_second;	  // for audio output channel: nominal rate ±0.5% from RateControl
+extern int32	 dsp_samples_per_buffer; // DSP_SAMPLES_PER_BUFFER_MIN .. DSP_SAMPLES_PER_BUFFER_MAX
 extern Time		 system_time;		 // monotonic real time [seconds]
 extern cstr		 appl_rsrc_path;	 // where are the roms, audio fx,
 
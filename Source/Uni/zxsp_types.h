@@ -11,7 +11,7 @@ using Frequency = double;
 using CoreByte	= uint32; // Z80
 using Sample	= float;
 class StereoSample;
-using StereoBuffer = StereoSample[DSP_SAMPLES_PER_BUFFER + DSP_SAMPLES_STITCHING];
+using StereoBuffer = StereoSample[DSP_SAMPLES_PER_BUFFER_MAX + DSP_SAMPLES_STITCHING];
 
 
 enum MessageStyle // popup message styles:
@@ -7,6 +7,8 @@
 
 #define MAX_USB_JOYSTICKS 4
 
-// Stereo samples per audio buffer:
-#define DSP_SAMPLES_PER_BUFFER 200 // ~ 4 buffers per video frame
-#define DSP_SAMPLES_STITCHING  4
+// Stereo samples per audio buffer: selected at runtime, see dsp_samples_per_buffer
+#define DSP_SAMPLES_PER_BUFFER_MIN	64
+#define DSP_SAMPLES_PER_BUFFER_MAX	2048 // size of the static buffers
+#define DSP_SAMPLES_PER_BUFFER_DFLT 200	 // ~ 4 buffers per video frame
+#define DSP_SAMPLES_STITCHING		4
@@ -0,0 +1,145 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+/*	zxsp-index: index a collection of snapshot and tape files
+
+	usage: zxsp-index [options] path…
+		   zxsp-index --list [-o index]
+
+	options:
+		-o index		the index file, default: zxsp.index
+		-t dir			the thumbnail directory, default: index + ".thumbs"
+		-r dir			the zxsp resource directory: the ZX81 rom is needed for ZX81 thumbnails
+		-j N			number of threads, default: number of cpus
+		--no-thumbs		don't create thumbnails
+		--list			print the index
+
+	paths may be files or directories which are searched recursively.
+	an existing index is used to skip files whose mtime and size did not change.
+	the new index contains only the files found in the given paths.
+*/
+
+#include "Files/FileIndex.h"
+#include "Files/FileScanner.h"
+#include "zxsp_globals.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+cstr appl_rsrc_path = nullptr; // set by -r
+
+void showMessage(MessageStyle, cstr text)
+{
+	// called by TapeFile and others
+	fprintf(stderr, "%s\n", text);
+}
+
+
+static void usage()
+{
+	fputs(
+		"usage: zxsp-index [options] path…\n"
+		"       zxsp-index --list [-o index]\n"
+		"  -o index       the index file, default: zxsp.index\n"
+		"  -t dir         the thumbnail directory, default: index + \".thumbs\"\n"
+		"  -r dir         the zxsp resource directory for the ZX81 rom\n"
+		"  -j N           number of threads, default: number of cpus\n"
+		"  --no-thumbs    don't create thumbnails\n"
+		"  --list         print the index\n",
+		stderr);
+	exit(1);
+}
+
+static void list(cstr index_path)
+{
+	FileIndex index;
+	if (!index.open(index_path))
+	{
+		fprintf(stderr, "zxsp-index: %s: no valid index file\n", index_path);
+		exit(1);
+	}
+
+	for (uint i = 0; i < index.count(); i++)
+	{
+		const FileIndexEntry& e = index[i];
+		printf("%s\n", index.str(e.path));
+		if (e.model != unknown_model) printf("  model: %s\n", zx_info[e.model].name);
+		if (e.thumbnail) printf("  thumbnail: %s\n", index.str(e.thumbnail));
+		if (e.error) printf("  error: %s\n", index.str(e.error));
+		for (cstr s = index.str(e.names); *s;)
+		{
+			cstr n = strchr(s, '\n');
+			if (!n) n = strchr(s, 0);
+			printf("  %.*s\n", int(n - s), s);
+			s = *n ? n + 1 : n;
+		}
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	cstr index_path	 = "zxsp.index";
+	cstr thumbs_dir	 = nullptr;
+	bool no_thumbs	 = false;
+	bool list_only	 = false;
+	uint num_threads = uint(max(1L, sysconf(_SC_NPROCESSORS_ONLN)));
+	int	 num_paths	 = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		cstr a = argv[i];
+		if (a[0] != '-')
+		{
+			argv[num_paths++] = argv[i]; // collect paths at the start of argv[]
+			continue;
+		}
+
+		if (eq(a, "--no-thumbs")) no_thumbs = true;
+		else if (eq(a, "--list")) list_only = true;
+		else if (i + 1 == argc) usage();
+		else if (eq(a, "-o")) index_path = argv[++i];
+		else if (eq(a, "-t")) thumbs_dir = argv[++i];
+		else if (eq(a, "-r")) appl_rsrc_path = catstr(argv[++i], "/");
+		else if (eq(a, "-j")) num_threads = uint(atoi(argv[++i]));
+		else usage();
+	}
+
+	if (list_only)
+	{
+		list(index_path);
+		return 0;
+	}
+	if (num_paths == 0) usage();
+	if (!thumbs_dir) thumbs_dir = catstr(index_path, ".thumbs");
+
+	FileScanner scanner(no_thumbs ? nullptr : thumbs_dir);
+	for (int i = 0; i < num_paths; i++) scanner.addPath(argv[i]);
+
+	FileIndex old_index;
+	bool	  incremental = old_index.open(index_path);
+	scanner.scan(incremental ? &old_index : nullptr, num_threads);
+
+	try
+	{
+		scanner.writeIndex(index_path);
+	}
+	catch (AnyError& e)
+	{
+		fprintf(stderr, "zxsp-index: %s: %s\n", index_path, e.what());
+		return 1;
+	}
+
+	uint reused = 0, errors = 0, thumbs = 0;
+	for (uint i = 0; i < scanner.count(); i++)
+	{
+		reused += scanner[i].reused;
+		errors += scanner[i].error != nullptr;
+		thumbs += scanner[i].thumbnail != nullptr;
+	}
+	printf("%u files, %u unchanged, %u thumbnails, %u errors\n", scanner.count(), reused, thumbs, errors);
+	return 0;
+}
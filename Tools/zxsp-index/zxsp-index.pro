@@ -0,0 +1,63 @@
+TEMPLATE = app
+TARGET = zxsp-index
+CONFIG += console c++14
+CONFIG -= qt app_bundle
+
+CONFIG(release,debug|release) { DEFINES += NDEBUG RELEASE }
+CONFIG(debug,debug|release) { DEFINES += DEBUG }
+QMAKE_CXXFLAGS += -Wno-multichar
+LIBS += -pthread -lz
+
+INCLUDEPATH += \
+	../../Source \
+	../../Source/Uni \
+	../../Source/Uni/Files \
+	../../Source/Uni/TapeFile \
+	../../Source/Uni/Video \
+	../../Source/Uni/Items \
+	../../Source/Uni/ZxInfo \
+	../../Libraries \
+	../../zasm/Source \
+
+SOURCES += \
+	zxsp-index.cpp \
+	../../Source/Uni/Files/FileIndex.cpp \
+	../../Source/Uni/Files/FileScanner.cpp \
+	../../Source/Uni/Files/Z80Head.cpp \
+	../../Source/Uni/Files/file_szx.cpp \
+	../../Source/Uni/Files/RzxFile.cpp \
+	../../Source/Uni/Files/RzxBlock.cpp \
+	../../Source/Uni/Files/RzxSpillFile.cpp \
+	../../Source/Uni/TapeFile/CswBuffer.cpp \
+	../../Source/Uni/TapeFile/TapeFile.cpp \
+	../../Source/Uni/TapeFile/TapeData.cpp \
+	../../Source/Uni/TapeFile/TapData.cpp \
+	../../Source/Uni/TapeFile/O80Data.cpp \
+	../../Source/Uni/TapeFile/TzxData.cpp \
+	../../Source/Uni/TapeFile/AudioData.cpp \
+	../../Source/Uni/TapeFile/RlesData.cpp \
+	../../Source/Uni/TapeFile/TapeFileDataBlock.cpp \
+	../../Source/Uni/Video/Renderer.cpp \
+	../../Source/Uni/Video/ZxspRenderer.cpp \
+	../../Source/Uni/Video/MonoRenderer.cpp \
+	../../Source/Uni/ZxInfo/ZxInfo.cpp \
+	../../Source/Uni/zxsp_helpers.cpp \
+	../../Libraries/kio/kio.cpp \
+	../../Libraries/kio/exceptions.cpp \
+	../../Libraries/cstrings/cstrings.cpp \
+	../../Libraries/cstrings/tempmem.cpp \
+	../../Libraries/cpp/cppthreads.cpp \
+	../../Libraries/unix/FD.cpp \
+	../../Libraries/unix/files.cpp \
+	../../Libraries/unix/os_utilities.cpp \
+	../../Libraries/unix/log_to_file.cpp \
+	../../Libraries/graphics/gif/Colormap.cpp \
+	../../Libraries/graphics/gif/Pixelmap.cpp \
+	../../Libraries/graphics/gif/GifEncoder.cpp \
+	../../Libraries/audio/WavFile.cpp \
+	../../Libraries/audio/convert_audio.cpp \
+	../../Libraries/audio/Linux/AudioDecoder.cpp \
+
+HEADERS += \
+	../../Source/Uni/Files/FileIndex.h \
+	../../Source/Uni/Files/FileScanner.h \
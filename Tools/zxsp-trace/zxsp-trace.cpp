@@ -0,0 +1,265 @@
+// Copyright (c) 2023 - 2023 kio@little-bat.de
+// BSD-2-Clause license
+// https://opensource.org/licenses/BSD-2-Clause
+
+/*	zxsp-trace: query an instruction trace recorded by zxsp
+
+	usage: zxsp-trace [options] file.z80trace
+
+	options:
+		--pc A[-E]		instructions at address A or in range A to E (inclusive)
+		--reg R=N		instructions where register R had value N before execution
+						R = af bc de hl sp a f b c d e h l
+		--mem A[-E]		instructions which wrote to address A or range A to E (inclusive)
+						note: only the first write of an instruction is recorded
+		--frame F[-G]	instructions in frame F or range F to G (inclusive)
+		--count			only print the number of matching instructions
+		--max N			stop after N matching instructions
+
+	numbers are decimal or hex with prefix '$' or '0x'.
+	all filters must match. filters of the same kind may be given more than once: one of them must match.
+	frames are counted from 0 at the start of the recording. the frame number is taken from the
+	markers in the file, so it is still right after records were dropped.
+*/
+
+#include "../../Source/Uni/Items/Z80/Z80_TraceRecord.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+struct Range
+{
+	uint32 a, e;
+	bool   contains(uint32 n) const { return n >= a && n <= e; }
+};
+
+struct RegFilter
+{
+	int	   reg; // index in reg_names[]
+	uint32 value;
+};
+
+static const char* const reg_names[] = {"af", "bc", "de", "hl", "sp", "a", "f", "b", "c", "d", "e", "h", "l"};
+static const int		 num_regs	 = sizeof(reg_names) / sizeof(*reg_names);
+
+static const int max_filters = 32;
+
+static Range	 pc_filter[max_filters];
+static Range	 mem_filter[max_filters];
+static Range	 frame_filter[max_filters];
+static RegFilter reg_filter[max_filters];
+static int		 num_pc = 0, num_mem = 0, num_frame = 0, num_reg = 0;
+
+
+static void usage()
+{
+	fputs(
+		"usage: zxsp-trace [options] file.z80trace\n"
+		"  --pc A[-E]     instructions at address A or in range A to E\n"
+		"  --reg R=N      register R had value N before execution: R = af bc de hl sp a f b c d e h l\n"
+		"  --mem A[-E]    instructions which wrote to address A or range A to E\n"
+		"  --frame F[-G]  instructions in frame F or range F to G\n"
+		"  --count        only print the number of matching instructions\n"
+		"  --max N        stop after N matching instructions\n",
+		stderr);
+	exit(1);
+}
+
+static void fail(const char* msg, const char* arg)
+{
+	fprintf(stderr, "zxsp-trace: %s: %s\n", msg, arg);
+	exit(1);
+}
+
+
+static uint32 parse_number(const char*& s, const char* arg)
+{
+	int base = 10;
+	if (*s == '$') { s += 1; base = 16; }
+	else if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) { s += 2; base = 16; }
+
+	char* e;
+	errno			= 0;
+	unsigned long n = strtoul(s, &e, base);
+	if (e == s || errno || n > 0xffffffffu) fail("number expected", arg);
+	s = e;
+	return uint32(n);
+}
+
+static Range parse_range(const char* arg)
+{
+	const char* s = arg;
+	Range		r;
+	r.a = r.e = parse_number(s, arg);
+	if (*s == '-') r.e = parse_number(++s, arg);
+	if (*s != 0 || r.e < r.a) fail("range expected", arg);
+	return r;
+}
+
+static uint32 parse_count(const char* arg)
+{
+	const char* s = arg;
+	uint32		n = parse_number(s, arg);
+	if (*s != 0) fail("number expected", arg);
+	return n;
+}
+
+static RegFilter parse_reg(const char* arg)
+{
+	const char* eq = strchr(arg, '=');
+	if (!eq) fail("R=N expected", arg);
+
+	RegFilter f;
+	for (f.reg = 0; f.reg < num_regs; f.reg++)
+	{
+		if (strlen(reg_names[f.reg]) == size_t(eq - arg) && strncmp(reg_names[f.reg], arg, size_t(eq - arg)) == 0)
+			break;
+	}
+	if (f.reg == num_regs) fail("unknown register", arg);
+
+	const char* s = eq + 1;
+	f.value		  = parse_number(s, arg);
+	if (*s != 0) fail("number expected", arg);
+	return f;
+}
+
+
+static uint32 reg_value(const Z80TraceRecord& t, int reg)
+{
+	switch (reg)
+	{
+	case 0: return t.af;
+	case 1: return t.bc;
+	case 2: return t.de;
+	case 3: return t.hl;
+	case 4: return t.sp;
+	case 5: return t.af >> 8;
+	case 6: return t.af & 0xff;
+	case 7: return t.bc >> 8;
+	case 8: return t.bc & 0xff;
+	case 9: return t.de >> 8;
+	case 10: return t.de & 0xff;
+	case 11: return t.hl >> 8;
+	default: return t.hl & 0xff;
+	}
+}
+
+static bool matches(const Z80TraceRecord& t, uint32 frame)
+{
+	// all kinds of filters must match
+	// any filter of one kind must match
+
+	bool f = num_frame == 0;
+	for (int i = 0; !f && i < num_frame; i++) { f = frame_filter[i].contains(frame); }
+	if (!f) return false;
+
+	f = num_pc == 0;
+	for (int i = 0; !f && i < num_pc; i++) { f = pc_filter[i].contains(t.pc); }
+	if (!f) return false;
+
+	f = num_mem == 0;
+	for (int i = 0; !f && i < num_mem; i++) { f = t.nwrites && mem_filter[i].contains(t.waddr); }
+	if (!f) return false;
+
+	f = num_reg == 0;
+	for (int i = 0; !f && i < num_reg; i++) { f = reg_value(t, reg_filter[i].reg) == reg_filter[i].value; }
+	return f;
+}
+
+static void print(const Z80TraceRecord& t, uint64_t index, uint32 frame)
+{
+	printf(
+		"%10llu %6u %6i  %04X  %02X %02X %02X %02X  AF=%04X BC=%04X DE=%04X HL=%04X SP=%04X", (unsigned long long)index,
+		frame, t.cc, t.pc, t.op[0], t.op[1], t.op[2], t.op[3], t.af, t.bc, t.de, t.hl, t.sp);
+	if (t.nwrites) printf("  (%04X)=%02X", t.waddr, t.wvalue);
+	if (t.nwrites > 1) printf(" +%u", t.nwrites - 1u);
+	putchar('\n');
+}
+
+
+int main(int argc, char* argv[])
+{
+	const char* path	   = nullptr;
+	bool		count_only = false;
+	uint64_t	max		   = ~uint64_t(0);
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* a = argv[i];
+		if (a[0] != '-')
+		{
+			if (path) usage();
+			path = a;
+			continue;
+		}
+
+		if (strcmp(a, "--count") == 0)
+		{
+			count_only = true;
+			continue;
+		}
+
+		if (i + 1 == argc) usage();
+		const char* v = argv[++i];
+
+		if (strcmp(a, "--pc") == 0 && num_pc < max_filters) pc_filter[num_pc++] = parse_range(v);
+		else if (strcmp(a, "--mem") == 0 && num_mem < max_filters) mem_filter[num_mem++] = parse_range(v);
+		else if (strcmp(a, "--frame") == 0 && num_frame < max_filters) frame_filter[num_frame++] = parse_range(v);
+		else if (strcmp(a, "--reg") == 0 && num_reg < max_filters) reg_filter[num_reg++] = parse_reg(v);
+		else if (strcmp(a, "--max") == 0) max = parse_count(v);
+		else usage();
+	}
+	if (!path) usage();
+
+	FILE* file = fopen(path, "rb");
+	if (!file) fail(strerror(errno), path);
+
+	Z80TraceHeader head;
+	if (fread(&head, sizeof(head), 1, file) != 1) fail("file too short", path);
+	if (memcmp(head.magic, z80trace_magic, sizeof(head.magic)) != 0) fail("not a zxsp trace file", path);
+	if (head.byte_order != 0x01020304) fail("trace file has wrong byte order", path);
+	if (head.record_size != sizeof(Z80TraceRecord)) fail("unsupported record size", path);
+
+	static Z80TraceRecord bu[4096];
+	uint64_t			  index	  = 0;
+	uint64_t			  matched = 0;
+	uint64_t			  dropped = 0;
+	uint32				  frame	  = 0;
+
+	while (matched < max)
+	{
+		size_t n = fread(bu, sizeof(Z80TraceRecord), 4096, file);
+		if (n == 0) break;
+
+		for (size_t i = 0; i < n && matched < max; i++)
+		{
+			const Z80TraceRecord& t = bu[i];
+			if (t.cc == z80trace_marker) // end of frame or records missing
+			{
+				Z80TraceMarker m;
+				memcpy(&m, &t, sizeof(m));
+				frame = m.frame;
+				dropped += m.dropped;
+				if (m.dropped && !count_only) printf("%10s  %u instructions missing\n", "--", m.dropped);
+				continue;
+			}
+
+			if (matches(t, frame))
+			{
+				matched++;
+				if (!count_only) print(t, index, frame);
+			}
+			index++;
+		}
+	}
+
+	if (ferror(file)) fail(strerror(errno), path);
+	fclose(file);
+
+	if (count_only) printf("%llu\n", (unsigned long long)matched);
+	else fprintf(stderr, "%llu of %llu instructions matched\n", (unsigned long long)matched, (unsigned long long)index);
+	if (dropped) fprintf(stderr, "%llu instructions are missing in the trace\n", (unsigned long long)dropped);
+	return 0;
+}
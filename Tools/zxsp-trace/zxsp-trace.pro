@@ -0,0 +1,7 @@
+TEMPLATE = app
+TARGET = zxsp-trace
+CONFIG += console c++14
+CONFIG -= qt app_bundle
+
+SOURCES += zxsp-trace.cpp
+HEADERS += ../../Source/Uni/Items/Z80/Z80_TraceRecord.h
@@ -193,6 +193,10 @@ SOURCES +=	\
 	Source/Qt/Dialogs/ConfigureKeyboardJoystickDialog.cpp \
 	Source/Qt/Overlays/Overlay.cpp \
 	\
+	Source/Uni/Audio/RateControl.cpp \
+	Source/Uni/Audio/StepBuffer.cpp \
+	Source/Uni/Audio/SampleKernels.cpp \
+	\
 	Source/Uni/TapeFile/CswBuffer.cpp \
 	Source/Uni/TapeFile/TapeFile.cpp \
 	Source/Uni/TapeFile/TapeData.cpp \
@@ -202,8 +206,10 @@ SOURCES +=	\
 	Source/Uni/TapeFile/AudioData.cpp \
 	Source/Uni/TapeFile/RlesData.cpp \
 	Source/Uni/TapeFile/TapeFileDataBlock.cpp \
+	Source/Uni/TapeFile/TapeSpeaker.cpp \
 	\
 	Source/Uni/Machine/Machine.cpp \
+	Source/Uni/Machine/MemMappedHandlers.cpp \
 	Source/Uni/Machine/MachineZx80.cpp \
 	Source/Uni/Machine/MachineZx81.cpp \
 	Source/Uni/Machine/MachineZxsp.cpp \
@@ -269,6 +275,7 @@ SOURCES +=	\
 	Source/Uni/Items/Fdc/DivIDE.cpp \
 	Source/Uni/Items/Fdc/FloppyDiskDrive.cpp \
 	Source/Uni/Items/Fdc/IdeDevice.cpp \
+	Source/Uni/Items/Fdc/SDCard.cpp \
 	Source/Uni/Items/Printer/Printer.cpp \
 	Source/Uni/Items/Printer/ZxPrinter.cpp \
 	Source/Uni/Items/Printer/PrinterPlus3.cpp \
@@ -288,7 +295,9 @@ SOURCES +=	\
 	Source/Uni/Items/Multiface/Multiface128.cpp \
 	Source/Uni/Items/Multiface/Multiface3.cpp \
 	Source/Uni/Items/Multiface/Multiface.cpp \
+	Source/Uni/Items/Z80/Z80_Breakpoints.cpp \
 	Source/Uni/Items/Z80/Z80_Disassembler.cpp \
+	Source/Uni/Items/Z80/Z80_Trace.cpp \
 	Source/Uni/Items/Z80/zxsp_Z80.cpp \
 	\
 	Source/Uni/Items/IcTester.cpp \
@@ -309,6 +318,7 @@ SOURCES +=	\
 	Source/Uni/Video/Renderer.cpp \
 	Source/Uni/Video/MonoRenderer.cpp \
 	Source/Uni/Video/SpectraRenderer.cpp \
+	Source/Uni/Video/MovieRecorder.cpp \
 	Source/Uni/Video/TVDecoderMono.cpp \
 	\
 	Source/Uni/Files/file_szx.cpp \
@@ -316,14 +326,21 @@ SOURCES +=	\
 	Source/Uni/Files/TccRom.cpp \
 	Source/Uni/Files/file_z80.cpp \
 	Source/Uni/Files/Z80Head.cpp \
+	Source/Uni/Files/Z80Snapshot.cpp \
+	Source/Uni/Files/SnapshotWriter.cpp \
 	Source/Uni/Files/RzxBlock.cpp \
 	Source/Uni/Files/RzxFile.cpp \
+	Source/Uni/Files/RzxSpillFile.cpp \
+	Source/Uni/Files/RomCache.cpp \
+	Source/Uni/Files/FileIndex.cpp \
+	Source/Uni/Files/FileScanner.cpp \
 	\
 	Source/Uni/ZxInfo/ZxInfo.cpp \
 	\
 	Source/Uni/zxsp_helpers.cpp \
 	Source/Uni/IoInfo.cpp \
 	Source/Uni/Memory.cpp \
+	Source/Uni/MemoryAccessCounter.cpp \
 	Source/Uni/IsaObject.cpp \
 
 
@@ -500,8 +517,16 @@ HEADERS += \
 	Source/Uni/Interfaces/IMachineController.h \
 	Source/Uni/Interfaces/IScreen.h \
 	\
+	Source/Uni/Audio/RateControl.h \
+	Source/Uni/Audio/StepBuffer.h \
+	Source/Uni/Audio/SampleKernels.h \
 	Source/Uni/Audio/StereoSample.h \
 	\
+	Source/Uni/Machine/InputQueue.h \
+	Source/Uni/Machine/MachineState.h \
+	Source/Uni/Machine/MemMappedHandlers.h \
+	Source/Uni/Machine/SeqLock.h \
+	Source/Uni/Machine/StateBuffer.h \
 	Source/Uni/Machine/Machine.h \
 	Source/Uni/Machine/MachineZx80.h \
 	Source/Uni/Machine/MachineZx81.h \
@@ -530,6 +555,7 @@ HEADERS += \
 	Source/Uni/TapeFile/CswBuffer.h \
 	Source/Uni/TapeFile/RlesData.h \
 	Source/Uni/TapeFile/TapeFileDataBlock.h \
+	Source/Uni/TapeFile/TapeSpeaker.h \
 	\
 	Source/Uni/Items/Ula/Ula.h \
 	Source/Uni/Items/Ula/Ula.h \
@@ -576,6 +602,7 @@ HEADERS += \
 	Source/Uni/Items/Fdc/DivIDE.h \
 	Source/Uni/Items/Fdc/FloppyDiskDrive.h \
 	Source/Uni/Items/Fdc/IdeDevice.h \
+	Source/Uni/Items/Fdc/SDCard.h \
 	Source/Uni/Items/Fdc/OpusDiscovery.h \
 	Source/Uni/Items/Fdc/Disciple.h \
 	Source/Uni/Items/Fdc/Fdc765.h \
@@ -605,8 +632,11 @@ HEADERS += \
 	Source/Uni/Items/Z80/Z80codesED.h \
 	Source/Uni/Items/Z80/Z80codesCB.h \
 	Source/Uni/Items/Z80/Z80codes.h \
+	Source/Uni/Items/Z80/Z80_Breakpoints.h \
 	Source/Uni/Items/Z80/Z80.h \
 	Source/Uni/Items/Z80/Z80_Disassembler.h \
+	Source/Uni/Items/Z80/Z80_Trace.h \
+	Source/Uni/Items/Z80/Z80_TraceRecord.h \
 	Source/Uni/Items/Z80/Z80opcodes.h \
 	Source/Uni/Items/Z80/Z80options.h \
 	\
@@ -630,6 +660,7 @@ HEADERS += \
 	Source/Uni/Video/Renderer.h \
 	Source/Uni/Video/MonoRenderer.h \
 	Source/Uni/Video/SpectraRenderer.h \
+	Source/Uni/Video/MovieRecorder.h \
 	Source/Uni/Video/TVDecoderMono.h \
 	\
 	Source/Uni/ZxInfo/ZxInfo.h \
@@ -637,11 +668,17 @@ HEADERS += \
 	Source/Uni/ZxInfo/zxsp_basic_tokens.h \
 	\
 	Source/Uni/Files/Z80Head.h \
+	Source/Uni/Files/Z80Snapshot.h \
+	Source/Uni/Files/SnapshotWriter.h \
 	Source/Uni/Files/file_szx.h \
 	Source/Uni/Files/FloppyDisk.h \
 	Source/Uni/Files/TccRom.h \
 	Source/Uni/Files/RzxFile.h \
 	Source/Uni/Files/RzxBlock.h \
+	Source/Uni/Files/RzxSpillFile.h \
+	Source/Uni/Files/RomCache.h \
+	Source/Uni/Files/FileIndex.h \
+	Source/Uni/Files/FileScanner.h \
 	\
 	Source/Uni/zxsp_globals.h \
 	Source/Uni/zxsp_helpers.h \
@@ -651,6 +688,7 @@ HEADERS += \
 	Source/Uni/isa_id.h \
 	Source/Uni/IoInfo.h \
 	Source/Uni/Memory.h \
+	Source/Uni/MemoryAccessCounter.h \
 	Source/Uni/precompiled_header.h \
 	Source/Uni/about_text.h \
 	Source/Uni/Keymap.h \